@@ -29,7 +29,7 @@
 
 namespace ImGui
 {
-  void AttachGizmo (Handle(AIS_InteractiveContext) theAISContext,
+  bool AttachGizmo (Handle(AIS_InteractiveContext) theAISContext,
                     Handle(V3d_View) theView,
                     Handle(AIS_InteractiveObject) theInteractiveObject,
                     int theOperation,
@@ -54,6 +54,8 @@ namespace ImGui
 
     float aPivot[3] = { (float)aCenter.X(), (float)aCenter.Y(), (float)aCenter.Z() };
     
+    bool isMoved = false;
+
     int aSelectedNum = theAISContext->NbSelected();
     for (theAISContext->InitSelected(); theAISContext->MoreSelected(); theAISContext->NextSelected(), aSelectedNum--)
     {
@@ -86,8 +88,12 @@ namespace ImGui
       {
         TopLoc_Location aLocation(aNewTransform);
         theAISContext->SetLocation(theAISContext->SelectedInteractive(), aLocation);
+
+        isMoved = true;
       }
     }
+
+    return isMoved;
   }
 
   IMGUI_API void DrawLights (Handle(AIS_InteractiveContext) theAISContext, Handle(V3d_View) theView)
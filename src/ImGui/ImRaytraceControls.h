@@ -16,7 +16,8 @@
 namespace ImGui
 {
 
-  IMGUI_API void AttachGizmo (Handle(AIS_InteractiveContext) theAISContext,
+  //! Draws manipulator of selected objects. Returns true if some object was moved.
+  IMGUI_API bool AttachGizmo (Handle(AIS_InteractiveContext) theAISContext,
                               Handle(V3d_View) theView,
                               Handle(AIS_InteractiveObject) theInteractiveObject,
                               int theOperation,
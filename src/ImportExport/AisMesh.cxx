@@ -10,6 +10,7 @@
 
 #include <set>
 #include <map>
+#include <fstream>
 
 #include <assimp/IOSystem.hpp>
 #include <assimp/Exporter.hpp>
@@ -37,13 +38,38 @@ namespace mesh
     //
   }
 
+  //===========================================================================
+  //function : AisMesh
+  //purpose  :
+  //===========================================================================
+  AisMesh::AisMesh (const Handle (Graphic3d_ArrayOfTriangles)&  theTriangles,
+                    const Handle (Graphic3d_AspectFillArea3d)& theAspect,
+                    const TCollection_AsciiString&             theName)
+    : myRange (MeshRange (NULL, NULL)),
+      myName (theName),
+      myAspect (theAspect),
+      myMeshes (theTriangles)
+  {
+    if (myAspect.IsNull ())
+    {
+      Graphic3d_MaterialAspect aMaterial (Graphic3d_NOM_DEFAULT);
+
+      aMaterial.SetBSDF (Graphic3d_BSDF::CreateDiffuse (Graphic3d_Vec3 (0.8f, 0.8f, 0.8f)));
+
+      myAspect = new Graphic3d_AspectFillArea3d (
+        Aspect_IS_SOLID, Quantity_NOC_WHITE, Quantity_NOC_WHITE, Aspect_TOL_SOLID, 1.0, aMaterial, aMaterial);
+    }
+
+    myDrawer->SetShadingAspect (new Prs3d_ShadingAspect (myAspect));
+  }
+
   //===========================================================================
   //function : Name
   //purpose  :
   //===========================================================================
   TCollection_AsciiString AisMesh::Name () const
   {
-    TCollection_AsciiString aName;
+    TCollection_AsciiString aName = myName;
 
     for (aiMesh** aMesh = myRange.first; aMesh != myRange.second && aName.IsEmpty(); ++aMesh)
     {
@@ -145,6 +171,20 @@ namespace mesh
       }
     }
 
+    if (myImporter.IsNull () && !myMeshes.IsNull ()) // mesh without importer
+    {
+      for (int aVrtID = 1; aVrtID <= myMeshes->VertexNumber (); ++aVrtID)
+      {
+        const gp_Pnt aVertex = myMeshes->Vertice (aVrtID);
+
+        for (int aDim = 0; aDim < 3; ++aDim)
+        {
+          aMinPnt[aDim] = std::min (aMinPnt[aDim], static_cast<float> (aVertex.Coord (aDim + 1)));
+          aMaxPnt[aDim] = std::max (aMaxPnt[aDim], static_cast<float> (aVertex.Coord (aDim + 1)));
+        }
+      }
+    }
+
     myMeshBounds.Update (aMinPnt[0], aMinPnt[1], aMinPnt[2],
                          aMaxPnt[0], aMaxPnt[1], aMaxPnt[2]);
 
@@ -219,216 +259,248 @@ namespace mesh
     {
       Handle (Graphic3d_Group) aGroup = Prs3d_Root::NewGroup (thePrs);
 
-      //------------------------------------------------------------------------------
-      // Import material
-      //------------------------------------------------------------------------------
+      buildAspect ();
 
-      if (myAspect.IsNull ())
-      {
-        Graphic3d_MaterialAspect aBsdfMaterial[2];
+      aGroup->SetGroupPrimitivesAspect (myAspect);
 
-        Handle (Graphic3d_TextureMap) aMapKd;
-        Handle (Graphic3d_TextureMap) aMapKs;
+      buildTriangles ();
 
-        for (size_t aMatIdx = 0; aMatIdx < 2; ++aMatIdx)
-        {
-          aBsdfMaterial[aMatIdx].SetMaterialType (Graphic3d_MATERIAL_PHYSIC);
+      aGroup->AddPrimitiveArray (myMeshes);
+    }
+  }
 
-          aBsdfMaterial[aMatIdx].SetAmbient  (1.0);
-          aBsdfMaterial[aMatIdx].SetDiffuse  (1.0);
-          aBsdfMaterial[aMatIdx].SetSpecular (1.0);
-          aBsdfMaterial[aMatIdx].SetEmissive (0.0);
+  //===========================================================================
+  //function : buildAspect
+  //purpose  :
+  //===========================================================================
+  void AisMesh::buildAspect ()
+  {
+    if (myAspect.IsNull ())
+    {
+      Graphic3d_MaterialAspect aBsdfMaterial[2];
 
-          aBsdfMaterial[aMatIdx].SetAmbientColor  (Quantity_Color (0.1, 0.1, 0.1, Quantity_TOC_RGB));
-          aBsdfMaterial[aMatIdx].SetDiffuseColor  (Quantity_Color (0.8, 0.8, 0.8, Quantity_TOC_RGB));
-          aBsdfMaterial[aMatIdx].SetSpecularColor (Quantity_Color (0.0, 0.0, 0.0, Quantity_TOC_RGB));
-          aBsdfMaterial[aMatIdx].SetEmissiveColor (Quantity_Color (0.0, 0.0, 0.0, Quantity_TOC_RGB));
+      Handle (Graphic3d_TextureMap) aMapKd;
+      Handle (Graphic3d_TextureMap) aMapKs;
 
-          Graphic3d_BSDF aBSDF = Graphic3d_BSDF::CreateDiffuse (Graphic3d_Vec3 (0.8f, 0.8f, 0.8f));
+      for (size_t aMatIdx = 0; aMatIdx < 2; ++aMatIdx)
+      {
+        aBsdfMaterial[aMatIdx].SetMaterialType (Graphic3d_MATERIAL_PHYSIC);
 
-          // FIXME: the condition is always true!
-          if ((*myRange.first)->mMaterialIndex >= 0)
-          {
-            aiMaterial* aMaterial = myImporter->myScene->mMaterials[(*myRange.first)->mMaterialIndex];
+        aBsdfMaterial[aMatIdx].SetAmbient  (1.0);
+        aBsdfMaterial[aMatIdx].SetDiffuse  (1.0);
+        aBsdfMaterial[aMatIdx].SetSpecular (1.0);
+        aBsdfMaterial[aMatIdx].SetEmissive (0.0);
 
-            aiColor4D aAmbient;
-            aiColor4D aDiffuse;
-            aiColor4D aSpecular;
-            aiColor4D aEmission;
+        aBsdfMaterial[aMatIdx].SetAmbientColor  (Quantity_Color (0.1, 0.1, 0.1, Quantity_TOC_RGB));
+        aBsdfMaterial[aMatIdx].SetDiffuseColor  (Quantity_Color (0.8, 0.8, 0.8, Quantity_TOC_RGB));
+        aBsdfMaterial[aMatIdx].SetSpecularColor (Quantity_Color (0.0, 0.0, 0.0, Quantity_TOC_RGB));
+        aBsdfMaterial[aMatIdx].SetEmissiveColor (Quantity_Color (0.0, 0.0, 0.0, Quantity_TOC_RGB));
 
-            if (AI_SUCCESS == aiGetMaterialColor (aMaterial, AI_MATKEY_COLOR_AMBIENT, &aAmbient))
-            {
-              aBsdfMaterial[aMatIdx].SetAmbientColor (Quantity_Color (aAmbient.r,
-                                                                      aAmbient.g,
-                                                                      aAmbient.b, Quantity_TOC_RGB));
-            }
+        Graphic3d_BSDF aBSDF = Graphic3d_BSDF::CreateDiffuse (Graphic3d_Vec3 (0.8f, 0.8f, 0.8f));
 
-            if (AI_SUCCESS == aiGetMaterialColor (aMaterial, AI_MATKEY_COLOR_DIFFUSE, &aDiffuse))
-            {
-              aBsdfMaterial[aMatIdx].SetAmbientColor (Quantity_Color (aDiffuse.r,
-                                                                      aDiffuse.g,
-                                                                      aDiffuse.b, Quantity_TOC_RGB));
+        // FIXME: the condition is always true!
+        if ((*myRange.first)->mMaterialIndex >= 0)
+        {
+          aiMaterial* aMaterial = myImporter->myScene->mMaterials[(*myRange.first)->mMaterialIndex];
 
-              aBSDF.Kd = Graphic3d_Vec3 (aDiffuse.r,
-                                         aDiffuse.g,
-                                         aDiffuse.b);
-            }
+          aiColor4D aAmbient;
+          aiColor4D aDiffuse;
+          aiColor4D aSpecular;
+          aiColor4D aEmission;
 
-            if (AI_SUCCESS == aiGetMaterialColor (aMaterial, AI_MATKEY_COLOR_SPECULAR, &aSpecular))
-            {
-              aBsdfMaterial[aMatIdx].SetAmbientColor (Quantity_Color (aSpecular.r,
-                                                                      aSpecular.g,
-                                                                      aSpecular.b, Quantity_TOC_RGB));
+          if (AI_SUCCESS == aiGetMaterialColor (aMaterial, AI_MATKEY_COLOR_AMBIENT, &aAmbient))
+          {
+            aBsdfMaterial[aMatIdx].SetAmbientColor (Quantity_Color (aAmbient.r,
+                                                                    aAmbient.g,
+                                                                    aAmbient.b, Quantity_TOC_RGB));
+          }
 
-              aBSDF.Ks.r () = aSpecular.r;
-              aBSDF.Ks.g () = aSpecular.g;
-              aBSDF.Ks.b () = aSpecular.b;
-            }
+          if (AI_SUCCESS == aiGetMaterialColor (aMaterial, AI_MATKEY_COLOR_DIFFUSE, &aDiffuse))
+          {
+            aBsdfMaterial[aMatIdx].SetAmbientColor (Quantity_Color (aDiffuse.r,
+                                                                    aDiffuse.g,
+                                                                    aDiffuse.b, Quantity_TOC_RGB));
 
-            if (AI_SUCCESS == aiGetMaterialColor (aMaterial, AI_MATKEY_COLOR_EMISSIVE, &aEmission))
-            {
-              aBsdfMaterial[aMatIdx].SetEmissiveColor (Quantity_Color (std::min (aEmission.r, 1.f),
-                                                                       std::min (aEmission.g, 1.f),
-                                                                       std::min (aEmission.b, 1.f), Quantity_TOC_RGB));
+            aBSDF.Kd = Graphic3d_Vec3 (aDiffuse.r,
+                                       aDiffuse.g,
+                                       aDiffuse.b);
+          }
 
-              aBSDF.Le = Graphic3d_Vec3 (aEmission.r,
-                                         aEmission.g,
-                                         aEmission.b);
-            }
+          if (AI_SUCCESS == aiGetMaterialColor (aMaterial, AI_MATKEY_COLOR_SPECULAR, &aSpecular))
+          {
+            aBsdfMaterial[aMatIdx].SetAmbientColor (Quantity_Color (aSpecular.r,
+                                                                    aSpecular.g,
+                                                                    aSpecular.b, Quantity_TOC_RGB));
 
-            float aExponent;
-            float aStrength;
+            aBSDF.Ks.r () = aSpecular.r;
+            aBSDF.Ks.g () = aSpecular.g;
+            aBSDF.Ks.b () = aSpecular.b;
+          }
 
-            unsigned int aMaxLength = 1;
+          if (AI_SUCCESS == aiGetMaterialColor (aMaterial, AI_MATKEY_COLOR_EMISSIVE, &aEmission))
+          {
+            aBsdfMaterial[aMatIdx].SetEmissiveColor (Quantity_Color (std::min (aEmission.r, 1.f),
+                                                                     std::min (aEmission.g, 1.f),
+                                                                     std::min (aEmission.b, 1.f), Quantity_TOC_RGB));
 
-            if (AI_SUCCESS == aiGetMaterialFloatArray (aMaterial, AI_MATKEY_SHININESS, &aExponent, &aMaxLength))
-            {
-              aMaxLength = 1;
+            aBSDF.Le = Graphic3d_Vec3 (aEmission.r,
+                                       aEmission.g,
+                                       aEmission.b);
+          }
 
-              if (AI_SUCCESS == aiGetMaterialFloatArray (aMaterial, AI_MATKEY_SHININESS_STRENGTH, &aStrength, &aMaxLength))
-              {
-                aExponent *= aStrength;
-              }
+          float aExponent;
+          float aStrength;
 
-              aBsdfMaterial[aMatIdx].SetShininess (Min (aExponent / 128.f, 1.f));
+          unsigned int aMaxLength = 1;
 
-              // for BSDF exponent is converted to roughness value
-              aBSDF.Ks.w () = std::sqrt (2.f / (aExponent + 2.f));
+          if (AI_SUCCESS == aiGetMaterialFloatArray (aMaterial, AI_MATKEY_SHININESS, &aExponent, &aMaxLength))
+          {
+            aMaxLength = 1;
+
+            if (AI_SUCCESS == aiGetMaterialFloatArray (aMaterial, AI_MATKEY_SHININESS_STRENGTH, &aStrength, &aMaxLength))
+            {
+              aExponent *= aStrength;
             }
 
-            aBSDF.Normalize (); // normalize BSDF to ensure energy conservation
+            aBsdfMaterial[aMatIdx].SetShininess (Min (aExponent / 128.f, 1.f));
 
-            aiString aTexturePathKd;
-            aiString aTexturePathKs;
+            // for BSDF exponent is converted to roughness value
+            aBSDF.Ks.w () = std::sqrt (2.f / (aExponent + 2.f));
+          }
 
-            if (AI_SUCCESS == aMaterial->GetTexture (aiTextureType_DIFFUSE, 0, &aTexturePathKd))
-            {
-              aMapKd = model::DataModel::GetDefault ()->Manager ()->PickTexture (myImporter->myDirectory + aTexturePathKd.C_Str ());
-            }
+          aBSDF.Normalize (); // normalize BSDF to ensure energy conservation
 
-            if (AI_SUCCESS == aMaterial->GetTexture (aiTextureType_SPECULAR, 0, &aTexturePathKs))
-            {
-              aMapKs = model::DataModel::GetDefault ()->Manager ()->PickTexture (myImporter->myDirectory + aTexturePathKs.C_Str ());
-            }
+          aiString aTexturePathKd;
+          aiString aTexturePathKs;
+
+          if (AI_SUCCESS == aMaterial->GetTexture (aiTextureType_DIFFUSE, 0, &aTexturePathKd))
+          {
+            aMapKd = model::DataModel::GetDefault ()->Manager ()->PickTexture (myImporter->myDirectory + aTexturePathKd.C_Str ());
           }
 
-          aBsdfMaterial[aMatIdx].SetBSDF (aBSDF);
+          if (AI_SUCCESS == aMaterial->GetTexture (aiTextureType_SPECULAR, 0, &aTexturePathKs))
+          {
+            aMapKs = model::DataModel::GetDefault ()->Manager ()->PickTexture (myImporter->myDirectory + aTexturePathKs.C_Str ());
+          }
         }
 
-        myAspect = new Graphic3d_AspectFillArea3d (
-          Aspect_IS_SOLID, Quantity_NOC_WHITE, Quantity_NOC_WHITE, Aspect_TOL_SOLID, 1.0, aBsdfMaterial[0], aBsdfMaterial[1]);
+        aBsdfMaterial[aMatIdx].SetBSDF (aBSDF);
+      }
 
-        if (!aMapKd.IsNull ())
-        {
-          myAspect->SetTextureMap (aMapKd);
+      myAspect = new Graphic3d_AspectFillArea3d (
+        Aspect_IS_SOLID, Quantity_NOC_WHITE, Quantity_NOC_WHITE, Aspect_TOL_SOLID, 1.0, aBsdfMaterial[0], aBsdfMaterial[1]);
 
-          myAspect->SetTextureMapOn (); // enable texturing
-        }
+      if (!aMapKd.IsNull ())
+      {
+        myAspect->SetTextureMap (aMapKd);
 
-        myDrawer->SetShadingAspect (new Prs3d_ShadingAspect (myAspect));
+        myAspect->SetTextureMapOn (); // enable texturing
       }
 
-      aGroup->SetGroupPrimitivesAspect (myAspect);
+      myDrawer->SetShadingAspect (new Prs3d_ShadingAspect (myAspect));
+    }
+  }
 
-      //------------------------------------------------------------------------------
-      // Import triangles
-      //------------------------------------------------------------------------------
+  //===========================================================================
+  //function : buildTriangles
+  //purpose  :
+  //===========================================================================
+  void AisMesh::buildTriangles ()
+  {
+    if (myMeshes.IsNull ())
+    {
+      int aTotalNbElements = 0;
+      int aTotalNbVertices = 0;
 
-      if (myMeshes.IsNull ())
+      for (aiMesh** aShape = myRange.first; aShape != myRange.second; ++aShape)
       {
-        int aTotalNbElements = 0;
-        int aTotalNbVertices = 0;
+        aTotalNbElements += (*aShape)->mNumFaces;
 
-        for (aiMesh** aShape = myRange.first; aShape != myRange.second; ++aShape)
+        if ((*aShape)->mNumFaces > 0)
         {
-          aTotalNbElements += (*aShape)->mNumFaces;
-
-          if ((*aShape)->mNumFaces > 0)
-          {
-            aTotalNbVertices += (*aShape)->mNumVertices;
-          }
+          aTotalNbVertices += (*aShape)->mNumVertices;
         }
+      }
 
-        myMeshes = new Graphic3d_ArrayOfTriangles (aTotalNbVertices, aTotalNbElements * 3, true, false, true);
+      myMeshes = new Graphic3d_ArrayOfTriangles (aTotalNbVertices, aTotalNbElements * 3, true, false, true);
+
+      for (aiMesh** aShape = myRange.first; aShape != myRange.second; ++aShape)
+      {
+        std::map<size_t, int> aVrtMap;
 
-        for (aiMesh** aShape = myRange.first; aShape != myRange.second; ++aShape)
+        for (size_t aFaceIdx = 0; aFaceIdx < (*aShape)->mNumFaces; ++aFaceIdx)
         {
-          std::map<size_t, int> aVrtMap;
+          const aiFace& aFace = (*aShape)->mFaces[aFaceIdx];
 
-          for (size_t aFaceIdx = 0; aFaceIdx < (*aShape)->mNumFaces; ++aFaceIdx)
-          {
-            const aiFace& aFace = (*aShape)->mFaces[aFaceIdx];
+          Standard_ASSERT_RAISE (aFace.mNumIndices == 3,
+            "Error! AIS mesh supports only triangular meshes");
 
-            Standard_ASSERT_RAISE (aFace.mNumIndices == 3,
-              "Error! AIS mesh supports only triangular meshes");
+          for (size_t aVrtIdx = 0; aVrtIdx < aFace.mNumIndices; ++aVrtIdx)
+          {
+            const size_t aVrt = aFace.mIndices[aVrtIdx];
 
-            for (size_t aVrtIdx = 0; aVrtIdx < aFace.mNumIndices; ++aVrtIdx)
+            if (aVrtMap.find (aVrt) == aVrtMap.end ())
             {
-              const size_t aVrt = aFace.mIndices[aVrtIdx];
+              gp_Dir aNormal (0, 0, 1);
 
-              if (aVrtMap.find (aVrt) == aVrtMap.end ())
+              if ((*aShape)->mNormals[aVrt].SquareLength () > FLT_MIN)
               {
-                gp_Dir aNormal (0, 0, 1);
-
-                if ((*aShape)->mNormals[aVrt].SquareLength () > FLT_MIN)
-                {
-                  aNormal = gp_Dir ((*aShape)->mNormals[aVrt].x,
-                                    (*aShape)->mNormals[aVrt].y,
-                                    (*aShape)->mNormals[aVrt].z);
-                }
-
-                gp_Pnt2d aTexcoord (0, 0);
-
-                if ((*aShape)->HasTextureCoords (0))
-                {
-                  aTexcoord = gp_Pnt2d ((*aShape)->mTextureCoords[0][aVrt].x,
-                                        (*aShape)->mTextureCoords[0][aVrt].y);
-                }
-
-                aVrtMap[aVrt] = myMeshes->AddVertex (gp_Pnt ((*aShape)->mVertices[aVrt].x,
-                                                             (*aShape)->mVertices[aVrt].y,
-                                                             (*aShape)->mVertices[aVrt].z), aNormal, aTexcoord);
+                aNormal = gp_Dir ((*aShape)->mNormals[aVrt].x,
+                                  (*aShape)->mNormals[aVrt].y,
+                                  (*aShape)->mNormals[aVrt].z);
               }
 
-              myMeshes->AddEdge (aVrtMap[aVrt]);
+              gp_Pnt2d aTexcoord (0, 0);
+
+              if ((*aShape)->HasTextureCoords (0))
+              {
+                aTexcoord = gp_Pnt2d ((*aShape)->mTextureCoords[0][aVrt].x,
+                                      (*aShape)->mTextureCoords[0][aVrt].y);
+              }
+
+              aVrtMap[aVrt] = myMeshes->AddVertex (gp_Pnt ((*aShape)->mVertices[aVrt].x,
+                                                           (*aShape)->mVertices[aVrt].y,
+                                                           (*aShape)->mVertices[aVrt].z), aNormal, aTexcoord);
             }
+
+            myMeshes->AddEdge (aVrtMap[aVrt]);
           }
         }
-
-  #ifdef PRINT_DEBUG_INFO
-        std::cout << "Mesh imported: " << aTotalNbElements << " triangles\n";
-  #endif
       }
-    
-      aGroup->AddPrimitiveArray (myMeshes);
+
+#ifdef PRINT_DEBUG_INFO
+      std::cout << "Mesh imported: " << aTotalNbElements << " triangles\n";
+#endif
     }
   }
 
+  //===========================================================================
+  //function : Triangles
+  //purpose  :
+  //===========================================================================
+  const Handle (Graphic3d_ArrayOfTriangles)& AisMesh::Triangles ()
+  {
+    buildTriangles ();
+
+    return myMeshes;
+  }
+
+  //===========================================================================
+  //function : Aspect
+  //purpose  :
+  //===========================================================================
+  const Handle (Graphic3d_AspectFillArea3d)& AisMesh::Aspect ()
+  {
+    buildAspect ();
+
+    return myAspect;
+  }
+
   //===========================================================================
   //function : ExportToFile
   //purpose  :
   //===========================================================================
-  void AisMesh::ExportToFile (const TCollection_AsciiString& theFileName)
+  bool AisMesh::ExportToFile (const TCollection_AsciiString& theFileName)
   {
     class WrapScene : public aiScene
     {
@@ -487,10 +559,60 @@ namespace mesh
     {
       WrapScene aScene (*myImporter->myScene, myRange);
 
-      if (aiExportScene (&aScene, "plyb", theFileName.ToCString (), 0) != aiReturn_SUCCESS)
+      return aiExportScene (&aScene, "plyb", theFileName.ToCString (), 0) == aiReturn_SUCCESS;
+    }
+    else if (!myMeshes.IsNull ()) // write binary PLY file directly
+    {
+      std::ofstream aStream (theFileName.ToCString (), std::ios_base::out | std::ios_base::binary);
+
+      if (!aStream.is_open ())
+      {
+        return false;
+      }
+
+      aStream << "ply\n"
+              << "format binary_little_endian 1.0\n"
+              << "element vertex " << myMeshes->VertexNumber () << "\n"
+              << "property float x\n"  << "property float y\n"  << "property float z\n"
+              << "property float nx\n" << "property float ny\n" << "property float nz\n"
+              << "property float u\n"  << "property float v\n"
+              << "element face " << myMeshes->EdgeNumber () / 3 << "\n"
+              << "property list uchar int vertex_indices\n"
+              << "end_header\n";
+
+      for (int aVrtID = 1; aVrtID <= myMeshes->VertexNumber (); ++aVrtID)
       {
-        Standard_ASSERT_INVOKE ("Error! Failed to export ASSIMP scene");
+        const gp_Pnt   aVertex = myMeshes->Vertice (aVrtID);
+        const gp_Dir   aNormal = myMeshes->VertexNormal (aVrtID);
+        const gp_Pnt2d aTexel  = myMeshes->VertexTexel (aVrtID);
+
+        const float aData[] = { static_cast<float> (aVertex.X ()),
+                                static_cast<float> (aVertex.Y ()),
+                                static_cast<float> (aVertex.Z ()),
+                                static_cast<float> (aNormal.X ()),
+                                static_cast<float> (aNormal.Y ()),
+                                static_cast<float> (aNormal.Z ()),
+                                static_cast<float> (aTexel.X ()),
+                                static_cast<float> (aTexel.Y ()) };
+
+        aStream.write (reinterpret_cast<const char*> (aData), sizeof (aData));
       }
+
+      for (int anEdgeID = 1; anEdgeID + 2 <= myMeshes->EdgeNumber (); anEdgeID += 3)
+      {
+        const unsigned char aNbIndices = 3;
+
+        const int anIndices[] = { myMeshes->Edge (anEdgeID + 0) - 1,
+                                  myMeshes->Edge (anEdgeID + 1) - 1,
+                                  myMeshes->Edge (anEdgeID + 2) - 1 };
+
+        aStream.write (reinterpret_cast<const char*> (&aNbIndices), sizeof (aNbIndices));
+        aStream.write (reinterpret_cast<const char*> (anIndices), sizeof (anIndices));
+      }
+
+      return aStream.good ();
     }
+
+    return false;
   }
 }
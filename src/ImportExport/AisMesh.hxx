@@ -46,6 +46,11 @@ namespace mesh
     //! Creates new AIS mesh.
     Standard_EXPORT AisMesh (Handle (MeshImporter) theImporter, MeshRange theRange);
 
+    //! Creates new AIS mesh from ready triangles (can be shared by several meshes).
+    Standard_EXPORT AisMesh (const Handle (Graphic3d_ArrayOfTriangles)&  theTriangles,
+                             const Handle (Graphic3d_AspectFillArea3d)& theAspect,
+                             const TCollection_AsciiString&             theName = "");
+
   public:
 
     //! Returns mesh name (can be empty).
@@ -61,13 +66,26 @@ namespace mesh
     Standard_EXPORT void SetMaterial (const Graphic3d_MaterialAspect& theMaterial);
 
     //! Exports the mesh to the given PLY file (only geometry is exported).
-    Standard_EXPORT void ExportToFile (const TCollection_AsciiString& theFileName);
+    //! Returns false if the file was failed to write.
+    Standard_EXPORT bool ExportToFile (const TCollection_AsciiString& theFileName);
 
     //! Replaces current graphic aspect to the given one (for unifying materials).
     Standard_EXPORT void SetGraphicAspect (const Handle (Graphic3d_AspectFillArea3d)& theAspect);
 
+    //! Returns triangles of the mesh (imported on first call).
+    Standard_EXPORT const Handle (Graphic3d_ArrayOfTriangles)& Triangles ();
+
+    //! Returns graphic aspect of the mesh (imported on first call).
+    Standard_EXPORT const Handle (Graphic3d_AspectFillArea3d)& Aspect ();
+
   protected:
 
+    //! Imports material of the mesh.
+    void buildAspect ();
+
+    //! Imports triangles of the mesh.
+    void buildTriangles ();
+
     //! Returns mesh bounding box.
     const Bnd_Box& getBoundingBox ();
 
@@ -85,6 +103,9 @@ namespace mesh
     //! Mesh importer to share resources.
     Handle (MeshImporter) myImporter;
 
+    //! Name of the mesh (if created without importer).
+    TCollection_AsciiString myName;
+
     //! Bounding box used for highlighting.
     Bnd_Box myMeshBounds;
 
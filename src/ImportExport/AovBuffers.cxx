@@ -0,0 +1,767 @@
+// Created: 2019-07-12
+//
+// Copyright (c) 2019 OPEN CASCADE SAS
+//
+// This file is a part of CADRays software.
+//
+// CADRays is free software; you can use it under the terms of the MIT license,
+// refer to file LICENSE.txt for complete text of the license and disclaimer of
+// any warranty.
+
+#include <AIS_InteractiveContext.hxx>
+#include <AIS_Shape.hxx>
+#include <Aspect_Window.hxx>
+#include <BRep_Tool.hxx>
+#include <BVH_BinnedBuilder.hxx>
+#include <BVH_Triangulation.hxx>
+#include <Graphic3d_ArrayOfTriangles.hxx>
+#include <Graphic3d_CView.hxx>
+#include <Image_PixMap.hxx>
+#include <OSD_Parallel.hxx>
+#include <Poly_Triangulation.hxx>
+#include <TopExp_Explorer.hxx>
+#include <TopoDS.hxx>
+#include <ViewerTest.hxx>
+#include <ViewerTest_DoubleMapOfInteractiveAndName.hxx>
+#include <ViewerTest_DoubleMapIteratorOfDoubleMapOfInteractiveAndName.hxx>
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <map>
+
+#include "Utils.hxx"
+#include "AisMesh.hxx"
+#include "Checkpoint.hxx"
+#include "AovBuffers.hxx"
+
+extern ViewerTest_DoubleMapOfInteractiveAndName& GetMapOfAIS ();
+
+namespace ie
+{
+  //! Depth of background pixels (as in most renderers).
+  static const float THE_BACKGROUND_DEPTH = 1.0e10f;
+
+  //===========================================================================
+  //function : viewSize
+  //purpose  : Returns size of the image rendered by the view
+  //===========================================================================
+  static void viewSize (const Handle (V3d_View)& theView, Standard_Integer& theSizeX, Standard_Integer& theSizeY)
+  {
+    const Handle (Standard_Transient) anFBO = theView->View ()->FBO ();
+
+    if (!anFBO.IsNull ())
+    {
+      Standard_Integer aSizeXMax = 0;
+      Standard_Integer aSizeYMax = 0;
+
+      theView->View ()->FBOGetDimensions (anFBO, theSizeX, theSizeY, aSizeXMax, aSizeYMax);
+    }
+    else
+    {
+      theView->Window ()->Size (theSizeX, theSizeY);
+    }
+  }
+
+  //===========================================================================
+  //function : addShape
+  //purpose  : Adds triangulation of the shape (as displayed by GPU)
+  //===========================================================================
+  static void addShape (BVH_Triangulation<Standard_Real, 3>& theTriangles,
+                        const TopoDS_Shape& theShape, const gp_Trsf& theTrsf, const int theObject)
+  {
+    for (TopExp_Explorer anExp (theShape, TopAbs_FACE); anExp.More (); anExp.Next ())
+    {
+      TopLoc_Location aLocation;
+
+      const Handle (Poly_Triangulation)& aTriangulation = BRep_Tool::Triangulation (TopoDS::Face (anExp.Current ()), aLocation);
+
+      if (aTriangulation.IsNull ())
+      {
+        continue;
+      }
+
+      const gp_Trsf aTrsf = theTrsf * aLocation.Transformation ();
+
+      const TColgp_Array1OfPnt&    aNodes = aTriangulation->Nodes ();
+      const Poly_Array1OfTriangle& aTris  = aTriangulation->Triangles ();
+
+      const int anOffset = static_cast<int> (theTriangles.Vertices.size ()) - aNodes.Lower ();
+
+      for (int aNodeIdx = aNodes.Lower (); aNodeIdx <= aNodes.Upper (); ++aNodeIdx)
+      {
+        const gp_Pnt aPnt = aNodes (aNodeIdx).Transformed (aTrsf);
+
+        theTriangles.Vertices.push_back (BVH_Vec3d (aPnt.X (), aPnt.Y (), aPnt.Z ()));
+      }
+
+      for (int aTriIdx = aTris.Lower (); aTriIdx <= aTris.Upper (); ++aTriIdx)
+      {
+        int aNode1, aNode2, aNode3;
+
+        aTris (aTriIdx).Get (aNode1, aNode2, aNode3);
+
+        theTriangles.Elements.push_back (BVH_Vec4i (aNode1 + anOffset, aNode2 + anOffset, aNode3 + anOffset, theObject));
+      }
+    }
+  }
+
+  //===========================================================================
+  //function : addMesh
+  //purpose  : Adds triangles of imported mesh
+  //===========================================================================
+  static void addMesh (BVH_Triangulation<Standard_Real, 3>& theTriangles,
+                       const Handle (Graphic3d_ArrayOfTriangles)& theMesh, const gp_Trsf& theTrsf, const int theObject)
+  {
+    if (theMesh.IsNull ())
+    {
+      return;
+    }
+
+    const int anOffset = static_cast<int> (theTriangles.Vertices.size ()) - 1;
+
+    for (int aVrtIdx = 1; aVrtIdx <= theMesh->VertexNumber (); ++aVrtIdx)
+    {
+      const gp_Pnt aPnt = theMesh->Vertice (aVrtIdx).Transformed (theTrsf);
+
+      theTriangles.Vertices.push_back (BVH_Vec3d (aPnt.X (), aPnt.Y (), aPnt.Z ()));
+    }
+
+    // Triangles are either indexed or listed vertex by vertex
+    const int aNbIndices = theMesh->EdgeNumber () > 0 ? theMesh->EdgeNumber () : theMesh->VertexNumber ();
+
+    for (int anIdx = 1; anIdx + 2 <= aNbIndices; anIdx += 3)
+    {
+      if (theMesh->EdgeNumber () > 0)
+      {
+        theTriangles.Elements.push_back (BVH_Vec4i (theMesh->Edge (anIdx + 0) + anOffset,
+                                                    theMesh->Edge (anIdx + 1) + anOffset,
+                                                    theMesh->Edge (anIdx + 2) + anOffset, theObject));
+      }
+      else
+      {
+        theTriangles.Elements.push_back (BVH_Vec4i (anIdx + 0 + anOffset,
+                                                    anIdx + 1 + anOffset,
+                                                    anIdx + 2 + anOffset, theObject));
+      }
+    }
+  }
+
+  //===========================================================================
+  //function : intersectBox
+  //purpose  : Returns distance to the box (or negative value if missed)
+  //===========================================================================
+  static double intersectBox (const BVH_Vec3d& theOrigin, const BVH_Vec3d& theInvDir,
+                              const BVH_Vec3d& theMin, const BVH_Vec3d& theMax, const double theMaxDist)
+  {
+    double aNear = 0.0;
+    double aFar  = theMaxDist;
+
+    for (int aDim = 0; aDim < 3; ++aDim)
+    {
+      const double aTime1 = (theMin.GetData ()[aDim] - theOrigin.GetData ()[aDim]) * theInvDir.GetData ()[aDim];
+      const double aTime2 = (theMax.GetData ()[aDim] - theOrigin.GetData ()[aDim]) * theInvDir.GetData ()[aDim];
+
+      aNear = std::max (aNear, std::min (aTime1, aTime2));
+      aFar  = std::min (aFar,  std::max (aTime1, aTime2));
+    }
+
+    return aNear <= aFar ? aNear : -1.0;
+  }
+
+  //===========================================================================
+  //function : intersectTriangle
+  //purpose  : Updates distance to the closest hit (Moller-Trumbore test)
+  //===========================================================================
+  static bool intersectTriangle (const BVH_Vec3d& theOrigin, const BVH_Vec3d& theDir,
+                                 const BVH_Vec3d& thePnt0, const BVH_Vec3d& thePnt1, const BVH_Vec3d& thePnt2, double& theDist)
+  {
+    const BVH_Vec3d anEdge1 = thePnt1 - thePnt0;
+    const BVH_Vec3d anEdge2 = thePnt2 - thePnt0;
+
+    const BVH_Vec3d aPVec = BVH_Vec3d::Cross (theDir, anEdge2);
+
+    const double aDet = anEdge1.Dot (aPVec);
+
+    if (aDet == 0.0)
+    {
+      return false;
+    }
+
+    const BVH_Vec3d aTVec = theOrigin - thePnt0;
+
+    const double aU = aTVec.Dot (aPVec) / aDet;
+
+    if (aU < 0.0 || aU > 1.0)
+    {
+      return false;
+    }
+
+    const BVH_Vec3d aQVec = BVH_Vec3d::Cross (aTVec, anEdge1);
+
+    const double aV = theDir.Dot (aQVec) / aDet;
+
+    if (aV < 0.0 || aU + aV > 1.0)
+    {
+      return false;
+    }
+
+    const double aTime = anEdge2.Dot (aQVec) / aDet;
+
+    if (aTime <= 0.0 || aTime >= theDist)
+    {
+      return false;
+    }
+
+    theDist = aTime;
+
+    return true;
+  }
+
+  //! Casts primary rays of image rows (functor for OSD_Parallel).
+  class RayCaster
+  {
+  public:
+
+    //! Creates ray caster writing to the given channels.
+    RayCaster (BVH_Triangulation<Standard_Real, 3>& theTriangles,
+               const std::vector<BVH_Vec3f>& theAlbedos,
+               const Handle (Graphic3d_Camera)& theCamera,
+               const int theSizeX, const int theSizeY, float* theChannels[8])
+      : myTriangles (theTriangles),
+        myTree (theTriangles.BVH ()),
+        myAlbedos (theAlbedos),
+        mySizeX (theSizeX),
+        mySizeY (theSizeY)
+    {
+      const Graphic3d_Mat4d aViewProj = theCamera->ProjectionMatrix () * theCamera->OrientationMatrix ();
+
+      aViewProj.Inverted (myInvViewProj);
+
+      myEye     = BVH_Vec3d (theCamera->Eye ().X (), theCamera->Eye ().Y (), theCamera->Eye ().Z ());
+      myViewDir = BVH_Vec3d (theCamera->Direction ().X (), theCamera->Direction ().Y (), theCamera->Direction ().Z ());
+
+      std::copy (theChannels, theChannels + 8, myChannels);
+    }
+
+    //! Casts rays of the given row.
+    void operator() (const int theRow) const
+    {
+      for (int aCol = 0; aCol < mySizeX; ++aCol)
+      {
+        // Ray through pixel center from near to far clipping plane
+        const double aX = (aCol + 0.5) / mySizeX * 2.0 - 1.0;
+        const double aY = 1.0 - (theRow + 0.5) / mySizeY * 2.0;
+
+        const BVH_Vec3d aNear = unproject (aX, aY, -1.0);
+        const BVH_Vec3d aFar  = unproject (aX, aY,  1.0);
+
+        BVH_Vec3d aDir = aFar - aNear;
+
+        double aDist = aDir.Modulus ();
+
+        aDir /= aDist;
+
+        int aTriangle = -1;
+
+        traverse (aNear, aDir, aDist, aTriangle);
+
+        if (aTriangle < 0)
+        {
+          continue;
+        }
+
+        const BVH_Vec4i& anElem = myTriangles.Elements[aTriangle];
+
+        const BVH_Vec3d& aPnt0 = myTriangles.Vertices[anElem.x ()];
+
+        BVH_Vec3d aNormal = BVH_Vec3d::Cross (myTriangles.Vertices[anElem.y ()] - aPnt0,
+                                              myTriangles.Vertices[anElem.z ()] - aPnt0);
+
+        aNormal.Normalize ();
+
+        // Normal faces the camera (triangles may have any orientation)
+        if (aNormal.Dot (aDir) > 0.0)
+        {
+          aNormal = -aNormal;
+        }
+
+        const BVH_Vec3d aHit = aNear + aDir * aDist;
+
+        const size_t aPixel = static_cast<size_t> (theRow) * mySizeX + aCol;
+
+        const BVH_Vec3f& anAlbedo = myAlbedos[anElem.w ()];
+
+        myChannels[0][aPixel] = static_cast<float> ((aHit - myEye).Dot (myViewDir));
+        myChannels[1][aPixel] = static_cast<float> (aNormal.x ());
+        myChannels[2][aPixel] = static_cast<float> (aNormal.y ());
+        myChannels[3][aPixel] = static_cast<float> (aNormal.z ());
+        myChannels[4][aPixel] = anAlbedo.r ();
+        myChannels[5][aPixel] = anAlbedo.g ();
+        myChannels[6][aPixel] = anAlbedo.b ();
+        myChannels[7][aPixel] = static_cast<float> (anElem.w () + 1);
+      }
+    }
+
+  private:
+
+    //! Transforms point from NDC to world space.
+    BVH_Vec3d unproject (const double theX, const double theY, const double theZ) const
+    {
+      const Graphic3d_Vec4d aPnt = myInvViewProj * Graphic3d_Vec4d (theX, theY, theZ, 1.0);
+
+      return BVH_Vec3d (aPnt.x (), aPnt.y (), aPnt.z ()) / aPnt.w ();
+    }
+
+    //! Finds the closest triangle hit by the ray.
+    void traverse (const BVH_Vec3d& theOrigin, const BVH_Vec3d& theDir, double& theDist, int& theTriangle) const
+    {
+      if (myTree.IsNull () || myTree->Length () == 0)
+      {
+        return;
+      }
+
+      BVH_Vec3d anInvDir;
+
+      for (int aDim = 0; aDim < 3; ++aDim)
+      {
+        const double aComp = theDir.GetData ()[aDim];
+
+        anInvDir.ChangeData ()[aDim] = 1.0 / (std::abs (aComp) > 1.0e-12 ? aComp : std::copysign (1.0e-12, aComp));
+      }
+
+      int aStack[64];
+      int aHead = 0;
+
+      aStack[aHead++] = 0;
+
+      while (aHead > 0)
+      {
+        const int aNode = aStack[--aHead];
+
+        if (intersectBox (theOrigin, anInvDir, myTree->MinPoint (aNode), myTree->MaxPoint (aNode), theDist) < 0.0)
+        {
+          continue;
+        }
+
+        // Node data: leaf flag, then children or range of triangles
+        const BVH_Vec4i& aData = myTree->NodeInfoBuffer ()[aNode];
+
+        if (aData.x () == 0)
+        {
+          aStack[aHead++] = aData.y ();
+          aStack[aHead++] = aData.z ();
+        }
+        else
+        {
+          for (int aTriIdx = aData.y (); aTriIdx <= aData.z (); ++aTriIdx)
+          {
+            const BVH_Vec4i& anElem = myTriangles.Elements[aTriIdx];
+
+            if (intersectTriangle (theOrigin, theDir, myTriangles.Vertices[anElem.x ()],
+                                                      myTriangles.Vertices[anElem.y ()],
+                                                      myTriangles.Vertices[anElem.z ()], theDist))
+            {
+              theTriangle = aTriIdx;
+            }
+          }
+        }
+      }
+    }
+
+  private:
+
+    BVH_Triangulation<Standard_Real, 3>&                  myTriangles;
+    const opencascade::handle<BVH_Tree<Standard_Real, 3> > myTree;
+    const std::vector<BVH_Vec3f>&                         myAlbedos;
+    Graphic3d_Mat4d                                       myInvViewProj;
+    BVH_Vec3d                                             myEye;
+    BVH_Vec3d                                             myViewDir;
+    int                                                   mySizeX;
+    int                                                   mySizeY;
+    float*                                                myChannels[8];
+  };
+
+  //===========================================================================
+  //function : AovBuffers
+  //purpose  :
+  //===========================================================================
+  AovBuffers::AovBuffers ()
+    : mySizeX (0),
+      mySizeY (0),
+      myIsComputed (false)
+  {
+    //
+  }
+
+  //===========================================================================
+  //function : addChannel
+  //purpose  :
+  //===========================================================================
+  AovBuffers::Channel& AovBuffers::addChannel (const std::string& theName, const float theValue)
+  {
+    myChannels.push_back (Channel ());
+
+    myChannels.back ().Name = theName;
+    myChannels.back ().Data.assign (static_cast<size_t> (mySizeX) * mySizeY, theValue);
+
+    return myChannels.back ();
+  }
+
+  //===========================================================================
+  //function : Find
+  //purpose  :
+  //===========================================================================
+  const AovBuffers::Channel* AovBuffers::Find (const std::string& theName) const
+  {
+    for (size_t anIdx = 0; anIdx < myChannels.size (); ++anIdx)
+    {
+      if (myChannels[anIdx].Name == theName)
+      {
+        return &myChannels[anIdx];
+      }
+    }
+
+    return NULL;
+  }
+
+  //===========================================================================
+  //function : Perform
+  //purpose  :
+  //===========================================================================
+  bool AovBuffers::Perform (const Handle (V3d_View)& theView, const bool toReadRadiance)
+  {
+    if (!Prepare (theView, toReadRadiance))
+    {
+      return false;
+    }
+
+    Compute ();
+
+    return true;
+  }
+
+  //===========================================================================
+  //function : Prepare
+  //purpose  :
+  //===========================================================================
+  bool AovBuffers::Prepare (const Handle (V3d_View)& theView, const bool toReadRadiance)
+  {
+    std::lock_guard<std::mutex> aLock (myMutex);
+
+    myChannels.clear ();
+    myObjects.clear ();
+    myAlbedos.clear ();
+
+    myTriangles.reset ();
+
+    myIsComputed = false;
+
+    if (theView.IsNull ())
+    {
+      return false;
+    }
+
+    viewSize (theView, mySizeX, mySizeY);
+
+    if (mySizeX < 1 || mySizeY < 1 || (toReadRadiance && !readRadiance (theView)))
+    {
+      return false;
+    }
+
+    myCamera = new Graphic3d_Camera (theView->Camera ());
+
+    collectTriangles ();
+
+    return true;
+  }
+
+  //===========================================================================
+  //function : Compute
+  //purpose  :
+  //===========================================================================
+  void AovBuffers::Compute ()
+  {
+    std::lock_guard<std::mutex> aLock (myMutex);
+
+    if (myIsComputed || myCamera.IsNull ())
+    {
+      return;
+    }
+
+    castRays ();
+
+    std::sort (myChannels.begin (), myChannels.end (),
+      [] (const Channel& theChannel1, const Channel& theChannel2) { return theChannel1.Name < theChannel2.Name; });
+
+    // Triangles are not needed anymore
+    myTriangles.reset ();
+
+    myIsComputed = true;
+  }
+
+  //===========================================================================
+  //function : readRadiance
+  //purpose  :
+  //===========================================================================
+  bool AovBuffers::readRadiance (const Handle (V3d_View)& theView)
+  {
+    const Graphic3d_RenderingParams& aParams = theView->RenderingParams ();
+
+    // Linear radiance is available in accumulation buffer of path tracing only
+    const bool isHdr = aParams.Method == Graphic3d_RM_RAYTRACING && aParams.IsGlobalIlluminationEnabled;
+
+    if (!isHdr)
+    {
+      std::cout << "Warning: Path tracing is off, displayed (tone mapped) image is written instead of radiance" << std::endl;
+    }
+
+    Image_PixMap anImage;
+
+    if (!anImage.InitZero (Image_PixMap::ImgRGBF, mySizeX, mySizeY)
+     || !theView->View ()->BufferDump (anImage, isHdr ? Graphic3d_BT_RGB_RayTraceHdrLeft : Graphic3d_BT_RGB))
+    {
+      return false;
+    }
+
+    // Add samples restored from checkpoint
+    Checkpoint::GetInstance ()->Combine (anImage, isHdr);
+
+    myChannels.reserve (myChannels.size () + 3);
+
+    float* aChannels[] = { &addChannel ("R").Data[0],
+                           &addChannel ("G").Data[0],
+                           &addChannel ("B").Data[0] };
+
+    for (int aRow = 0; aRow < mySizeY; ++aRow)
+    {
+      const float* aPixel = reinterpret_cast<const float*> (anImage.Row (aRow));
+
+      for (int aCol = 0; aCol < mySizeX; ++aCol, aPixel += 3)
+      {
+        for (int aChannel = 0; aChannel < 3; ++aChannel)
+        {
+          aChannels[aChannel][static_cast<size_t> (aRow) * mySizeX + aCol] = aPixel[aChannel];
+        }
+      }
+    }
+
+    return true;
+  }
+
+  //===========================================================================
+  //function : collectTriangles
+  //purpose  :
+  //===========================================================================
+  void AovBuffers::collectTriangles ()
+  {
+    myTriangles.reset (new BVH_Triangulation<Standard_Real, 3> (new BVH_BinnedBuilder<Standard_Real, 3, 32> (4, 32)));
+
+    Handle (AIS_InteractiveContext) aContext = ViewerTest::GetAISContext ();
+
+    // Objects are sorted by name, so that IDs are stable across sessions
+    std::map<TCollection_AsciiString, Handle (AIS_InteractiveObject)> anObjects;
+
+    for (ViewerTest_DoubleMapIteratorOfDoubleMapOfInteractiveAndName anIter (GetMapOfAIS ()); anIter.More (); anIter.Next ())
+    {
+      const Handle (AIS_InteractiveObject) anObject = Handle (AIS_InteractiveObject)::DownCast (anIter.Key1 ());
+
+      if (!anObject.IsNull () && !aContext.IsNull () && aContext->IsDisplayed (anObject))
+      {
+        anObjects[anIter.Key2 ()] = anObject;
+      }
+    }
+
+    for (std::map<TCollection_AsciiString, Handle (AIS_InteractiveObject)>::const_iterator anIter = anObjects.begin (); anIter != anObjects.end (); ++anIter)
+    {
+      const int anIndex = static_cast<int> (myObjects.size ());
+
+      const Handle (AIS_InteractiveObject)& anObject = anIter->second;
+
+      Handle (AIS_Shape)     aShape = Handle (AIS_Shape)::DownCast (anObject);
+      Handle (mesh::AisMesh) aMesh  = Handle (mesh::AisMesh)::DownCast (anObject);
+
+      if (!aShape.IsNull ())
+      {
+        addShape (*myTriangles, aShape->Shape (), anObject->Transformation (), anIndex);
+      }
+      else if (!aMesh.IsNull ())
+      {
+        addMesh (*myTriangles, aMesh->Triangles (), anObject->Transformation (), anIndex);
+      }
+
+      // Albedo is reflectance of base layer (textures are not taken into account)
+      BVH_Vec3f anAlbedo (0.f, 0.f, 0.f);
+
+      Graphic3d_AspectFillArea3d* anAspect = model::GetAspect (anObject);
+
+      if (anAspect != NULL)
+      {
+        const Graphic3d_BSDF& aBSDF = anAspect->FrontMaterial ().BSDF ();
+
+        for (int aDim = 0; aDim < 3; ++aDim)
+        {
+          anAlbedo.ChangeData ()[aDim] = std::min (aBSDF.Kd.GetData ()[aDim] + aBSDF.Ks.GetData ()[aDim] + aBSDF.Kt.GetData ()[aDim], 1.f);
+        }
+      }
+
+      myAlbedos.push_back (anAlbedo);
+
+      myObjects.push_back (anIter->first);
+    }
+  }
+
+  //===========================================================================
+  //function : castRays
+  //purpose  :
+  //===========================================================================
+  void AovBuffers::castRays ()
+  {
+    myChannels.reserve (myChannels.size () + 8);
+
+    float* aChannels[] = { &addChannel ("Z", THE_BACKGROUND_DEPTH).Data[0],
+                           &addChannel ("normal.X").Data[0],
+                           &addChannel ("normal.Y").Data[0],
+                           &addChannel ("normal.Z").Data[0],
+                           &addChannel ("albedo.R").Data[0],
+                           &addChannel ("albedo.G").Data[0],
+                           &addChannel ("albedo.B").Data[0],
+                           &addChannel ("id").Data[0] };
+
+    if (myTriangles == NULL || myTriangles->Elements.empty ())
+    {
+      return;
+    }
+
+    myTriangles->MarkDirty ();
+
+    OSD_Parallel::For (0, mySizeY, RayCaster (*myTriangles, myAlbedos, myCamera, mySizeX, mySizeY, aChannels));
+  }
+
+  //===========================================================================
+  //function : WriteExr
+  //purpose  :
+  //===========================================================================
+  bool AovBuffers::WriteExr (const TCollection_AsciiString& theFileName) const
+  {
+    if (myChannels.empty ())
+    {
+      return false;
+    }
+
+    std::ofstream aFile (theFileName.ToCString (), std::ios::binary);
+
+    if (!aFile.is_open ())
+    {
+      return false;
+    }
+
+    // OpenEXR files are little-endian (as all supported platforms)
+    struct Writer
+    {
+      std::ofstream& File;
+
+      void Int (const int theValue) { File.write (reinterpret_cast<const char*> (&theValue), 4); }
+
+      void Float (const float theValue) { File.write (reinterpret_cast<const char*> (&theValue), 4); }
+
+      void String (const std::string& theValue) { File.write (theValue.c_str (), theValue.size () + 1); }
+
+      void Attribute (const std::string& theName, const std::string& theType, const int theSize)
+      {
+        String (theName);
+        String (theType);
+        Int (theSize);
+      }
+    };
+
+    Writer aWriter = { aFile };
+
+    aWriter.Int (20000630); // magic number
+    aWriter.Int (2);        // version 2, single-part scan line file
+
+    // Channel list (sorted by name)
+    int aListSize = 1;
+
+    for (size_t anIdx = 0; anIdx < myChannels.size (); ++anIdx)
+    {
+      aListSize += static_cast<int> (myChannels[anIdx].Name.size ()) + 1 + 16;
+    }
+
+    aWriter.Attribute ("channels", "chlist", aListSize);
+
+    for (size_t anIdx = 0; anIdx < myChannels.size (); ++anIdx)
+    {
+      aWriter.String (myChannels[anIdx].Name);
+      aWriter.Int (2); // FLOAT
+      aWriter.Int (0); // linear flag and reserved bytes
+      aWriter.Int (1); // x sampling
+      aWriter.Int (1); // y sampling
+    }
+
+    aFile.put (0);
+
+    aWriter.Attribute ("compression", "compression", 1);
+    aFile.put (0); // NO_COMPRESSION
+
+    for (int aWindow = 0; aWindow < 2; ++aWindow)
+    {
+      aWriter.Attribute (aWindow == 0 ? "dataWindow" : "displayWindow", "box2i", 16);
+      aWriter.Int (0);
+      aWriter.Int (0);
+      aWriter.Int (mySizeX - 1);
+      aWriter.Int (mySizeY - 1);
+    }
+
+    aWriter.Attribute ("lineOrder", "lineOrder", 1);
+    aFile.put (0); // INCREASING_Y
+
+    aWriter.Attribute ("pixelAspectRatio", "float", 4);
+    aWriter.Float (1.f);
+
+    aWriter.Attribute ("screenWindowCenter", "v2f", 8);
+    aWriter.Float (0.f);
+    aWriter.Float (0.f);
+
+    aWriter.Attribute ("screenWindowWidth", "float", 4);
+    aWriter.Float (1.f);
+
+    // Names of objects referenced by ID channel
+    std::string anObjects;
+
+    for (size_t anIdx = 0; anIdx < myObjects.size (); ++anIdx)
+    {
+      anObjects += (anIdx > 0 ? ";" : "") + std::to_string (anIdx + 1) + "=" + myObjects[anIdx].ToCString ();
+    }
+
+    aWriter.Attribute ("objects", "string", static_cast<int> (anObjects.size ()));
+    aFile.write (anObjects.c_str (), anObjects.size ());
+
+    aFile.put (0); // end of header
+
+    // Offset table (each block is a single scan line)
+    const int aLineSize = mySizeX * static_cast<int> (myChannels.size ()) * 4;
+
+    const unsigned long long aFirstLine = static_cast<unsigned long long> (aFile.tellp ()) + 8ULL * mySizeY;
+
+    for (int aRow = 0; aRow < mySizeY; ++aRow)
+    {
+      const unsigned long long anOffset = aFirstLine + static_cast<unsigned long long> (aRow) * (aLineSize + 8);
+
+      aFile.write (reinterpret_cast<const char*> (&anOffset), 8);
+    }
+
+    for (int aRow = 0; aRow < mySizeY; ++aRow)
+    {
+      aWriter.Int (aRow);
+      aWriter.Int (aLineSize);
+
+      for (size_t anIdx = 0; anIdx < myChannels.size (); ++anIdx)
+      {
+        aFile.write (reinterpret_cast<const char*> (&myChannels[anIdx].Data[static_cast<size_t> (aRow) * mySizeX]), mySizeX * 4);
+      }
+    }
+
+    return aFile.good ();
+  }
+}
@@ -0,0 +1,130 @@
+// Created: 2019-07-12
+//
+// Copyright (c) 2019 OPEN CASCADE SAS
+//
+// This file is a part of CADRays software.
+//
+// CADRays is free software; you can use it under the terms of the MIT license,
+// refer to file LICENSE.txt for complete text of the license and disclaimer of
+// any warranty.
+
+#ifndef _RT_AovBuffers_Header
+#define _RT_AovBuffers_Header
+
+#include <V3d_View.hxx>
+#include <BVH_Triangulation.hxx>
+#include <TCollection_AsciiString.hxx>
+
+#include <mutex>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace ie
+{
+  //! Linear HDR radiance and auxiliary buffers (AOVs) of the view for
+  //! compositing and denoising. Radiance is read from accumulation buffer
+  //! of path tracing. Depth, normal, albedo and object ID are not produced
+  //! by OCCT path tracer, so they are computed for primary rays on CPU
+  //! (using the same triangulations as GPU) without restart of rendering.
+  class AovBuffers
+  {
+  public:
+
+    //! Single float channel of the image (rows from top to bottom).
+    struct Channel
+    {
+      std::string        Name;
+      std::vector<float> Data;
+    };
+
+  public:
+
+    //! Creates empty buffers.
+    Standard_EXPORT AovBuffers ();
+
+    //! Reads radiance and computes auxiliary buffers of the view (or the
+    //! auxiliary buffers only). Returns false if the view has no image.
+    Standard_EXPORT bool Perform (const Handle (V3d_View)& theView, const bool toReadRadiance = true);
+
+    //! Reads radiance (optionally) and collects triangles of displayed objects.
+    //! Should be called from the main thread. Returns false if the view has no image.
+    Standard_EXPORT bool Prepare (const Handle (V3d_View)& theView, const bool toReadRadiance = true);
+
+    //! Computes auxiliary buffers collected by Prepare. Rays are cast once,
+    //! so the method can be called from any thread (e.g. before filtering).
+    Standard_EXPORT void Compute ();
+
+    //! Writes all channels to multi-channel OpenEXR file (uncompressed 32-bit
+    //! float): R, G, B (radiance), Z (view depth), normal.X/Y/Z (world space),
+    //! albedo.R/G/B and id (1-based index of object, 0 for background).
+    Standard_EXPORT bool WriteExr (const TCollection_AsciiString& theFileName) const;
+
+  public:
+
+    //! Returns width of buffers.
+    int SizeX () const { return mySizeX; }
+
+    //! Returns height of buffers.
+    int SizeY () const { return mySizeY; }
+
+    //! Returns channels sorted by name.
+    const std::vector<Channel>& Channels () const { return myChannels; }
+
+    //! Returns channel with the given name (NULL if not found).
+    Standard_EXPORT const Channel* Find (const std::string& theName) const;
+
+    //! Returns modifiable channel with the given name (NULL if not found).
+    Channel* ChangeChannel (const std::string& theName) { return const_cast<Channel*> (Find (theName)); }
+
+    //! Returns names of objects (ID of object is its index + 1).
+    const std::vector<TCollection_AsciiString>& Objects () const { return myObjects; }
+
+  protected:
+
+    //! Adds new channel filled with the given value.
+    Channel& addChannel (const std::string& theName, const float theValue = 0.f);
+
+    //! Reads linear radiance from accumulation buffer.
+    bool readRadiance (const Handle (V3d_View)& theView);
+
+    //! Collects triangles and albedo of displayed objects.
+    void collectTriangles ();
+
+    //! Casts primary rays to compute depth, normal, albedo and object ID.
+    void castRays ();
+
+  protected:
+
+    //! Width of buffers.
+    int mySizeX;
+
+    //! Height of buffers.
+    int mySizeY;
+
+    //! Channels of the image.
+    std::vector<Channel> myChannels;
+
+    //! Names of displayed objects.
+    std::vector<TCollection_AsciiString> myObjects;
+
+  protected:
+
+    //! Triangles of displayed objects (index of object is stored in elements).
+    std::shared_ptr<BVH_Triangulation<Standard_Real, 3> > myTriangles;
+
+    //! Albedo of displayed objects.
+    std::vector<BVH_Vec3f> myAlbedos;
+
+    //! Copy of the camera of the view.
+    Handle (Graphic3d_Camera) myCamera;
+
+    //! Set once auxiliary buffers are computed.
+    bool myIsComputed;
+
+    //! Guards computation of auxiliary buffers.
+    std::mutex myMutex;
+  };
+}
+
+#endif // _RT_AovBuffers_Header
@@ -0,0 +1,699 @@
+// Created: 2019-07-05
+//
+// Copyright (c) 2019 OPEN CASCADE SAS
+//
+// This file is a part of CADRays software.
+//
+// CADRays is free software; you can use it under the terms of the MIT license,
+// refer to file LICENSE.txt for complete text of the license and disclaimer of
+// any warranty.
+
+#include <AIS_InteractiveContext.hxx>
+#include <AIS_Shape.hxx>
+#include <Aspect_Window.hxx>
+#include <Graphic3d_CView.hxx>
+#include <Graphic3d_CameraTile.hxx>
+#include <Graphic3d_TextureEnv.hxx>
+#include <OSD_Directory.hxx>
+#include <OSD_File.hxx>
+#include <OSD_FileIterator.hxx>
+#include <OSD_Path.hxx>
+#include <OSD_Protection.hxx>
+#include <V3d_DirectionalLight.hxx>
+#include <V3d_PositionalLight.hxx>
+#include <ViewerTest.hxx>
+#include <ViewerTest_DoubleMapOfInteractiveAndName.hxx>
+#include <ViewerTest_DoubleMapIteratorOfDoubleMapOfInteractiveAndName.hxx>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <vector>
+
+#include "Utils.hxx"
+#include "Convergence.hxx"
+#include "Checkpoint.hxx"
+
+extern ViewerTest_DoubleMapOfInteractiveAndName& GetMapOfAIS ();
+
+namespace ie
+{
+  //! Signature of checkpoint files.
+  static const char THE_SIGNATURE[] = "CADRays checkpoint 2";
+
+  //! Minimum number of samples worth storing.
+  static const int THE_MIN_SAMPLES = 16;
+
+  std::shared_ptr<Checkpoint> Checkpoint::myInstance;
+
+  //===========================================================================
+  //function : filmicCurve
+  //purpose  : Filmic tone mapping curve of OCCT path tracing
+  //===========================================================================
+  static float filmicCurve (const float theValue)
+  {
+    const float aCurve = 1.425f * theValue + 0.05f;
+
+    return (theValue * aCurve + 0.004f) / (theValue * (aCurve + 0.55f) + 0.0491f) - 0.0821f;
+  }
+
+  //===========================================================================
+  //function : viewSize
+  //purpose  : Returns size of the image rendered by the view
+  //===========================================================================
+  static void viewSize (const Handle (V3d_View)& theView, Standard_Integer& theSizeX, Standard_Integer& theSizeY)
+  {
+    const Handle (Standard_Transient) anFBO = theView->View ()->FBO ();
+
+    if (!anFBO.IsNull ())
+    {
+      Standard_Integer aSizeXMax = 0;
+      Standard_Integer aSizeYMax = 0;
+
+      theView->View ()->FBOGetDimensions (anFBO, theSizeX, theSizeY, aSizeXMax, aSizeYMax);
+    }
+    else
+    {
+      theView->Window ()->Size (theSizeX, theSizeY);
+    }
+  }
+
+  //===========================================================================
+  //function : hashString
+  //purpose  : Computes FNV-1a hash (stable across sessions and platforms)
+  //===========================================================================
+  static size_t hashString (const std::string& theString)
+  {
+    unsigned long long aHash = 14695981039346656037ULL;
+
+    for (size_t anIdx = 0; anIdx < theString.size (); ++anIdx)
+    {
+      aHash ^= static_cast<unsigned char> (theString[anIdx]);
+      aHash *= 1099511628211ULL;
+    }
+
+    return static_cast<size_t> (aHash);
+  }
+
+  //===========================================================================
+  //function : Checkpoint
+  //purpose  :
+  //===========================================================================
+  Checkpoint::Checkpoint ()
+    : myIsEnabled (false),
+      myDirectory ("checkpoints"),
+      myInterval (60.0),
+      myFingerprint (0),
+      myNbRestoredSamples (0),
+      myRevision (0),
+      myExposureScale (1.f),
+      myWhitePoint (1.f),
+      myIsFilmic (false),
+      myIsConvergedWritten (false)
+  {
+    //
+  }
+
+  //===========================================================================
+  //function : GetInstance
+  //purpose  :
+  //===========================================================================
+  Checkpoint* Checkpoint::GetInstance ()
+  {
+    if (myInstance == NULL)
+    {
+      myInstance.reset (new Checkpoint);
+    }
+
+    return myInstance.get ();
+  }
+
+  //===========================================================================
+  //function : SetDirectory
+  //purpose  :
+  //===========================================================================
+  void Checkpoint::SetDirectory (const TCollection_AsciiString& theDirectory)
+  {
+    myDirectory = theDirectory;
+
+    // Remove trailing separators
+    while (myDirectory.Length () > 1 && (myDirectory.Value (myDirectory.Length ()) == '/'
+                                      || myDirectory.Value (myDirectory.Length ()) == '\\'))
+    {
+      myDirectory.Trunc (myDirectory.Length () - 1);
+    }
+  }
+
+  //===========================================================================
+  //function : filePath
+  //purpose  :
+  //===========================================================================
+  TCollection_AsciiString Checkpoint::filePath (const size_t theFingerprint) const
+  {
+    std::ostringstream aName;
+
+    aName << std::hex << static_cast<unsigned long long> (theFingerprint);
+
+    return myDirectory + "/" + aName.str ().c_str () + ".ckpt";
+  }
+
+  //===========================================================================
+  //function : Fingerprint
+  //purpose  :
+  //===========================================================================
+  size_t Checkpoint::Fingerprint (const Handle (V3d_View)& theView)
+  {
+    std::ostringstream aStream;
+
+    aStream.precision (9);
+
+    // Displayed objects (sorted by name)
+    Handle (AIS_InteractiveContext) aContext = ViewerTest::GetAISContext ();
+
+    std::map<std::string, std::string> anObjects;
+
+    for (ViewerTest_DoubleMapIteratorOfDoubleMapOfInteractiveAndName anIter (GetMapOfAIS ()); anIter.More (); anIter.Next ())
+    {
+      const Handle (AIS_InteractiveObject) anObject = Handle (AIS_InteractiveObject)::DownCast (anIter.Key1 ());
+
+      if (anObject.IsNull () || aContext.IsNull () || !aContext->IsDisplayed (anObject))
+      {
+        continue;
+      }
+
+      std::ostringstream anObjectStream;
+
+      anObjectStream.precision (9);
+
+      const gp_Trsf& aTrsf = anObject->LocalTransformation ();
+
+      for (int aRow = 1; aRow <= 3; ++aRow)
+      {
+        for (int aCol = 1; aCol <= 4; ++aCol)
+        {
+          anObjectStream << aTrsf.Value (aRow, aCol) << " ";
+        }
+      }
+
+      Handle (AIS_Shape) aShape = Handle (AIS_Shape)::DownCast (anObject);
+
+      if (!aShape.IsNull () && !aShape->BoundingBox ().IsVoid ())
+      {
+        double aMinMax[6];
+
+        aShape->BoundingBox ().Get (aMinMax[0], aMinMax[1], aMinMax[2],
+                                    aMinMax[3], aMinMax[4], aMinMax[5]);
+
+        for (int aCoord = 0; aCoord < 6; ++aCoord)
+        {
+          anObjectStream << aMinMax[aCoord] << " ";
+        }
+      }
+
+      Graphic3d_AspectFillArea3d* anAspect = model::GetAspect (anObject);
+
+      if (anAspect != NULL)
+      {
+        anObjectStream << model::SerializeBSDF (anAspect->FrontMaterial ().BSDF ()) << " ";
+
+        Handle (Graphic3d_TextureRoot) aTexMap = Handle (Graphic3d_TextureRoot)::DownCast (anAspect->TextureMap ());
+
+        if (!aTexMap.IsNull () && anAspect->ToMapTexture ())
+        {
+          TCollection_AsciiString aTexturePath;
+
+          aTexMap->Path ().SystemName (aTexturePath);
+
+          anObjectStream << aTexturePath;
+        }
+      }
+
+      anObjects[anIter.Key2 ().ToCString ()] = anObjectStream.str ();
+    }
+
+    for (std::map<std::string, std::string>::const_iterator anIter = anObjects.begin (); anIter != anObjects.end (); ++anIter)
+    {
+      aStream << anIter->first << ":" << anIter->second << "\n";
+    }
+
+    // Light sources
+    for (V3d_ListOfLightIterator aLightIter (theView->ActiveLightIterator ()); aLightIter.More (); aLightIter.Next ())
+    {
+      const Handle (V3d_Light)& aLight = aLightIter.Value ();
+
+      aStream << "light " << aLight->Type () << " " << aLight->Intensity () << " " << aLight->Smoothness ()
+              << " " << aLight->Headlight () << " " << aLight->Color ().Red ()
+              << " " << aLight->Color ().Green () << " " << aLight->Color ().Blue ();
+
+      double aVec[3] = { 0.0, 0.0, 0.0 };
+
+      if (aLight->Type () == V3d_DIRECTIONAL)
+      {
+        Handle (V3d_DirectionalLight)::DownCast (aLight)->Direction (aVec[0], aVec[1], aVec[2]);
+      }
+      else if (aLight->Type () == V3d_POSITIONAL)
+      {
+        Handle (V3d_PositionalLight)::DownCast (aLight)->Position (aVec[0], aVec[1], aVec[2]);
+      }
+
+      aStream << " " << aVec[0] << " " << aVec[1] << " " << aVec[2] << "\n";
+    }
+
+    if (!theView->TextureEnv ().IsNull ())
+    {
+      aStream << "env " << theView->TextureEnv ()->Path ().Name () << theView->TextureEnv ()->Path ().Extension () << "\n";
+    }
+
+    // Camera
+    const Handle (Graphic3d_Camera)& aCamera = theView->Camera ();
+
+    aStream << "camera " << aCamera->Eye ().X ()    << " " << aCamera->Eye ().Y ()    << " " << aCamera->Eye ().Z ()
+            << " "       << aCamera->Center ().X () << " " << aCamera->Center ().Y () << " " << aCamera->Center ().Z ()
+            << " "       << aCamera->Up ().X ()     << " " << aCamera->Up ().Y ()     << " " << aCamera->Up ().Z ()
+            << " "       << aCamera->FOVy ()        << " " << aCamera->Scale ()       << " " << aCamera->Aspect ()
+            << " "       << aCamera->ProjectionType () << "\n";
+
+    // Sub-frustum of tiled rendering
+    const Graphic3d_CameraTile& aTile = aCamera->Tile ();
+
+    if (aTile.IsValid ())
+    {
+      aStream << "tile " << aTile.TotalSize.x () << " " << aTile.TotalSize.y ()
+              << " "     << aTile.Offset.x ()    << " " << aTile.Offset.y () << " " << aTile.IsTopDown << "\n";
+    }
+
+    // Rendering parameters and image size
+    const Graphic3d_RenderingParams& aParams = theView->RenderingParams ();
+
+    Standard_Integer aSizeX = 0;
+    Standard_Integer aSizeY = 0;
+
+    viewSize (theView, aSizeX, aSizeY);
+
+    aStream << "params " << aParams.Method
+            << " " << aParams.IsGlobalIlluminationEnabled
+            << " " << aParams.RaytracingDepth
+            << " " << aParams.CoherentPathTracingMode
+            << " " << aParams.AdaptiveScreenSampling
+            << " " << aParams.RadianceClampingValue
+            << " " << aParams.UseEnvironmentMapBackground
+            << " " << aParams.CameraApertureRadius
+            << " " << aParams.CameraFocalPlaneDist
+            << " " << aSizeX << "x" << aSizeY << "\n";
+
+    return hashString (aStream.str ());
+  }
+
+  //===========================================================================
+  //function : Update
+  //purpose  :
+  //===========================================================================
+  void Checkpoint::Update (const Handle (V3d_View)& theView)
+  {
+    Convergence* aConvergence = Convergence::GetInstance ();
+
+    if (!myIsEnabled || !aConvergence->IsActive ())
+    {
+      return;
+    }
+
+    // Stored radiance is linear, tone mapping is applied to display images
+    const Graphic3d_RenderingParams& aParams = theView->RenderingParams ();
+
+    const float anExposureScale = std::pow (2.f, aParams.Exposure);
+
+    const bool isFilmic = aParams.ToneMappingMethod == Graphic3d_ToneMappingMethod_Filmic;
+
+    if (anExposureScale != myExposureScale || aParams.WhitePoint != myWhitePoint || isFilmic != myIsFilmic)
+    {
+      myExposureScale = anExposureScale;
+      myWhitePoint    = aParams.WhitePoint;
+      myIsFilmic      = isFilmic;
+
+      if (myNbRestoredSamples > 0)
+      {
+        ++myRevision;
+      }
+    }
+
+    if (aConvergence->NbSamples () == 1) // accumulation was restarted
+    {
+      const bool wasRestored = myNbRestoredSamples > 0;
+
+      myFingerprint = Fingerprint (theView);
+
+      myNbRestoredSamples = 0;
+
+      if (restore (theView))
+      {
+        aConvergence->SetRestoredSamples (myNbRestoredSamples);
+      }
+      else
+      {
+        myRestoredImage.Clear ();
+      }
+
+      if (wasRestored || myNbRestoredSamples > 0)
+      {
+        ++myRevision;
+      }
+
+      myIsConvergedWritten = false;
+
+      myTimer.Reset ();
+      myTimer.Start ();
+
+      return;
+    }
+
+    const bool toWrite = myTimer.ElapsedTime () >= myInterval
+                      || (aConvergence->IsConverged () && !myIsConvergedWritten);
+
+    if (toWrite)
+    {
+      Write (theView);
+
+      myIsConvergedWritten = aConvergence->IsConverged ();
+
+      myTimer.Reset ();
+      myTimer.Start ();
+    }
+  }
+
+  //===========================================================================
+  //function : restore
+  //purpose  :
+  //===========================================================================
+  bool Checkpoint::restore (const Handle (V3d_View)& theView)
+  {
+    std::ifstream aFile (filePath (myFingerprint).ToCString (), std::ios::binary);
+
+    if (!aFile.is_open ())
+    {
+      return false;
+    }
+
+    std::string aSignature;
+
+    std::getline (aFile, aSignature);
+
+    unsigned long long aFingerprint = 0;
+
+    int aNbSamples = 0;
+    int aSizeX = 0;
+    int aSizeY = 0;
+
+    aFile >> aFingerprint >> aNbSamples >> aSizeX >> aSizeY;
+
+    aFile.ignore (1); // end of header line
+
+    Standard_Integer aViewSizeX = 0;
+    Standard_Integer aViewSizeY = 0;
+
+    viewSize (theView, aViewSizeX, aViewSizeY);
+
+    if (!aFile || aSignature != THE_SIGNATURE || aFingerprint != myFingerprint
+     || aSizeX != aViewSizeX || aSizeY != aViewSizeY || aNbSamples <= 0)
+    {
+      return false;
+    }
+
+    if (!myRestoredImage.InitTrash (Image_PixMap::ImgRGBF, aSizeX, aSizeY))
+    {
+      return false;
+    }
+
+    for (Standard_Size aRow = 0; aRow < myRestoredImage.SizeY (); ++aRow)
+    {
+      aFile.read (reinterpret_cast<char*> (myRestoredImage.ChangeRow (aRow)), aSizeX * 3 * sizeof (float));
+    }
+
+    if (!aFile)
+    {
+      std::cout << "Warning: Checkpoint file " << filePath (myFingerprint) << " is damaged" << std::endl;
+
+      return false;
+    }
+
+    myNbRestoredSamples = aNbSamples;
+
+    std::cout << "Info: Resuming accumulation from checkpoint (" << aNbSamples << " samples)" << std::endl;
+
+    return true;
+  }
+
+  //===========================================================================
+  //function : Write
+  //purpose  :
+  //===========================================================================
+  bool Checkpoint::Write (const Handle (V3d_View)& theView)
+  {
+    Convergence* aConvergence = Convergence::GetInstance ();
+
+    if (!myIsEnabled || !aConvergence->IsActive () || aConvergence->NbSamples () < THE_MIN_SAMPLES)
+    {
+      return false;
+    }
+
+    // Scene may be changed without restart of convergence tracker (e.g. by
+    // material editor), then samples are counted from unknown frame
+    if (Fingerprint (theView) != myFingerprint)
+    {
+      aConvergence->Reset ();
+
+      return false;
+    }
+
+    Standard_Integer aSizeX = 0;
+    Standard_Integer aSizeY = 0;
+
+    viewSize (theView, aSizeX, aSizeY);
+
+    Image_PixMap anImage;
+
+    // Accumulation buffer keeps linear radiance (displayed image is tone mapped)
+    if (!anImage.InitZero (Image_PixMap::ImgRGBF, aSizeX, aSizeY)
+     || !theView->View ()->BufferDump (anImage, Graphic3d_BT_RGB_RayTraceHdrLeft))
+    {
+      return false;
+    }
+
+    Combine (anImage, true);
+
+    OSD_Directory aDirectory ((OSD_Path (myDirectory)));
+
+    if (!aDirectory.Exists ())
+    {
+      aDirectory.Build (OSD_Protection ());
+
+      if (aDirectory.Failed ())
+      {
+        std::cout << "Warning: Failed to create checkpoint directory " << myDirectory << std::endl;
+
+        return false;
+      }
+    }
+
+    const TCollection_AsciiString aPath = filePath (myFingerprint);
+
+    // Write to temporary file first, so that crash does not damage previous checkpoint
+    const TCollection_AsciiString aTmpPath = aPath + ".tmp";
+
+    {
+      std::ofstream aFile (aTmpPath.ToCString (), std::ios::binary);
+
+      if (!aFile.is_open ())
+      {
+        return false;
+      }
+
+      aFile << THE_SIGNATURE << "\n"
+            << static_cast<unsigned long long> (myFingerprint) << " " << aConvergence->NbTotalSamples ()
+            << " " << aSizeX << " " << aSizeY << "\n";
+
+      for (Standard_Size aRow = 0; aRow < anImage.SizeY (); ++aRow)
+      {
+        aFile.write (reinterpret_cast<const char*> (anImage.Row (aRow)), aSizeX * 3 * sizeof (float));
+      }
+
+      if (!aFile.good ())
+      {
+        return false;
+      }
+    }
+
+    std::remove (aPath.ToCString ());
+
+    return std::rename (aTmpPath.ToCString (), aPath.ToCString ()) == 0;
+  }
+
+  //===========================================================================
+  //function : toDisplay
+  //purpose  :
+  //===========================================================================
+  float Checkpoint::toDisplay (const float theRadiance) const
+  {
+    float aValue = theRadiance * myExposureScale;
+
+    if (myIsFilmic)
+    {
+      aValue = filmicCurve (aValue) / filmicCurve (myWhitePoint);
+    }
+
+    // Gamma correction (gamma = 2), displayed image is stored in 8-bit buffer
+    return std::sqrt (std::max (0.f, std::min (aValue, 1.f)));
+  }
+
+  //===========================================================================
+  //function : toRadiance
+  //purpose  :
+  //===========================================================================
+  float Checkpoint::toRadiance (const float theValue) const
+  {
+    float aValue = theValue * theValue;
+
+    if (myIsFilmic)
+    {
+      // Filmic curve is a ratio of quadratic polynomials, so it is inverted
+      // by solving quadratic equation (the curve approaches 1 at infinity)
+      const float aTarget = std::min (aValue * filmicCurve (myWhitePoint) + 0.0821f, 0.999f);
+
+      const float aA = 1.425f * (1.f - aTarget);
+      const float aB = 0.05f - 0.6f * aTarget;
+      const float aC = 0.004f - 0.0491f * aTarget;
+
+      aValue = std::max (0.f, (-aB + std::sqrt (std::max (aB * aB - 4.f * aA * aC, 0.f))) / (2.f * aA));
+    }
+
+    return aValue / myExposureScale;
+  }
+
+  //===========================================================================
+  //function : ToDisplay
+  //purpose  :
+  //===========================================================================
+  void Checkpoint::ToDisplay (Image_PixMap& theImage) const
+  {
+    if (theImage.Format () != Image_PixMap::ImgRGBF)
+    {
+      return;
+    }
+
+    for (Standard_Size aRow = 0; aRow < theImage.SizeY (); ++aRow)
+    {
+      float* aPixel = reinterpret_cast<float*> (theImage.ChangeRow (aRow));
+
+      for (Standard_Size anIdx = 0; anIdx < theImage.SizeX () * 3; ++anIdx)
+      {
+        aPixel[anIdx] = toDisplay (aPixel[anIdx]);
+      }
+    }
+  }
+
+  //===========================================================================
+  //function : Combine
+  //purpose  :
+  //===========================================================================
+  void Checkpoint::Combine (Image_PixMap& theImage, const bool theIsLinear) const
+  {
+    if (myNbRestoredSamples <= 0
+     || theImage.SizeX () != myRestoredImage.SizeX ()
+     || theImage.SizeY () != myRestoredImage.SizeY ())
+    {
+      return;
+    }
+
+    const int aNbSamples = Convergence::GetInstance ()->NbSamples ();
+
+    const float aWeight = static_cast<float> (myNbRestoredSamples) / (myNbRestoredSamples + std::max (aNbSamples, 0));
+
+    bool isFloat = false;
+    bool isBGR   = false;
+
+    switch (theImage.Format ())
+    {
+      case Image_PixMap::ImgRGB:
+      case Image_PixMap::ImgRGB32:
+      case Image_PixMap::ImgRGBA:
+        break;
+      case Image_PixMap::ImgBGR:
+      case Image_PixMap::ImgBGR32:
+      case Image_PixMap::ImgBGRA:
+        isBGR = true;
+        break;
+      case Image_PixMap::ImgRGBF:
+      case Image_PixMap::ImgRGBAF:
+        isFloat = true;
+        break;
+      case Image_PixMap::ImgBGRF:
+      case Image_PixMap::ImgBGRAF:
+        isFloat = true;
+        isBGR   = true;
+        break;
+      default:
+        return;
+    }
+
+    const Standard_Size aStride = theImage.SizePixelBytes () / (isFloat ? sizeof (float) : 1);
+
+    for (Standard_Size aRow = 0; aRow < theImage.SizeY (); ++aRow)
+    {
+      const float* aRestored = reinterpret_cast<const float*> (myRestoredImage.Row (aRow));
+
+      for (Standard_Size aCol = 0; aCol < theImage.SizeX (); ++aCol, aRestored += 3)
+      {
+        for (int aChannel = 0; aChannel < 3; ++aChannel)
+        {
+          const float aValue = aRestored[isBGR ? 2 - aChannel : aChannel];
+
+          if (isFloat)
+          {
+            float* aPixel = reinterpret_cast<float*> (theImage.ChangeRow (aRow)) + aCol * aStride;
+
+            const float aCurrent = theIsLinear ? aPixel[aChannel] : toRadiance (aPixel[aChannel]);
+
+            const float aMixed = aCurrent * (1.f - aWeight) + aValue * aWeight;
+
+            aPixel[aChannel] = theIsLinear ? aMixed : toDisplay (aMixed);
+          }
+          else
+          {
+            Standard_Byte* aPixel = theImage.ChangeRow (aRow) + aCol * aStride;
+
+            const float aCurrent = theIsLinear ? aPixel[aChannel] / 255.f : toRadiance (aPixel[aChannel] / 255.f);
+
+            const float aMixed = aCurrent * (1.f - aWeight) + aValue * aWeight;
+
+            aPixel[aChannel] = static_cast<Standard_Byte> (std::max (0.f, std::min ((theIsLinear ? aMixed : toDisplay (aMixed)) * 255.f + 0.5f, 255.f)));
+          }
+        }
+      }
+    }
+  }
+
+  //===========================================================================
+  //function : Clear
+  //purpose  :
+  //===========================================================================
+  void Checkpoint::Clear ()
+  {
+    std::vector<TCollection_AsciiString> aFiles;
+
+    for (OSD_FileIterator anIter (OSD_Path (myDirectory), "*.ckpt"); anIter.More (); anIter.Next ())
+    {
+      OSD_Path aPath;
+
+      anIter.Values ().Path (aPath);
+
+      aFiles.push_back (myDirectory + "/" + aPath.Name () + aPath.Extension ());
+    }
+
+    for (size_t anIdx = 0; anIdx < aFiles.size (); ++anIdx)
+    {
+      OSD_File (aFiles[anIdx]).Remove ();
+    }
+  }
+}
@@ -0,0 +1,158 @@
+// Created: 2019-07-05
+//
+// Copyright (c) 2019 OPEN CASCADE SAS
+//
+// This file is a part of CADRays software.
+//
+// CADRays is free software; you can use it under the terms of the MIT license,
+// refer to file LICENSE.txt for complete text of the license and disclaimer of
+// any warranty.
+
+#ifndef _RT_Checkpoint_Header
+#define _RT_Checkpoint_Header
+
+#include <V3d_View.hxx>
+#include <Image_PixMap.hxx>
+#include <OSD_Timer.hxx>
+#include <TCollection_AsciiString.hxx>
+
+#include <memory>
+
+namespace ie
+{
+  //! Periodically stores progressive render (averaged linear radiance and number
+  //! of samples) on disk and resumes it when the same scene is rendered with the
+  //! same camera, view size and rendering parameters. Accumulation buffers of
+  //! OCCT can not be restored, so the stored image is blended with the image
+  //! accumulated after restart weighted by the numbers of samples. Blending is
+  //! done in linear space, tone mapping is applied for display images only.
+  class Checkpoint
+  {
+  public:
+
+    //! Returns the instance of checkpoint manager.
+    static Standard_EXPORT Checkpoint* GetInstance ();
+
+  public:
+
+    //! Checks whether checkpoints are enabled.
+    bool IsEnabled () const { return myIsEnabled; }
+
+    //! Enables or disables checkpoints.
+    void SetEnabled (const bool theToEnable) { myIsEnabled = theToEnable; }
+
+    //! Returns directory of checkpoint files.
+    const TCollection_AsciiString& Directory () const { return myDirectory; }
+
+    //! Sets directory of checkpoint files (created on first write).
+    Standard_EXPORT void SetDirectory (const TCollection_AsciiString& theDirectory);
+
+    //! Returns interval between checkpoints (in seconds).
+    double Interval () const { return myInterval; }
+
+    //! Sets interval between checkpoints (in seconds).
+    void SetInterval (const double theInterval) { myInterval = theInterval; }
+
+  public:
+
+    //! Returns number of samples restored from checkpoint (0 if not resumed).
+    int NbRestoredSamples () const { return myNbRestoredSamples; }
+
+    //! Returns image restored from checkpoint (linear RGB float, top-down rows).
+    const Image_PixMap& RestoredImage () const { return myRestoredImage; }
+
+    //! Returns counter incremented each time the restored image or tone mapping is changed.
+    int Revision () const { return myRevision; }
+
+    //! Registers the frame just rendered by the view. Should be called from
+    //! the main thread after Convergence::Update. Looks for checkpoint once
+    //! accumulation is restarted and writes checkpoints periodically.
+    Standard_EXPORT void Update (const Handle (V3d_View)& theView);
+
+    //! Writes checkpoint of current accumulation. Returns false on error.
+    Standard_EXPORT bool Write (const Handle (V3d_View)& theView);
+
+    //! Blends restored image into the given image of current accumulation
+    //! (RGB or RGBA image, 8-bit or float). Linear image is the accumulation
+    //! buffer of path tracing (Graphic3d_BT_RGB_RayTraceHdrLeft). Otherwise,
+    //! the image is displayed one (Graphic3d_BT_RGB): it is converted to
+    //! linear space for blending and tone mapped back.
+    Standard_EXPORT void Combine (Image_PixMap& theImage, const bool theIsLinear = false) const;
+
+    //! Converts the given linear image (RGB float) to displayed values using
+    //! exposure and tone mapping of the view at the last update.
+    Standard_EXPORT void ToDisplay (Image_PixMap& theImage) const;
+
+    //! Removes all checkpoint files.
+    Standard_EXPORT void Clear ();
+
+  public:
+
+    //! Computes fingerprint of the scene (names, locations, bounds and
+    //! materials of displayed objects), lights, camera and rendering
+    //! parameters. Unlike Fingerprints, the value is stable across sessions.
+    Standard_EXPORT static size_t Fingerprint (const Handle (V3d_View)& theView);
+
+  protected:
+
+    //! Creates new checkpoint manager.
+    Checkpoint ();
+
+    //! Returns path of checkpoint file for the given fingerprint.
+    TCollection_AsciiString filePath (const size_t theFingerprint) const;
+
+    //! Reads checkpoint matching current fingerprint and view size.
+    bool restore (const Handle (V3d_View)& theView);
+
+    //! Converts linear radiance to displayed value (as OCCT display shader).
+    float toDisplay (const float theRadiance) const;
+
+    //! Converts displayed value back to linear radiance.
+    float toRadiance (const float theValue) const;
+
+  protected:
+
+    //! Set when checkpoints are enabled.
+    bool myIsEnabled;
+
+    //! Directory of checkpoint files.
+    TCollection_AsciiString myDirectory;
+
+    //! Interval between checkpoints (in seconds).
+    double myInterval;
+
+    //! Fingerprint of current accumulation.
+    size_t myFingerprint;
+
+    //! Image restored from checkpoint.
+    Image_PixMap myRestoredImage;
+
+    //! Number of samples of restored image.
+    int myNbRestoredSamples;
+
+    //! Revision of restored image.
+    int myRevision;
+
+    //! Exposure scale of the view (2 ^ exposure).
+    float myExposureScale;
+
+    //! White point of filmic tone mapping.
+    float myWhitePoint;
+
+    //! Set when filmic tone mapping is used.
+    bool myIsFilmic;
+
+    //! Measures time since the last checkpoint.
+    OSD_Timer myTimer;
+
+    //! Set when checkpoint of converged image is written.
+    bool myIsConvergedWritten;
+
+  private:
+
+    //! Instance of checkpoint manager.
+    static std::shared_ptr<Checkpoint> myInstance;
+  };
+}
+
+#endif // _RT_Checkpoint_Header
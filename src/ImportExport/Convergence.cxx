@@ -0,0 +1,254 @@
+// Created: 2019-07-02
+//
+// Copyright (c) 2019 OPEN CASCADE SAS
+//
+// This file is a part of CADRays software.
+//
+// CADRays is free software; you can use it under the terms of the MIT license,
+// refer to file LICENSE.txt for complete text of the license and disclaimer of
+// any warranty.
+
+#include <Aspect_Window.hxx>
+#include <Graphic3d_CView.hxx>
+#include <Image_PixMap.hxx>
+
+#include <cmath>
+#include <algorithm>
+
+#include "Convergence.hxx"
+
+namespace ie
+{
+  //! Number of samples at the first noise estimation (doubled for each next one).
+  static const int THE_NOISE_INTERVAL = 16;
+
+  //! Step between pixels used for noise estimation.
+  static const int THE_NOISE_STRIDE = 4;
+
+  std::shared_ptr<Convergence> Convergence::myInstance;
+
+  //===========================================================================
+  //function : operator!=
+  //purpose  :
+  //===========================================================================
+  bool Convergence::ViewState::operator!= (const ViewState& theOther) const
+  {
+    return WorldView  != theOther.WorldView
+        || Projection != theOther.Projection
+        || SizeX      != theOther.SizeX
+        || SizeY      != theOther.SizeY
+        || NbObjects  != theOther.NbObjects
+        || Depth      != theOther.Depth
+        || IsActive   != theOther.IsActive
+        || IsCoherent != theOther.IsCoherent
+        || IsAdaptive != theOther.IsAdaptive;
+  }
+
+  //===========================================================================
+  //function : Convergence
+  //purpose  :
+  //===========================================================================
+  Convergence::Convergence ()
+    : myMaxSamples (0),
+      myMaxTime (0.0),
+      myMaxNoise (0.0),
+      myNbSamples (0),
+      myRestoredSamples (0),
+      myNoise (-1.0),
+      mySnapshotSamples (0),
+      myNextEstimation (THE_NOISE_INTERVAL),
+      myIsActive (false),
+      myIsConverged (false),
+      myIsContinued (false),
+      myToReset (true)
+  {
+    myState = ViewState ();
+  }
+
+  //===========================================================================
+  //function : GetInstance
+  //purpose  :
+  //===========================================================================
+  Convergence* Convergence::GetInstance ()
+  {
+    if (myInstance == NULL)
+    {
+      myInstance.reset (new Convergence);
+    }
+
+    return myInstance.get ();
+  }
+
+  //===========================================================================
+  //function : Progress
+  //purpose  :
+  //===========================================================================
+  double Convergence::Progress () const
+  {
+    double aProgress = 0.0;
+
+    if (myMaxSamples > 0)
+    {
+      aProgress = std::max (aProgress, static_cast<double> (NbTotalSamples ()) / myMaxSamples);
+    }
+
+    if (myMaxTime > 0.0)
+    {
+      aProgress = std::max (aProgress, ElapsedTime () / myMaxTime);
+    }
+
+    if (myMaxNoise > 0.0 && myNoise > 0.0)
+    {
+      // Noise decreases as inverse square root of number of samples
+      aProgress = std::max (aProgress, (myMaxNoise * myMaxNoise) / (myNoise * myNoise));
+    }
+
+    return std::min (aProgress, 1.0);
+  }
+
+  //===========================================================================
+  //function : viewState
+  //purpose  :
+  //===========================================================================
+  Convergence::ViewState Convergence::viewState (const Handle (V3d_View)& theView)
+  {
+    const Graphic3d_RenderingParams& aParams = theView->RenderingParams ();
+
+    ViewState aState;
+
+    aState.WorldView  = theView->Camera ()->WorldViewState ();
+    aState.Projection = theView->Camera ()->ProjectionState ();
+    aState.NbObjects  = theView->View ()->NumberOfDisplayedStructures ();
+    aState.Depth      = aParams.RaytracingDepth;
+    aState.IsActive   = aParams.Method == Graphic3d_RM_RAYTRACING && aParams.IsGlobalIlluminationEnabled;
+    aState.IsCoherent = aParams.CoherentPathTracingMode != Standard_False;
+    aState.IsAdaptive = aParams.AdaptiveScreenSampling != Standard_False;
+
+    theView->Window ()->Size (aState.SizeX, aState.SizeY);
+
+    return aState;
+  }
+
+  //===========================================================================
+  //function : IsOutdated
+  //purpose  :
+  //===========================================================================
+  bool Convergence::IsOutdated (const Handle (V3d_View)& theView) const
+  {
+    return myToReset || viewState (theView) != myState;
+  }
+
+  //===========================================================================
+  //function : Update
+  //purpose  :
+  //===========================================================================
+  bool Convergence::Update (const Handle (V3d_View)& theView)
+  {
+    const ViewState aState = viewState (theView);
+
+    if (myToReset || aState != myState)
+    {
+      myState = aState;
+
+      myNbSamples = 0;
+      myRestoredSamples = 0;
+      myNoise = -1.0;
+
+      mySnapshot.clear ();
+      mySnapshotSamples = 0;
+      myNextEstimation = THE_NOISE_INTERVAL;
+
+      myIsConverged = false;
+      myIsContinued = false;
+      myToReset = false;
+
+      myTimer.Reset ();
+      myTimer.Start ();
+    }
+
+    myIsActive = aState.IsActive;
+
+    if (!myIsActive)
+    {
+      return false;
+    }
+
+    ++myNbSamples;
+
+    if (myMaxNoise > 0.0 && myNbSamples >= myNextEstimation)
+    {
+      estimateNoise (theView);
+
+      myNextEstimation = myNbSamples * 2;
+    }
+
+    // Noise is estimated for samples of current session only (overestimated if resumed)
+    myIsConverged = (myMaxSamples > 0 && NbTotalSamples () >= myMaxSamples)
+                 || (myMaxTime > 0.0 && ElapsedTime () >= myMaxTime)
+                 || (myMaxNoise > 0.0 && myNoise >= 0.0 && myNoise <= myMaxNoise);
+
+    return myIsConverged && !myIsContinued;
+  }
+
+  //===========================================================================
+  //function : estimateNoise
+  //purpose  :
+  //===========================================================================
+  void Convergence::estimateNoise (const Handle (V3d_View)& theView)
+  {
+    Image_PixMap anImage;
+
+    // Accumulation buffer is used, since quantization error of 8-bit
+    // displayed image exceeds the difference of snapshots at low noise
+    if (!anImage.InitZero (Image_PixMap::ImgRGBF, myState.SizeX, myState.SizeY)
+     || !theView->View ()->BufferDump (anImage, Graphic3d_BT_RGB_RayTraceHdrLeft))
+    {
+      return;
+    }
+
+    std::vector<float> aSnapshot;
+
+    aSnapshot.reserve ((anImage.SizeX () / THE_NOISE_STRIDE + 1) * (anImage.SizeY () / THE_NOISE_STRIDE + 1));
+
+    double aMean = 0.0;
+
+    for (Standard_Size aRow = 0; aRow < anImage.SizeY (); aRow += THE_NOISE_STRIDE)
+    {
+      for (Standard_Size aCol = 0; aCol < anImage.SizeX (); aCol += THE_NOISE_STRIDE)
+      {
+        const float* aPixel = reinterpret_cast<const float*> (anImage.RawValue (aRow, aCol));
+
+        aSnapshot.push_back (0.2126f * aPixel[0] + 0.7152f * aPixel[1] + 0.0722f * aPixel[2]);
+
+        aMean += aSnapshot.back ();
+      }
+    }
+
+    aMean /= std::max (aSnapshot.size (), static_cast<size_t> (1));
+
+    if (mySnapshot.size () == aSnapshot.size () && mySnapshotSamples > 0 && myNbSamples > mySnapshotSamples && aMean > 0.0)
+    {
+      double anError = 0.0;
+
+      for (size_t aPixelIdx = 0; aPixelIdx < aSnapshot.size (); ++aPixelIdx)
+      {
+        const double aDelta = aSnapshot[aPixelIdx] - mySnapshot[aPixelIdx];
+
+        anError += aDelta * aDelta;
+      }
+
+      anError /= std::max (aSnapshot.size (), static_cast<size_t> (1));
+
+      // For averages of N1 and N2 samples E[(I2 - I1)^2] = s^2 * (1 / N1 - 1 / N2),
+      // where s^2 is the variance of single sample; noise of I2 is s / sqrt (N2).
+      // Radiance is not bounded, so noise is measured relative to mean luminance
+      const double aVariance = anError / (1.0 / mySnapshotSamples - 1.0 / myNbSamples);
+
+      myNoise = std::sqrt (aVariance / myNbSamples) / aMean;
+    }
+
+    mySnapshot.swap (aSnapshot);
+
+    mySnapshotSamples = myNbSamples;
+  }
+}
@@ -0,0 +1,187 @@
+// Created: 2019-07-02
+//
+// Copyright (c) 2019 OPEN CASCADE SAS
+//
+// This file is a part of CADRays software.
+//
+// CADRays is free software; you can use it under the terms of the MIT license,
+// refer to file LICENSE.txt for complete text of the license and disclaimer of
+// any warranty.
+
+#ifndef _RT_Convergence_Header
+#define _RT_Convergence_Header
+
+#include <V3d_View.hxx>
+#include <OSD_Timer.hxx>
+
+#include <memory>
+#include <vector>
+
+namespace ie
+{
+  //! Tracks progress of path tracing (number of accumulated samples, time and
+  //! estimated noise of the image) and decides when accumulation can be stopped.
+  //! Accumulation restarts on changes of camera, view size, rendering parameters
+  //! and set of displayed structures, or explicitly by Reset().
+  class Convergence
+  {
+  public:
+
+    //! Returns the instance of convergence tracker.
+    static Standard_EXPORT Convergence* GetInstance ();
+
+  public:
+
+    //! Returns target number of samples per pixel (0 if not used).
+    int MaxSamples () const { return myMaxSamples; }
+
+    //! Sets target number of samples per pixel (0 if not used).
+    void SetMaxSamples (const int theMaxSamples) { myMaxSamples = theMaxSamples; }
+
+    //! Returns time budget in seconds (0 if not used).
+    double MaxTime () const { return myMaxTime; }
+
+    //! Sets time budget in seconds (0 if not used).
+    void SetMaxTime (const double theMaxTime) { myMaxTime = theMaxTime; }
+
+    //! Returns target noise level (0 if not used).
+    double MaxNoise () const { return myMaxNoise; }
+
+    //! Sets target noise level, i.e. RMS error of pixel luminance relative to
+    //! the mean luminance of the image (0 if not used).
+    void SetMaxNoise (const double theMaxNoise) { myMaxNoise = theMaxNoise; }
+
+    //! Checks whether some stop criterion is set.
+    bool HasCriteria () const { return myMaxSamples > 0 || myMaxTime > 0.0 || myMaxNoise > 0.0; }
+
+  public:
+
+    //! Checks whether the image is accumulated (path tracing is on).
+    bool IsActive () const { return myIsActive; }
+
+    //! Returns number of samples per pixel accumulated since restart (average in adaptive mode).
+    int NbSamples () const { return myNbSamples; }
+
+    //! Returns number of samples accumulated before restart (restored from checkpoint).
+    int NbRestoredSamples () const { return myRestoredSamples; }
+
+    //! Sets number of samples accumulated before restart (reset on the next restart).
+    void SetRestoredSamples (const int theNbSamples) { myRestoredSamples = theNbSamples; }
+
+    //! Returns total number of samples per pixel of the image.
+    int NbTotalSamples () const { return myNbSamples + myRestoredSamples; }
+
+    //! Returns time since accumulation restart (in seconds).
+    double ElapsedTime () const { return myTimer.ElapsedTime (); }
+
+    //! Returns estimated noise level (negative if not estimated yet).
+    double Noise () const { return myNoise; }
+
+    //! Checks whether some stop criterion is met.
+    bool IsConverged () const { return myIsConverged; }
+
+    //! Returns progress in [0, 1] towards the nearest stop criterion.
+    Standard_EXPORT double Progress () const;
+
+  public:
+
+    //! Restarts accumulation (e.g. after scene change).
+    void Reset () { myToReset = true; }
+
+    //! Continues rendering of converged image until the next restart.
+    void Continue () { myIsContinued = true; }
+
+    //! Checks whether accumulation restarts on the next update (the view state
+    //! was changed or Reset() was called), e.g. to resume paused rendering.
+    Standard_EXPORT bool IsOutdated (const Handle (V3d_View)& theView) const;
+
+    //! Registers the frame just rendered by the view. Should be called from
+    //! the main thread after each redraw. Returns true if rendering should stop.
+    Standard_EXPORT bool Update (const Handle (V3d_View)& theView);
+
+  protected:
+
+    //! Creates new convergence tracker.
+    Convergence ();
+
+    //! Estimates noise from difference to the previous snapshot of the image
+    //! (snapshots are taken at doubling numbers of samples).
+    void estimateNoise (const Handle (V3d_View)& theView);
+
+  protected:
+
+    //! State of the view which restarts accumulation when changed.
+    struct ViewState
+    {
+      Standard_Size WorldView;   //!< Camera orientation state
+      Standard_Size Projection;  //!< Camera projection state
+      int           SizeX;       //!< View width
+      int           SizeY;       //!< View height
+      int           NbObjects;   //!< Number of displayed structures
+      int           Depth;       //!< Maximum ray depth
+      bool          IsActive;    //!< Path tracing is on
+      bool          IsCoherent;  //!< Coherent sampling mode
+      bool          IsAdaptive;  //!< Adaptive sampling mode
+
+      //! Compares view states.
+      bool operator!= (const ViewState& theOther) const;
+    };
+
+    //! Returns current state of the given view.
+    static ViewState viewState (const Handle (V3d_View)& theView);
+
+  protected:
+
+    //! Target number of samples per pixel.
+    int myMaxSamples;
+
+    //! Time budget (in seconds).
+    double myMaxTime;
+
+    //! Target noise level.
+    double myMaxNoise;
+
+    //! View state at last update.
+    ViewState myState;
+
+    //! Number of accumulated samples.
+    int myNbSamples;
+
+    //! Number of samples restored from checkpoint.
+    int myRestoredSamples;
+
+    //! Estimated noise level.
+    double myNoise;
+
+    //! Measures time since accumulation restart.
+    OSD_Timer myTimer;
+
+    //! Luminance of sparse pixels at the last noise estimation.
+    std::vector<float> mySnapshot;
+
+    //! Number of samples at the last noise estimation.
+    int mySnapshotSamples;
+
+    //! Number of samples at the next noise estimation.
+    int myNextEstimation;
+
+    //! Set when path tracing is on.
+    bool myIsActive;
+
+    //! Set when some stop criterion is met.
+    bool myIsConverged;
+
+    //! Set when converged image should be rendered further.
+    bool myIsContinued;
+
+    //! Set when accumulation should be restarted.
+    bool myToReset;
+
+  private:
+
+    //! Instance of convergence tracker.
+    static std::shared_ptr<Convergence> myInstance;
+  };
+}
+
+#endif // _RT_Convergence_Header
@@ -15,6 +15,7 @@
 
 #include <Utils.hxx>
 #include <DataNode.hxx>
+#include <MeshQueue.hxx>
 #include <DataContext.hxx>
 
 #include <AIS_Shape.hxx>
@@ -234,6 +235,9 @@ namespace model
     wasParametrized = !myObject->IsKind (STANDARD_TYPE (AIS_TexturedShape));
     if (wasParametrized)
     {
+      // Textured shape is meshed on display, so wait for background tessellation
+      ie::MeshQueue::GetInstance ()->Flush (Handle (AIS_Shape)::DownCast (myObject)->Shape ());
+
       Handle (AIS_TexturedShape) aTexShape = new AIS_TexturedShape (Handle (AIS_Shape)::DownCast (myObject)->Shape ());
 
       if (myObject->HasTransformation ())
@@ -255,23 +259,17 @@ namespace model
     }
     else
     {
-      Handle (AIS_TexturedShape) aTexShape = Handle (AIS_TexturedShape)::DownCast (myObject);
+      double aScaleS = 1.0;
+      double aScaleT = 1.0;
 
-      if (aTexShape->TextureScaleU () != theScaleS
-       || aTexShape->TextureScaleV () != theScaleT)
-      {
-        aTexShape->SetTextureScale (Standard_True, theScaleS, theScaleT);
-
-        if (aTexShape->DisplayMode () == 3)
-        {
-          TheAISContext ()->RecomputePrsOnly (aTexShape, Standard_False);
-        }
-        else
-        {
-          Standard_ASSERT_INVOKE ("Error! Invalid display mode for texture shape");
-        }
+      model::GetTextureScale (myObject, aScaleS, aScaleT);
 
-        wasParametrized = true;
+      if (aScaleS != theScaleS
+       || aScaleT != theScaleT)
+      {
+        // Texture coordinates are kept, new scale is applied as texture
+        // transformation (neither triangulation nor presentation is rebuilt)
+        model::SetTextureScale (myObject, theScaleS, theScaleT);
       }
     }
 
@@ -305,7 +303,12 @@ namespace model
   {
     if (!myObject.IsNull ())
     {
-      if (!TheAISContext ()->IsDisplayed (myObject))
+      if (ie::MeshQueue::GetInstance ()->IsQueued (myObject))
+      {
+        // Keep bounding box until the shape is tessellated
+        ie::MeshQueue::GetInstance ()->Display (Handle (AIS_Shape)::DownCast (myObject), theToRedraw);
+      }
+      else if (!TheAISContext ()->IsDisplayed (myObject))
       {
         TheAISContext ()->Display (myObject, theToRedraw);
       }
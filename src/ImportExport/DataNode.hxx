@@ -115,7 +115,8 @@ namespace model
     //! Checks whether the node is parametrized.
     Standard_EXPORT bool IsParameterized () const;
 
-    //! Updates parameterization for node shape.
+    //! Updates parameterization for node shape. Returns true if new textured
+    //! shape was created (scale of existing UV is changed without rebuilding).
     Standard_EXPORT bool Parameterize (const float theScaleS = 1.f,
                                        const float theScaleT = 1.f);
 
@@ -0,0 +1,780 @@
+// Created: 2019-07-15
+//
+// Copyright (c) 2019 OPEN CASCADE SAS
+//
+// This file is a part of CADRays software.
+//
+// CADRays is free software; you can use it under the terms of the MIT license,
+// refer to file LICENSE.txt for complete text of the license and disclaimer of
+// any warranty.
+
+#include <Graphic3d_CView.hxx>
+#include <OSD_Parallel.hxx>
+
+#include <cmath>
+#include <cstring>
+
+#include "Denoiser.hxx"
+#include "Checkpoint.hxx"
+#include "Convergence.hxx"
+
+namespace ie
+{
+  //! Number of samples of the first denoised image of the view.
+  static const int THE_MIN_SAMPLES = 4;
+
+  //! B3-spline kernel of a-trous wavelet transform.
+  static const float THE_KERNEL[5] = { 1.f / 16.f, 1.f / 4.f, 3.f / 8.f, 1.f / 4.f, 1.f / 16.f };
+
+  //! Maximum exponent of edge-stopping weight (smaller weights are not distinguished).
+  static const float THE_MAX_EXPONENT = 80.f;
+
+  //===========================================================================
+  //function : fastExp
+  //purpose  : Approximates exp(x) for x in [-80, 0] (relative error about
+  //           1e-4). Unlike std::exp, the function is inlined and vectorized
+  //           by compiler in the loops over pixels
+  //===========================================================================
+  static inline float fastExp (const float theX)
+  {
+    const float aPow = theX * 1.442695f; // to power of 2
+
+    int anInt = static_cast<int> (aPow);
+
+    anInt -= aPow < static_cast<float> (anInt) ? 1 : 0; // floor
+
+    const float aFrac = aPow - static_cast<float> (anInt);
+
+    const int aBits = (anInt + 127) << 23;
+
+    float aScale;
+
+    std::memcpy (&aScale, &aBits, sizeof (float));
+
+    return aScale * (1.f + aFrac * (0.6960656f + aFrac * (0.2244943f + aFrac * 0.0794402f)));
+  }
+
+  //! Guide buffers used by filter.
+  struct Guide
+  {
+    const float* Normal[3];
+    const float* Albedo[3];
+    const float* Depth;
+  };
+
+  //! Single pass of a-trous filter (functor for OSD_Parallel over image rows).
+  //! Planes are processed by contiguous spans of pixels for each filter tap,
+  //! so that inner loop has no branches and is vectorized by compiler.
+  class FilterPass
+  {
+  public:
+
+    //! Creates filter pass with the given distance between taps.
+    FilterPass (const Guide& theGuide, const float* const theInput[3], float* const theOutput[3],
+                const int theSizeX, const int theSizeY, const int theStep,
+                const float theColorSigma, const float theNormalSigma, const float theDepthSigma, const float theAlbedoSigma)
+      : myGuide (theGuide),
+        mySizeX (theSizeX),
+        mySizeY (theSizeY),
+        myStep (theStep),
+        myInvColor (1.f / (theColorSigma * theColorSigma)),
+        myNormalSigma (theNormalSigma),
+        myDepthSigma (theDepthSigma),
+        myInvAlbedo (1.f / (theAlbedoSigma * theAlbedoSigma))
+    {
+      for (int aChannel = 0; aChannel < 3; ++aChannel)
+      {
+        myInput[aChannel]  = theInput[aChannel];
+        myOutput[aChannel] = theOutput[aChannel];
+      }
+    }
+
+    //! Filters the given row.
+    void operator() (const int theRow) const
+    {
+      // Sums of weights and weighted colors
+      std::vector<float> aSums (static_cast<size_t> (mySizeX) * 4, 0.f);
+
+      // Weights of current tap
+      std::vector<float> aTerms (mySizeX);
+
+      const size_t aCenter = static_cast<size_t> (theRow) * mySizeX;
+
+      for (int aTapY = -2; aTapY <= 2; ++aTapY)
+      {
+        const int aRow = theRow + aTapY * myStep;
+
+        if (aRow < 0 || aRow >= mySizeY)
+        {
+          continue;
+        }
+
+        for (int aTapX = -2; aTapX <= 2; ++aTapX)
+        {
+          const int aShift = aTapX * myStep;
+
+          // Span of pixels with the tap inside the image
+          const int aBeg = std::max (0, -aShift);
+          const int aEnd = std::min (mySizeX, mySizeX - aShift);
+
+          const size_t aCntr = aCenter + aBeg;
+          const size_t aNear = static_cast<size_t> (aRow) * mySizeX + aShift + aBeg;
+
+          const float aKernel = THE_KERNEL[aTapY + 2] * THE_KERNEL[aTapX + 2];
+
+          // Depth tolerance grows with distance to the tap
+          const float aDepthScale = myDepthSigma * std::max (std::abs (aTapX), std::abs (aTapY)) * myStep;
+
+          const float* aColor[] = { myInput[0] + aCntr, myInput[1] + aCntr, myInput[2] + aCntr };
+          const float* aTap[]   = { myInput[0] + aNear, myInput[1] + aNear, myInput[2] + aNear };
+
+          const int aLength = aEnd - aBeg;
+
+          // Exponent of weight (then weight itself) for the span
+          float* aTerm = &aTerms[0];
+
+          // Edge-stopping terms are accumulated by separate loops over few
+          // arrays, so that compiler vectorizes them without giving up on
+          // too many run-time alias checks
+          {
+            for (int anIdx = 0; anIdx < aLength; ++anIdx)
+            {
+              const float aDiffR = aTap[0][anIdx] - aColor[0][anIdx];
+              const float aDiffG = aTap[1][anIdx] - aColor[1][anIdx];
+              const float aDiffB = aTap[2][anIdx] - aColor[2][anIdx];
+
+              aTerm[anIdx] = (aDiffR * aDiffR + aDiffG * aDiffG + aDiffB * aDiffB) * myInvColor;
+            }
+          }
+
+          {
+            const float* anAlbR = myGuide.Albedo[0] + aCntr;
+            const float* anAlbG = myGuide.Albedo[1] + aCntr;
+            const float* anAlbB = myGuide.Albedo[2] + aCntr;
+            const float* aTapR  = myGuide.Albedo[0] + aNear;
+            const float* aTapG  = myGuide.Albedo[1] + aNear;
+            const float* aTapB  = myGuide.Albedo[2] + aNear;
+
+            for (int anIdx = 0; anIdx < aLength; ++anIdx)
+            {
+              const float aDiffR = aTapR[anIdx] - anAlbR[anIdx];
+              const float aDiffG = aTapG[anIdx] - anAlbG[anIdx];
+              const float aDiffB = aTapB[anIdx] - anAlbB[anIdx];
+
+              aTerm[anIdx] += (aDiffR * aDiffR + aDiffG * aDiffG + aDiffB * aDiffB) * myInvAlbedo;
+            }
+          }
+
+          {
+            const float* aNrmX = myGuide.Normal[0] + aCntr;
+            const float* aNrmY = myGuide.Normal[1] + aCntr;
+            const float* aNrmZ = myGuide.Normal[2] + aCntr;
+            const float* aTapNrmX = myGuide.Normal[0] + aNear;
+            const float* aTapNrmY = myGuide.Normal[1] + aNear;
+            const float* aTapNrmZ = myGuide.Normal[2] + aNear;
+
+            // Term exp(-sigma * (1 - cos)) approximates cos^sigma for close normals
+            for (int anIdx = 0; anIdx < aLength; ++anIdx)
+            {
+              aTerm[anIdx] += (1.f - aNrmX[anIdx] * aTapNrmX[anIdx]
+                                   - aNrmY[anIdx] * aTapNrmY[anIdx]
+                                   - aNrmZ[anIdx] * aTapNrmZ[anIdx]) * myNormalSigma;
+            }
+          }
+
+          {
+            const float* aDepth    = myGuide.Depth + aCntr;
+            const float* aTapDepth = myGuide.Depth + aNear;
+
+            for (int anIdx = 0; anIdx < aLength; ++anIdx)
+            {
+              aTerm[anIdx] = std::min (aTerm[anIdx] + std::abs (aTapDepth[anIdx] - aDepth[anIdx]) / (aDepthScale * aDepth[anIdx] + 1.0e-6f), THE_MAX_EXPONENT);
+            }
+          }
+
+          // Clamped exponent is converted to weight by separate loop, as GCC
+          // does not vectorize clamped value being converted to integer
+          for (int anIdx = 0; anIdx < aLength; ++anIdx)
+          {
+            aTerm[anIdx] = aKernel * fastExp (-aTerm[anIdx]);
+          }
+
+          float* aSumW = &aSums[0] + aBeg;
+
+          for (int anIdx = 0; anIdx < aLength; ++anIdx)
+          {
+            aSumW[anIdx] += aTerm[anIdx];
+          }
+
+          for (int aChannel = 0; aChannel < 3; ++aChannel)
+          {
+            float* aSum = aSumW + static_cast<size_t> (aChannel + 1) * mySizeX;
+
+            const float* aValue = aTap[aChannel];
+
+            for (int anIdx = 0; anIdx < aLength; ++anIdx)
+            {
+              aSum[anIdx] += aTerm[anIdx] * aValue[anIdx];
+            }
+          }
+        }
+      }
+
+      // Weight of central tap is never zero
+      const float* aSumW = &aSums[0];
+
+      for (int aChannel = 0; aChannel < 3; ++aChannel)
+      {
+        const float* aSum = aSumW + static_cast<size_t> (aChannel + 1) * mySizeX;
+
+        float* anOutput = myOutput[aChannel] + aCenter;
+
+        for (int aCol = 0; aCol < mySizeX; ++aCol)
+        {
+          anOutput[aCol] = aSum[aCol] / aSumW[aCol];
+        }
+      }
+    }
+
+  private:
+
+    Guide        myGuide;
+    const float* myInput[3];
+    float*       myOutput[3];
+    int          mySizeX;
+    int          mySizeY;
+    int          myStep;
+    float        myInvColor;
+    float        myNormalSigma;
+    float        myDepthSigma;
+    float        myInvAlbedo;
+  };
+
+  std::shared_ptr<Denoiser> Denoiser::myInstance;
+
+  //===========================================================================
+  //function : Denoiser
+  //purpose  :
+  //===========================================================================
+  Denoiser::Denoiser ()
+    : myIsEnabled (false),
+      myNbIterations (5),
+      myColorSigma (0.5f),
+      myNormalSigma (16.f),
+      myDepthSigma (0.01f),
+      myAlbedoSigma (0.1f),
+      myRevision (0),
+      myNbSamples (0),
+      myIsConvergedFiltered (false),
+      myGeneration (0),
+      myInputGeneration (0),
+      myResultGeneration (0),
+      myIsFiltering (false),
+      myToStop (false)
+  {
+    myInputParams = parameters ();
+  }
+
+  //===========================================================================
+  //function : ~Denoiser
+  //purpose  :
+  //===========================================================================
+  Denoiser::~Denoiser ()
+  {
+    {
+      std::lock_guard<std::mutex> aLock (myMutex);
+
+      myToStop = true;
+    }
+
+    myInputAdded.notify_all ();
+
+    if (myWorker.joinable ())
+    {
+      myWorker.join ();
+    }
+  }
+
+  //===========================================================================
+  //function : GetInstance
+  //purpose  :
+  //===========================================================================
+  Denoiser* Denoiser::GetInstance ()
+  {
+    if (myInstance == NULL)
+    {
+      myInstance.reset (new Denoiser);
+    }
+
+    return myInstance.get ();
+  }
+
+  //===========================================================================
+  //function : SetEnabled
+  //purpose  :
+  //===========================================================================
+  void Denoiser::SetEnabled (const bool theToEnable)
+  {
+    if (myIsEnabled != theToEnable)
+    {
+      clear ();
+    }
+
+    myIsEnabled = theToEnable;
+  }
+
+  //===========================================================================
+  //function : parameters
+  //purpose  :
+  //===========================================================================
+  Denoiser::Parameters Denoiser::parameters () const
+  {
+    Parameters aParams;
+
+    aParams.NbIterations = myNbIterations;
+    aParams.ColorSigma   = myColorSigma;
+    aParams.NormalSigma  = myNormalSigma;
+    aParams.DepthSigma   = myDepthSigma;
+    aParams.AlbedoSigma  = myAlbedoSigma;
+
+    return aParams;
+  }
+
+  //===========================================================================
+  //function : Perform
+  //purpose  :
+  //===========================================================================
+  bool Denoiser::Perform (const AovBuffers& theGuides, std::vector<float> theColor[3], const bool isHdr) const
+  {
+    return filter (theGuides, theColor, isHdr, parameters ());
+  }
+
+  //===========================================================================
+  //function : Perform
+  //purpose  :
+  //===========================================================================
+  bool Denoiser::Perform (const AovBuffers& theGuides, Image_PixMap& theImage, const bool isHdr) const
+  {
+    return filter (theGuides, theImage, isHdr, parameters ());
+  }
+
+  //===========================================================================
+  //function : filter
+  //purpose  :
+  //===========================================================================
+  bool Denoiser::filter (const AovBuffers& theGuides, std::vector<float> theColor[3], const bool isHdr, const Parameters& theParams)
+  {
+    const AovBuffers::Channel* aChannels[] = { theGuides.Find ("normal.X"),
+                                               theGuides.Find ("normal.Y"),
+                                               theGuides.Find ("normal.Z"),
+                                               theGuides.Find ("albedo.R"),
+                                               theGuides.Find ("albedo.G"),
+                                               theGuides.Find ("albedo.B"),
+                                               theGuides.Find ("Z") };
+
+    const size_t aNbPixels = static_cast<size_t> (theGuides.SizeX ()) * theGuides.SizeY ();
+
+    for (int anIdx = 0; anIdx < 7; ++anIdx)
+    {
+      if (aChannels[anIdx] == NULL || aChannels[anIdx]->Data.size () != aNbPixels)
+      {
+        return false;
+      }
+    }
+
+    for (int aChannel = 0; aChannel < 3; ++aChannel)
+    {
+      if (aNbPixels == 0 || theColor[aChannel].size () != aNbPixels)
+      {
+        return false;
+      }
+    }
+
+    // Color tolerance is meaningful for both dark and very bright pixels in compressed range
+    if (isHdr)
+    {
+      for (int aChannel = 0; aChannel < 3; ++aChannel)
+      {
+        for (size_t anIdx = 0; anIdx < aNbPixels; ++anIdx)
+        {
+          const float aValue = std::max (theColor[aChannel][anIdx], 0.f);
+
+          theColor[aChannel][anIdx] = aValue / (1.f + aValue);
+        }
+      }
+    }
+
+    Guide aGuide;
+
+    for (int aDim = 0; aDim < 3; ++aDim)
+    {
+      aGuide.Normal[aDim] = &aChannels[aDim + 0]->Data[0];
+      aGuide.Albedo[aDim] = &aChannels[aDim + 3]->Data[0];
+    }
+
+    aGuide.Depth = &aChannels[6]->Data[0];
+
+    std::vector<float> aBuffer[3];
+
+    for (int aChannel = 0; aChannel < 3; ++aChannel)
+    {
+      aBuffer[aChannel].resize (aNbPixels);
+    }
+
+    for (int anIter = 0; anIter < theParams.NbIterations; ++anIter)
+    {
+      const float* anInput[] = { &theColor[0][0], &theColor[1][0], &theColor[2][0] };
+
+      float* anOutput[] = { &aBuffer[0][0], &aBuffer[1][0], &aBuffer[2][0] };
+
+      // Color tolerance is reduced for coarser scales (as noise is already smoothed)
+      const float aSigma = theParams.ColorSigma / static_cast<float> (1 << anIter);
+
+      OSD_Parallel::For (0, theGuides.SizeY (), FilterPass (aGuide, anInput, anOutput,
+        theGuides.SizeX (), theGuides.SizeY (), 1 << anIter, aSigma, theParams.NormalSigma, theParams.DepthSigma, theParams.AlbedoSigma));
+
+      for (int aChannel = 0; aChannel < 3; ++aChannel)
+      {
+        theColor[aChannel].swap (aBuffer[aChannel]);
+      }
+    }
+
+    if (isHdr)
+    {
+      for (int aChannel = 0; aChannel < 3; ++aChannel)
+      {
+        for (size_t anIdx = 0; anIdx < aNbPixels; ++anIdx)
+        {
+          const float aValue = std::min (theColor[aChannel][anIdx], 0.9999f);
+
+          theColor[aChannel][anIdx] = aValue / (1.f - aValue);
+        }
+      }
+    }
+
+    return true;
+  }
+
+  //===========================================================================
+  //function : filter
+  //purpose  :
+  //===========================================================================
+  bool Denoiser::filter (const AovBuffers& theGuides, Image_PixMap& theImage, const bool isHdr, const Parameters& theParams)
+  {
+    if (static_cast<int> (theImage.SizeX ()) != theGuides.SizeX ()
+     || static_cast<int> (theImage.SizeY ()) != theGuides.SizeY ())
+    {
+      return false;
+    }
+
+    bool isFloat = false;
+    bool isBGR   = false;
+
+    switch (theImage.Format ())
+    {
+      case Image_PixMap::ImgRGB:
+      case Image_PixMap::ImgRGB32:
+      case Image_PixMap::ImgRGBA:
+        break;
+      case Image_PixMap::ImgBGR:
+      case Image_PixMap::ImgBGR32:
+      case Image_PixMap::ImgBGRA:
+        isBGR = true;
+        break;
+      case Image_PixMap::ImgRGBF:
+      case Image_PixMap::ImgRGBAF:
+        isFloat = true;
+        break;
+      case Image_PixMap::ImgBGRF:
+      case Image_PixMap::ImgBGRAF:
+        isFloat = true;
+        isBGR   = true;
+        break;
+      default:
+        return false;
+    }
+
+    const Standard_Size aStride = theImage.SizePixelBytes () / (isFloat ? sizeof (float) : 1);
+
+    std::vector<float> aColor[3];
+
+    for (int aChannel = 0; aChannel < 3; ++aChannel)
+    {
+      aColor[aChannel].resize (theImage.SizeX () * theImage.SizeY ());
+    }
+
+    for (Standard_Size aRow = 0; aRow < theImage.SizeY (); ++aRow)
+    {
+      for (Standard_Size aCol = 0; aCol < theImage.SizeX (); ++aCol)
+      {
+        for (int aChannel = 0; aChannel < 3; ++aChannel)
+        {
+          const Standard_Size anOffset = aCol * aStride + (isBGR ? 2 - aChannel : aChannel);
+
+          aColor[aChannel][aRow * theImage.SizeX () + aCol] = isFloat
+            ? reinterpret_cast<const float*> (theImage.Row (aRow))[anOffset]
+            : theImage.Row (aRow)[anOffset] / 255.f;
+        }
+      }
+    }
+
+    if (!filter (theGuides, aColor, isFloat && isHdr, theParams))
+    {
+      return false;
+    }
+
+    for (Standard_Size aRow = 0; aRow < theImage.SizeY (); ++aRow)
+    {
+      for (Standard_Size aCol = 0; aCol < theImage.SizeX (); ++aCol)
+      {
+        for (int aChannel = 0; aChannel < 3; ++aChannel)
+        {
+          const Standard_Size anOffset = aCol * aStride + (isBGR ? 2 - aChannel : aChannel);
+
+          const float aValue = aColor[aChannel][aRow * theImage.SizeX () + aCol];
+
+          if (isFloat)
+          {
+            reinterpret_cast<float*> (theImage.ChangeRow (aRow))[anOffset] = aValue;
+          }
+          else
+          {
+            theImage.ChangeRow (aRow)[anOffset] = static_cast<Standard_Byte> (std::max (0.f, std::min (aValue * 255.f + 0.5f, 255.f)));
+          }
+        }
+      }
+    }
+
+    return true;
+  }
+
+  //===========================================================================
+  //function : Perform
+  //purpose  :
+  //===========================================================================
+  bool Denoiser::Perform (AovBuffers& theBuffers) const
+  {
+    AovBuffers::Channel* aChannels[] = { theBuffers.ChangeChannel ("R"),
+                                         theBuffers.ChangeChannel ("G"),
+                                         theBuffers.ChangeChannel ("B") };
+
+    if (aChannels[0] == NULL || aChannels[1] == NULL || aChannels[2] == NULL)
+    {
+      return false;
+    }
+
+    std::vector<float> aColor[3];
+
+    for (int aChannel = 0; aChannel < 3; ++aChannel)
+    {
+      aColor[aChannel].swap (aChannels[aChannel]->Data);
+    }
+
+    const bool isDone = Perform (theBuffers, aColor, true /* linear radiance */);
+
+    for (int aChannel = 0; aChannel < 3; ++aChannel)
+    {
+      aColor[aChannel].swap (aChannels[aChannel]->Data);
+    }
+
+    return isDone;
+  }
+
+  //===========================================================================
+  //function : Guides
+  //purpose  :
+  //===========================================================================
+  std::shared_ptr<AovBuffers> Denoiser::Guides (const Handle (V3d_View)& theView)
+  {
+    if (myGuides == NULL)
+    {
+      std::shared_ptr<AovBuffers> aGuides (new AovBuffers);
+
+      // Rays are cast later by filtering thread
+      if (aGuides->Prepare (theView, false /* no radiance */))
+      {
+        myGuides = aGuides;
+      }
+    }
+
+    return myGuides;
+  }
+
+  //===========================================================================
+  //function : clear
+  //purpose  :
+  //===========================================================================
+  void Denoiser::clear ()
+  {
+    myGuides.reset ();
+
+    myNbSamples = 0;
+
+    myIsConvergedFiltered = false;
+
+    ++myGeneration;
+
+    if (!myImage.IsEmpty ())
+    {
+      myImage.Clear ();
+
+      ++myRevision;
+    }
+
+    std::lock_guard<std::mutex> aLock (myMutex);
+
+    myInput.reset ();
+    myInputGuides.reset ();
+    myResult.reset ();
+  }
+
+  //===========================================================================
+  //function : Update
+  //purpose  :
+  //===========================================================================
+  void Denoiser::Update (const Handle (V3d_View)& theView)
+  {
+    Convergence* aConvergence = Convergence::GetInstance ();
+
+    if (!myIsEnabled || !aConvergence->IsActive ())
+    {
+      if (!myImage.IsEmpty ())
+      {
+        clear ();
+      }
+
+      return;
+    }
+
+    if (aConvergence->NbSamples () == 1) // accumulation was restarted
+    {
+      clear ();
+    }
+
+    // Pick up image filtered in background
+    {
+      std::lock_guard<std::mutex> aLock (myMutex);
+
+      if (myResult != NULL)
+      {
+        if (myResultGeneration == myGeneration && myImage.InitCopy (*myResult))
+        {
+          ++myRevision;
+        }
+
+        myResult.reset ();
+      }
+    }
+
+    const int aNbSamples = aConvergence->NbTotalSamples ();
+
+    // Image is filtered each time the number of samples is doubled (and once converged)
+    const bool isConverged = aConvergence->IsConverged () && !myIsConvergedFiltered;
+
+    if (aNbSamples < std::max (myNbSamples * 2, THE_MIN_SAMPLES) && !isConverged)
+    {
+      return;
+    }
+
+    std::shared_ptr<AovBuffers> aGuides = Guides (theView);
+
+    if (aGuides == NULL)
+    {
+      return;
+    }
+
+    std::shared_ptr<Image_PixMap> anImage (new Image_PixMap);
+
+    if (!anImage->InitZero (Image_PixMap::ImgRGBF, aGuides->SizeX (), aGuides->SizeY ())
+     || !theView->View ()->BufferDump (*anImage, Graphic3d_BT_RGB))
+    {
+      return;
+    }
+
+    // Add samples restored from checkpoint
+    Checkpoint::GetInstance ()->Combine (*anImage);
+
+    myNbSamples = aNbSamples;
+
+    myIsConvergedFiltered = aConvergence->IsConverged ();
+
+    {
+      std::lock_guard<std::mutex> aLock (myMutex);
+
+      // Image waiting for filtering (if any) is outdated
+      myInput = anImage;
+      myInputGuides = aGuides;
+      myInputGeneration = myGeneration;
+      myInputParams = parameters ();
+    }
+
+    if (!myWorker.joinable ())
+    {
+      myWorker = std::thread ([this] { filterImages (); });
+    }
+
+    myInputAdded.notify_one ();
+  }
+
+  //===========================================================================
+  //function : IsBusy
+  //purpose  :
+  //===========================================================================
+  bool Denoiser::IsBusy () const
+  {
+    std::lock_guard<std::mutex> aLock (myMutex);
+
+    return myInput != NULL || myResult != NULL || myIsFiltering;
+  }
+
+  //===========================================================================
+  //function : filterImages
+  //purpose  :
+  //===========================================================================
+  void Denoiser::filterImages ()
+  {
+    for (;;)
+    {
+      std::shared_ptr<Image_PixMap> anImage;
+      std::shared_ptr<AovBuffers>   aGuides;
+
+      int aGeneration = 0;
+
+      Parameters aParams;
+
+      {
+        std::unique_lock<std::mutex> aLock (myMutex);
+
+        myInputAdded.wait (aLock, [this] { return myToStop || myInput != NULL; });
+
+        if (myToStop)
+        {
+          return;
+        }
+
+        anImage.swap (myInput);
+        aGuides.swap (myInputGuides);
+
+        aGeneration = myInputGeneration;
+        aParams     = myInputParams;
+
+        myIsFiltering = true;
+      }
+
+      aGuides->Compute ();
+
+      // Parameters of the denoiser are not accessed by filtering thread
+      const bool isDone = filter (*aGuides, *anImage, false, aParams);
+
+      std::lock_guard<std::mutex> aLock (myMutex);
+
+      myIsFiltering = false;
+
+      if (isDone)
+      {
+        myResult = anImage;
+        myResultGeneration = aGeneration;
+      }
+    }
+  }
+}
@@ -0,0 +1,228 @@
+// Created: 2019-07-15
+//
+// Copyright (c) 2019 OPEN CASCADE SAS
+//
+// This file is a part of CADRays software.
+//
+// CADRays is free software; you can use it under the terms of the MIT license,
+// refer to file LICENSE.txt for complete text of the license and disclaimer of
+// any warranty.
+
+#ifndef _RT_Denoiser_Header
+#define _RT_Denoiser_Header
+
+#include <V3d_View.hxx>
+#include <Image_PixMap.hxx>
+
+#include <mutex>
+#include <algorithm>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <condition_variable>
+
+#include "AovBuffers.hxx"
+
+namespace ie
+{
+  //! Edge-aware a-trous wavelet filter removing noise of progressive path
+  //! tracing on CPU. Filtering is guided by normal, albedo and depth buffers
+  //! (see AovBuffers), so that geometric and material edges are preserved.
+  //! The denoised image of the view is updated in background thread each
+  //! time the number of accumulated samples is doubled.
+  class Denoiser
+  {
+  public:
+
+    //! Returns the instance of denoiser.
+    static Standard_EXPORT Denoiser* GetInstance ();
+
+    //! Stops filtering thread.
+    Standard_EXPORT ~Denoiser ();
+
+  public:
+
+    //! Checks whether denoised image of the view is displayed.
+    bool IsEnabled () const { return myIsEnabled; }
+
+    //! Enables or disables denoising of the view.
+    Standard_EXPORT void SetEnabled (const bool theToEnable);
+
+    //! Returns number of filter passes (each pass doubles filter radius).
+    int NbIterations () const { return myNbIterations; }
+
+    //! Sets number of filter passes (from 1 to 8).
+    void SetNbIterations (const int theNbIterations) { myNbIterations = std::max (1, std::min (theNbIterations, 8)); }
+
+    //! Returns color edge-stopping parameter (halved each pass).
+    float ColorSigma () const { return myColorSigma; }
+
+    //! Sets color edge-stopping parameter (halved each pass).
+    void SetColorSigma (const float theSigma) { myColorSigma = std::max (theSigma, 1.0e-3f); }
+
+    //! Returns normal edge-stopping parameter (larger values preserve more edges).
+    float NormalSigma () const { return myNormalSigma; }
+
+    //! Sets normal edge-stopping parameter (larger values preserve more edges).
+    void SetNormalSigma (const float theSigma) { myNormalSigma = std::max (theSigma, 0.f); }
+
+    //! Returns depth edge-stopping parameter (relative to depth per pixel).
+    float DepthSigma () const { return myDepthSigma; }
+
+    //! Sets depth edge-stopping parameter (relative to depth per pixel).
+    void SetDepthSigma (const float theSigma) { myDepthSigma = std::max (theSigma, 1.0e-4f); }
+
+    //! Returns albedo edge-stopping parameter.
+    float AlbedoSigma () const { return myAlbedoSigma; }
+
+    //! Sets albedo edge-stopping parameter.
+    void SetAlbedoSigma (const float theSigma) { myAlbedoSigma = std::max (theSigma, 1.0e-3f); }
+
+  public:
+
+    //! Filters RGB planes (rows from top to bottom) of the same size as guide buffers.
+    //! Linear HDR values are filtered in compressed range x / (1 + x).
+    Standard_EXPORT bool Perform (const AovBuffers& theGuides, std::vector<float> theColor[3], const bool isHdr = false) const;
+
+    //! Filters the image (RGB or RGBA, 8-bit or float) using guide buffers of the same size.
+    Standard_EXPORT bool Perform (const AovBuffers& theGuides, Image_PixMap& theImage, const bool isHdr = false) const;
+
+    //! Filters linear radiance (R, G and B channels) of the buffers.
+    Standard_EXPORT bool Perform (AovBuffers& theBuffers) const;
+
+  public:
+
+    //! Returns guide buffers of the view prepared once after restart of accumulation
+    //! (AovBuffers::Compute should be called before filtering).
+    Standard_EXPORT std::shared_ptr<AovBuffers> Guides (const Handle (V3d_View)& theView);
+
+    //! Returns denoised image of the view (RGB float, top-down rows).
+    const Image_PixMap& Image () const { return myImage; }
+
+    //! Returns counter incremented each time the denoised image is changed.
+    int Revision () const { return myRevision; }
+
+    //! Registers the frame just rendered by the view. Should be called from
+    //! the main thread after Convergence::Update. Starts filtering of the
+    //! displayed image and picks up images filtered in background.
+    Standard_EXPORT void Update (const Handle (V3d_View)& theView);
+
+    //! Checks whether some image is filtered or waiting for pick up.
+    Standard_EXPORT bool IsBusy () const;
+
+  protected:
+
+    //! Filter parameters copied for filtering in background (the GUI can change
+    //! parameters of the denoiser while the image is filtered).
+    struct Parameters
+    {
+      int   NbIterations; //!< Number of filter passes
+      float ColorSigma;   //!< Color edge-stopping parameter
+      float NormalSigma;  //!< Normal edge-stopping parameter
+      float DepthSigma;   //!< Depth edge-stopping parameter
+      float AlbedoSigma;  //!< Albedo edge-stopping parameter
+    };
+
+  protected:
+
+    //! Creates new denoiser.
+    Denoiser ();
+
+    //! Returns copy of current filter parameters.
+    Parameters parameters () const;
+
+    //! Filters RGB planes with the given parameters (see Perform).
+    static bool filter (const AovBuffers& theGuides, std::vector<float> theColor[3], const bool isHdr, const Parameters& theParams);
+
+    //! Filters the image with the given parameters (see Perform).
+    static bool filter (const AovBuffers& theGuides, Image_PixMap& theImage, const bool isHdr, const Parameters& theParams);
+
+    //! Clears denoised image and discards filtering in progress.
+    void clear ();
+
+    //! Filters images of the view (filtering thread function).
+    void filterImages ();
+
+  protected:
+
+    //! Set when denoised image of the view is displayed.
+    bool myIsEnabled;
+
+    //! Number of filter passes.
+    int myNbIterations;
+
+    //! Color edge-stopping parameter.
+    float myColorSigma;
+
+    //! Normal edge-stopping parameter.
+    float myNormalSigma;
+
+    //! Depth edge-stopping parameter.
+    float myDepthSigma;
+
+    //! Albedo edge-stopping parameter.
+    float myAlbedoSigma;
+
+  protected:
+
+    //! Guide buffers of current accumulation.
+    std::shared_ptr<AovBuffers> myGuides;
+
+    //! Denoised image of the view.
+    Image_PixMap myImage;
+
+    //! Revision of denoised image.
+    int myRevision;
+
+    //! Number of samples of the last filtered image.
+    int myNbSamples;
+
+    //! Set when converged image is filtered.
+    bool myIsConvergedFiltered;
+
+    //! Incremented on restart of accumulation (discards outdated results).
+    int myGeneration;
+
+  protected:
+
+    //! Image waiting for filtering.
+    std::shared_ptr<Image_PixMap> myInput;
+
+    //! Guide buffers of the waiting image.
+    std::shared_ptr<AovBuffers> myInputGuides;
+
+    //! Generation of the waiting image.
+    int myInputGeneration;
+
+    //! Filter parameters of the waiting image.
+    Parameters myInputParams;
+
+    //! Filtered image (NULL if not ready).
+    std::shared_ptr<Image_PixMap> myResult;
+
+    //! Generation of the filtered image.
+    int myResultGeneration;
+
+    //! Set while the filtering thread is working.
+    bool myIsFiltering;
+
+    //! Set to stop filtering thread.
+    bool myToStop;
+
+    //! Filtering thread (started on first update).
+    std::thread myWorker;
+
+    //! Guards input and result images.
+    mutable std::mutex myMutex;
+
+    //! Signaled when new image is waiting for filtering.
+    std::condition_variable myInputAdded;
+
+  private:
+
+    //! Instance of denoiser.
+    static std::shared_ptr<Denoiser> myInstance;
+  };
+}
+
+#endif // _RT_Denoiser_Header
@@ -0,0 +1,296 @@
+// Created: 2019-06-14
+//
+// Copyright (c) 2019 OPEN CASCADE SAS
+//
+// This file is a part of CADRays software.
+//
+// CADRays is free software; you can use it under the terms of the MIT license,
+// refer to file LICENSE.txt for complete text of the license and disclaimer of
+// any warranty.
+
+#include <AIS_Shape.hxx>
+#include <BRep_Tool.hxx>
+#include <TopExp_Explorer.hxx>
+#include <TopoDS.hxx>
+#include <Poly_Triangulation.hxx>
+
+#include <fstream>
+#include <sstream>
+
+#include "AisMesh.hxx"
+#include "Fingerprints.hxx"
+
+namespace ie
+{
+  //! Version of fingerprints file (should be changed with hashing scheme).
+  static const int THE_FORMAT_VERSION = 2;
+
+  //===========================================================================
+  //function : hashBytes
+  //purpose  : Combines the seed with FNV-1a hash of the given data
+  //===========================================================================
+  static void hashBytes (size_t& theSeed, const void* theData, const size_t theSize)
+  {
+    const unsigned char* aData = static_cast<const unsigned char*> (theData);
+
+    unsigned long long aHash = 14695981039346656037ULL;
+
+    for (size_t anIdx = 0; anIdx < theSize; ++anIdx)
+    {
+      aHash = (aHash ^ aData[anIdx]) * 1099511628211ULL;
+    }
+
+    HashCombine (theSeed, static_cast<size_t> (aHash));
+  }
+
+  //===========================================================================
+  //function : hashXYZ
+  //purpose  :
+  //===========================================================================
+  static void hashXYZ (size_t& theSeed, const gp_XYZ& theXYZ)
+  {
+    HashCombine (theSeed, std::hash<double> () (theXYZ.X ()));
+    HashCombine (theSeed, std::hash<double> () (theXYZ.Y ()));
+    HashCombine (theSeed, std::hash<double> () (theXYZ.Z ()));
+  }
+
+  //===========================================================================
+  //function : hashLocation
+  //purpose  :
+  //===========================================================================
+  static void hashLocation (size_t& theSeed, const TopLoc_Location& theLocation)
+  {
+    if (theLocation.IsIdentity ())
+    {
+      return;
+    }
+
+    const gp_Trsf aTrsf = theLocation.Transformation ();
+
+    for (int aRow = 1; aRow <= 3; ++aRow)
+    {
+      for (int aCol = 1; aCol <= 4; ++aCol)
+      {
+        HashCombine (theSeed, std::hash<double> () (aTrsf.Value (aRow, aCol)));
+      }
+    }
+  }
+
+  //===========================================================================
+  //function : Compute
+  //purpose  :
+  //===========================================================================
+  size_t Fingerprints::Compute (const Handle (AIS_InteractiveObject)& theObject)
+  {
+    Handle (AIS_Shape) aShape = Handle (AIS_Shape)::DownCast (theObject);
+
+    if (!aShape.IsNull ())
+    {
+      // AIS object may be replaced (by textured one), so we use
+      // the shape itself; TShape is never modified in CADRays
+      size_t aHash = Compute (aShape->Shape ());
+
+      const Bnd_Box& aBox = aShape->BoundingBox ();
+
+      if (!aBox.IsVoid ())
+      {
+        double aMinMax[6];
+
+        aBox.Get (aMinMax[0], aMinMax[1], aMinMax[2],
+                  aMinMax[3], aMinMax[4], aMinMax[5]);
+
+        for (int aCoord = 0; aCoord < 6; ++aCoord)
+        {
+          HashCombine (aHash, std::hash<double> () (aMinMax[aCoord]));
+        }
+      }
+
+      return aHash;
+    }
+
+    size_t aHash = 0;
+
+    Handle (mesh::AisMesh) aMesh = Handle (mesh::AisMesh)::DownCast (theObject);
+
+    if (!aMesh.IsNull ()) // geometry of AIS mesh is never modified
+    {
+      HashCombine (aHash, std::hash<std::string> () (aMesh->Name ().ToCString ()));
+
+      const Handle (Graphic3d_ArrayOfTriangles)& aTriangles = aMesh->Triangles ();
+
+      if (!aTriangles.IsNull () && !aTriangles->Attributes ().IsNull ())
+      {
+        hashBytes (aHash, aTriangles->Attributes ()->Data (), aTriangles->Attributes ()->Size ());
+
+        if (!aTriangles->Indices ().IsNull ())
+        {
+          hashBytes (aHash, aTriangles->Indices ()->Data (), aTriangles->Indices ()->Size ());
+        }
+      }
+    }
+
+    return aHash;
+  }
+
+  //===========================================================================
+  //function : Compute
+  //purpose  :
+  //===========================================================================
+  size_t Fingerprints::Compute (const TopoDS_Shape& theShape)
+  {
+    size_t aHash = 0;
+
+    // Vertices are located, so they reflect transformation of sub-shapes
+    for (TopExp_Explorer anExp (theShape, TopAbs_VERTEX); anExp.More (); anExp.Next ())
+    {
+      hashXYZ (aHash, BRep_Tool::Pnt (TopoDS::Vertex (anExp.Current ())).XYZ ());
+    }
+
+    for (TopExp_Explorer anExp (theShape, TopAbs_EDGE); anExp.More (); anExp.Next ())
+    {
+      Standard_Real aFirst = 0.0;
+      Standard_Real aLast  = 0.0;
+
+      BRep_Tool::Range (TopoDS::Edge (anExp.Current ()), aFirst, aLast);
+
+      HashCombine (aHash, std::hash<double> () (aFirst));
+      HashCombine (aHash, std::hash<double> () (aLast));
+      HashCombine (aHash, static_cast<size_t> (anExp.Current ().Orientation ()));
+    }
+
+    // Triangulation is stored in the file too, and it reflects shape of surfaces
+    for (TopExp_Explorer anExp (theShape, TopAbs_FACE); anExp.More (); anExp.Next ())
+    {
+      const TopoDS_Face& aFace = TopoDS::Face (anExp.Current ());
+
+      TopLoc_Location aLocation;
+
+      const Handle (Poly_Triangulation)& aTriangulation = BRep_Tool::Triangulation (aFace, aLocation);
+
+      HashCombine (aHash, static_cast<size_t> (aFace.Orientation ()));
+
+      if (aTriangulation.IsNull ())
+      {
+        continue;
+      }
+
+      hashLocation (aHash, aLocation);
+
+      HashCombine (aHash, std::hash<double> () (aTriangulation->Deflection ()));
+
+      const TColgp_Array1OfPnt& aNodes = aTriangulation->Nodes ();
+
+      for (int aNodeIdx = aNodes.Lower (); aNodeIdx <= aNodes.Upper (); ++aNodeIdx)
+      {
+        hashXYZ (aHash, aNodes (aNodeIdx).XYZ ());
+      }
+
+      const Poly_Array1OfTriangle& aTriangles = aTriangulation->Triangles ();
+
+      for (int aTrgIdx = aTriangles.Lower (); aTrgIdx <= aTriangles.Upper (); ++aTrgIdx)
+      {
+        int aNodeIDs[3];
+
+        aTriangles (aTrgIdx).Get (aNodeIDs[0], aNodeIDs[1], aNodeIDs[2]);
+
+        hashBytes (aHash, aNodeIDs, sizeof (aNodeIDs));
+      }
+    }
+
+    hashLocation (aHash, theShape.Location ());
+
+    HashCombine (aHash, static_cast<size_t> (theShape.Orientation ()));
+
+    return aHash;
+  }
+
+  //===========================================================================
+  //function : Load
+  //purpose  :
+  //===========================================================================
+  bool Fingerprints::Load (const TCollection_AsciiString& theFileName)
+  {
+    myHashes.clear ();
+
+    std::ifstream aStream (theFileName.ToCString ());
+
+    if (!aStream.is_open ())
+    {
+      return false;
+    }
+
+    std::string aLine;
+
+    if (!std::getline (aStream, aLine))
+    {
+      return false;
+    }
+
+    std::istringstream aHeader (aLine);
+
+    std::string aMagic;
+    int         aVersion = 0;
+
+    aHeader >> aMagic >> aVersion;
+
+    if (aMagic != "CADRAYS_FINGERPRINTS" || aVersion != THE_FORMAT_VERSION)
+    {
+      return false; // exported by other version
+    }
+
+    while (std::getline (aStream, aLine))
+    {
+      std::istringstream aRecord (aLine);
+
+      size_t aHash = 0;
+
+      if (aRecord >> aHash)
+      {
+        std::string aFileName;
+
+        std::getline (aRecord >> std::ws, aFileName);
+
+        if (!aFileName.empty ())
+        {
+          myHashes[aFileName] = aHash;
+        }
+      }
+    }
+
+    return true;
+  }
+
+  //===========================================================================
+  //function : Save
+  //purpose  :
+  //===========================================================================
+  bool Fingerprints::Save (const TCollection_AsciiString& theFileName) const
+  {
+    std::ofstream aStream (theFileName.ToCString ());
+
+    if (!aStream.is_open ())
+    {
+      return false;
+    }
+
+    aStream << "CADRAYS_FINGERPRINTS " << THE_FORMAT_VERSION << "\n";
+
+    for (auto aHashIter = myHashes.begin (); aHashIter != myHashes.end (); ++aHashIter)
+    {
+      aStream << aHashIter->second << " " << aHashIter->first << "\n";
+    }
+
+    return aStream.good ();
+  }
+
+  //===========================================================================
+  //function : IsChanged
+  //purpose  :
+  //===========================================================================
+  bool Fingerprints::IsChanged (const TCollection_AsciiString& theFileName, const size_t theHash) const
+  {
+    auto aHashIter = myHashes.find (theFileName.ToCString ());
+
+    return aHashIter == myHashes.end () || aHashIter->second != theHash;
+  }
+}
@@ -0,0 +1,72 @@
+// Created: 2019-06-14
+//
+// Copyright (c) 2019 OPEN CASCADE SAS
+//
+// This file is a part of CADRays software.
+//
+// CADRays is free software; you can use it under the terms of the MIT license,
+// refer to file LICENSE.txt for complete text of the license and disclaimer of
+// any warranty.
+
+#ifndef _RT_Fingerprints_Header
+#define _RT_Fingerprints_Header
+
+#include <TopoDS_Shape.hxx>
+#include <AIS_InteractiveObject.hxx>
+
+#include <map>
+#include <string>
+
+namespace ie
+{
+  //! Combines the given hash value with the seed.
+  inline void HashCombine (size_t& theSeed, const size_t theValue)
+  {
+    theSeed ^= theValue + 0x9e3779b9 + (theSeed << 6) + (theSeed >> 2);
+  }
+
+  //! Set of content fingerprints of exported files (for incremental export).
+  //! Fingerprints are computed from geometry data only, so they remain valid
+  //! after restart of the application.
+  class Fingerprints
+  {
+  public:
+
+    //! Computes fingerprint of the geometry stored for the given AIS object.
+    Standard_EXPORT static size_t Compute (const Handle (AIS_InteractiveObject)& theObject);
+
+    //! Computes fingerprint of the given shape (geometry of vertices and edges,
+    //! triangulation of faces, location and orientation).
+    Standard_EXPORT static size_t Compute (const TopoDS_Shape& theShape);
+
+  public:
+
+    //! Loads fingerprints from the given file (fails for files of other versions).
+    Standard_EXPORT bool Load (const TCollection_AsciiString& theFileName);
+
+    //! Saves fingerprints to the given file.
+    Standard_EXPORT bool Save (const TCollection_AsciiString& theFileName) const;
+
+    //! Checks if the given file should be rewritten.
+    Standard_EXPORT bool IsChanged (const TCollection_AsciiString& theFileName, const size_t theHash) const;
+
+    //! Sets fingerprint of the given file.
+    void Bind (const TCollection_AsciiString& theFileName, const size_t theHash)
+    {
+      myHashes[theFileName.ToCString ()] = theHash;
+    }
+
+    //! Returns all fingerprints (file name to hash).
+    const std::map<std::string, size_t>& Hashes () const
+    {
+      return myHashes;
+    }
+
+  protected:
+
+    //! Fingerprints of the files.
+    std::map<std::string, size_t> myHashes;
+  };
+}
+
+#endif // _RT_Fingerprints_Header
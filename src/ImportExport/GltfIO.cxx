@@ -0,0 +1,2476 @@
+// Created: 2019-06-21
+//
+// Copyright (c) 2019 OPEN CASCADE SAS
+//
+// This file is a part of CADRays software.
+//
+// CADRays is free software; you can use it under the terms of the MIT license,
+// refer to file LICENSE.txt for complete text of the license and disclaimer of
+// any warranty.
+
+#ifdef _WIN32
+  #ifndef NOMINMAX
+    #define NOMINMAX
+  #endif
+  #include <windows.h>
+#else
+  #include <fcntl.h>
+  #include <unistd.h>
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+#endif
+
+#include <AIS_Shape.hxx>
+#include <AIS_TexturedShape.hxx>
+
+#include <BRep_Tool.hxx>
+#include <BRepTools.hxx>
+
+#include <Poly_Connect.hxx>
+#include <Poly_Triangulation.hxx>
+
+#include <StdPrs_ToolTriangulatedShape.hxx>
+
+#include <TopoDS.hxx>
+#include <TopExp_Explorer.hxx>
+#include <TColgp_Array1OfDir.hxx>
+
+#include <OSD_File.hxx>
+#include <OSD_Path.hxx>
+#include <OSD_Directory.hxx>
+#include <OSD_Protection.hxx>
+
+#include <TCollection_ExtendedString.hxx>
+
+#include <gp.hxx>
+#include <gp_Mat.hxx>
+#include <gp_Quaternion.hxx>
+#include <Precision.hxx>
+
+#include <set>
+#include <map>
+#include <cmath>
+#include <cfloat>
+#include <cstdio>
+#include <limits>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <algorithm>
+#include <stdexcept>
+
+#include <Utils.hxx>
+#include <AisMesh.hxx>
+
+#include "GltfIO.hxx"
+
+namespace ie
+{
+  namespace
+  {
+    //! GLB header magic ("glTF").
+    static const unsigned THE_GLB_MAGIC = 0x46546C67;
+
+    //! Type of GLB chunk with JSON content ("JSON").
+    static const unsigned THE_CHUNK_JSON = 0x4E4F534A;
+
+    //! Type of GLB chunk with binary buffer ("BIN").
+    static const unsigned THE_CHUNK_BIN = 0x004E4942;
+
+    //! Component types of glTF accessors.
+    enum ComponentType
+    {
+      Component_UInt8   = 5121,
+      Component_UInt16  = 5123,
+      Component_UInt32  = 5125,
+      Component_Float32 = 5126
+    };
+
+    //! Targets of glTF buffer views.
+    enum BufferTarget
+    {
+      Target_Vertices = 34962,
+      Target_Indices  = 34963
+    };
+
+    //! Transformation of Z-up scene to Y-up glTF space (column-major).
+    static const double THE_Z_UP_TO_Y_UP[] = { 1.0, 0.0,  0.0, 0.0,
+                                                0.0, 0.0, -1.0, 0.0,
+                                                0.0, 1.0,  0.0, 0.0,
+                                                0.0, 0.0,  0.0, 1.0 };
+
+    //===========================================================================
+    //function : initStream
+    //purpose  : Prepares string stream for writing JSON numbers
+    //===========================================================================
+    static void initStream (std::ostringstream& theStream)
+    {
+      theStream.imbue (std::locale::classic ());
+
+      theStream.precision (std::numeric_limits<float>::max_digits10);
+    }
+
+    //===========================================================================
+    //function : jsonString
+    //purpose  : Converts the given string to quoted JSON string
+    //===========================================================================
+    static std::string jsonString (const std::string& theString)
+    {
+      std::string aResult = "\"";
+
+      for (size_t aCharIdx = 0; aCharIdx < theString.size (); ++aCharIdx)
+      {
+        const char aChar = theString[aCharIdx];
+
+        if (aChar == '\"' || aChar == '\\')
+        {
+          aResult += '\\';
+          aResult += aChar;
+        }
+        else if (static_cast<unsigned char> (aChar) < 0x20)
+        {
+          char aCode[8];
+
+          sprintf (aCode, "\\u%04x", static_cast<unsigned> (aChar));
+
+          aResult += aCode;
+        }
+        else
+        {
+          aResult += aChar;
+        }
+      }
+
+      return aResult + "\"";
+    }
+
+    //===========================================================================
+    //function : jsonArray
+    //purpose  : Writes the named array of JSON objects (if not empty)
+    //===========================================================================
+    static void jsonArray (std::ostream& theStream, const char* theName, const std::vector<std::string>& theItems)
+    {
+      if (theItems.empty ())
+      {
+        return;
+      }
+
+      theStream << ",\"" << theName << "\":[";
+
+      for (size_t anItemIdx = 0; anItemIdx < theItems.size (); ++anItemIdx)
+      {
+        theStream << (anItemIdx == 0 ? "" : ",") << theItems[anItemIdx];
+      }
+
+      theStream << "]";
+    }
+
+    //===========================================================================
+    //function : writeUInt32
+    //purpose  : Writes 32-bit unsigned integer in little-endian order
+    //===========================================================================
+    static void writeUInt32 (std::ostream& theStream, const unsigned theValue)
+    {
+      const char aBytes[] = { static_cast<char> ((theValue >>  0) & 0xFF),
+                              static_cast<char> ((theValue >>  8) & 0xFF),
+                              static_cast<char> ((theValue >> 16) & 0xFF),
+                              static_cast<char> ((theValue >> 24) & 0xFF) };
+
+      theStream.write (aBytes, 4);
+    }
+
+    //===========================================================================
+    //function : readUInt32
+    //purpose  : Reads 32-bit unsigned integer in little-endian order
+    //===========================================================================
+    static unsigned readUInt32 (const unsigned char* theData)
+    {
+      return static_cast<unsigned> (theData[0])
+          | (static_cast<unsigned> (theData[1]) <<  8)
+          | (static_cast<unsigned> (theData[2]) << 16)
+          | (static_cast<unsigned> (theData[3]) << 24);
+    }
+
+    //===========================================================================
+    //function : maxComponent
+    //purpose  :
+    //===========================================================================
+    static float maxComponent (const Graphic3d_Vec3& theVec)
+    {
+      return std::max (theVec.x (), std::max (theVec.y (), theVec.z ()));
+    }
+
+    //! Minimal JSON value (DOM) to access glTF header.
+    class JsonValue
+    {
+      friend class JsonParser;
+
+    public:
+
+      //! Type of JSON value.
+      enum Type
+      {
+        Json_Null,
+        Json_Bool,
+        Json_Number,
+        Json_String,
+        Json_Array,
+        Json_Object
+      };
+
+    public:
+
+      //! Creates null value.
+      JsonValue () : myType (Json_Null), myNumber (0.0)
+      {
+        //
+      }
+
+      //! Checks if the value is null (or missing).
+      bool IsNull () const { return myType == Json_Null; }
+
+      //! Returns numeric value (or the given default one).
+      double Number (const double theDefault = 0.0) const
+      {
+        return myType == Json_Number || myType == Json_Bool ? myNumber : theDefault;
+      }
+
+      //! Returns integer value (or the given default one).
+      int Int (const int theDefault = -1) const
+      {
+        return myType == Json_Number ? static_cast<int> (myNumber) : theDefault;
+      }
+
+      //! Returns size value (or the given default one).
+      size_t Size (const size_t theDefault = 0) const
+      {
+        return myType == Json_Number && myNumber >= 0.0 ? static_cast<size_t> (myNumber) : theDefault;
+      }
+
+      //! Returns string value (empty for non-string values).
+      const std::string& String () const { return myString; }
+
+      //! Returns number of array items (or object members).
+      size_t Length () const { return myItems.size (); }
+
+      //! Returns array item (null value if missing).
+      const JsonValue& operator[] (const size_t theIndex) const
+      {
+        return myType == Json_Array && theIndex < myItems.size () ? myItems[theIndex] : null ();
+      }
+
+      //! Returns array item (null value if missing).
+      const JsonValue& operator[] (const int theIndex) const
+      {
+        return theIndex >= 0 ? (*this)[static_cast<size_t> (theIndex)] : null ();
+      }
+
+      //! Returns object member (null value if missing).
+      const JsonValue& operator[] (const char* theKey) const
+      {
+        for (size_t aKeyIdx = 0; aKeyIdx < myKeys.size (); ++aKeyIdx)
+        {
+          if (myKeys[aKeyIdx] == theKey)
+          {
+            return myItems[aKeyIdx];
+          }
+        }
+
+        return null ();
+      }
+
+    private:
+
+      //! Returns shared null value.
+      static const JsonValue& null ()
+      {
+        static const JsonValue aNull;
+
+        return aNull;
+      }
+
+    private:
+
+      //! Type of the value.
+      Type myType;
+
+      //! Value of number or boolean.
+      double myNumber;
+
+      //! Value of string.
+      std::string myString;
+
+      //! Items of array or values of object members.
+      std::vector<JsonValue> myItems;
+
+      //! Keys of object members.
+      std::vector<std::string> myKeys;
+    };
+
+    //! Minimal recursive descent JSON parser.
+    class JsonParser
+    {
+    public:
+
+      //! Creates parser for the given text range.
+      JsonParser (const char* theBegin, const char* theEnd) : myPos (theBegin), myEnd (theEnd)
+      {
+        //
+      }
+
+      //! Parses the whole text into the given value.
+      bool Parse (JsonValue& theValue)
+      {
+        if (!parseValue (theValue, 0))
+        {
+          return false;
+        }
+
+        skipSpaces ();
+
+        return myPos == myEnd;
+      }
+
+    private:
+
+      //! Skips white spaces (and zero padding).
+      void skipSpaces ()
+      {
+        while (myPos != myEnd && (*myPos == ' ' || *myPos == '\t' || *myPos == '\n' || *myPos == '\r' || *myPos == '\0'))
+        {
+          ++myPos;
+        }
+      }
+
+      //! Parses the given literal.
+      bool parseLiteral (const char* theLiteral)
+      {
+        const size_t aLength = strlen (theLiteral);
+
+        if (static_cast<size_t> (myEnd - myPos) < aLength || strncmp (myPos, theLiteral, aLength) != 0)
+        {
+          return false;
+        }
+
+        myPos += aLength;
+
+        return true;
+      }
+
+      //! Parses JSON string.
+      bool parseString (std::string& theString)
+      {
+        if (myPos == myEnd || *myPos != '\"')
+        {
+          return false;
+        }
+
+        for (++myPos; myPos != myEnd; ++myPos)
+        {
+          if (*myPos == '\"')
+          {
+            ++myPos;
+
+            return true;
+          }
+
+          if (*myPos != '\\')
+          {
+            theString += *myPos;
+
+            continue;
+          }
+
+          if (++myPos == myEnd)
+          {
+            return false;
+          }
+
+          switch (*myPos)
+          {
+            case 'b': theString += '\b'; break;
+            case 'f': theString += '\f'; break;
+            case 'n': theString += '\n'; break;
+            case 'r': theString += '\r'; break;
+            case 't': theString += '\t'; break;
+            case 'u':
+            {
+              if (myEnd - myPos < 5)
+              {
+                return false;
+              }
+
+              const unsigned aCode = static_cast<unsigned> (strtoul (std::string (myPos + 1, 4).c_str (), NULL, 16));
+
+              // encode code point in UTF-8 (surrogate pairs are not combined)
+              if (aCode < 0x80)
+              {
+                theString += static_cast<char> (aCode);
+              }
+              else if (aCode < 0x800)
+              {
+                theString += static_cast<char> (0xC0 | (aCode >> 6));
+                theString += static_cast<char> (0x80 | (aCode & 0x3F));
+              }
+              else
+              {
+                theString += static_cast<char> (0xE0 | (aCode >> 12));
+                theString += static_cast<char> (0x80 | ((aCode >> 6) & 0x3F));
+                theString += static_cast<char> (0x80 | (aCode & 0x3F));
+              }
+
+              myPos += 4;
+            }
+            break;
+
+            default: theString += *myPos;
+          }
+        }
+
+        return false;
+      }
+
+      //! Parses JSON value.
+      bool parseValue (JsonValue& theValue, const int theDepth)
+      {
+        if (theDepth > 256) // protect from stack overflow
+        {
+          return false;
+        }
+
+        skipSpaces ();
+
+        if (myPos == myEnd)
+        {
+          return false;
+        }
+
+        if (*myPos == '{')
+        {
+          theValue.myType = JsonValue::Json_Object;
+
+          ++myPos;
+
+          skipSpaces ();
+
+          if (myPos != myEnd && *myPos == '}')
+          {
+            ++myPos;
+
+            return true;
+          }
+
+          for (;;)
+          {
+            skipSpaces ();
+
+            theValue.myKeys.push_back (std::string ());
+
+            if (!parseString (theValue.myKeys.back ()))
+            {
+              return false;
+            }
+
+            skipSpaces ();
+
+            if (myPos == myEnd || *myPos++ != ':')
+            {
+              return false;
+            }
+
+            theValue.myItems.push_back (JsonValue ());
+
+            if (!parseValue (theValue.myItems.back (), theDepth + 1))
+            {
+              return false;
+            }
+
+            skipSpaces ();
+
+            if (myPos == myEnd)
+            {
+              return false;
+            }
+
+            if (*myPos++ == '}')
+            {
+              return true;
+            }
+            else if (*(myPos - 1) != ',')
+            {
+              return false;
+            }
+          }
+        }
+        else if (*myPos == '[')
+        {
+          theValue.myType = JsonValue::Json_Array;
+
+          ++myPos;
+
+          skipSpaces ();
+
+          if (myPos != myEnd && *myPos == ']')
+          {
+            ++myPos;
+
+            return true;
+          }
+
+          for (;;)
+          {
+            theValue.myItems.push_back (JsonValue ());
+
+            if (!parseValue (theValue.myItems.back (), theDepth + 1))
+            {
+              return false;
+            }
+
+            skipSpaces ();
+
+            if (myPos == myEnd)
+            {
+              return false;
+            }
+
+            if (*myPos++ == ']')
+            {
+              return true;
+            }
+            else if (*(myPos - 1) != ',')
+            {
+              return false;
+            }
+          }
+        }
+        else if (*myPos == '\"')
+        {
+          theValue.myType = JsonValue::Json_String;
+
+          return parseString (theValue.myString);
+        }
+        else if (*myPos == 't' || *myPos == 'f')
+        {
+          theValue.myType = JsonValue::Json_Bool;
+          theValue.myNumber = *myPos == 't' ? 1.0 : 0.0;
+
+          return parseLiteral (*myPos == 't' ? "true" : "false");
+        }
+        else if (*myPos == 'n')
+        {
+          return parseLiteral ("null");
+        }
+
+        std::string aToken;
+
+        while (myPos != myEnd && strchr ("+-0123456789.eE", *myPos) != NULL)
+        {
+          aToken += *myPos++;
+        }
+
+        std::istringstream aStream (aToken);
+
+        aStream.imbue (std::locale::classic ());
+
+        theValue.myType = JsonValue::Json_Number;
+
+        return !aToken.empty () && (aStream >> theValue.myNumber);
+      }
+
+    private:
+
+      //! Current parsing position.
+      const char* myPos;
+
+      //! End of parsed text.
+      const char* myEnd;
+    };
+
+    //! Read-only memory mapping of the whole file.
+    class MappedFile
+    {
+    public:
+
+      //! Creates empty mapping.
+      MappedFile () : myData (NULL), mySize (0)
+      {
+#ifdef _WIN32
+        myFile    = INVALID_HANDLE_VALUE;
+        myMapping = NULL;
+#else
+        myFile = -1;
+#endif
+      }
+
+      //! Releases the mapping.
+      ~MappedFile ()
+      {
+#ifdef _WIN32
+        if (myData != NULL)
+        {
+          UnmapViewOfFile (myData);
+        }
+
+        if (myMapping != NULL)
+        {
+          CloseHandle (myMapping);
+        }
+
+        if (myFile != INVALID_HANDLE_VALUE)
+        {
+          CloseHandle (myFile);
+        }
+#else
+        if (myData != NULL)
+        {
+          munmap (const_cast<unsigned char*> (myData), mySize);
+        }
+
+        if (myFile != -1)
+        {
+          close (myFile);
+        }
+#endif
+      }
+
+      //! Maps the given file into memory.
+      bool Open (const TCollection_AsciiString& theFileName)
+      {
+#ifdef _WIN32
+        const TCollection_ExtendedString aFileNameW (theFileName, Standard_True);
+
+        myFile = CreateFileW ((const wchar_t* )aFileNameW.ToExtString (), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+
+        LARGE_INTEGER aSize;
+
+        if (myFile == INVALID_HANDLE_VALUE || !GetFileSizeEx (myFile, &aSize) || aSize.QuadPart == 0)
+        {
+          return false;
+        }
+
+        mySize = static_cast<size_t> (aSize.QuadPart);
+
+        if ((myMapping = CreateFileMappingW (myFile, NULL, PAGE_READONLY, 0, 0, NULL)) == NULL)
+        {
+          return false;
+        }
+
+        myData = static_cast<const unsigned char*> (MapViewOfFile (myMapping, FILE_MAP_READ, 0, 0, 0));
+#else
+        if ((myFile = open (theFileName.ToCString (), O_RDONLY)) == -1)
+        {
+          return false;
+        }
+
+        struct stat aStat;
+
+        if (fstat (myFile, &aStat) != 0 || aStat.st_size == 0)
+        {
+          return false;
+        }
+
+        mySize = static_cast<size_t> (aStat.st_size);
+
+        void* aData = mmap (NULL, mySize, PROT_READ, MAP_PRIVATE, myFile, 0);
+
+        myData = aData != MAP_FAILED ? static_cast<const unsigned char*> (aData) : NULL;
+#endif
+
+        return myData != NULL;
+      }
+
+      //! Returns mapped data.
+      const unsigned char* Data () const { return myData; }
+
+      //! Returns size of mapped data.
+      size_t Size () const { return mySize; }
+
+    private:
+
+      //! Mapped file contents.
+      const unsigned char* myData;
+
+      //! Size of mapped file.
+      size_t mySize;
+
+#ifdef _WIN32
+      HANDLE myFile;
+      HANDLE myMapping;
+#else
+      int myFile;
+#endif
+    };
+
+    //! Affine 3x4 transformation (row-major).
+    struct Matrix
+    {
+      double Values[12];
+
+      //! Creates identity transformation.
+      Matrix ()
+      {
+        for (int anIdx = 0; anIdx < 12; ++anIdx)
+        {
+          Values[anIdx] = (anIdx % 5 == 0) ? 1.0 : 0.0;
+        }
+      }
+
+      //! Creates transformation from column-major 4x4 glTF matrix.
+      explicit Matrix (const double* theColumnMajor)
+      {
+        for (int aRow = 0; aRow < 3; ++aRow)
+        {
+          for (int aCol = 0; aCol < 4; ++aCol)
+          {
+            Values[aRow * 4 + aCol] = theColumnMajor[aCol * 4 + aRow];
+          }
+        }
+      }
+
+      //! Returns element of transformation matrix.
+      double operator() (const int theRow, const int theCol) const
+      {
+        return Values[theRow * 4 + theCol];
+      }
+
+      //! Returns product of two transformations.
+      Matrix operator* (const Matrix& theOther) const
+      {
+        Matrix aResult;
+
+        for (int aRow = 0; aRow < 3; ++aRow)
+        {
+          for (int aCol = 0; aCol < 4; ++aCol)
+          {
+            double aValue = aCol == 3 ? Values[aRow * 4 + 3] : 0.0;
+
+            for (int anIdx = 0; anIdx < 3; ++anIdx)
+            {
+              aValue += Values[aRow * 4 + anIdx] * theOther (anIdx, aCol);
+            }
+
+            aResult.Values[aRow * 4 + aCol] = aValue;
+          }
+        }
+
+        return aResult;
+      }
+    };
+
+    //! Tool writing data nodes to GLB file.
+    class GltfWriter
+    {
+    public:
+
+      //! Creates new writer.
+      GltfWriter ()
+      {
+        //
+      }
+
+      //! Adds the given data node (with sub-nodes) and returns its index.
+      int AddNode (model::DataNode* theNode);
+
+      //! Writes GLB file with the given root nodes.
+      bool Save (const TCollection_AsciiString& theFileName, const std::vector<int>& theRoots);
+
+    private:
+
+      //! Appends the given data to binary buffer and creates buffer view.
+      int addBufferView (const void* theData, const size_t theSize, const size_t theStride, const int theTarget);
+
+      //! Creates accessor to the given buffer view.
+      int addAccessor (const int    theView,
+                       const size_t theOffset,
+                       const int    theComponent,
+                       const size_t theCount,
+                       const char*  theType,
+                       const float* theMin = NULL,
+                       const float* theMax = NULL);
+
+      //! Creates (or reuses) glTF material for the given AIS object.
+      int addMaterial (const Handle (AIS_InteractiveObject)& theObject);
+
+      //! Creates (or reuses) glTF texture for the given image file.
+      int addTexture (const TCollection_AsciiString& thePath);
+
+      //! Creates glTF mesh for the shape (triangulation of its faces).
+      int addShapeMesh (const Handle (AIS_Shape)& theObject, const int theMaterial);
+
+      //! Creates glTF mesh for the triangle array (directly mapped to buffer views).
+      int addArrayMesh (const Handle (mesh::AisMesh)& theObject, const int theMaterial);
+
+      //! Creates glTF mesh with single primitive.
+      int addMesh (const std::string& theName,
+                   const int          thePosition,
+                   const int          theNormal,
+                   const int          theTexcoord,
+                   const int          theIndices,
+                   const int          theMaterial);
+
+    private:
+
+      //! Binary chunk of GLB file.
+      std::string myBinary;
+
+      //! Serialized glTF nodes.
+      std::vector<std::string> myNodes;
+
+      //! Serialized glTF meshes.
+      std::vector<std::string> myMeshes;
+
+      //! Serialized glTF materials.
+      std::vector<std::string> myMaterials;
+
+      //! Serialized glTF textures.
+      std::vector<std::string> myTextures;
+
+      //! Serialized glTF images.
+      std::vector<std::string> myImages;
+
+      //! Serialized glTF accessors.
+      std::vector<std::string> myAccessors;
+
+      //! Serialized glTF buffer views.
+      std::vector<std::string> myBufferViews;
+
+      //! Indices of meshes created for geometry/material pairs (for instancing).
+      std::map<std::string, int> myMeshIDs;
+
+      //! Indices of materials created for material keys.
+      std::map<std::string, int> myMaterialIDs;
+
+      //! Indices of textures created for image files.
+      std::map<std::string, int> myTextureIDs;
+
+      //! glTF extensions used by materials.
+      std::set<std::string> myExtensions;
+    };
+
+    //===========================================================================
+    //function : addBufferView
+    //purpose  :
+    //===========================================================================
+    int GltfWriter::addBufferView (const void* theData, const size_t theSize, const size_t theStride, const int theTarget)
+    {
+      myBinary.resize ((myBinary.size () + 3) & ~static_cast<size_t> (3), '\0'); // 4-byte alignment
+
+      std::ostringstream aJson;
+
+      initStream (aJson);
+
+      aJson << "{\"buffer\":0,\"byteOffset\":" << myBinary.size () << ",\"byteLength\":" << theSize;
+
+      if (theStride != 0)
+      {
+        aJson << ",\"byteStride\":" << theStride;
+      }
+
+      if (theTarget != 0)
+      {
+        aJson << ",\"target\":" << theTarget;
+      }
+
+      aJson << "}";
+
+      myBinary.append (static_cast<const char*> (theData), theSize);
+
+      myBufferViews.push_back (aJson.str ());
+
+      return static_cast<int> (myBufferViews.size ()) - 1;
+    }
+
+    //===========================================================================
+    //function : addAccessor
+    //purpose  :
+    //===========================================================================
+    int GltfWriter::addAccessor (const int    theView,
+                                 const size_t theOffset,
+                                 const int    theComponent,
+                                 const size_t theCount,
+                                 const char*  theType,
+                                 const float* theMin,
+                                 const float* theMax)
+    {
+      std::ostringstream aJson;
+
+      initStream (aJson);
+
+      aJson << "{\"bufferView\":" << theView << ",\"byteOffset\":" << theOffset
+            << ",\"componentType\":" << theComponent << ",\"count\":" << theCount << ",\"type\":\"" << theType << "\"";
+
+      if (theMin != NULL && theMax != NULL)
+      {
+        aJson << ",\"min\":[" << theMin[0] << "," << theMin[1] << "," << theMin[2] << "]"
+              << ",\"max\":[" << theMax[0] << "," << theMax[1] << "," << theMax[2] << "]";
+      }
+
+      aJson << "}";
+
+      myAccessors.push_back (aJson.str ());
+
+      return static_cast<int> (myAccessors.size ()) - 1;
+    }
+
+    //===========================================================================
+    //function : addTexture
+    //purpose  :
+    //===========================================================================
+    int GltfWriter::addTexture (const TCollection_AsciiString& thePath)
+    {
+      auto aTextureIter = myTextureIDs.find (thePath.ToCString ());
+
+      if (aTextureIter != myTextureIDs.end ())
+      {
+        return aTextureIter->second;
+      }
+
+      TCollection_AsciiString anExtension = OSD_Path (thePath).Extension ();
+
+      anExtension.LowerCase ();
+
+      std::ostringstream aJson;
+
+      initStream (aJson);
+
+      std::ifstream aStream (thePath.ToCString (), std::ios_base::in | std::ios_base::binary);
+
+      if (aStream.is_open () && (anExtension == ".png" || anExtension == ".jpg" || anExtension == ".jpeg"))
+      {
+        std::ostringstream aBuffer;
+
+        aBuffer << aStream.rdbuf ();
+
+        const std::string anImage = aBuffer.str ();
+
+        // PNG and JPEG images are embedded into binary chunk
+        aJson << "{\"bufferView\":" << addBufferView (anImage.data (), anImage.size (), 0, 0)
+              << ",\"mimeType\":\"" << (anExtension == ".png" ? "image/png" : "image/jpeg") << "\"}";
+      }
+      else // other formats are referenced
+      {
+        aJson << "{\"uri\":" << jsonString (thePath.ToCString ()) << "}";
+      }
+
+      myImages.push_back (aJson.str ());
+
+      std::ostringstream aTexture;
+
+      aTexture << "{\"source\":" << myImages.size () - 1 << "}";
+
+      myTextures.push_back (aTexture.str ());
+
+      return myTextureIDs[thePath.ToCString ()] = static_cast<int> (myTextures.size ()) - 1;
+    }
+
+    //===========================================================================
+    //function : addMaterial
+    //purpose  :
+    //===========================================================================
+    int GltfWriter::addMaterial (const Handle (AIS_InteractiveObject)& theObject)
+    {
+      Graphic3d_AspectFillArea3d* anAspect = model::GetAspect (theObject);
+
+      const Graphic3d_MaterialAspect& aMaterial = anAspect->FrontMaterial ();
+
+      const Graphic3d_BSDF& aBSDF = aMaterial.BSDF ();
+
+      TCollection_AsciiString aTexturePath;
+
+      Handle (Graphic3d_TextureRoot) aTexMap = Handle (Graphic3d_TextureRoot)::DownCast (anAspect->TextureMap ());
+
+      if (!aTexMap.IsNull () && anAspect->ToMapTexture ())
+      {
+        aTexMap->Path ().SystemName (aTexturePath);
+      }
+
+      const int aMatIndex = aMaterial.Name ();
+
+      const TCollection_AsciiString aMatName = aMatIndex < Graphic3d_MaterialAspect::NumberOfMaterials () ?
+        TCollection_AsciiString (Graphic3d_MaterialAspect::MaterialName (aMatIndex + 1)) : TCollection_AsciiString ();
+
+      const TCollection_AsciiString aSerialized = model::SerializeBSDF (aBSDF);
+
+      const std::string aKey = std::string (aSerialized.ToCString ()) + "|" + aMatName.ToCString () + "|" + aTexturePath.ToCString ();
+
+      auto aMaterialIter = myMaterialIDs.find (aKey);
+
+      if (aMaterialIter != myMaterialIDs.end ())
+      {
+        return aMaterialIter->second;
+      }
+
+      // Approximate CADRays BSDF by metallic-roughness model
+      const Graphic3d_Vec4 aFresnel = aBSDF.FresnelBase.Serialize ();
+
+      const bool isMetal = aBSDF.FresnelBase.FresnelType () == Graphic3d_FM_SCHLICK
+                        || aBSDF.FresnelBase.FresnelType () == Graphic3d_FM_CONDUCTOR;
+
+      Graphic3d_Vec3 aBaseColor = aBSDF.Kd;
+
+      if (isMetal)
+      {
+        aBaseColor = Graphic3d_Vec3 (aBSDF.Ks.x (), aBSDF.Ks.y (), aBSDF.Ks.z ());
+
+        if (aBSDF.FresnelBase.FresnelType () == Graphic3d_FM_SCHLICK)
+        {
+          aBaseColor *= Graphic3d_Vec3 (aFresnel.r (), aFresnel.g (), aFresnel.b ());
+        }
+      }
+      else if (maxComponent (aBSDF.Kt) > 0.f && maxComponent (aBSDF.Kd) == 0.f)
+      {
+        aBaseColor = aBSDF.Kt; // pure transparent material
+      }
+
+      std::ostringstream aJson;
+
+      initStream (aJson);
+
+      aJson << "{\"name\":" << jsonString (aMatName.IsEmpty () ? "Material" : aMatName.ToCString ());
+
+      aJson << ",\"pbrMetallicRoughness\":{\"baseColorFactor\":[" << std::min (aBaseColor.r (), 1.f) << ","
+                                                                 << std::min (aBaseColor.g (), 1.f) << ","
+                                                                 << std::min (aBaseColor.b (), 1.f) << ",1]"
+            << ",\"metallicFactor\":" << (isMetal ? 1 : 0)
+            << ",\"roughnessFactor\":" << std::max (0.f, std::min (aBSDF.Ks.w (), 1.f));
+
+      if (!aTexturePath.IsEmpty ())
+      {
+        aJson << ",\"baseColorTexture\":{\"index\":" << addTexture (aTexturePath) << "}";
+      }
+
+      aJson << "}";
+
+      const float anEmission = maxComponent (aBSDF.Le);
+
+      if (anEmission > 0.f)
+      {
+        const float aScale = std::max (anEmission, 1.f);
+
+        aJson << ",\"emissiveFactor\":[" << aBSDF.Le.x () / aScale << ","
+                                         << aBSDF.Le.y () / aScale << ","
+                                         << aBSDF.Le.z () / aScale << "]";
+      }
+
+      std::ostringstream anExtensions;
+
+      initStream (anExtensions);
+
+      if (anEmission > 1.f)
+      {
+        anExtensions << ",\"KHR_materials_emissive_strength\":{\"emissiveStrength\":" << anEmission << "}";
+      }
+
+      if (maxComponent (aBSDF.Kt) > 0.f)
+      {
+        anExtensions << ",\"KHR_materials_transmission\":{\"transmissionFactor\":" << std::min (maxComponent (aBSDF.Kt), 1.f) << "}";
+
+        if (aBSDF.FresnelBase.FresnelType () == Graphic3d_FM_DIELECTRIC)
+        {
+          anExtensions << ",\"KHR_materials_ior\":{\"ior\":" << aFresnel.y () << "}";
+        }
+      }
+
+      const Graphic3d_Vec3 aCoat (aBSDF.Kc.x (), aBSDF.Kc.y (), aBSDF.Kc.z ());
+
+      if (maxComponent (aCoat) > 0.f)
+      {
+        anExtensions << ",\"KHR_materials_clearcoat\":{\"clearcoatFactor\":" << std::min (maxComponent (aCoat), 1.f)
+                     << ",\"clearcoatRoughnessFactor\":" << std::max (0.f, std::min (aBSDF.Kc.w (), 1.f)) << "}";
+      }
+
+      const std::string anExtString = anExtensions.str ();
+
+      if (!anExtString.empty ())
+      {
+        aJson << ",\"extensions\":{" << anExtString.substr (1) << "}";
+
+        for (size_t aPos = anExtString.find ("\"KHR_"); aPos != std::string::npos; aPos = anExtString.find ("\"KHR_", aPos + 1))
+        {
+          myExtensions.insert (anExtString.substr (aPos, anExtString.find ('\"', aPos + 1) - aPos + 1));
+        }
+      }
+
+      // Exact CADRays material for lossless round trip
+      aJson << ",\"extras\":{\"cadrays\":{\"bsdf\":" << jsonString (aSerialized.ToCString ());
+
+      if (!aMatName.IsEmpty ())
+      {
+        aJson << ",\"material\":" << jsonString (aMatName.ToCString ());
+      }
+
+      aJson << "}}}";
+
+      myMaterials.push_back (aJson.str ());
+
+      return myMaterialIDs[aKey] = static_cast<int> (myMaterials.size ()) - 1;
+    }
+
+    //===========================================================================
+    //function : addMesh
+    //purpose  :
+    //===========================================================================
+    int GltfWriter::addMesh (const std::string& theName,
+                             const int          thePosition,
+                             const int          theNormal,
+                             const int          theTexcoord,
+                             const int          theIndices,
+                             const int          theMaterial)
+    {
+      std::ostringstream aJson;
+
+      aJson << "{\"name\":" << jsonString (theName) << ",\"primitives\":[{\"attributes\":{\"POSITION\":" << thePosition;
+
+      if (theNormal >= 0)
+      {
+        aJson << ",\"NORMAL\":" << theNormal;
+      }
+
+      if (theTexcoord >= 0)
+      {
+        aJson << ",\"TEXCOORD_0\":" << theTexcoord;
+      }
+
+      aJson << "}";
+
+      if (theIndices >= 0)
+      {
+        aJson << ",\"indices\":" << theIndices;
+      }
+
+      aJson << ",\"material\":" << theMaterial << ",\"mode\":4}]}";
+
+      myMeshes.push_back (aJson.str ());
+
+      return static_cast<int> (myMeshes.size ()) - 1;
+    }
+
+    //===========================================================================
+    //function : addShapeMesh
+    //purpose  :
+    //===========================================================================
+    int GltfWriter::addShapeMesh (const Handle (AIS_Shape)& theObject, const int theMaterial)
+    {
+      // Shape location is written to glTF node, so instances of
+      // the same TShape share the same glTF mesh (and buffers)
+      const TopoDS_Shape aShape = theObject->Shape ().Located (TopLoc_Location ());
+
+      double aScaleU = 0.0;
+      double aScaleV = 0.0;
+
+      // Scale includes texture transformation (see model::SetTextureScale)
+      model::GetTextureScale (theObject, aScaleU, aScaleV);
+
+      std::ostringstream aKey;
+
+      aKey << "S" << aShape.TShape ().get () << ":" << aShape.Orientation () << ":" << aScaleU << ":" << aScaleV << "|" << theMaterial;
+
+      auto aMeshIter = myMeshIDs.find (aKey.str ());
+
+      if (aMeshIter != myMeshIDs.end ())
+      {
+        return aMeshIter->second;
+      }
+
+      StdPrs_ToolTriangulatedShape::Tessellate (aShape, theObject->Attributes ());
+
+      std::vector<float> aPositions;
+      std::vector<float> aNormals;
+      std::vector<float> aTexcoords;
+
+      std::vector<unsigned> anIndices;
+
+      for (TopExp_Explorer anExp (aShape, TopAbs_FACE); anExp.More (); anExp.Next ())
+      {
+        const TopoDS_Face& aFace = TopoDS::Face (anExp.Current ());
+
+        TopLoc_Location aLocation;
+
+        Handle (Poly_Triangulation) aTriangulation = BRep_Tool::Triangulation (aFace, aLocation);
+
+        if (aTriangulation.IsNull ())
+        {
+          continue;
+        }
+
+        const gp_Trsf aTrsf = aLocation.Transformation ();
+
+        const TColgp_Array1OfPnt& aNodes = aTriangulation->Nodes ();
+
+        TColgp_Array1OfDir aFaceNormals (aNodes.Lower (), aNodes.Upper ());
+
+        Poly_Connect aConnect (aTriangulation);
+
+        StdPrs_ToolTriangulatedShape::Normal (aFace, aConnect, aFaceNormals);
+
+        double aUMin = 0.0;
+        double aUMax = 1.0;
+        double aVMin = 0.0;
+        double aVMax = 1.0;
+
+        const bool toGenTexcoords = !aTexShape.IsNull () && aTriangulation->HasUVNodes ();
+
+        if (toGenTexcoords)
+        {
+          BRepTools::UVBounds (aFace, aUMin, aUMax, aVMin, aVMax);
+        }
+
+        const unsigned aFirstVertex = static_cast<unsigned> (aPositions.size () / 3);
+
+        for (int aNodeIdx = aNodes.Lower (); aNodeIdx <= aNodes.Upper (); ++aNodeIdx)
+        {
+          const gp_Pnt aPoint = aNodes (aNodeIdx).Transformed (aTrsf);
+          const gp_Dir aNormal = aFaceNormals (aNodeIdx).Transformed (aTrsf);
+
+          aPositions.push_back (static_cast<float> (aPoint.X ()));
+          aPositions.push_back (static_cast<float> (aPoint.Y ()));
+          aPositions.push_back (static_cast<float> (aPoint.Z ()));
+
+          aNormals.push_back (static_cast<float> (aNormal.X ()));
+          aNormals.push_back (static_cast<float> (aNormal.Y ()));
+          aNormals.push_back (static_cast<float> (aNormal.Z ()));
+
+          if (!aTexShape.IsNull ())
+          {
+            gp_Pnt2d aTexel (0.0, 0.0);
+
+            // Same parametrization as generated by AIS textured shape
+            if (toGenTexcoords)
+            {
+              const gp_Pnt2d& aUV = aTriangulation->UVNodes () (aNodeIdx);
+
+              aTexel.SetX ((aUV.X () - aUMin) / std::max (aUMax - aUMin, Precision::Confusion ()) / aScaleU);
+              aTexel.SetY ((aUV.Y () - aVMin) / std::max (aVMax - aVMin, Precision::Confusion ()) / aScaleV);
+            }
+
+            aTexcoords.push_back (static_cast<float> (aTexel.X ()));
+            aTexcoords.push_back (static_cast<float> (1.0 - aTexel.Y ())); // glTF origin is top-left
+          }
+        }
+
+        const bool isReversed = aFace.Orientation () == TopAbs_REVERSED;
+
+        const Poly_Array1OfTriangle& aTriangles = aTriangulation->Triangles ();
+
+        for (int aTriIdx = aTriangles.Lower (); aTriIdx <= aTriangles.Upper (); ++aTriIdx)
+        {
+          int aNode1 = 0;
+          int aNode2 = 0;
+          int aNode3 = 0;
+
+          aTriangles (aTriIdx).Get (aNode1, aNode2, aNode3);
+
+          if (isReversed)
+          {
+            std::swap (aNode2, aNode3);
+          }
+
+          anIndices.push_back (aFirstVertex + static_cast<unsigned> (aNode1 - aNodes.Lower ()));
+          anIndices.push_back (aFirstVertex + static_cast<unsigned> (aNode2 - aNodes.Lower ()));
+          anIndices.push_back (aFirstVertex + static_cast<unsigned> (aNode3 - aNodes.Lower ()));
+        }
+      }
+
+      if (anIndices.empty ())
+      {
+        return myMeshIDs[aKey.str ()] = -1;
+      }
+
+      const size_t aNbVertices = aPositions.size () / 3;
+
+      float aMin[] = {  FLT_MAX,  FLT_MAX,  FLT_MAX };
+      float aMax[] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+
+      for (size_t aVrtIdx = 0; aVrtIdx < aNbVertices; ++aVrtIdx)
+      {
+        for (int aDim = 0; aDim < 3; ++aDim)
+        {
+          aMin[aDim] = std::min (aMin[aDim], aPositions[aVrtIdx * 3 + aDim]);
+          aMax[aDim] = std::max (aMax[aDim], aPositions[aVrtIdx * 3 + aDim]);
+        }
+      }
+
+      const int aPosition = addAccessor (addBufferView (aPositions.data (), aPositions.size () * sizeof (float), 0, Target_Vertices),
+                                         0, Component_Float32, aNbVertices, "VEC3", aMin, aMax);
+
+      const int aNormal = addAccessor (addBufferView (aNormals.data (), aNormals.size () * sizeof (float), 0, Target_Vertices),
+                                       0, Component_Float32, aNbVertices, "VEC3");
+
+      const int aTexcoord = aTexcoords.empty () ? -1 :
+        addAccessor (addBufferView (aTexcoords.data (), aTexcoords.size () * sizeof (float), 0, Target_Vertices),
+                     0, Component_Float32, aNbVertices, "VEC2");
+
+      const int anIndex = addAccessor (addBufferView (anIndices.data (), anIndices.size () * sizeof (unsigned), 0, Target_Indices),
+                                       0, Component_UInt32, anIndices.size (), "SCALAR");
+
+      return myMeshIDs[aKey.str ()] = addMesh ("Shape", aPosition, aNormal, aTexcoord, anIndex, theMaterial);
+    }
+
+    //===========================================================================
+    //function : addArrayMesh
+    //purpose  :
+    //===========================================================================
+    int GltfWriter::addArrayMesh (const Handle (mesh::AisMesh)& theObject, const int theMaterial)
+    {
+      const Handle (Graphic3d_ArrayOfTriangles)& anArray = theObject->Triangles ();
+
+      if (anArray.IsNull () || anArray->VertexNumber () == 0)
+      {
+        return -1;
+      }
+
+      std::ostringstream aKey;
+
+      aKey << "M" << anArray.get () << "|" << theMaterial;
+
+      auto aMeshIter = myMeshIDs.find (aKey.str ());
+
+      if (aMeshIter != myMeshIDs.end ())
+      {
+        return aMeshIter->second;
+      }
+
+      const Handle (Graphic3d_Buffer)& anAttribs = anArray->Attributes ();
+
+      const size_t aNbVertices = static_cast<size_t> (anAttribs->NbElements);
+
+      // Interleaved vertex buffer is written as is
+      const int aView = addBufferView (anAttribs->Data (), aNbVertices * anAttribs->Stride, anAttribs->Stride, Target_Vertices);
+
+      int aPosition = -1;
+      int aNormal   = -1;
+      int aTexcoord = -1;
+
+      for (int anAttribIdx = 0; anAttribIdx < anAttribs->NbAttributes; ++anAttribIdx)
+      {
+        const Graphic3d_Attribute& anAttrib = anAttribs->Attribute (anAttribIdx);
+
+        const size_t anOffset = static_cast<size_t> (anAttribs->AttributeOffset (anAttribIdx));
+
+        if (anAttrib.Id == Graphic3d_TOA_POS && anAttrib.DataType == Graphic3d_TOD_VEC3)
+        {
+          float aMin[] = {  FLT_MAX,  FLT_MAX,  FLT_MAX };
+          float aMax[] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+
+          for (size_t aVrtIdx = 0; aVrtIdx < aNbVertices; ++aVrtIdx)
+          {
+            const float* aVertex = reinterpret_cast<const float*> (anAttribs->Data () + aVrtIdx * anAttribs->Stride + anOffset);
+
+            for (int aDim = 0; aDim < 3; ++aDim)
+            {
+              aMin[aDim] = std::min (aMin[aDim], aVertex[aDim]);
+              aMax[aDim] = std::max (aMax[aDim], aVertex[aDim]);
+            }
+          }
+
+          aPosition = addAccessor (aView, anOffset, Component_Float32, aNbVertices, "VEC3", aMin, aMax);
+        }
+        else if (anAttrib.Id == Graphic3d_TOA_NORM && anAttrib.DataType == Graphic3d_TOD_VEC3)
+        {
+          aNormal = addAccessor (aView, anOffset, Component_Float32, aNbVertices, "VEC3");
+        }
+        else if (anAttrib.Id == Graphic3d_TOA_UV && anAttrib.DataType == Graphic3d_TOD_VEC2)
+        {
+          // Texture coordinates should be flipped (glTF origin is top-left)
+          std::vector<float> aTexcoords (aNbVertices * 2);
+
+          for (size_t aVrtIdx = 0; aVrtIdx < aNbVertices; ++aVrtIdx)
+          {
+            const float* aTexel = reinterpret_cast<const float*> (anAttribs->Data () + aVrtIdx * anAttribs->Stride + anOffset);
+
+            aTexcoords[aVrtIdx * 2 + 0] = aTexel[0];
+            aTexcoords[aVrtIdx * 2 + 1] = 1.f - aTexel[1];
+          }
+
+          aTexcoord = addAccessor (addBufferView (aTexcoords.data (), aTexcoords.size () * sizeof (float), 0, Target_Vertices),
+                                   0, Component_Float32, aNbVertices, "VEC2");
+        }
+      }
+
+      if (aPosition < 0)
+      {
+        return myMeshIDs[aKey.str ()] = -1;
+      }
+
+      int anIndex = -1;
+
+      const Handle (Graphic3d_IndexBuffer)& anIndices = anArray->Indices ();
+
+      if (!anIndices.IsNull () && anIndices->NbElements > 0)
+      {
+        anIndex = addAccessor (addBufferView (anIndices->Data (), anIndices->NbElements * anIndices->Stride, 0, Target_Indices), 0,
+                               anIndices->Stride == sizeof (unsigned short) ? Component_UInt16 : Component_UInt32, anIndices->NbElements, "SCALAR");
+      }
+
+      return myMeshIDs[aKey.str ()] = addMesh ("Mesh", aPosition, aNormal, aTexcoord, anIndex, theMaterial);
+    }
+
+    //===========================================================================
+    //function : AddNode
+    //purpose  :
+    //===========================================================================
+    int GltfWriter::AddNode (model::DataNode* theNode)
+    {
+      const int aNodeIndex = static_cast<int> (myNodes.size ());
+
+      myNodes.push_back (std::string ()); // reserve index of the node
+
+      std::ostringstream aJson;
+
+      initStream (aJson);
+
+      aJson << "{\"name\":" << jsonString (theNode->Name ().ToCString ());
+
+      if (!theNode->SubNodes ().empty ())
+      {
+        std::ostringstream aChildren;
+
+        for (size_t aSubNodeIdx = 0; aSubNodeIdx < theNode->SubNodes ().size (); ++aSubNodeIdx)
+        {
+          aChildren << (aSubNodeIdx == 0 ? "" : ",") << AddNode (theNode->SubNodes ()[aSubNodeIdx].get ());
+        }
+
+        aJson << ",\"children\":[" << aChildren.str () << "]";
+      }
+      else if (!theNode->Object ().IsNull ())
+      {
+        const Handle (AIS_InteractiveObject)& anObject = theNode->Object ();
+
+        gp_Trsf aTrsf = anObject->LocalTransformation ();
+
+        int aMesh = -1;
+
+        Handle (AIS_Shape) aShape = Handle (AIS_Shape)::DownCast (anObject);
+
+        if (!aShape.IsNull ())
+        {
+          aTrsf = aTrsf * aShape->Shape ().Location ().Transformation ();
+
+          aMesh = addShapeMesh (aShape, addMaterial (anObject));
+        }
+
+        Handle (mesh::AisMesh) anAisMesh = Handle (mesh::AisMesh)::DownCast (anObject);
+
+        if (!anAisMesh.IsNull ())
+        {
+          aMesh = addArrayMesh (anAisMesh, addMaterial (anObject));
+        }
+
+        if (aMesh >= 0)
+        {
+          aJson << ",\"mesh\":" << aMesh;
+        }
+
+        if (aTrsf.Form () != gp_Identity)
+        {
+          aJson << ",\"matrix\":[";
+
+          for (int aCol = 1; aCol <= 4; ++aCol)
+          {
+            for (int aRow = 1; aRow <= 3; ++aRow)
+            {
+              aJson << aTrsf.Value (aRow, aCol) << ",";
+            }
+
+            aJson << (aCol == 4 ? "1" : "0,");
+          }
+
+          aJson << "]";
+        }
+      }
+
+      aJson << "}";
+
+      myNodes[aNodeIndex] = aJson.str ();
+
+      return aNodeIndex;
+    }
+
+    //===========================================================================
+    //function : Save
+    //purpose  :
+    //===========================================================================
+    bool GltfWriter::Save (const TCollection_AsciiString& theFileName, const std::vector<int>& theRoots)
+    {
+      std::ostringstream aRoot;
+
+      initStream (aRoot);
+
+      aRoot << "{\"name\":\"CADRays\",\"matrix\":[";
+
+      for (int anIdx = 0; anIdx < 16; ++anIdx)
+      {
+        aRoot << (anIdx == 0 ? "" : ",") << THE_Z_UP_TO_Y_UP[anIdx];
+      }
+
+      aRoot << "]";
+
+      if (!theRoots.empty ())
+      {
+        aRoot << ",\"children\":[";
+
+        for (size_t aRootIdx = 0; aRootIdx < theRoots.size (); ++aRootIdx)
+        {
+          aRoot << (aRootIdx == 0 ? "" : ",") << theRoots[aRootIdx];
+        }
+
+        aRoot << "]";
+      }
+
+      aRoot << "}";
+
+      myNodes.push_back (aRoot.str ());
+
+      myBinary.resize ((myBinary.size () + 3) & ~static_cast<size_t> (3), '\0');
+
+      std::ostringstream aJson;
+
+      aJson << "{\"asset\":{\"version\":\"2.0\",\"generator\":\"CADRays\"}";
+
+      if (!myExtensions.empty ())
+      {
+        aJson << ",\"extensionsUsed\":[";
+
+        for (auto anExtIter = myExtensions.begin (); anExtIter != myExtensions.end (); ++anExtIter)
+        {
+          aJson << (anExtIter == myExtensions.begin () ? "" : ",") << *anExtIter;
+        }
+
+        aJson << "]";
+      }
+
+      aJson << ",\"scene\":0,\"scenes\":[{\"nodes\":[" << myNodes.size () - 1 << "]}]";
+
+      jsonArray (aJson, "nodes",       myNodes);
+      jsonArray (aJson, "meshes",      myMeshes);
+      jsonArray (aJson, "materials",   myMaterials);
+      jsonArray (aJson, "textures",    myTextures);
+      jsonArray (aJson, "images",      myImages);
+      jsonArray (aJson, "accessors",   myAccessors);
+      jsonArray (aJson, "bufferViews", myBufferViews);
+
+      if (!myBinary.empty ())
+      {
+        aJson << ",\"buffers\":[{\"byteLength\":" << myBinary.size () << "}]";
+      }
+
+      aJson << "}";
+
+      std::string aJsonChunk = aJson.str ();
+
+      aJsonChunk.resize ((aJsonChunk.size () + 3) & ~static_cast<size_t> (3), ' ');
+
+      std::ofstream aStream (theFileName.ToCString (), std::ios_base::out | std::ios_base::binary);
+
+      if (!aStream.is_open ())
+      {
+        return false;
+      }
+
+      const size_t aTotalSize = 12 + 8 + aJsonChunk.size () + (myBinary.empty () ? 0 : 8 + myBinary.size ());
+
+      if (aTotalSize > std::numeric_limits<unsigned>::max ())
+      {
+        return false; // GLB file is limited by 4 GB
+      }
+
+      writeUInt32 (aStream, THE_GLB_MAGIC);
+      writeUInt32 (aStream, 2);
+      writeUInt32 (aStream, static_cast<unsigned> (aTotalSize));
+
+      writeUInt32 (aStream, static_cast<unsigned> (aJsonChunk.size ()));
+      writeUInt32 (aStream, THE_CHUNK_JSON);
+
+      aStream.write (aJsonChunk.data (), aJsonChunk.size ());
+
+      if (!myBinary.empty ())
+      {
+        writeUInt32 (aStream, static_cast<unsigned> (myBinary.size ()));
+        writeUInt32 (aStream, THE_CHUNK_BIN);
+
+        aStream.write (myBinary.data (), myBinary.size ());
+      }
+
+      return aStream.good ();
+    }
+
+    //! Tool reading GLB file into data nodes.
+    class GltfReader
+    {
+    public:
+
+      //! View of glTF accessor data in binary chunk.
+      struct Accessor
+      {
+        const unsigned char* Data;
+        size_t               Count;
+        size_t               Stride;
+        int                  Component;
+        bool                 IsNormalized;
+      };
+
+    public:
+
+      //! Maps the given file and parses its JSON chunk.
+      GltfReader (const TCollection_AsciiString& theFileName);
+
+      //! Creates data node with the given name for default glTF scene.
+      model::DataNodePtr Perform (const TCollection_AsciiString& theNodeName);
+
+    private:
+
+      //! Creates data nodes for the given glTF node and its children.
+      void addNode (const size_t theIndex, const Matrix& theParentTrsf, model::DataNode* theParent, const int theDepth);
+
+      //! Returns accessor data with the given index.
+      Accessor accessor (const JsonValue& theIndex, const int theNbComponents) const;
+
+      //! Returns component of accessor item as floating-point number.
+      static float component (const Accessor& theAccessor, const size_t theItem, const int theComponent);
+
+      //! Returns item of index accessor.
+      static size_t index (const Accessor& theAccessor, const size_t theItem);
+
+      //! Returns (cached) triangles of the given mesh primitive.
+      Handle (Graphic3d_ArrayOfTriangles) triangles (const size_t theMesh, const size_t thePrimitive);
+
+      //! Returns (cached) graphic aspect of the given material.
+      Handle (Graphic3d_AspectFillArea3d) aspect (const int theMaterial);
+
+      //! Returns path to the image file of the given texture.
+      TCollection_AsciiString texturePath (const int theTexture);
+
+      //! Converts glTF name to the valid name of data node.
+      static TCollection_AsciiString nodeName (const std::string& theName, const TCollection_AsciiString& theParent);
+
+    private:
+
+      //! Memory mapping of GLB file.
+      MappedFile myFile;
+
+      //! Root of glTF JSON.
+      JsonValue myJson;
+
+      //! Pointer to binary chunk.
+      const unsigned char* myBinary;
+
+      //! Size of binary chunk.
+      size_t myBinarySize;
+
+      //! Path to GLB file.
+      TCollection_AsciiString myFileName;
+
+      //! Triangles created for mesh primitives.
+      std::map<std::pair<size_t, size_t>, Handle (Graphic3d_ArrayOfTriangles)> myTriangles;
+
+      //! Aspects created for glTF materials.
+      std::map<int, Handle (Graphic3d_AspectFillArea3d)> myAspects;
+    };
+
+    //===========================================================================
+    //function : GltfReader
+    //purpose  :
+    //===========================================================================
+    GltfReader::GltfReader (const TCollection_AsciiString& theFileName)
+      : myBinary (NULL),
+        myBinarySize (0),
+        myFileName (theFileName)
+    {
+      if (!myFile.Open (theFileName))
+      {
+        throw std::runtime_error ("Failed to open GLB file");
+      }
+
+      const unsigned char* aData = myFile.Data ();
+
+      if (myFile.Size () < 20 || readUInt32 (aData) != THE_GLB_MAGIC || readUInt32 (aData + 4) != 2)
+      {
+        throw std::runtime_error ("File is not a binary glTF 2.0 file");
+      }
+
+      const size_t aFileSize = std::min (static_cast<size_t> (readUInt32 (aData + 8)), myFile.Size ());
+
+      for (size_t aChunkPos = 12; aChunkPos + 8 <= aFileSize;)
+      {
+        const size_t aChunkSize = readUInt32 (aData + aChunkPos);
+        const unsigned aChunkType = readUInt32 (aData + aChunkPos + 4);
+
+        if (aChunkPos + 8 + aChunkSize > aFileSize)
+        {
+          throw std::runtime_error ("GLB file is truncated");
+        }
+
+        const unsigned char* aChunk = aData + aChunkPos + 8;
+
+        if (aChunkType == THE_CHUNK_JSON && myJson.IsNull ())
+        {
+          JsonParser aParser (reinterpret_cast<const char*> (aChunk), reinterpret_cast<const char*> (aChunk + aChunkSize));
+
+          if (!aParser.Parse (myJson))
+          {
+            throw std::runtime_error ("Failed to parse JSON chunk of GLB file");
+          }
+        }
+        else if (aChunkType == THE_CHUNK_BIN && myBinary == NULL)
+        {
+          // Binary data is never copied, accessors refer to mapped memory
+          myBinary = aChunk;
+          myBinarySize = aChunkSize;
+        }
+
+        aChunkPos += 8 + ((aChunkSize + 3) & ~static_cast<size_t> (3));
+      }
+
+      if (myJson.IsNull ())
+      {
+        throw std::runtime_error ("GLB file has no JSON chunk");
+      }
+    }
+
+    //===========================================================================
+    //function : accessor
+    //purpose  :
+    //===========================================================================
+    GltfReader::Accessor GltfReader::accessor (const JsonValue& theIndex, const int theNbComponents) const
+    {
+      const JsonValue& anAccessor = myJson["accessors"][theIndex.Size (std::numeric_limits<size_t>::max ())];
+
+      const JsonValue& aView = myJson["bufferViews"][anAccessor["bufferView"].Size (std::numeric_limits<size_t>::max ())];
+
+      if (anAccessor.IsNull () || aView.IsNull () || !anAccessor["sparse"].IsNull ())
+      {
+        throw std::runtime_error ("Unsupported or invalid glTF accessor");
+      }
+
+      if (aView["buffer"].Size (0) != 0 || myBinary == NULL || !myJson["buffers"][0]["uri"].IsNull ())
+      {
+        throw std::runtime_error ("Only data of GLB binary chunk is supported");
+      }
+
+      const std::string& aType = anAccessor["type"].String ();
+
+      const int aNbComponents = aType == "SCALAR" ? 1 : aType == "VEC2" ? 2 : aType == "VEC3" ? 3 : aType == "VEC4" ? 4 : 0;
+
+      Accessor aResult;
+
+      aResult.Component = anAccessor["componentType"].Int (0);
+      aResult.Count = anAccessor["count"].Size (0);
+      aResult.IsNormalized = anAccessor["normalized"].Number () != 0.0;
+
+      size_t aComponentSize = 0;
+
+      switch (aResult.Component)
+      {
+        case Component_UInt8:   aComponentSize = 1; break;
+        case Component_UInt16:  aComponentSize = 2; break;
+        case Component_UInt32:  aComponentSize = 4; break;
+        case Component_Float32: aComponentSize = 4; break;
+      }
+
+      if (aComponentSize == 0 || aNbComponents < theNbComponents)
+      {
+        throw std::runtime_error ("Unsupported type of glTF accessor");
+      }
+
+      const size_t anItemSize = aComponentSize * aNbComponents;
+
+      aResult.Stride = aView["byteStride"].Size (0) != 0 ? aView["byteStride"].Size (0) : anItemSize;
+
+      const size_t aViewOffset = aView["byteOffset"].Size (0);
+      const size_t aViewLength = aView["byteLength"].Size (0);
+      const size_t anOffset    = anAccessor["byteOffset"].Size (0);
+
+      if (aViewOffset + aViewLength > myBinarySize
+       || (aResult.Count > 0 && anOffset + aResult.Stride * (aResult.Count - 1) + anItemSize > aViewLength))
+      {
+        throw std::runtime_error ("glTF accessor is out of binary chunk");
+      }
+
+      aResult.Data = myBinary + aViewOffset + anOffset;
+
+      return aResult;
+    }
+
+    //===========================================================================
+    //function : component
+    //purpose  :
+    //===========================================================================
+    float GltfReader::component (const Accessor& theAccessor, const size_t theItem, const int theComponent)
+    {
+      const unsigned char* anItem = theAccessor.Data + theItem * theAccessor.Stride;
+
+      switch (theAccessor.Component)
+      {
+        case Component_Float32:
+        {
+          float aValue;
+
+          memcpy (&aValue, anItem + theComponent * sizeof (float), sizeof (float));
+
+          return aValue;
+        }
+
+        case Component_UInt16:
+        {
+          unsigned short aValue;
+
+          memcpy (&aValue, anItem + theComponent * sizeof (unsigned short), sizeof (unsigned short));
+
+          return theAccessor.IsNormalized ? aValue / 65535.f : aValue;
+        }
+
+        case Component_UInt8:
+        {
+          return theAccessor.IsNormalized ? anItem[theComponent] / 255.f : anItem[theComponent];
+        }
+      }
+
+      return 0.f;
+    }
+
+    //===========================================================================
+    //function : index
+    //purpose  :
+    //===========================================================================
+    size_t GltfReader::index (const Accessor& theAccessor, const size_t theItem)
+    {
+      const unsigned char* anItem = theAccessor.Data + theItem * theAccessor.Stride;
+
+      if (theAccessor.Component == Component_UInt32)
+      {
+        unsigned aValue;
+
+        memcpy (&aValue, anItem, sizeof (unsigned));
+
+        return aValue;
+      }
+      else if (theAccessor.Component == Component_UInt16)
+      {
+        unsigned short aValue;
+
+        memcpy (&aValue, anItem, sizeof (unsigned short));
+
+        return aValue;
+      }
+
+      return anItem[0];
+    }
+
+    //===========================================================================
+    //function : triangles
+    //purpose  :
+    //===========================================================================
+    Handle (Graphic3d_ArrayOfTriangles) GltfReader::triangles (const size_t theMesh, const size_t thePrimitive)
+    {
+      const std::pair<size_t, size_t> aKey (theMesh, thePrimitive);
+
+      auto aTrianglesIter = myTriangles.find (aKey);
+
+      if (aTrianglesIter != myTriangles.end ())
+      {
+        return aTrianglesIter->second;
+      }
+
+      const JsonValue& aPrimitive = myJson["meshes"][theMesh]["primitives"][thePrimitive];
+
+      Handle (Graphic3d_ArrayOfTriangles)& anArray = myTriangles[aKey];
+
+      if (aPrimitive["mode"].Int (4) != 4)
+      {
+        std::cout << "Warning: Only triangle primitives of glTF meshes are supported" << std::endl;
+
+        return anArray;
+      }
+
+      const JsonValue& anAttribs = aPrimitive["attributes"];
+
+      const Accessor aPositions = accessor (anAttribs["POSITION"], 3);
+
+      const size_t aNbVertices = aPositions.Count;
+      const size_t aNbIndices  = aPrimitive["indices"].IsNull () ? aNbVertices : accessor (aPrimitive["indices"], 1).Count;
+
+      if (aNbVertices == 0 || aNbIndices < 3 || aNbVertices > static_cast<size_t> (IntegerLast ()) || aNbIndices > static_cast<size_t> (IntegerLast ()))
+      {
+        return anArray;
+      }
+
+      std::vector<size_t> anIndices (aNbIndices - aNbIndices % 3);
+
+      if (!aPrimitive["indices"].IsNull ())
+      {
+        const Accessor anIndexData = accessor (aPrimitive["indices"], 1);
+
+        for (size_t anIdx = 0; anIdx < anIndices.size (); ++anIdx)
+        {
+          if ((anIndices[anIdx] = index (anIndexData, anIdx)) >= aNbVertices)
+          {
+            throw std::runtime_error ("Index of glTF mesh is out of range");
+          }
+        }
+      }
+      else
+      {
+        for (size_t anIdx = 0; anIdx < anIndices.size (); ++anIdx)
+        {
+          anIndices[anIdx] = anIdx;
+        }
+      }
+
+      std::vector<Graphic3d_Vec3> aNormals (aNbVertices, Graphic3d_Vec3 (0.f));
+
+      if (!anAttribs["NORMAL"].IsNull ())
+      {
+        const Accessor aNormalData = accessor (anAttribs["NORMAL"], 3);
+
+        for (size_t aVrtIdx = 0; aVrtIdx < std::min (aNbVertices, aNormalData.Count); ++aVrtIdx)
+        {
+          aNormals[aVrtIdx] = Graphic3d_Vec3 (component (aNormalData, aVrtIdx, 0),
+                                              component (aNormalData, aVrtIdx, 1),
+                                              component (aNormalData, aVrtIdx, 2));
+        }
+      }
+      else // generate smooth normals
+      {
+        for (size_t anIdx = 0; anIdx < anIndices.size (); anIdx += 3)
+        {
+          Graphic3d_Vec3 aPoints[3];
+
+          for (int aVrt = 0; aVrt < 3; ++aVrt)
+          {
+            aPoints[aVrt] = Graphic3d_Vec3 (component (aPositions, anIndices[anIdx + aVrt], 0),
+                                            component (aPositions, anIndices[anIdx + aVrt], 1),
+                                            component (aPositions, anIndices[anIdx + aVrt], 2));
+          }
+
+          const Graphic3d_Vec3 aNormal = Graphic3d_Vec3::Cross (aPoints[1] - aPoints[0], aPoints[2] - aPoints[0]);
+
+          for (int aVrt = 0; aVrt < 3; ++aVrt)
+          {
+            aNormals[anIndices[anIdx + aVrt]] += aNormal;
+          }
+        }
+      }
+
+      anArray = new Graphic3d_ArrayOfTriangles (static_cast<int> (aNbVertices), static_cast<int> (anIndices.size ()), true, false, true);
+
+      const bool hasTexcoords = !anAttribs["TEXCOORD_0"].IsNull ();
+
+      const Accessor aTexcoords = hasTexcoords ? accessor (anAttribs["TEXCOORD_0"], 2) : aPositions;
+
+      for (size_t aVrtIdx = 0; aVrtIdx < aNbVertices; ++aVrtIdx)
+      {
+        const int aVertex = anArray->AddVertex (component (aPositions, aVrtIdx, 0),
+                                                component (aPositions, aVrtIdx, 1),
+                                                component (aPositions, aVrtIdx, 2));
+
+        Graphic3d_Vec3& aNormal = aNormals[aVrtIdx];
+
+        if (aNormal.SquareModulus () > FLT_MIN)
+        {
+          aNormal.Normalize ();
+        }
+        else
+        {
+          aNormal = Graphic3d_Vec3 (0.f, 0.f, 1.f);
+        }
+
+        anArray->SetVertexNormal (aVertex, aNormal.x (), aNormal.y (), aNormal.z ());
+
+        if (hasTexcoords && aVrtIdx < aTexcoords.Count)
+        {
+          anArray->SetVertexTexel (aVertex, component (aTexcoords, aVrtIdx, 0), 1.f - component (aTexcoords, aVrtIdx, 1));
+        }
+        else
+        {
+          anArray->SetVertexTexel (aVertex, 0.f, 0.f);
+        }
+      }
+
+      for (size_t anIdx = 0; anIdx < anIndices.size (); ++anIdx)
+      {
+        anArray->AddEdge (static_cast<int> (anIndices[anIdx]) + 1);
+      }
+
+      return anArray;
+    }
+
+    //===========================================================================
+    //function : texturePath
+    //purpose  :
+    //===========================================================================
+    TCollection_AsciiString GltfReader::texturePath (const int theTexture)
+    {
+      const size_t aSource = myJson["textures"][static_cast<size_t> (theTexture)]["source"].Size (std::numeric_limits<size_t>::max ());
+
+      const JsonValue& anImage = myJson["images"][aSource];
+
+      if (anImage.IsNull ())
+      {
+        return TCollection_AsciiString ();
+      }
+
+      const std::string aFileName = myFileName.ToCString ();
+
+      const std::string aDirectory = aFileName.substr (0, aFileName.find_last_of ("/\\") + 1);
+
+      if (!anImage["uri"].IsNull ())
+      {
+        const std::string& anURI = anImage["uri"].String ();
+
+        if (anURI.compare (0, 5, "data:") == 0)
+        {
+          std::cout << "Warning: Embedded data URIs of glTF images are not supported" << std::endl;
+
+          return TCollection_AsciiString ();
+        }
+
+        if (OSD_File (OSD_Path (anURI.c_str ())).Exists ())
+        {
+          return anURI.c_str ();
+        }
+
+        return (aDirectory + anURI).c_str (); // relative to GLB file
+      }
+
+      // Images of binary chunk are extracted to the folder
+      // next to GLB file (texture manager works with files)
+      const JsonValue& aView = myJson["bufferViews"][anImage["bufferView"].Size (std::numeric_limits<size_t>::max ())];
+
+      const size_t anOffset = aView["byteOffset"].Size (0);
+      const size_t aLength  = aView["byteLength"].Size (0);
+
+      if (aView.IsNull () || myBinary == NULL || anOffset + aLength > myBinarySize)
+      {
+        return TCollection_AsciiString ();
+      }
+
+      const std::string aStem = aFileName.substr (aDirectory.size (), aFileName.find_last_of ('.') - aDirectory.size ());
+
+      OSD_Path anImagesPath (TCollection_AsciiString ((aDirectory + aStem + "_images").c_str ()));
+
+      OSD_Directory anImagesDir (anImagesPath);
+
+      if (!anImagesDir.Exists ())
+      {
+        anImagesDir.Build (OSD_Protection ());
+      }
+
+      std::ostringstream anImagePath;
+
+      anImagePath << aDirectory << aStem << "_images/image_" << aSource
+                  << (anImage["mimeType"].String () == "image/png" ? ".png" : ".jpg");
+
+      std::ofstream aStream (anImagePath.str ().c_str (), std::ios_base::out | std::ios_base::binary);
+
+      aStream.write (reinterpret_cast<const char*> (myBinary + anOffset), aLength);
+
+      return aStream.good () ? TCollection_AsciiString (anImagePath.str ().c_str ()) : TCollection_AsciiString ();
+    }
+
+    //===========================================================================
+    //function : aspect
+    //purpose  :
+    //===========================================================================
+    Handle (Graphic3d_AspectFillArea3d) GltfReader::aspect (const int theMaterial)
+    {
+      if (theMaterial < 0)
+      {
+        return NULL; // default material
+      }
+
+      auto anAspectIter = myAspects.find (theMaterial);
+
+      if (anAspectIter != myAspects.end ())
+      {
+        return anAspectIter->second;
+      }
+
+      Handle (Graphic3d_AspectFillArea3d)& anAspect = myAspects[theMaterial];
+
+      const JsonValue& aJson = myJson["materials"][static_cast<size_t> (theMaterial)];
+
+      const JsonValue& aPBR = aJson["pbrMetallicRoughness"];
+
+      Graphic3d_Vec3 aBaseColor (1.f);
+
+      for (int aComp = 0; aComp < 3; ++aComp)
+      {
+        aBaseColor[aComp] = static_cast<float> (aPBR["baseColorFactor"][aComp].Number (1.0));
+      }
+
+      Graphic3d_MaterialAspect aMaterial;
+
+      aMaterial.SetMaterialType (Graphic3d_MATERIAL_PHYSIC);
+
+      aMaterial.SetAmbient  (1.0);
+      aMaterial.SetDiffuse  (1.0);
+      aMaterial.SetSpecular (1.0);
+      aMaterial.SetEmissive (0.0);
+
+      aMaterial.SetAmbientColor  (Quantity_Color (0.1, 0.1, 0.1, Quantity_TOC_RGB));
+      aMaterial.SetDiffuseColor  (Quantity_Color (aBaseColor.r (), aBaseColor.g (), aBaseColor.b (), Quantity_TOC_RGB));
+      aMaterial.SetSpecularColor (Quantity_Color (0.0, 0.0, 0.0, Quantity_TOC_RGB));
+      aMaterial.SetEmissiveColor (Quantity_Color (0.0, 0.0, 0.0, Quantity_TOC_RGB));
+
+      Graphic3d_BSDF aBSDF;
+
+      const JsonValue& anExtras = aJson["extras"]["cadrays"];
+
+      if (!anExtras.IsNull () && model::DeserializeBSDF (anExtras["bsdf"].String ().c_str (), aBSDF))
+      {
+        TCollection_AsciiString aName (anExtras["material"].String ().c_str ());
+
+        aName.LowerCase ();
+
+        for (int aMatIndex = 1; aMatIndex <= Graphic3d_MaterialAspect::NumberOfMaterials () && !aName.IsEmpty (); ++aMatIndex)
+        {
+          TCollection_AsciiString aCurrentName (Graphic3d_MaterialAspect::MaterialName (aMatIndex));
+
+          aCurrentName.LowerCase ();
+
+          if (aCurrentName == aName)
+          {
+            aMaterial = Graphic3d_MaterialAspect (static_cast<Graphic3d_NameOfMaterial> (aMatIndex - 1));
+          }
+        }
+      }
+      else // approximate metallic-roughness model by CADRays BSDF
+      {
+        const float aMetallic  = static_cast<float> (std::max (0.0, std::min (aPBR["metallicFactor"].Number (1.0), 1.0)));
+        const float aRoughness = static_cast<float> (std::max (0.0, std::min (aPBR["roughnessFactor"].Number (1.0), 1.0)));
+
+        const JsonValue& anExtensions = aJson["extensions"];
+
+        const float aTransmission = static_cast<float> (anExtensions["KHR_materials_transmission"]["transmissionFactor"].Number (0.0));
+
+        const float anIOR = static_cast<float> (anExtensions["KHR_materials_ior"]["ior"].Number (1.5));
+
+        if (aMetallic >= 0.5f)
+        {
+          aBSDF.Ks = Graphic3d_Vec4 (1.f, 1.f, 1.f, aRoughness);
+
+          aBSDF.FresnelBase = Graphic3d_Fresnel::CreateSchlick (aBaseColor);
+        }
+        else
+        {
+          aBSDF.Kt = aBaseColor * aTransmission;
+          aBSDF.Kd = aBaseColor * (1.f - aTransmission);
+
+          const float aSpecular = std::max (0.f, 1.f - maxComponent (aBSDF.Kd + aBSDF.Kt));
+
+          aBSDF.Ks = Graphic3d_Vec4 (aSpecular, aSpecular, aSpecular, aRoughness);
+
+          aBSDF.FresnelBase = Graphic3d_Fresnel::CreateDielectric (anIOR);
+        }
+
+        const JsonValue& aCoat = anExtensions["KHR_materials_clearcoat"];
+
+        if (!aCoat.IsNull ())
+        {
+          const float aCoatWeight = static_cast<float> (aCoat["clearcoatFactor"].Number (0.0));
+
+          aBSDF.Kc = Graphic3d_Vec4 (aCoatWeight, aCoatWeight, aCoatWeight, static_cast<float> (aCoat["clearcoatRoughnessFactor"].Number (0.0)));
+
+          aBSDF.FresnelCoat = Graphic3d_Fresnel::CreateDielectric (1.5f);
+        }
+
+        const float aStrength = static_cast<float> (anExtensions["KHR_materials_emissive_strength"]["emissiveStrength"].Number (1.0));
+
+        for (int aComp = 0; aComp < 3; ++aComp)
+        {
+          aBSDF.Le[aComp] = static_cast<float> (aJson["emissiveFactor"][aComp].Number (0.0)) * aStrength;
+        }
+
+        aBSDF.Normalize (); // normalize BSDF to ensure energy conservation
+      }
+
+      aMaterial.SetBSDF (aBSDF);
+
+      anAspect = new Graphic3d_AspectFillArea3d (
+        Aspect_IS_SOLID, Quantity_NOC_WHITE, Quantity_NOC_WHITE, Aspect_TOL_SOLID, 1.0, aMaterial, aMaterial);
+
+      if (!aPBR["baseColorTexture"].IsNull ())
+      {
+        const TCollection_AsciiString aPath = texturePath (aPBR["baseColorTexture"]["index"].Int ());
+
+        if (!aPath.IsEmpty () && OSD_File (aPath).Exists ())
+        {
+          anAspect->SetTextureMap (model::DataModel::GetDefault ()->Manager ()->PickTexture (aPath));
+
+          anAspect->SetTextureMapOn (); // enable texturing
+        }
+      }
+
+      return anAspect;
+    }
+
+    //===========================================================================
+    //function : nodeName
+    //purpose  :
+    //===========================================================================
+    TCollection_AsciiString GltfReader::nodeName (const std::string& theName, const TCollection_AsciiString& theParent)
+    {
+      TCollection_AsciiString aName;
+
+      for (size_t aCharIdx = 0; aCharIdx < theName.size (); ++aCharIdx)
+      {
+        const char aChar = theName[aCharIdx];
+
+        aName += (isalnum (static_cast<unsigned char> (aChar)) && static_cast<unsigned char> (aChar) < 0x80) ? aChar : '_';
+      }
+
+      if (aName.IsEmpty ())
+      {
+        return theParent + "_"; // take the name of parent
+      }
+
+      return isalpha (aName.Value (1)) ? aName : theParent + "_" + aName;
+    }
+
+    //===========================================================================
+    //function : bakeTriangles
+    //purpose  : Creates copy of triangles with the given transformation applied
+    //===========================================================================
+    static Handle (Graphic3d_ArrayOfTriangles) bakeTriangles (const Handle (Graphic3d_ArrayOfTriangles)& theTriangles, const Matrix& theTrsf)
+    {
+      Handle (Graphic3d_ArrayOfTriangles) anArray = new Graphic3d_ArrayOfTriangles (
+        theTriangles->VertexNumber (), theTriangles->EdgeNumber (), true, false, true);
+
+      // Normals are transformed by inverse transpose matrix
+      gp_Mat aNormalMat (theTrsf (0, 0), theTrsf (0, 1), theTrsf (0, 2),
+                         theTrsf (1, 0), theTrsf (1, 1), theTrsf (1, 2),
+                         theTrsf (2, 0), theTrsf (2, 1), theTrsf (2, 2));
+
+      if (std::abs (aNormalMat.Determinant ()) > gp::Resolution ())
+      {
+        aNormalMat.Invert ();
+        aNormalMat.Transpose ();
+      }
+
+      for (int aVrtIdx = 1; aVrtIdx <= theTriangles->VertexNumber (); ++aVrtIdx)
+      {
+        const gp_Pnt aPoint = theTriangles->Vertice (aVrtIdx);
+
+        gp_XYZ aNormal = theTriangles->VertexNormal (aVrtIdx).XYZ ();
+
+        aNormal.Multiply (aNormalMat);
+
+        if (aNormal.SquareModulus () > gp::Resolution ())
+        {
+          aNormal.Normalize ();
+        }
+
+        const gp_Pnt2d aTexel = theTriangles->VertexTexel (aVrtIdx);
+
+        const int aVertex = anArray->AddVertex (
+          static_cast<float> (theTrsf (0, 0) * aPoint.X () + theTrsf (0, 1) * aPoint.Y () + theTrsf (0, 2) * aPoint.Z () + theTrsf (0, 3)),
+          static_cast<float> (theTrsf (1, 0) * aPoint.X () + theTrsf (1, 1) * aPoint.Y () + theTrsf (1, 2) * aPoint.Z () + theTrsf (1, 3)),
+          static_cast<float> (theTrsf (2, 0) * aPoint.X () + theTrsf (2, 1) * aPoint.Y () + theTrsf (2, 2) * aPoint.Z () + theTrsf (2, 3)));
+
+        anArray->SetVertexNormal (aVertex, aNormal.X (), aNormal.Y (), aNormal.Z ());
+        anArray->SetVertexTexel  (aVertex, aTexel.X (), aTexel.Y ());
+      }
+
+      for (int anEdgeIdx = 1; anEdgeIdx <= theTriangles->EdgeNumber (); ++anEdgeIdx)
+      {
+        anArray->AddEdge (theTriangles->Edge (anEdgeIdx));
+      }
+
+      return anArray;
+    }
+
+    //===========================================================================
+    //function : addNode
+    //purpose  :
+    //===========================================================================
+    void GltfReader::addNode (const size_t theIndex, const Matrix& theParentTrsf, model::DataNode* theParent, const int theDepth)
+    {
+      if (theDepth > 64) // protect from cycles in node hierarchy
+      {
+        throw std::runtime_error ("glTF node hierarchy is too deep");
+      }
+
+      const JsonValue& aNode = myJson["nodes"][theIndex];
+
+      if (aNode.IsNull ())
+      {
+        return;
+      }
+
+      Matrix aLocalTrsf;
+
+      if (!aNode["matrix"].IsNull ())
+      {
+        double aValues[16];
+
+        for (int anIdx = 0; anIdx < 16; ++anIdx)
+        {
+          aValues[anIdx] = aNode["matrix"][anIdx].Number (anIdx % 5 == 0 ? 1.0 : 0.0);
+        }
+
+        aLocalTrsf = Matrix (aValues);
+      }
+      else // translation, rotation and scale
+      {
+        const JsonValue& aRotation = aNode["rotation"];
+        const JsonValue& aScale    = aNode["scale"];
+
+        const gp_Mat aRotationMat = gp_Quaternion (aRotation[0].Number (0.0),
+                                                   aRotation[1].Number (0.0),
+                                                   aRotation[2].Number (0.0),
+                                                   aRotation[3].Number (1.0)).GetMatrix ();
+
+        for (int aRow = 0; aRow < 3; ++aRow)
+        {
+          for (int aCol = 0; aCol < 3; ++aCol)
+          {
+            aLocalTrsf.Values[aRow * 4 + aCol] = aRotationMat (aRow + 1, aCol + 1) * aScale[aCol].Number (1.0);
+          }
+
+          aLocalTrsf.Values[aRow * 4 + 3] = aNode["translation"][aRow].Number (0.0);
+        }
+      }
+
+      const Matrix aWorldTrsf = theParentTrsf * aLocalTrsf;
+
+      const TCollection_AsciiString aName = nodeName (aNode["name"].String (), theParent->Name ());
+
+      const size_t aMeshIdx = aNode["mesh"].Size (std::numeric_limits<size_t>::max ());
+
+      const JsonValue& aPrimitives = myJson["meshes"][aMeshIdx]["primitives"];
+
+      model::DataNode* aParent = theParent;
+
+      if (aNode["children"].Length () > 0 || aPrimitives.Length () > 1)
+      {
+        theParent->SubNodes ().push_back (model::DataNodePtr (new model::DataNode (aName, model::DataNode::DataNode_Type_PolyMesh)));
+
+        aParent = theParent->SubNodes ().back ().get ();
+      }
+
+      for (size_t aPrimIdx = 0; aPrimIdx < aPrimitives.Length (); ++aPrimIdx)
+      {
+        Handle (Graphic3d_ArrayOfTriangles) aTriangles = triangles (aMeshIdx, aPrimIdx);
+
+        if (aTriangles.IsNull ())
+        {
+          continue;
+        }
+
+        gp_Trsf aTrsf;
+
+        try
+        {
+          aTrsf.SetValues (aWorldTrsf (0, 0), aWorldTrsf (0, 1), aWorldTrsf (0, 2), aWorldTrsf (0, 3),
+                           aWorldTrsf (1, 0), aWorldTrsf (1, 1), aWorldTrsf (1, 2), aWorldTrsf (1, 3),
+                           aWorldTrsf (2, 0), aWorldTrsf (2, 1), aWorldTrsf (2, 2), aWorldTrsf (2, 3));
+        }
+        catch (Standard_Failure const&)
+        {
+          // Non-uniform scale or shear is not supported by
+          // local transformation, so it is applied to copy
+          aTriangles = bakeTriangles (aTriangles, aWorldTrsf);
+
+          aTrsf = gp_Trsf ();
+        }
+
+        // Each mesh has own aspect to allow independent material editing
+        const Handle (Graphic3d_AspectFillArea3d) aPrototype = aspect (aPrimitives[aPrimIdx]["material"].Int ());
+
+        Handle (mesh::AisMesh) anObject = new mesh::AisMesh (aTriangles,
+          aPrototype.IsNull () ? NULL : new Graphic3d_AspectFillArea3d (*aPrototype), aName);
+
+        if (aTrsf.Form () != gp_Identity)
+        {
+          anObject->SetLocalTransformation (aTrsf);
+        }
+
+        aParent->SubNodes ().push_back (model::DataNodePtr (new model::DataNode (anObject, aParent != theParent ? aParent->Name () + "_" : aName)));
+      }
+
+      for (size_t aChildIdx = 0; aChildIdx < aNode["children"].Length (); ++aChildIdx)
+      {
+        addNode (aNode["children"][aChildIdx].Size (std::numeric_limits<size_t>::max ()), aWorldTrsf, aParent, theDepth + 1);
+      }
+    }
+
+    //===========================================================================
+    //function : Perform
+    //purpose  :
+    //===========================================================================
+    model::DataNodePtr GltfReader::Perform (const TCollection_AsciiString& theNodeName)
+    {
+      model::DataNodePtr aRoot (new model::DataNode (theNodeName, model::DataNode::DataNode_Type_PolyMesh));
+
+      // Transformation of Y-up glTF space to Z-up scene (column-major)
+      static const double THE_Y_UP_TO_Z_UP[] = { 1.0,  0.0, 0.0, 0.0,
+                                                 0.0,  0.0, 1.0, 0.0,
+                                                 0.0, -1.0, 0.0, 0.0,
+                                                 0.0,  0.0, 0.0, 1.0 };
+
+      const Matrix aRootTrsf (THE_Y_UP_TO_Z_UP);
+
+      const JsonValue& aScene = myJson["scenes"][myJson["scene"].Size (0)];
+
+      if (!aScene.IsNull ())
+      {
+        for (size_t aNodeIdx = 0; aNodeIdx < aScene["nodes"].Length (); ++aNodeIdx)
+        {
+          addNode (aScene["nodes"][aNodeIdx].Size (std::numeric_limits<size_t>::max ()), aRootTrsf, aRoot.get (), 0);
+        }
+      }
+      else // no scene, take all root nodes
+      {
+        std::set<size_t> aChildren;
+
+        for (size_t aNodeIdx = 0; aNodeIdx < myJson["nodes"].Length (); ++aNodeIdx)
+        {
+          for (size_t aChildIdx = 0; aChildIdx < myJson["nodes"][aNodeIdx]["children"].Length (); ++aChildIdx)
+          {
+            aChildren.insert (myJson["nodes"][aNodeIdx]["children"][aChildIdx].Size ());
+          }
+        }
+
+        for (size_t aNodeIdx = 0; aNodeIdx < myJson["nodes"].Length (); ++aNodeIdx)
+        {
+          if (aChildren.find (aNodeIdx) == aChildren.end ())
+          {
+            addNode (aNodeIdx, aRootTrsf, aRoot.get (), 0);
+          }
+        }
+      }
+
+      return aRoot;
+    }
+  }
+
+  //===========================================================================
+  //function : Write
+  //purpose  :
+  //===========================================================================
+  bool GltfIO::Write (const TCollection_AsciiString& theFileName, const std::vector<model::DataNode*>& theNodes)
+  {
+    GltfWriter aWriter;
+
+    std::vector<int> aRoots;
+
+    for (size_t aNodeIdx = 0; aNodeIdx < theNodes.size (); ++aNodeIdx)
+    {
+      aRoots.push_back (aWriter.AddNode (theNodes[aNodeIdx]));
+    }
+
+    return aWriter.Save (theFileName, aRoots);
+  }
+
+  //===========================================================================
+  //function : Read
+  //purpose  :
+  //===========================================================================
+  model::DataNodePtr GltfIO::Read (const TCollection_AsciiString& theFileName, const TCollection_AsciiString& theNodeName)
+  {
+    GltfReader aReader (theFileName);
+
+    return aReader.Perform (theNodeName);
+  }
+}
@@ -0,0 +1,37 @@
+// Created: 2019-06-21
+//
+// Copyright (c) 2019 OPEN CASCADE SAS
+//
+// This file is a part of CADRays software.
+//
+// CADRays is free software; you can use it under the terms of the MIT license,
+// refer to file LICENSE.txt for complete text of the license and disclaimer of
+// any warranty.
+
+#ifndef _RT_GltfIO_Header
+#define _RT_GltfIO_Header
+
+#include <DataModel.hxx>
+
+namespace ie
+{
+  //! Tool class for native reading and writing of binary glTF 2.0 (GLB) files.
+  //! Z-up scene is converted to Y-up glTF space (and back) by the root node.
+  class GltfIO
+  {
+  public:
+
+    //! Writes the given nodes (with all sub-nodes) to GLB file.
+    //! Nodes referring to the same geometry and material share glTF mesh.
+    Standard_EXPORT static bool Write (const TCollection_AsciiString&       theFileName,
+                                       const std::vector<model::DataNode*>& theNodes);
+
+    //! Reads GLB file into the new data node with the given name (not added to data model).
+    //! glTF meshes referenced by several nodes share the same triangle array.
+    //! Throws std::runtime_error if the file is invalid or not supported.
+    Standard_EXPORT static model::DataNodePtr Read (const TCollection_AsciiString& theFileName,
+                                                    const TCollection_AsciiString& theNodeName);
+  };
+}
+
+#endif // _RT_GltfIO_Header
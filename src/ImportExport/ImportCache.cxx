@@ -0,0 +1,700 @@
+// Created: 2019-06-29
+//
+// Copyright (c) 2019 OPEN CASCADE SAS
+//
+// This file is a part of CADRays software.
+//
+// CADRays is free software; you can use it under the terms of the MIT license,
+// refer to file LICENSE.txt for complete text of the license and disclaimer of
+// any warranty.
+
+#include <AIS_Shape.hxx>
+
+#include <BRep_Tool.hxx>
+#include <BRep_Builder.hxx>
+#include <TopoDS.hxx>
+#include <TopoDS_Compound.hxx>
+#include <TopoDS_Iterator.hxx>
+#include <TopExp_Explorer.hxx>
+#include <TopTools_DataMapOfShapeInteger.hxx>
+
+#include <OSD_File.hxx>
+#include <OSD_Path.hxx>
+#include <OSD_Directory.hxx>
+#include <OSD_Protection.hxx>
+#include <OSD_FileIterator.hxx>
+
+#include <sys/stat.h>
+
+#include <ctime>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+#include <algorithm>
+
+#include "ShapeIO.hxx"
+#include "DataModel.hxx"
+#include "Fingerprints.hxx"
+#include "ImportCache.hxx"
+
+namespace ie
+{
+  //! Header of cache entry structure file.
+  static const char THE_CACHE_SIGNATURE[] = "CADRAYS_CACHE";
+
+  //! Version of cache entry format.
+  static const int THE_CACHE_VERSION = 1;
+
+  std::shared_ptr<ImportCache> ImportCache::myInstance;
+
+  namespace
+  {
+    //! Node structure and unique shapes collected for cache entry.
+    struct EntryWriter
+    {
+      std::ostringstream Stream; //!< Structure of data node
+
+      TopTools_DataMapOfShapeInteger Indices; //!< Indices of unique shapes
+
+      BRep_Builder Builder;
+
+      TopoDS_Compound Shapes; //!< Unique shapes (without locations)
+
+      //! Writes sub-nodes of the given node (depth first).
+      bool Write (const model::DataNode* theNode, const int theDepth)
+      {
+        for (size_t aSubID = 0; aSubID < theNode->SubNodes ().size (); ++aSubID)
+        {
+          const model::DataNode* aNode = theNode->SubNodes ()[aSubID].get ();
+
+          if (!aNode->SubNodes ().empty ())
+          {
+            Stream << theDepth << " G " << aNode->Name () << "\n";
+
+            if (!Write (aNode, theDepth + 1))
+            {
+              return false;
+            }
+
+            continue;
+          }
+
+          Handle (AIS_Shape) anObject = Handle (AIS_Shape)::DownCast (aNode->Object ());
+
+          if (anObject.IsNull () || anObject->Shape ().IsNull ())
+          {
+            return false; // only CAD shapes are cached
+          }
+
+          const TopoDS_Shape& aShape = anObject->Shape ();
+
+          const TopoDS_Shape aUnique = aShape.Located (TopLoc_Location ()).Oriented (TopAbs_FORWARD);
+
+          if (!Indices.IsBound (aUnique))
+          {
+            Indices.Bind (aUnique, Indices.Extent ());
+
+            Builder.Add (Shapes, aUnique);
+          }
+
+          const gp_Trsf aTrsf = aShape.Location ().Transformation ();
+
+          Stream << theDepth << " P " << Indices.Find (aUnique) << " " << static_cast<int> (aShape.Orientation ());
+
+          for (int aRow = 1; aRow <= 3; ++aRow)
+          {
+            for (int aCol = 1; aCol <= 4; ++aCol)
+            {
+              Stream << " " << aTrsf.Value (aRow, aCol);
+            }
+          }
+
+          Quantity_Color aColor;
+
+          if (anObject->HasColor ())
+          {
+            anObject->Color (aColor);
+          }
+
+          Stream << " " << (anObject->HasColor () ? 1 : 0) << " " << aColor.Red ()
+                                                         << " " << aColor.Green ()
+                                                         << " " << aColor.Blue () << " " << aNode->Name () << "\n";
+        }
+
+        return true;
+      }
+    };
+
+    //===========================================================================
+    //function : isMeshed
+    //purpose  : Checks whether all faces of the shape are triangulated
+    //===========================================================================
+    static bool isMeshed (const TopoDS_Shape& theShape)
+    {
+      TopLoc_Location aLocation;
+
+      for (TopExp_Explorer anExp (theShape, TopAbs_FACE); anExp.More (); anExp.Next ())
+      {
+        if (BRep_Tool::Triangulation (TopoDS::Face (anExp.Current ()), aLocation).IsNull ())
+        {
+          return false;
+        }
+      }
+
+      return true;
+    }
+
+    //===========================================================================
+    //function : writeHeader
+    //purpose  : Writes header with the time of last use
+    //===========================================================================
+    static std::string writeHeader ()
+    {
+      std::ostringstream aStream;
+
+      aStream << THE_CACHE_SIGNATURE << " " << THE_CACHE_VERSION << " " << static_cast<long long> (std::time (NULL)) << "\n";
+
+      return aStream.str ();
+    }
+
+    //===========================================================================
+    //function : readHeader
+    //purpose  : Reads header (returns time of last use or -1 for invalid one)
+    //===========================================================================
+    static long long readHeader (std::istream& theStream)
+    {
+      std::string aSignature;
+
+      int aVersion = 0;
+
+      long long aTime = -1;
+
+      theStream >> aSignature >> aVersion >> aTime;
+
+      if (theStream.fail () || aSignature != THE_CACHE_SIGNATURE || aVersion != THE_CACHE_VERSION)
+      {
+        return -1;
+      }
+
+      return aTime;
+    }
+  }
+
+  //===========================================================================
+  //function : GetInstance
+  //purpose  :
+  //===========================================================================
+  ImportCache* ImportCache::GetInstance ()
+  {
+    if (myInstance == NULL)
+    {
+      myInstance.reset (new ImportCache);
+    }
+
+    return myInstance.get ();
+  }
+
+  //===========================================================================
+  //function : ImportCache
+  //purpose  :
+  //===========================================================================
+  ImportCache::ImportCache ()
+    : myIsEnabled (true),
+      myDirectory ("cache"),
+      myMaxSize (2048)
+  {
+    //
+  }
+
+  //===========================================================================
+  //function : SetDirectory
+  //purpose  :
+  //===========================================================================
+  void ImportCache::SetDirectory (const TCollection_AsciiString& theDirectory)
+  {
+    myDirectory = theDirectory;
+
+    // strip trailing separators
+    while (myDirectory.Length () > 1 && (myDirectory.Value (myDirectory.Length ()) == '/'
+                                      || myDirectory.Value (myDirectory.Length ()) == '\\'))
+    {
+      myDirectory.Trunc (myDirectory.Length () - 1);
+    }
+
+    myStored.clear ();
+  }
+
+  //===========================================================================
+  //function : entryPath
+  //purpose  :
+  //===========================================================================
+  TCollection_AsciiString ImportCache::entryPath (const TCollection_AsciiString& theKey, const char* theExtension) const
+  {
+    return myDirectory + "/" + theKey + theExtension;
+  }
+
+  //===========================================================================
+  //function : Key
+  //purpose  :
+  //===========================================================================
+  TCollection_AsciiString ImportCache::Key (const TCollection_AsciiString& theFileName,
+                                            const TCollection_AsciiString& theOptions)
+  {
+    OSD_File aFile (theFileName);
+
+    if (!aFile.Exists ())
+    {
+      return TCollection_AsciiString ();
+    }
+
+    std::ifstream aStream (theFileName.ToCString (), std::ios_base::in | std::ios_base::binary);
+
+    if (!aStream.is_open ())
+    {
+      return TCollection_AsciiString ();
+    }
+
+    // FNV-1a hash of file contents
+    unsigned long long aHash = 14695981039346656037ULL;
+
+    std::vector<char> aBuffer (1 << 20);
+
+    size_t aSize = 0;
+
+    while (aStream)
+    {
+      aStream.read (&aBuffer.front (), aBuffer.size ());
+
+      const std::streamsize aCount = aStream.gcount ();
+
+      for (std::streamsize anIdx = 0; anIdx < aCount; ++anIdx)
+      {
+        aHash = (aHash ^ static_cast<unsigned char> (aBuffer[anIdx])) * 1099511628211ULL;
+      }
+
+      aSize += static_cast<size_t> (aCount);
+    }
+
+    // modification time guards against files modified within the same size and hash
+    struct stat aStat;
+
+    if (stat (theFileName.ToCString (), &aStat) != 0)
+    {
+      return TCollection_AsciiString ();
+    }
+
+    size_t aSeed = static_cast<size_t> (aHash);
+
+    HashCombine (aSeed, aSize);
+
+    HashCombine (aSeed, static_cast<size_t> (aStat.st_mtime));
+
+    HashCombine (aSeed, std::hash<std::string> () (theOptions.ToCString ()));
+
+    std::ostringstream aKey;
+
+    aKey << std::hex << std::setfill ('0') << std::setw (12) << aSize << "_"
+                                           << std::setw (16) << static_cast<unsigned long long> (aSeed);
+
+    return TCollection_AsciiString (aKey.str ().c_str ());
+  }
+
+  //===========================================================================
+  //function : Load
+  //purpose  :
+  //===========================================================================
+  model::DataNodePtr ImportCache::Load (const TCollection_AsciiString& theKey,
+                                        const TCollection_AsciiString& theNodeName)
+  {
+    if (!myIsEnabled || theKey.IsEmpty ())
+    {
+      return model::DataNodePtr ();
+    }
+
+    std::string aData;
+
+    if (!OSD_File (entryPath (theKey, ".txt")).Exists ())
+    {
+      return model::DataNodePtr ();
+    }
+
+    // Unreadable entry is a miss (the file is translated and the entry is rewritten)
+    if (!ShapeIO::ReadData (entryPath (theKey, ".txt"), aData))
+    {
+      std::cout << "Warning: Failed to read cache entry " << theKey << ", it will be rewritten" << std::endl;
+
+      return model::DataNodePtr ();
+    }
+
+    std::istringstream aStream (aData);
+
+    int aNbShapes = 0;
+
+    if (readHeader (aStream) < 0 || !(aStream >> aNbShapes))
+    {
+      return model::DataNodePtr ();
+    }
+
+    TopoDS_Shape aCompound;
+
+    if (!ShapeIO::Read (entryPath (theKey, ".brep"), aCompound))
+    {
+      return model::DataNodePtr ();
+    }
+
+    std::vector<TopoDS_Shape> aShapes;
+
+    for (TopoDS_Iterator anIter (aCompound); anIter.More (); anIter.Next ())
+    {
+      aShapes.push_back (anIter.Value ());
+    }
+
+    if (static_cast<int> (aShapes.size ()) != aNbShapes)
+    {
+      return model::DataNodePtr ();
+    }
+
+    model::DataNodePtr aRoot (new model::DataNode (theNodeName, model::DataNode::DataNode_Type_CadShape));
+
+    std::vector<model::DataNode*> aParents (1, aRoot.get ());
+
+    for (std::string aLine; std::getline (aStream, aLine);)
+    {
+      if (aLine.empty ())
+      {
+        continue;
+      }
+
+      std::istringstream aLineStream (aLine);
+
+      int aDepth = -1;
+
+      std::string aType;
+
+      aLineStream >> aDepth >> aType;
+
+      if (aDepth < 0 || aDepth >= static_cast<int> (aParents.size ()))
+      {
+        return model::DataNodePtr (); // corrupted entry
+      }
+
+      model::DataNode* aParent = aParents[aDepth];
+
+      std::string aName;
+
+      if (aType == "G")
+      {
+        aLineStream >> aName;
+
+        aParent->SubNodes ().push_back (model::DataNodePtr (new model::DataNode (aName.c_str (), model::DataNode::DataNode_Type_CadShape, true)));
+
+        aParents.resize (aDepth + 1);
+
+        aParents.push_back (aParent->SubNodes ().back ().get ());
+
+        continue;
+      }
+
+      int aShapeID = -1;
+      int anOrient = 0;
+
+      double aMatrix[12];
+
+      int hasColor = 0;
+
+      double aRGB[3];
+
+      aLineStream >> aShapeID >> anOrient;
+
+      for (int anIdx = 0; anIdx < 12; ++anIdx)
+      {
+        aLineStream >> aMatrix[anIdx];
+      }
+
+      aLineStream >> hasColor >> aRGB[0] >> aRGB[1] >> aRGB[2] >> aName;
+
+      if (aLineStream.fail () || aType != "P" || aShapeID < 0 || aShapeID >= aNbShapes)
+      {
+        return model::DataNodePtr (); // corrupted entry
+      }
+
+      gp_Trsf aTrsf;
+
+      aTrsf.SetValues (aMatrix[0], aMatrix[1], aMatrix[ 2], aMatrix[ 3],
+                       aMatrix[4], aMatrix[5], aMatrix[ 6], aMatrix[ 7],
+                       aMatrix[8], aMatrix[9], aMatrix[10], aMatrix[11]);
+
+      Handle (AIS_Shape) anObject = new AIS_Shape (aShapes[aShapeID].Oriented (static_cast<TopAbs_Orientation> (anOrient)).Located (TopLoc_Location (aTrsf)));
+
+      if (hasColor != 0)
+      {
+        anObject->SetColor (Quantity_Color (aRGB[0], aRGB[1], aRGB[2], Quantity_TOC_RGB));
+      }
+
+      aParent->SubNodes ().push_back (model::DataNodePtr (new model::DataNode (anObject, aName.c_str ())));
+    }
+
+    if (aRoot->SubNodes ().empty ())
+    {
+      return model::DataNodePtr ();
+    }
+
+    // mark the entry as recently used
+    ShapeIO::WriteData (entryPath (theKey, ".txt"), writeHeader () + aData.substr (aData.find ('\n') + 1));
+
+    if (!isMeshed (aCompound))
+    {
+      myStored[theNodeName.ToCString ()] = theKey; // triangulation can be added later
+    }
+
+    return aRoot;
+  }
+
+  //===========================================================================
+  //function : Store
+  //purpose  :
+  //===========================================================================
+  bool ImportCache::Store (const TCollection_AsciiString& theKey, model::DataNode* theNode)
+  {
+    if (!myIsEnabled || theKey.IsEmpty ())
+    {
+      return false;
+    }
+
+    OSD_Directory aDirectory ((OSD_Path (myDirectory)));
+
+    if (!aDirectory.Exists ())
+    {
+      aDirectory.Build (OSD_Protection ());
+
+      if (aDirectory.Failed ())
+      {
+        std::cout << "Warning: Failed to create cache directory " << myDirectory << std::endl;
+
+        return false;
+      }
+    }
+
+    EntryWriter aWriter;
+
+    aWriter.Builder.MakeCompound (aWriter.Shapes);
+
+    aWriter.Stream << std::setprecision (17);
+
+    if (!aWriter.Write (theNode, 0))
+    {
+      return false;
+    }
+
+    std::ostringstream aHeader;
+
+    aHeader << writeHeader () << aWriter.Indices.Extent () << "\n";
+
+    // structure is written last, so partially written entry is never loaded
+    if (!ShapeIO::Write (aWriter.Shapes, entryPath (theKey, ".brep"))
+     || !ShapeIO::WriteData (entryPath (theKey, ".txt"), aHeader.str () + aWriter.Stream.str ()))
+    {
+      OSD_File (entryPath (theKey, ".txt")).Remove ();
+
+      std::cout << "Warning: Failed to write cache entry " << theKey << std::endl;
+
+      return false;
+    }
+
+    if (isMeshed (aWriter.Shapes))
+    {
+      myStored.erase (theNode->Name ().ToCString ());
+    }
+    else
+    {
+      myStored[theNode->Name ().ToCString ()] = theKey;
+    }
+
+    Evict (theKey); // the new entry is kept even if it exceeds the limit alone
+
+    return true;
+  }
+
+  //===========================================================================
+  //function : Update
+  //purpose  :
+  //===========================================================================
+  bool ImportCache::Update (model::DataNode* theNode)
+  {
+    std::map<std::string, TCollection_AsciiString>::iterator anEntry = myStored.find (theNode->Name ().ToCString ());
+
+    if (!myIsEnabled || anEntry == myStored.end ())
+    {
+      return false;
+    }
+
+    EntryWriter aWriter;
+
+    aWriter.Builder.MakeCompound (aWriter.Shapes);
+
+    // unique shapes are collected in the same order as in stored entry
+    if (!aWriter.Write (theNode, 0) || !OSD_File (entryPath (anEntry->second, ".txt")).Exists ())
+    {
+      return false;
+    }
+
+    if (!isMeshed (aWriter.Shapes))
+    {
+      return false; // nothing to add yet
+    }
+
+    if (!ShapeIO::Write (aWriter.Shapes, entryPath (anEntry->second, ".brep")))
+    {
+      OSD_File (entryPath (anEntry->second, ".txt")).Remove ();
+
+      return false;
+    }
+
+    const TCollection_AsciiString aKey = anEntry->second;
+
+    myStored.erase (anEntry);
+
+    Evict (aKey);
+
+    return true;
+  }
+
+  //===========================================================================
+  //function : UpdateStored
+  //purpose  :
+  //===========================================================================
+  void ImportCache::UpdateStored ()
+  {
+    model::DataModel* aModel = model::DataModel::GetDefault ();
+
+    if (!myIsEnabled || myStored.empty () || aModel == NULL)
+    {
+      return;
+    }
+
+    std::vector<std::string> aNames;
+
+    for (std::map<std::string, TCollection_AsciiString>::iterator anIter = myStored.begin (); anIter != myStored.end (); ++anIter)
+    {
+      aNames.push_back (anIter->first);
+    }
+
+    for (size_t anIdx = 0; anIdx < aNames.size (); ++anIdx)
+    {
+      if (aModel->Has (aNames[anIdx].c_str ()))
+      {
+        Update (aModel->Get (aNames[anIdx].c_str ()).get ());
+      }
+    }
+  }
+
+  //===========================================================================
+  //function : Size
+  //purpose  :
+  //===========================================================================
+  size_t ImportCache::Size () const
+  {
+    size_t aSize = 0;
+
+    for (OSD_FileIterator anIter (OSD_Path (myDirectory), "*"); anIter.More (); anIter.Next ())
+    {
+      OSD_Path aPath;
+
+      anIter.Values ().Path (aPath);
+
+      aSize += OSD_File (myDirectory + "/" + aPath.Name () + aPath.Extension ()).Size ();
+    }
+
+    return aSize;
+  }
+
+  //===========================================================================
+  //function : Evict
+  //purpose  :
+  //===========================================================================
+  void ImportCache::Evict (const TCollection_AsciiString& theKeep)
+  {
+    std::vector<std::pair<long long, TCollection_AsciiString> > anEntries;
+
+    size_t aTotalSize = 0;
+
+    for (OSD_FileIterator anIter (OSD_Path (myDirectory), "*.txt"); anIter.More (); anIter.Next ())
+    {
+      OSD_Path aPath;
+
+      anIter.Values ().Path (aPath);
+
+      const TCollection_AsciiString aKey = aPath.Name ();
+
+      std::ifstream aStream (entryPath (aKey, ".txt").ToCString ());
+
+      anEntries.push_back (std::make_pair (readHeader (aStream), aKey)); // invalid entries go first
+
+      OSD_File aGeometry (entryPath (aKey, ".brep"));
+
+      aTotalSize += OSD_File (entryPath (aKey, ".txt")).Size () + (aGeometry.Exists () ? aGeometry.Size () : 0);
+    }
+
+    std::sort (anEntries.begin (), anEntries.end (), [] (const std::pair<long long, TCollection_AsciiString>& theLft,
+                                                          const std::pair<long long, TCollection_AsciiString>& theRgh)
+    {
+      return theLft.first < theRgh.first;
+    });
+
+    const size_t aMaxSize = static_cast<size_t> (std::max (myMaxSize, 0)) << 20;
+
+    for (size_t anIdx = 0; anIdx < anEntries.size () && aTotalSize > aMaxSize; ++anIdx)
+    {
+      if (anEntries[anIdx].second == theKeep)
+      {
+        continue;
+      }
+
+      OSD_File aStructure (entryPath (anEntries[anIdx].second, ".txt"));
+      OSD_File aGeometry  (entryPath (anEntries[anIdx].second, ".brep"));
+
+      const size_t anEntrySize = aStructure.Size () + (aGeometry.Exists () ? aGeometry.Size () : 0);
+
+      aStructure.Remove ();
+
+      if (aGeometry.Exists ())
+      {
+        aGeometry.Remove ();
+      }
+
+      aTotalSize -= std::min (anEntrySize, aTotalSize);
+    }
+  }
+
+  //===========================================================================
+  //function : Clear
+  //purpose  :
+  //===========================================================================
+  void ImportCache::Clear ()
+  {
+    const char* aMasks[] = { "*.txt", "*.brep" };
+
+    for (int aMaskID = 0; aMaskID < 2; ++aMaskID)
+    {
+      std::vector<TCollection_AsciiString> aFiles;
+
+      for (OSD_FileIterator anIter (OSD_Path (myDirectory), aMasks[aMaskID]); anIter.More (); anIter.Next ())
+      {
+        OSD_Path aPath;
+
+        anIter.Values ().Path (aPath);
+
+        aFiles.push_back (myDirectory + "/" + aPath.Name () + aPath.Extension ());
+      }
+
+      for (size_t anIdx = 0; anIdx < aFiles.size (); ++anIdx)
+      {
+        OSD_File (aFiles[anIdx]).Remove ();
+      }
+    }
+
+    myStored.clear ();
+  }
+}
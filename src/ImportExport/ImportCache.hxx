@@ -0,0 +1,119 @@
+// Created: 2019-06-29
+//
+// Copyright (c) 2019 OPEN CASCADE SAS
+//
+// This file is a part of CADRays software.
+//
+// CADRays is free software; you can use it under the terms of the MIT license,
+// refer to file LICENSE.txt for complete text of the license and disclaimer of
+// any warranty.
+
+#ifndef _RT_ImportCache_Header
+#define _RT_ImportCache_Header
+
+#include <DataModel.hxx>
+
+#include <map>
+#include <memory>
+#include <string>
+
+namespace ie
+{
+  //! On-disk cache of translated CAD files. Entry is keyed by size, modification time
+  //! and content hash of the source file and by translation options. It keeps
+  //! unique shapes (binary BREP with triangulation) and the structure of data
+  //! node (names, colors and locations of parts). Least recently used entries
+  //! are evicted when the total size exceeds the limit.
+  class ImportCache
+  {
+  public:
+
+    //! Returns the instance of import cache.
+    static Standard_EXPORT ImportCache* GetInstance ();
+
+  public:
+
+    //! Checks whether the cache is enabled.
+    bool IsEnabled () const { return myIsEnabled; }
+
+    //! Enables or disables the cache.
+    void SetEnabled (const bool theToEnable) { myIsEnabled = theToEnable; }
+
+    //! Returns cache directory.
+    const TCollection_AsciiString& Directory () const { return myDirectory; }
+
+    //! Sets cache directory (created on first store).
+    Standard_EXPORT void SetDirectory (const TCollection_AsciiString& theDirectory);
+
+    //! Returns size limit of the cache (in megabytes).
+    int MaxSize () const { return myMaxSize; }
+
+    //! Sets size limit of the cache (in megabytes).
+    void SetMaxSize (const int theMaxSize) { myMaxSize = theMaxSize; }
+
+  public:
+
+    //! Computes cache key of the given source file and translation options.
+    //! Returns empty string if the file cannot be read.
+    Standard_EXPORT static TCollection_AsciiString Key (const TCollection_AsciiString& theFileName,
+                                                        const TCollection_AsciiString& theOptions);
+
+    //! Restores data node with the given name from the cache (NULL if missing).
+    Standard_EXPORT model::DataNodePtr Load (const TCollection_AsciiString& theKey,
+                                             const TCollection_AsciiString& theNodeName);
+
+    //! Stores translated data node in the cache and evicts old entries.
+    //! Should be called before any transformation is applied to the node.
+    Standard_EXPORT bool Store (const TCollection_AsciiString& theKey, model::DataNode* theNode);
+
+    //! Rewrites shapes of the node stored in this session (e.g. to keep
+    //! triangulation computed after import). Locations are not changed.
+    Standard_EXPORT bool Update (model::DataNode* theNode);
+
+    //! Updates all entries stored in this session which were not meshed at
+    //! storing (e.g. once progressive display has tessellated all shapes).
+    Standard_EXPORT void UpdateStored ();
+
+    //! Checks whether some entry stored in this session waits for triangulation.
+    bool HasStored () const { return !myStored.empty (); }
+
+    //! Removes least recently used entries until the total size fits the limit
+    //! (the given entry is never removed, e.g. the one which was just stored).
+    Standard_EXPORT void Evict (const TCollection_AsciiString& theKeep = TCollection_AsciiString ());
+
+    //! Removes all entries.
+    Standard_EXPORT void Clear ();
+
+    //! Returns total size of cache entries (in bytes).
+    Standard_EXPORT size_t Size () const;
+
+  protected:
+
+    //! Creates import cache with default settings.
+    ImportCache ();
+
+    //! Returns path of entry file with the given extension.
+    TCollection_AsciiString entryPath (const TCollection_AsciiString& theKey, const char* theExtension) const;
+
+  protected:
+
+    //! Is cache enabled?
+    bool myIsEnabled;
+
+    //! Cache directory.
+    TCollection_AsciiString myDirectory;
+
+    //! Size limit (in megabytes).
+    int myMaxSize;
+
+    //! Keys of entries stored in this session (by node name).
+    std::map<std::string, TCollection_AsciiString> myStored;
+
+  protected:
+
+    //! Instance of import cache.
+    static std::shared_ptr<ImportCache> myInstance;
+  };
+}
+
+#endif // _RT_ImportCache_Header
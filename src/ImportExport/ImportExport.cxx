@@ -12,10 +12,19 @@
 #include <OSD_File.hxx>
 #include <OSD_Directory.hxx>
 #include <OSD_Protection.hxx>
+#include <OSD_Parallel.hxx>
+#include <OSD_Timer.hxx>
 
 #include <BRepTools.hxx>
 #include <gp_Quaternion.hxx>
 
+#include <Prs3d.hxx>
+#include <ViewerTest.hxx>
+
+#include <limits>
+#include <sstream>
+#include <algorithm>
+
 #include <V3d_Light.hxx>
 #include <V3d_SpotLight.hxx>
 #include <V3d_PositionalLight.hxx>
@@ -25,6 +34,8 @@
 
 #include <Utils.hxx>
 #include <AisMesh.hxx>
+#include <ShapeIO.hxx>
+#include <MeshQueue.hxx>
 
 #include "ImportExport.hxx"
 
@@ -39,6 +50,33 @@ namespace ie
     myStream << "variable Root [file dirname [file normalize [info script]]]" << "\n";
   }
 
+  //===========================================================================
+  //function : shapeExtension
+  //purpose  :
+  //===========================================================================
+  const char* ImportExport::shapeExtension () const
+  {
+    return myDrawCompatible ? ".brep" : ".bbrep"; // DRAW supports only ASCII BREP
+  }
+
+  //===========================================================================
+  //function : restoreCommand
+  //purpose  :
+  //===========================================================================
+  const char* ImportExport::restoreCommand () const
+  {
+    return myDrawCompatible ? "restore" : "rtrestore";
+  }
+
+  //===========================================================================
+  //function : relativePath
+  //purpose  :
+  //===========================================================================
+  TCollection_AsciiString ImportExport::relativePath (const TCollection_AsciiString& theFileName) const
+  {
+    return theFileName.SubString (myBasePath.Length () + 1, theFileName.Length ());
+  }
+
   //===========================================================================
   //function : storeDataNode
   //purpose  :
@@ -66,34 +104,343 @@ namespace ie
     }
     else
     {
+      // Files are written later by the thread pool, here we only
+      // fix the output path and the order of manifest commands
+      StoreTask aTask;
+
       Handle (AIS_Shape) aShape = Handle (AIS_Shape)::DownCast (theNode->Object ());
 
       if (!aShape.IsNull ())
       {
-        TCollection_AsciiString aShapeName = thePath + "/" + theNode->Name () + ".brep";
+        const TopoDS_Shape& aTopoShape = aShape->Shape ();
 
-        if (!BRepTools::Write (aShape->Shape (), aShapeName.ToCString ()))
+        if (myDrawCompatible || myShapeUses[aTopoShape.TShape ().get ()] < 2)
         {
-          Standard_ASSERT_INVOKE ("Error! Failed to export shape to BREP");
+          aTask.Shape = aTopoShape;
+          aTask.FileName = thePath + "/" + theNode->Name () + shapeExtension ();
+
+          myStream << restoreCommand () << " $Root" << relativePath (aTask.FileName) << " " << theNode->Name () << "\n";
+
+          pushMeshParams (aShape, theNode->Name ());
+
+          // Triangulation is stored too, so it is computed before fingerprint
+          triangulate (aShape, aTask);
+
+          scheduleTask (aTask);
+        }
+        else // shared geometry is stored once and instanced
+        {
+          auto aBaseIter = myShapeBases.find (aTopoShape.TShape ().get ());
+
+          if (aBaseIter == myShapeBases.end ())
+          {
+            aTask.Shape = aTopoShape.Located (TopLoc_Location ()).Oriented (TopAbs_FORWARD);
+            aTask.FileName = thePath + "/" + theNode->Name () + shapeExtension ();
+
+            aBaseIter = myShapeBases.insert (std::make_pair (aTopoShape.TShape ().get (), theNode->Name () + "_base")).first;
+
+            myStream << restoreCommand () << " $Root" << relativePath (aTask.FileName) << " " << aBaseIter->second << "\n";
+
+            triangulate (aShape, aTask);
+
+            scheduleTask (aTask);
+          }
+
+          static const char* anOrientNames[] = { "F", "R", "I", "E" };
+
+          myStream << "rtinstance " << theNode->Name () << " " << aBaseIter->second << " -orient " << anOrientNames[aTopoShape.Orientation ()];
+
+          if (!aTopoShape.Location ().IsIdentity ())
+          {
+            std::ostringstream aLocation;
+
+            aLocation.precision (std::numeric_limits<double>::max_digits10);
+
+            const gp_Trsf aTrsf = aTopoShape.Location ().Transformation ();
+
+            for (int aRow = 1; aRow <= 3; ++aRow)
+            {
+              for (int aCol = 1; aCol <= 4; ++aCol)
+              {
+                aLocation << " " << aTrsf.Value (aRow, aCol);
+              }
+            }
+
+            myStream << " -location" << aLocation.str ();
+          }
+
+          myStream << "\n";
+
+          pushMeshParams (aShape, theNode->Name ());
         }
+      }
+      else if (!Handle (mesh::AisMesh)::DownCast (theNode->Object ()).IsNull ())
+      {
+        aTask.Object = theNode->Object ();
+        aTask.FileName = thePath + "/" + theNode->Name () + ".ply";
+
+        myStream << "rtmeshread $Root" << relativePath (aTask.FileName) << " " << theNode->Name () << " -group \n";
 
-        myStream << "restore $Root" << aShapeName.Split (myBasePath.Length ()) << " " << theNode->Name () << "\n";
+        scheduleTask (aTask);
       }
       else
       {
-        Handle (mesh::AisMesh) aMesh = Handle (mesh::AisMesh)::DownCast (theNode->Object ());
+        Standard_ASSERT_INVOKE ("Error! Invalid AIS object to export");
+      }
+    }
+  }
+
+  //===========================================================================
+  //function : triangulate
+  //purpose  :
+  //===========================================================================
+  void ImportExport::triangulate (const Handle (AIS_Shape)& theShape, StoreTask& theTask)
+  {
+    // Restored shapes are displayed with parameters of their objects (see pushMeshParams)
+    const Handle (Prs3d_Drawer)& aDrawer = theShape->Attributes ();
+
+    // Deflection is computed here, since it reads (and updates) the shared drawer.
+    // Shapes which were never displayed (or meshed coarser) are meshed by mesh
+    // queue worker, since triangulation is stored in BREP file and AIS will not
+    // re-mesh it on load
+    theTask.LinDefl = Prs3d::GetDeflection (theShape->Shape (), aDrawer);
+    theTask.AngDefl = aDrawer->DeviationAngle ();
+
+    HashCombine (theTask.Hash, std::hash<double> () (theTask.LinDefl));
+    HashCombine (theTask.Hash, std::hash<double> () (theTask.AngDefl));
+  }
+
+  //===========================================================================
+  //function : pushMeshParams
+  //purpose  :
+  //===========================================================================
+  void ImportExport::pushMeshParams (const Handle (AIS_Shape)& theShape, const TCollection_AsciiString& theName)
+  {
+    if (myDrawCompatible)
+    {
+      return; // command is not supported in DRAW
+    }
+
+    const Handle (Prs3d_Drawer)& aDrawer = theShape->Attributes ();
+
+    std::ostringstream aParams;
+
+    aParams.precision (std::numeric_limits<double>::max_digits10);
+
+    // Stored triangulation is reused only if the deflection matches
+    if (aDrawer->TypeOfDeflection () == Aspect_TOD_ABSOLUTE)
+    {
+      aParams << "rtmesh " << theName << " -absDefl " << aDrawer->MaximalChordialDeviation ();
+    }
+    else
+    {
+      aParams << "rtmesh " << theName << " -devCoeff " << aDrawer->DeviationCoefficient ();
+    }
+
+    aParams << " -angDefl " << aDrawer->DeviationAngle () * 180.0 / M_PI;
+
+    myStream << aParams.str () << "\n";
+  }
+
+  //===========================================================================
+  //function : registerTexture
+  //purpose  :
+  //===========================================================================
+  TCollection_AsciiString ImportExport::registerTexture (const OSD_Path& thePath)
+  {
+    const TCollection_AsciiString aName = model::DataModel::GetDefault ()->Manager ()->RegisterName (thePath);
+
+    myTextureNames.insert (aName.ToCString ());
+
+    // Textures are copied by modification time, fingerprint is only
+    // needed to remove copies of textures which are not used anymore
+    myNewPrints.Bind ("/textures/" + aName, 0);
+
+    return aName;
+  }
+
+  //===========================================================================
+  //function : scheduleTask
+  //purpose  :
+  //===========================================================================
+  void ImportExport::scheduleTask (const StoreTask& theTask)
+  {
+    myTasks.push_back (theTask);
+  }
+
+  //===========================================================================
+  //function : submitTasks
+  //purpose  :
+  //===========================================================================
+  void ImportExport::submitTasks ()
+  {
+    myNbPending = static_cast<int> (myTasks.size ());
+
+    // Tasks are not added anymore, so workers can refer to them
+    for (size_t aTaskID = 0; aTaskID < myTasks.size (); ++aTaskID)
+    {
+      StoreTask* aTask = &myTasks[aTaskID];
+
+      MeshQueue::GetInstance ()->Submit (aTask->Shape, aTask->LinDefl, aTask->AngDefl, [this, aTask] ()
+      {
+        HashCombine (aTask->Hash, !aTask->Shape.IsNull () ? Fingerprints::Compute (aTask->Shape)
+                                                          : Fingerprints::Compute (aTask->Object));
 
-        if (!aMesh.IsNull ())
         {
-          TCollection_AsciiString aMeshName = thePath + "/" + theNode->Name () + ".ply";
+          std::lock_guard<std::mutex> aLock (myMutex);
+
+          --myNbPending;
+        }
+
+        myTaskDone.notify_all ();
+      });
+    }
+  }
 
-          aMesh->ExportToFile (aMeshName);
+  //===========================================================================
+  //function : waitTasks
+  //purpose  :
+  //===========================================================================
+  void ImportExport::waitTasks ()
+  {
+    std::unique_lock<std::mutex> aLock (myMutex);
+
+    myTaskDone.wait (aLock, [this] { return myNbPending == 0; });
+  }
+
+  //===========================================================================
+  //function : filterTasks
+  //purpose  :
+  //===========================================================================
+  void ImportExport::filterTasks ()
+  {
+    std::vector<StoreTask> aChanged;
+
+    for (size_t aTaskID = 0; aTaskID < myTasks.size (); ++aTaskID)
+    {
+      const StoreTask& aTask = myTasks[aTaskID];
+
+      const TCollection_AsciiString aFileName = relativePath (aTask.FileName);
+
+      size_t aHash = aTask.Hash;
+
+      HashCombine (aHash, myToCompress ? 1 : 0); // file format also matters
+
+      myNewPrints.Bind (aFileName, aHash);
+
+      if (myOldPrints.IsChanged (aFileName, aHash) || !OSD_File (aTask.FileName).Exists ())
+      {
+        aChanged.push_back (aTask);
+      }
+    }
 
-          myStream << "rtmeshread $Root" << aMeshName.Split (myBasePath.Length ()) << " " << theNode->Name () << " -group \n";
+    myTasks.swap (aChanged);
+
+    myNbToStore = static_cast<int> (myTasks.size ());
+  }
+
+  //===========================================================================
+  //function : countShapeUses
+  //purpose  :
+  //===========================================================================
+  void ImportExport::countShapeUses (model::DataNode* theNode)
+  {
+    for (size_t aShapeID = 0; aShapeID < theNode->SubNodes ().size (); ++aShapeID)
+    {
+      countShapeUses (theNode->SubNodes ()[aShapeID].get ());
+    }
+
+    Handle (AIS_Shape) aShape = Handle (AIS_Shape)::DownCast (theNode->Object ());
+
+    if (theNode->SubNodes ().empty () && !aShape.IsNull ())
+    {
+      ++myShapeUses[aShape->Shape ().TShape ().get ()];
+    }
+  }
+
+  //! Functor to write shape/mesh file in a worker thread.
+  struct StoreFunctor
+  {
+    StoreFunctor (const std::vector<ImportExport::StoreTask>& theTasks,
+                  std::atomic<int>&                           theNbStored,
+                  std::atomic<bool>&                          theHasFailed,
+                  const bool                                  theToUseBinary,
+                  const bool                                  theToCompress)
+      : myTasks (theTasks),
+        myNbStored (theNbStored),
+        myHasFailed (theHasFailed),
+        myToUseBinary (theToUseBinary),
+        myToCompress (theToCompress)
+    {
+      //
+    }
+
+    void operator() (const int theTaskID) const
+    {
+      const ImportExport::StoreTask& aTask = myTasks[theTaskID];
+
+      if (!aTask.Shape.IsNull ())
+      {
+        const bool isDone = myToUseBinary ? ShapeIO::Write (aTask.Shape, aTask.FileName, myToCompress)
+                                          : BRepTools::Write (aTask.Shape, aTask.FileName.ToCString ());
+
+        if (!isDone)
+        {
+          std::cout << "Error! Failed to export shape to BREP: " << aTask.FileName << std::endl;
+
+          myHasFailed = true;
         }
-        else
+      }
+      else if (!Handle (mesh::AisMesh)::DownCast (aTask.Object)->ExportToFile (aTask.FileName))
+      {
+        std::cout << "Error! Failed to export mesh to PLY: " << aTask.FileName << std::endl;
+
+        myHasFailed = true;
+      }
+
+      ++myNbStored;
+    }
+
+  private:
+
+    const std::vector<ImportExport::StoreTask>& myTasks;
+
+    std::atomic<int>& myNbStored;
+
+    std::atomic<bool>& myHasFailed;
+
+    bool myToUseBinary;
+
+    bool myToCompress;
+  };
+
+  //===========================================================================
+  //function : storeFiles
+  //purpose  :
+  //===========================================================================
+  bool ImportExport::storeFiles ()
+  {
+    // Leaf nodes are independent, so the files can be written concurrently
+    OSD_Parallel::For (0, static_cast<int> (myTasks.size ()), StoreFunctor (myTasks, myNbStored, myHasFailed, !myDrawCompatible, myToCompress));
+
+    return !myHasFailed;
+  }
+
+  //===========================================================================
+  //function : removeStaleFiles
+  //purpose  :
+  //===========================================================================
+  void ImportExport::removeStaleFiles ()
+  {
+    for (auto aHashIter = myOldPrints.Hashes ().begin (); aHashIter != myOldPrints.Hashes ().end (); ++aHashIter)
+    {
+      if (myNewPrints.Hashes ().find (aHashIter->first) == myNewPrints.Hashes ().end ())
+      {
+        OSD_File aFile (myBasePath + aHashIter->first.c_str ());
+
+        if (aFile.Exists ())
         {
-          Standard_ASSERT_INVOKE ("Error! Invalid AIS object to export");
+          aFile.Remove ();
         }
       }
     }
@@ -234,75 +581,194 @@ namespace ie
 
       if (!aTexMap.IsNull ()) // handle texture attached
       {
-        const TCollection_AsciiString aName = model::DataModel::GetDefault ()->Manager ()->RegisterName (aTexMap->Path ());
+        const TCollection_AsciiString aName = registerTexture (aTexMap->Path ());
 
         double aScaleS = 1.0;
         double aScaleT = 1.0;
 
+        model::GetTextureScale (anObject, aScaleS, aScaleT);
+
+        // try to provide backward compatibility with DRAW
         if (anObject->IsKind (STANDARD_TYPE (AIS_TexturedShape)))
         {
-          Handle (AIS_TexturedShape) aTexShape = Handle (AIS_TexturedShape)::DownCast (anObject);
-
-          if (aTexShape->TextureScale ())
-          {
-            aScaleS = aTexShape->TextureScaleU ();
-            aScaleT = aTexShape->TextureScaleV ();
-          }
+          myStream << "vtexture " << theNode->Name () << " $Root/textures/" << aName << " -scale " << aScaleS << " " << aScaleT << "\n";
         }
+      }
 
-        if (!myDrawCompatible)
-        {
-          // Here we should synchronize DRAW with our data model
-          // since we can apply rt* commands only for data nodes
-          myStream << "rtmodel -sync default" << "\n";
+      setLocation (theNode);
+    }
+  }
+
+  //===========================================================================
+  //function : setLocation
+  //purpose  :
+  //===========================================================================
+  void ImportExport::setLocation (model::DataNode* theNode)
+  {
+    Handle (AIS_InteractiveObject) anObject = theNode->Object ();
+
+    const gp_Quaternion aQuat = anObject->LocalTransformation ().GetRotation ();
+
+    if (aQuat.X () != 0.0
+     || aQuat.Y () != 0.0
+     || aQuat.Z () != 0.0
+     || aQuat.W () != 0.0)
+    {
+      myStream << "vlocation " << theNode->Name () << " -rotation " << aQuat.X () << " "
+                                                                    << aQuat.Y () << " "
+                                                                    << aQuat.Z () << " "
+                                                                    << aQuat.W () << "\n";
+    }
+
+    const double aScale = anObject->LocalTransformation ().ScaleFactor ();
+
+    if (aScale != 1.0)
+    {
+      myStream << "vlocation " << theNode->Name () << " -scale " << aScale << "\n";
+    }
+
+    const gp_XYZ aTranslation = anObject->LocalTransformation ().TranslationPart ();
+
+    if (aTranslation.X () != 0.0
+     || aTranslation.Y () != 0.0
+     || aTranslation.Z () != 0.0)
+    {
+      myStream << "vlocation " << theNode->Name () << " -location " << aTranslation.X () << " "
+                                                                    << aTranslation.Y () << " "
+                                                                    << aTranslation.Z () << "\n";
+    }
+  }
+
+  //===========================================================================
+  //function : collectLeaves
+  //purpose  :
+  //===========================================================================
+  void ImportExport::collectLeaves (model::DataNode* theNode, std::vector<model::DataNode*>& theLeaves)
+  {
+    if (!theNode->SubNodes ().empty ())
+    {
+      for (size_t aSubID = 0; aSubID < theNode->SubNodes ().size (); ++aSubID)
+      {
+        collectLeaves (theNode->SubNodes ()[aSubID].get (), theLeaves);
+      }
+    }
+    else
+    {
+      theLeaves.push_back (theNode);
+    }
+  }
+
+  //===========================================================================
+  //function : setProperties
+  //purpose  :
+  //===========================================================================
+  void ImportExport::setProperties (const std::vector<model::DataNode*>& theLeaves)
+  {
+    if (theLeaves.empty ())
+    {
+      return;
+    }
+
+    // Maximum number of objects displayed by single command
+    static const size_t THE_DISPLAY_CHUNK = 256;
+
+    myStream << "\n# Display objects" << "\n";
+
+    for (size_t aFirst = 0; aFirst < theLeaves.size (); aFirst += THE_DISPLAY_CHUNK)
+    {
+      myStream << "vdisplay";
+
+      for (size_t aLeafID = aFirst; aLeafID < std::min (aFirst + THE_DISPLAY_CHUNK, theLeaves.size ()); ++aLeafID)
+      {
+        myStream << " " << theLeaves[aLeafID]->Name ();
+      }
+
+      myStream << " -noupdate\n";
+    }
+
+    // Here we should synchronize DRAW with our data model
+    // since we can apply rt* commands only for data nodes
+    myStream << "rtmodel -sync default" << "\n";
+
+    // Nodes sharing the same material are set up by single command
+    // (groups are kept in order of their first appearance)
+    std::vector<std::pair<std::string, std::string> > aGroups;
+
+    std::map<std::string, size_t> aGroupIDs;
+
+    for (size_t aLeafID = 0; aLeafID < theLeaves.size (); ++aLeafID)
+    {
+      model::DataNode* aNode = theLeaves[aLeafID];
+
+      Handle (AIS_InteractiveObject) anObject = aNode->Object ();
+
+      if (anObject.IsNull ())
+      {
+        Standard_ASSERT_INVOKE ("Error! AIS interactive shape is NULL");
+      }
+
+      const Graphic3d_MaterialAspect& aMaterial = model::GetAspect (anObject)->FrontMaterial ();
+
+      std::ostringstream anArgs;
+
+      anArgs << "{" << model::SerializeBSDF (aMaterial.BSDF ()) << "}";
 
-          myStream << "rttexture " << theNode->Name () << " \"$Root/textures/" << aName << "\"\n";
+      const int aMatIndex = aMaterial.Name ();
 
+      if (aMatIndex < Graphic3d_MaterialAspect::NumberOfMaterials ())
+      {
+        anArgs << " -material " << Graphic3d_MaterialAspect::MaterialName (aMatIndex + 1);
+      }
+
+      Handle (Graphic3d_TextureRoot) aTexMap = Handle (Graphic3d_TextureRoot)::DownCast (model::GetAspect (anObject)->TextureMap ());
+
+      if (!aTexMap.IsNull ()) // handle texture attached
+      {
+        const TCollection_AsciiString aName = registerTexture (aTexMap->Path ());
+
+        anArgs << " -texture \"$Root/textures/" << aName << "\"";
+
+        double aScaleS = 1.0;
+        double aScaleT = 1.0;
+
+        if (model::GetTextureScale (anObject, aScaleS, aScaleT))
+        {
           if (aScaleS != 1.0
            || aScaleT != 1.0)
           {
-            myStream << "rttexture " << theNode->Name () << " -scale " << aScaleS << " " << aScaleT << "\n";
-          }
-        }
-        else // try to provide backward compatibility with DRAW
-        {
-          if (anObject->IsKind (STANDARD_TYPE (AIS_TexturedShape)))
-          {
-            myStream << "vtexture " << theNode->Name () << " $Root/textures/" << aName << " -scale " << aScaleS << " " << aScaleT << "\n";
+            anArgs << " -scale " << aScaleS << " " << aScaleT;
           }
         }
       }
 
-      const gp_Quaternion aQuat = anObject->LocalTransformation ().GetRotation ();
+      auto aGroupIter = aGroupIDs.find (anArgs.str ());
 
-      if (aQuat.X () != 0.0
-       || aQuat.Y () != 0.0
-       || aQuat.Z () != 0.0
-       || aQuat.W () != 0.0)
+      if (aGroupIter == aGroupIDs.end ())
       {
-        myStream << "vlocation " << theNode->Name () << " -rotation " << aQuat.X () << " "
-                                                                      << aQuat.Y () << " "
-                                                                      << aQuat.Z () << " "
-                                                                      << aQuat.W () << "\n";
-      }
+        aGroupIter = aGroupIDs.insert (std::make_pair (anArgs.str (), aGroups.size ())).first;
 
-      const double aScale = anObject->LocalTransformation ().ScaleFactor ();
-
-      if (aScale != 1.0)
+        aGroups.push_back (std::make_pair (anArgs.str (), std::string ()));
+      }
+      else
       {
-        myStream << "vlocation " << theNode->Name () << " -scale " << aScale << "\n";
+        aGroups[aGroupIter->second].second += " ";
       }
 
-      const gp_XYZ aTranslation = anObject->LocalTransformation ().TranslationPart ();
+      aGroups[aGroupIter->second].second += aNode->Name ().ToCString ();
+    }
 
-      if (aTranslation.X () != 0.0
-       || aTranslation.Y () != 0.0
-       || aTranslation.Z () != 0.0)
-      {
-        myStream << "vlocation " << theNode->Name () << " -location " << aTranslation.X () << " "
-                                                                      << aTranslation.Y () << " "
-                                                                      << aTranslation.Z () << "\n";
-      }
+    myStream << "\n# Setup materials" << "\n";
+
+    for (size_t aGroupID = 0; aGroupID < aGroups.size (); ++aGroupID)
+    {
+      myStream << "rtmaterial {" << aGroups[aGroupID].second << "} " << aGroups[aGroupID].first << " -noupdate\n";
+    }
+
+    myStream << "\n# Setup locations" << "\n";
+
+    for (size_t aLeafID = 0; aLeafID < theLeaves.size (); ++aLeafID)
+    {
+      setLocation (theLeaves[aLeafID]);
     }
   }
 
@@ -343,11 +809,29 @@ namespace ie
     return "UNKNOWN";
   }
 
+  //===========================================================================
+  //function : ~ImportExport
+  //purpose  :
+  //===========================================================================
+  ImportExport::~ImportExport ()
+  {
+    waitTasks ();
+  }
+
   //===========================================================================
   //function : Export
   //purpose  :
   //===========================================================================
   bool ImportExport::Export (const TCollection_AsciiString& thePath, Handle (V3d_View) theView)
+  {
+    return Prepare (thePath, theView) && Store ();
+  }
+
+  //===========================================================================
+  //function : Prepare
+  //purpose  :
+  //===========================================================================
+  bool ImportExport::Prepare (const TCollection_AsciiString& thePath, Handle (V3d_View) theView)
   {
     myBasePath = thePath;
 
@@ -372,13 +856,23 @@ namespace ie
 
     pushPrefix ();
 
-    // Store CAD shapes and meshes to the files
+    if (myIncremental)
+    {
+      myOldPrints.Load (myBasePath + "/model.fingerprints");
+    }
+
+    // Schedule CAD shapes and meshes to be stored to the files
     {
       if (!aModel->Shapes ().empty ())
       {
         myStream << "\n# Restore exported shapes" << "\n";
       }
 
+      for (size_t aShapeID = 0; aShapeID < aModel->Shapes ().size (); ++aShapeID)
+      {
+        countShapeUses (aModel->Shapes ()[aShapeID].get ());
+      }
+
       for (size_t aShapeID = 0; aShapeID < aModel->Shapes ().size (); ++aShapeID)
       {
         storeDataNode (aModel->Shapes ()[aShapeID].get (), myBasePath + "/shapes");
@@ -399,19 +893,28 @@ namespace ie
     }
 
     // Export properties of AIS interactive objects
+    if (myDrawCompatible)
     {
       for (size_t aShapeID = 0; aShapeID < aModel->Shapes ().size (); ++aShapeID)
       {
         setProperties (aModel->Shapes ()[aShapeID].get ());
       }
+    }
+    else // materials are set by batches of nodes
+    {
+      std::vector<model::DataNode*> aLeaves;
 
-      if (!myDrawCompatible) // meshes are not supported in DRAW
+      for (size_t aShapeID = 0; aShapeID < aModel->Shapes ().size (); ++aShapeID)
       {
-        for (size_t aMeshID = 0; aMeshID < aModel->Meshes ().size (); ++aMeshID)
-        {
-          setProperties (aModel->Meshes ()[aMeshID].get ());
-        }
+        collectLeaves (aModel->Shapes ()[aShapeID].get (), aLeaves);
+      }
+
+      for (size_t aMeshID = 0; aMeshID < aModel->Meshes ().size (); ++aMeshID)
+      {
+        collectLeaves (aModel->Meshes ()[aMeshID].get (), aLeaves);
       }
+
+      setProperties (aLeaves);
     }
     
     if (!myDrawCompatible) // Export CADRays scene hierarchy
@@ -502,7 +1005,7 @@ namespace ie
     {
       if (!theView->TextureEnv ().IsNull ()) // export environment map if any
       {
-        const TCollection_AsciiString aName = model::DataModel::GetDefault ()->Manager ()->RegisterName (theView->TextureEnv ()->Path ());
+        const TCollection_AsciiString aName = registerTexture (theView->TextureEnv ()->Path ());
 
         myStream << "\n# Restore environment map" << "\n";
 
@@ -524,7 +1027,7 @@ namespace ie
         }
       }
 
-      aModel->Manager ()->CopyTo (myBasePath + "/" + "textures");
+      aModel->Manager ()->CopyTo (myBasePath + "/" + "textures", myIncremental, &myTextureNames);
     }
 
     if (!theView.IsNull ()) // export light source parameters
@@ -608,6 +1111,44 @@ namespace ie
 
     myStream.close ();
 
+    // Shapes being tessellated in background are linked to the same tasks
+    submitTasks ();
+
     return true;
   }
+
+  //===========================================================================
+  //function : Store
+  //purpose  :
+  //===========================================================================
+  bool ImportExport::Store ()
+  {
+    OSD_Timer aTimer;
+
+    aTimer.Start ();
+
+    waitTasks ();
+
+    filterTasks ();
+
+    if (!storeFiles ())
+    {
+      std::cout << "Error! Failed to export some shapes or meshes" << std::endl;
+    }
+    else
+    {
+      removeStaleFiles ();
+
+      if (!myNewPrints.Save (myBasePath + "/model.fingerprints"))
+      {
+        std::cout << "Warning: Failed to save file fingerprints, next export will rewrite all files" << std::endl;
+      }
+    }
+
+    aTimer.Stop ();
+
+    std::cout << "Exported " << myNbStored << " files in " << aTimer.ElapsedTime () << " sec" << std::endl;
+
+    return !myHasFailed;
+  }
 }
@@ -12,46 +12,216 @@
 #define _ImportExport_HeaderFile
 
 #include <V3d_View.hxx>
+#include <OSD_Path.hxx>
+#include <AIS_Shape.hxx>
 #include <DataModel.hxx>
+#include <Fingerprints.hxx>
+
+#include <map>
+#include <set>
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
 
 namespace ie
 {
   //! Tool class to export default data model.
   class ImportExport
   {
+  public:
+
+    //! Shape or mesh file to be written by export thread pool.
+    struct StoreTask
+    {
+      //! Creates new empty task.
+      StoreTask () : LinDefl (0.0), AngDefl (0.0), Hash (0)
+      {
+        //
+      }
+
+      //! Shape to write to BREP file.
+      TopoDS_Shape Shape;
+
+      //! AIS mesh to write to PLY file.
+      Handle (AIS_InteractiveObject) Object;
+
+      //! Full path to output file.
+      TCollection_AsciiString FileName;
+
+      //! Linear deflection to triangulate the shape with.
+      double LinDefl;
+
+      //! Angular deflection to triangulate the shape with.
+      double AngDefl;
+
+      //! Fingerprint of file contents (completed by mesh queue worker).
+      size_t Hash;
+    };
+
   public:
 
     //! Creates new data model exporter.
-    ImportExport (const bool theIsDrawCompatible = false) : myDrawCompatible (theIsDrawCompatible) { }
+    ImportExport (const bool theIsDrawCompatible = false)
+      : myDrawCompatible (theIsDrawCompatible),
+        myIncremental (true),
+        myToCompress (false),
+        myNbToStore (0),
+        myNbStored (0),
+        myNbPending (0),
+        myHasFailed (false)
+    {
+      //
+    }
+
+    //! Waits for background processing of scheduled files.
+    Standard_EXPORT ~ImportExport ();
 
     //! Exports default data model to the given folder.
     Standard_EXPORT bool Export (const TCollection_AsciiString& thePath, Handle (V3d_View) theView = NULL);
 
+    //! Writes TCL script and textures, and schedules shape/mesh files to be written.
+    //! Reads AIS objects and the view, so it should be called from the main thread.
+    //! Shapes are triangulated and fingerprinted by mesh queue workers afterwards.
+    Standard_EXPORT bool Prepare (const TCollection_AsciiString& thePath, Handle (V3d_View) theView = NULL);
+
+    //! Writes the files scheduled by Prepare (once they are processed by mesh queue).
+    //! Reads only shape and mesh data (not AIS aspects or the view), so it can be
+    //! called from any thread.
+    Standard_EXPORT bool Store ();
+
+    //! Enables/disables rewriting of unchanged files in existing export folder.
+    void SetIncremental (const bool theToEnable) { myIncremental = theToEnable; }
+
+    //! Enables/disables compression of binary shape files (if supported).
+    void SetCompression (const bool theToEnable) { myToCompress = theToEnable; }
+
+    //! Returns number of shape/mesh files scheduled for writing.
+    int NbFilesToStore () const { return myNbToStore; }
+
+    //! Returns number of shape/mesh files already written (safe to call from any thread).
+    int NbFilesStored () const { return myNbStored; }
+
+    //! Returns number of shape/mesh files waiting for triangulation and fingerprint.
+    int NbFilesPending () const { return myNbPending; }
+
   protected:
 
+    //! Returns extension of exported shape files.
+    const char* shapeExtension () const;
+
+    //! Returns TCL command restoring exported shape.
+    const char* restoreCommand () const;
+
+    //! Returns path of the given file relative to output directory.
+    TCollection_AsciiString relativePath (const TCollection_AsciiString& theFileName) const;
+
     //! Generates prefix for TCL script.
     void pushPrefix ();
 
-    //! Exports properties of given node.
+    //! Exports properties of given node (DRAW compatible).
     void setProperties (model::DataNode* theNode);
 
+    //! Exports properties of given leaf nodes (grouped by material).
+    void setProperties (const std::vector<model::DataNode*>& theLeaves);
+
+    //! Exports local transformation of given node.
+    void setLocation (model::DataNode* theNode);
+
+    //! Collects leaf nodes of the given node.
+    void collectLeaves (model::DataNode* theNode, std::vector<model::DataNode*>& theLeaves);
+
     //! Restores hierarchy of the given node.
     void groupSubNodes (model::DataNode* theNode);
 
-    //! Exports the given data node to BREP shapes or PLY meshes.
+    //! Schedules export of the given data node to BREP shapes or PLY meshes.
     void storeDataNode (model::DataNode* theNode, const TCollection_AsciiString& thePath);
 
+    //! Registers texture used by exported scene and returns its unique file name.
+    TCollection_AsciiString registerTexture (const OSD_Path& thePath);
+
+    //! Schedules writing of the given file (fingerprint is completed later).
+    void scheduleTask (const StoreTask& theTask);
+
+    //! Chooses triangulation parameters of the shape from its drawer (written by
+    //! pushMeshParams) and adds them to fingerprint. Should be called from the main thread.
+    void triangulate (const Handle (AIS_Shape)& theShape, StoreTask& theTask);
+
+    //! Passes scheduled files to mesh queue workers which triangulate
+    //! shapes (if needed) and compute fingerprints of the files.
+    void submitTasks ();
+
+    //! Waits until all scheduled files are processed by mesh queue workers.
+    void waitTasks ();
+
+    //! Removes scheduled files which fingerprints were not changed.
+    void filterTasks ();
+
+    //! Generates TCL command restoring meshing parameters of the given object
+    //! (so its stored triangulation is reused on display).
+    void pushMeshParams (const Handle (AIS_Shape)& theShape, const TCollection_AsciiString& theName);
+
+    //! Counts the number of leaf nodes referring to each TShape.
+    void countShapeUses (model::DataNode* theNode);
+
+    //! Writes all scheduled shape/mesh files in parallel.
+    bool storeFiles ();
+
+    //! Removes files left from previous export which are not used anymore.
+    void removeStaleFiles ();
+
   protected:
 
     //! DRAW compatibility.
     bool myDrawCompatible;
 
+    //! Skip unchanged files on re-export.
+    bool myIncremental;
+
+    //! Compress binary shape files.
+    bool myToCompress;
+
+    //! Fingerprints of files from previous export.
+    Fingerprints myOldPrints;
+
+    //! Fingerprints of files from current export.
+    Fingerprints myNewPrints;
+
     //! TCL script generated.
     std::ofstream myStream;
 
     //! Base path to output directory.
     TCollection_AsciiString myBasePath;
 
+    //! Number of leaf nodes sharing the same TShape.
+    std::map<const TopoDS_TShape*, int> myShapeUses;
+
+    //! DRAW names of base shapes restored for shared TShapes.
+    std::map<const TopoDS_TShape*, TCollection_AsciiString> myShapeBases;
+
+    //! Unique file names of textures used by exported scene.
+    std::set<std::string> myTextureNames;
+
+    //! Files scheduled for writing (in manifest order).
+    std::vector<StoreTask> myTasks;
+
+    //! Number of files scheduled so far.
+    std::atomic<int> myNbToStore;
+
+    //! Number of files written so far.
+    std::atomic<int> myNbStored;
+
+    //! Number of files waiting for mesh queue workers.
+    std::atomic<int> myNbPending;
+
+    //! Guards waiting for mesh queue workers.
+    std::mutex myMutex;
+
+    //! Notifies about files processed by mesh queue workers.
+    std::condition_variable myTaskDone;
+
+    //! Set if some file was failed to write.
+    std::atomic<bool> myHasFailed;
+
   };
 }
 
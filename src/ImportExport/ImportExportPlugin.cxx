@@ -15,7 +15,11 @@
 #include <OSD_File.hxx>
 #include <OSD_Path.hxx>
 
+#include <BRepTools.hxx>
+#include <TopoDS_Iterator.hxx>
+
 #include <Draw.hxx>
+#include <DBRep.hxx>
 #include <ViewerTest.hxx>
 
 #include <V3d_View.hxx>
@@ -26,9 +30,23 @@
 #include <Quantity_Parameter.hxx>
 
 #include <set>
+#include <algorithm>
+#include <sstream>
 
 #include <Utils.hxx>
 #include <AisMesh.hxx>
+#include <GltfIO.hxx>
+#include <StepIO.hxx>
+#include <ImportCache.hxx>
+#include <Convergence.hxx>
+#include <Checkpoint.hxx>
+#include <AovBuffers.hxx>
+#include <Denoiser.hxx>
+#include <ShapeIO.hxx>
+#include <MeshQueue.hxx>
+#include <MeshPlanner.hxx>
+#include <MeshRefiner.hxx>
+#include <ShapeMesher.hxx>
 #include <DataContext.hxx>
 
 // Returns AIS context.
@@ -370,7 +388,7 @@ static int RTDisplay (Draw_Interpretor& /*theDI*/, int theNbArgs, const char** t
     {
       if (theType == Usage)
       {
-        std::cout << "Usage: rtdisplay <node name>" << "\n";
+        std::cout << "Usage: rtdisplay <node name> [-progressive|-pr]" << "\n";
       }
       else if (theType == NoObject)
       {
@@ -381,11 +399,29 @@ static int RTDisplay (Draw_Interpretor& /*theDI*/, int theNbArgs, const char** t
     }
   };
 
-  if (theNbArgs != 2)
+  if (theNbArgs < 2 || theNbArgs > 3)
   {
     return Error::print (Error::Usage);
   }
 
+  bool toProgressive = false;
+
+  if (theNbArgs == 3)
+  {
+    TCollection_AsciiString aFlag (theArgs[2]);
+
+    aFlag.LowerCase ();
+
+    if (aFlag == "-progressive" || aFlag == "-pr")
+    {
+      toProgressive = true;
+    }
+    else
+    {
+      return Error::print (Error::Usage);
+    }
+  }
+
   model::DataModel* aModel = model::DataModel::GetDefault ();
 
   if (aModel == NULL)
@@ -400,6 +436,26 @@ static int RTDisplay (Draw_Interpretor& /*theDI*/, int theNbArgs, const char** t
     return Error::print (Error::NoObject, aNodeName);
   }
 
+  if (toProgressive)
+  {
+    struct ShapeQueue : public model::DataNode::NodeProcessor
+    {
+      virtual void operator() (const Handle (AIS_InteractiveObject)& theObject)
+      {
+        Handle (AIS_Shape) aShape = Handle (AIS_Shape)::DownCast (theObject);
+
+        if (!aShape.IsNull ())
+        {
+          ie::MeshQueue::GetInstance ()->Display (aShape); // instances sharing geometry are meshed once
+        }
+      }
+    };
+
+    ShapeQueue aQueue;
+
+    aModel->Get (aNodeName)->Traverse (aQueue);
+  }
+
   aModel->Get (aNodeName)->Show ();
 
   return 0;
@@ -601,6 +657,61 @@ static int RTGroup (Draw_Interpretor& /*theDI*/, int theNbArgs, const char** the
   return 0;
 }
 
+//===========================================================================
+//function : setNodeTexture
+//purpose  : Applies texture map (new or current one) to the given node
+//===========================================================================
+static void setNodeTexture (model::DataNode*              theNode,
+                            Handle (Graphic3d_TextureMap) theNewMap,
+                            const double                  theScaleS,
+                            const double                  theScaleT,
+                            const bool                    toEnableMap)
+{
+  double aScaleS = theScaleS > 0.0 ? theScaleS : 1.0;
+  double aScaleT = theScaleT > 0.0 ? theScaleT : 1.0;
+
+  if (theScaleS <= 0.0 && theScaleT <= 0.0)
+  {
+    model::GetTextureScale (theNode->Object (), aScaleS, aScaleT); // keep current UV scale
+  }
+
+  if (!theNewMap.IsNull () || theScaleS > 0.0 || theScaleT > 0.0)
+  {
+    if (theNewMap.IsNull ()) // save current texture
+    {
+      theNewMap = model::GetAspect (theNode->Object ())->TextureMap ();
+    }
+
+    // Generate UV parametrization for shape node.
+    // Graphic aspect is copied to the new object.
+    theNode->Parameterize (static_cast<float> (aScaleS),
+                           static_cast<float> (aScaleT));
+  }
+
+  Handle (Graphic3d_AspectFillArea3d) aGraphicAspect = model::GetAspect (theNode->Object ());
+
+  if (!theNewMap.IsNull ())
+  {
+    // Here we need to RESTORE current or APPLY
+    // new texture map since it was replaced by
+    // default OCCT texture
+    aGraphicAspect->SetTextureMap (theNewMap);
+
+    // UV scale of restored map is applied as texture transformation
+    // (new instance of the map is created if the scale is changed)
+    model::SetTextureScale (theNode->Object (), aScaleS, aScaleT);
+  }
+
+  if (toEnableMap)
+  {
+    aGraphicAspect->SetTextureMapOn ();
+  }
+  else
+  {
+    aGraphicAspect->SetTextureMapOff ();
+  }
+}
+
 //===========================================================================
 //function : RTTexture
 //purpose  :
@@ -714,39 +825,216 @@ static int RTTexture (Draw_Interpretor& /*theDI*/, int theNbArgs, const char** t
     }
   }
 
-  if (!aNewMap.IsNull () || aScaleS > 0.0 || aScaleT > 0.0)
+  setNodeTexture (aNode, aNewMap, aScaleS, aScaleT, toEnableMap);
+
+  TheAISContext ()->Update (aNode->Object (), Standard_True);
+
+  return 0;
+}
+
+//===========================================================================
+//function : RTMaterial
+//purpose  : Applies complete material (BSDF and texture) in a single call
+//===========================================================================
+static int RTMaterial (Draw_Interpretor& /*theDI*/, int theNbArgs, const char** theArgs)
+{
+  struct Error
   {
-    if (aNewMap.IsNull ()) // save current texture
+    enum Type
+    {
+      Usage = 0, NoObject = 1, WrongNode = 2, NoImageFile = 3, WrongBSDF = 4, WrongMaterial = 5
+    };
+
+    static int print (const Type theType, TCollection_AsciiString theInfo = "")
     {
-      aNewMap = model::GetAspect (aNode->Object ())->TextureMap ();
+      if (theType == Usage)
+      {
+        std::cout << "Usage: rtmaterial <node name(s)> <BSDF> [-material <name>] [-texture <file name>] [-scale <S> <T>] [-noupdate]" << "\n";
+      }
+      else if (theType == NoObject)
+      {
+        std::cout << "Error: Node with the name \'" << theInfo << "\' does not exist" << "\n";
+      }
+      else if (theType == WrongNode)
+      {
+        std::cout << "Error: Material can be applied to simple node only (non-inner)" << "\n";
+      }
+      else if (theType == NoImageFile)
+      {
+        std::cout << "Error: Failed to find image file at the path \'" << theInfo << "\'" << "\n";
+      }
+      else if (theType == WrongBSDF)
+      {
+        std::cout << "Error: Failed to parse BSDF string \'" << theInfo << "\'" << "\n";
+      }
+      else if (theType == WrongMaterial)
+      {
+        std::cout << "Error: Unknown material \'" << theInfo << "\'" << "\n";
+      }
+
+      return 1; // TCL_ERROR
     }
+  };
 
-    // Generate UV parametrization for shape node.
-    // Graphic aspect is copied to the new object.
-    aNode->Parameterize (aScaleS > 0.0 ? static_cast<float> (aScaleS) : 1.f,
-                         aScaleT > 0.0 ? static_cast<float> (aScaleT) : 1.f);
+  if (theNbArgs < 3)
+  {
+    return Error::print (Error::Usage);
   }
 
-  Handle (Graphic3d_AspectFillArea3d) aGraphicAspect = model::GetAspect (aNode->Object ());
+  model::DataModel* aModel = model::DataModel::GetDefault ();
 
-  if (!aNewMap.IsNull ())
+  if (aModel == NULL)
   {
-    // Here we need to RESTORE current or APPLY
-    // new texture map since it was replaced by
-    // default OCCT texture
-    aGraphicAspect->SetTextureMap (aNewMap);
+    Standard_ASSERT_INVOKE ("Error! Failed to get default data model");
   }
 
-  if (toEnableMap)
+  // Collect target nodes (single name or TCL list of names)
+  std::vector<model::DataNode*> aNodes;
+
   {
-    aGraphicAspect->SetTextureMapOn ();
+    std::istringstream aNameStream (theArgs[1]);
+
+    std::string aNodeName;
+
+    while (aNameStream >> aNodeName)
+    {
+      if (!aModel->Has (aNodeName.c_str ()))
+      {
+        return Error::print (Error::NoObject, aNodeName.c_str ());
+      }
+
+      model::DataNode* aNode = aModel->Get (aNodeName.c_str ()).get ();
+
+      if (aNode->Object ().IsNull ())
+      {
+        return Error::print (Error::WrongNode);
+      }
+
+      aNodes.push_back (aNode);
+    }
   }
-  else
+
+  if (aNodes.empty ())
   {
-    aGraphicAspect->SetTextureMapOff ();
+    return Error::print (Error::Usage);
   }
 
-  TheAISContext ()->Update (aNode->Object (), Standard_True);
+  Graphic3d_BSDF aBSDF;
+
+  if (!model::DeserializeBSDF (theArgs[2], aBSDF))
+  {
+    return Error::print (Error::WrongBSDF, theArgs[2]);
+  }
+
+  Handle (Graphic3d_TextureMap) aNewMap = NULL;
+
+  double aScaleS = -1.0;
+  double aScaleT = -1.0;
+
+  bool toUseMaterial = false;
+  bool toUpdateViewer = true;
+
+  Graphic3d_NameOfMaterial aMaterialName = Graphic3d_NOM_DEFAULT;
+
+  for (int anArgIdx = 3; anArgIdx < theNbArgs; ++anArgIdx)
+  {
+    TCollection_AsciiString aFlag (theArgs[anArgIdx]);
+
+    aFlag.LowerCase (); // convert string to lower case
+
+    if (aFlag == "-material")
+    {
+      if (++anArgIdx == theNbArgs)
+      {
+        return Error::print (Error::Usage);
+      }
+
+      TCollection_AsciiString aName (theArgs[anArgIdx]);
+
+      aName.LowerCase ();
+
+      for (int aMatIndex = 1; aMatIndex <= Graphic3d_MaterialAspect::NumberOfMaterials () && !toUseMaterial; ++aMatIndex)
+      {
+        TCollection_AsciiString aCurrentName (Graphic3d_MaterialAspect::MaterialName (aMatIndex));
+
+        aCurrentName.LowerCase ();
+
+        if (aCurrentName == aName)
+        {
+          aMaterialName = static_cast<Graphic3d_NameOfMaterial> (aMatIndex - 1);
+
+          toUseMaterial = true;
+        }
+      }
+
+      if (!toUseMaterial)
+      {
+        return Error::print (Error::WrongMaterial, theArgs[anArgIdx]);
+      }
+    }
+    else if (aFlag == "-texture")
+    {
+      if (++anArgIdx == theNbArgs)
+      {
+        return Error::print (Error::Usage);
+      }
+
+      const TCollection_AsciiString aFileName = theArgs[anArgIdx];
+
+      if (!OSD_File (aFileName).Exists ())
+      {
+        return Error::print (Error::NoImageFile, aFileName);
+      }
+
+      // request texture map from data model texture manager
+      aNewMap = aModel->Manager ()->PickTexture (aFileName);
+    }
+    else if (aFlag == "-scale")
+    {
+      if (anArgIdx + 2 >= theNbArgs
+       || !TCollection_AsciiString (theArgs[anArgIdx + 1]).IsRealValue ()
+       || !TCollection_AsciiString (theArgs[anArgIdx + 2]).IsRealValue ())
+      {
+        return Error::print (Error::Usage);
+      }
+
+      aScaleS = TCollection_AsciiString (theArgs[++anArgIdx]).RealValue ();
+      aScaleT = TCollection_AsciiString (theArgs[++anArgIdx]).RealValue ();
+    }
+    else if (aFlag == "-noupdate")
+    {
+      toUpdateViewer = false;
+    }
+    else
+    {
+      return Error::print (Error::Usage);
+    }
+  }
+
+  for (size_t aNodeIdx = 0; aNodeIdx < aNodes.size (); ++aNodeIdx)
+  {
+    model::DataNode* aNode = aNodes[aNodeIdx];
+
+    if (!aNewMap.IsNull () || aScaleS > 0.0 || aScaleT > 0.0)
+    {
+      // Texture is applied first, since it may replace AIS object
+      setNodeTexture (aNode, aNewMap, aScaleS, aScaleT, true);
+    }
+
+    Graphic3d_MaterialAspect aMaterial = toUseMaterial ? Graphic3d_MaterialAspect (aMaterialName)
+                                                       : model::GetAspect (aNode->Object ())->FrontMaterial ();
+
+    aMaterial.SetBSDF (aBSDF);
+
+    model::SetMaterial (aNode->Object (), aMaterial);
+
+    TheAISContext ()->Update (aNode->Object (), Standard_False);
+  }
+
+  if (toUpdateViewer)
+  {
+    TheAISContext ()->UpdateCurrentViewer ();
+  }
 
   return 0;
 }
@@ -966,31 +1254,1475 @@ static int RTRotate (Draw_Interpretor& /*theDI*/, int theNbArgs, const char** th
   return 0;
 }
 
-//=======================================================================
-//function : Commands
-//purpose  : 
-//=======================================================================
-void ImportExport_Plugin::Commands (Draw_Interpretor& theCommands)
+//===========================================================================
+//function : RTRestore
+//purpose  : Restores shape (with stored triangulation) from binary or ASCII BREP file
+//===========================================================================
+static int RTRestore (Draw_Interpretor& /*theDI*/, int theNbArgs, const char** theArgs)
 {
-  const char* aGroupIE = "Commands for import mesh files";
+  struct Error
+  {
+    enum Type
+    {
+      Usage = 0, NoFile = 1, BadFile = 2
+    };
 
-  theCommands.Add ("rtmeshread", "rtmeshread <file name> <node name> [-rename|-rn] [-group|-gr] [-pretrans|-pt] [-gensmooth|-gs] [-fixnorms|-fn] [-genuv|-uv] [-up X|Y|Z|-X|-Y|-Z]", __FILE__, RTMeshRead, aGroupIE);
+    static int print (const Type theType, TCollection_AsciiString theInfo = "")
+    {
+      if (theType == Usage)
+      {
+        std::cout << "Usage: rtrestore <file name> <shape name> [-nomesh]" << "\n";
+      }
+      else if (theType == NoFile)
+      {
+        std::cout << "Error: Failed to find file at the path \'" << theInfo << "\'" << "\n";
+      }
+      else if (theType == BadFile)
+      {
+        std::cout << "Error: Failed to read shape from file \'" << theInfo << "\'" << "\n";
+      }
 
-  const char* aGroupDM = "Commands for management data models";
+      return 1; // TCL_ERROR
+    }
+  };
 
-  theCommands.Add ("rtmodel", "rtmodel [-print <model>] [-sync <model>] [-textures <model>] [-all]", __FILE__, RTModel, aGroupDM);
+  if (theNbArgs < 3 || theNbArgs > 4)
+  {
+    return Error::print (Error::Usage);
+  }
 
-  theCommands.Add ("rtdisplay", "rtdisplay <node name>", __FILE__, RTDisplay, aGroupDM);
+  bool toDropMesh = false;
 
-  theCommands.Add ("rterase", "rterase <node name>", __FILE__, RTErase, aGroupDM);
+  if (theNbArgs == 4)
+  {
+    TCollection_AsciiString aFlag (theArgs[3]);
 
-  theCommands.Add ("rttexture", "rttexture <node name> <file name> [-scale <S> <T>] [-on|-off]", __FILE__, RTTexture, aGroupDM);
+    aFlag.LowerCase (); // convert string to lower case
 
-  theCommands.Add ("rtlight", "rtlight <index> -color <R G B>", __FILE__, RTLight, aGroupDM);
+    if (aFlag != "-nomesh")
+    {
+      return Error::print (Error::Usage);
+    }
 
-  theCommands.Add ("rtrotate", "rtrotate <node name> <dx dy dz> <angle>", __FILE__, RTRotate, aGroupDM);
+    toDropMesh = true;
+  }
 
-  theCommands.Add ("rtgroup", "rtgroup <group name> <node name 1> ... <node name N>", __FILE__, RTGroup, aGroupDM);
+  const TCollection_AsciiString aFileName = theArgs[1];
+
+  if (!OSD_File (aFileName).Exists ())
+  {
+    return Error::print (Error::NoFile, aFileName);
+  }
+
+  TopoDS_Shape aShape;
+
+  if (!ie::ShapeIO::Read (aFileName, aShape))
+  {
+    return Error::print (Error::BadFile, aFileName);
+  }
+
+  if (toDropMesh) // force re-meshing on display (e.g. to measure its cost)
+  {
+    BRepTools::Clean (aShape);
+  }
+
+  DBRep::Set (theArgs[2], aShape);
+
+  return 0;
+}
+
+//===========================================================================
+//function : RTMesh
+//purpose  : Tessellates shape in parallel mode before display
+//===========================================================================
+static int RTMesh (Draw_Interpretor& /*theDI*/, int theNbArgs, const char** theArgs)
+{
+  struct Error
+  {
+    enum Type
+    {
+      Usage = 0, NoShape = 1, NoViewer = 2
+    };
+
+    static int print (const Type theType, TCollection_AsciiString theInfo = "")
+    {
+      if (theType == Usage)
+      {
+        std::cout << "Usage: rtmesh <shape name> [-absDefl <value>|-devCoeff <value>] [-angDefl <degrees>]" << "\n";
+      }
+      else if (theType == NoShape)
+      {
+        std::cout << "Error: Shape with the name \'" << theInfo << "\' does not exist" << "\n";
+      }
+      else if (theType == NoViewer)
+      {
+        std::cout << "Error: No active viewer" << "\n";
+      }
+
+      return 1; // TCL_ERROR
+    }
+  };
+
+  if (theNbArgs < 2)
+  {
+    return Error::print (Error::Usage);
+  }
+
+  const TopoDS_Shape aShape = DBRep::Get (theArgs[1]);
+
+  if (aShape.IsNull ())
+  {
+    return Error::print (Error::NoShape, theArgs[1]);
+  }
+
+  Handle (AIS_InteractiveContext) aContext = ViewerTest::GetAISContext ();
+
+  if (aContext.IsNull ())
+  {
+    return Error::print (Error::NoViewer);
+  }
+
+  Aspect_TypeOfDeflection aType = Aspect_TOD_RELATIVE;
+
+  double aLinDefl = -1.0;
+  double anAngDefl = -1.0;
+
+  for (int anArgIdx = 2; anArgIdx < theNbArgs; ++anArgIdx)
+  {
+    TCollection_AsciiString aFlag (theArgs[anArgIdx]);
+
+    aFlag.LowerCase (); // convert string to lower case
+
+    if (aFlag != "-absdefl" && aFlag != "-devcoeff" && aFlag != "-angdefl")
+    {
+      return Error::print (Error::Usage);
+    }
+
+    ++anArgIdx;
+
+    if (theNbArgs == anArgIdx || !TCollection_AsciiString (theArgs[anArgIdx]).IsRealValue ())
+    {
+      return Error::print (Error::Usage);
+    }
+
+    const double aValue = TCollection_AsciiString (theArgs[anArgIdx]).RealValue ();
+
+    if (aFlag == "-angdefl")
+    {
+      anAngDefl = aValue * M_PI / 180.0;
+    }
+    else
+    {
+      aType = aFlag == "-absdefl" ? Aspect_TOD_ABSOLUTE : Aspect_TOD_RELATIVE;
+
+      aLinDefl = aValue;
+    }
+  }
+
+  Handle (Prs3d_Drawer) aDrawer = aContext->DefaultDrawer ();
+
+  Handle (AIS_Shape) anObject;
+
+  // Parameters are set to the object (created here if it was not displayed yet),
+  // so it is displayed with the same triangulation later (e.g. restored one)
+  if (aLinDefl > 0.0 || anAngDefl > 0.0)
+  {
+    anObject = Handle (AIS_Shape)::DownCast (model::DataContext::BoundObject (theArgs[1]));
+
+    if (anObject.IsNull () || !anObject->Shape ().IsEqual (aShape))
+    {
+      Handle (AIS_InteractiveObject) anOldObject = model::DataContext::BoundObject (theArgs[1]);
+
+      if (!anOldObject.IsNull ())
+      {
+        aContext->Remove (anOldObject, Standard_False);
+
+        model::DataContext::UnbindObject (theArgs[1]);
+      }
+
+      anObject = new AIS_Shape (aShape);
+
+      model::DataContext::RebindObject (theArgs[1], anObject);
+    }
+
+    aDrawer = anObject->Attributes ();
+
+    if (aLinDefl > 0.0)
+    {
+      aDrawer->SetTypeOfDeflection (aType);
+
+      if (aType == Aspect_TOD_ABSOLUTE)
+      {
+        aDrawer->SetMaximalChordialDeviation (aLinDefl);
+      }
+      else
+      {
+        aDrawer->SetDeviationCoefficient (aLinDefl);
+      }
+    }
+
+    if (anAngDefl > 0.0)
+    {
+      aDrawer->SetDeviationAngle (anAngDefl);
+    }
+  }
+
+  ie::ShapeMesher aMesher (aShape, aDrawer);
+
+  aMesher.Perform ();
+
+  if (!anObject.IsNull () && aContext->IsDisplayed (anObject))
+  {
+    aContext->Redisplay (anObject, Standard_False);
+  }
+
+  std::cout << "Tessellated " << aMesher.NbFaces () << " faces (" << aMesher.NbTriangles () << " triangles) in "
+            << aMesher.ElapsedTime () << " sec, deflection " << aMesher.LinearDeflection () << "\n";
+
+  return 0;
+}
+
+//===========================================================================
+//function : RTProgressive
+//purpose  : Displays shapes as bounding boxes and meshes them in background
+//===========================================================================
+static int RTProgressive (Draw_Interpretor& /*theDI*/, int theNbArgs, const char** theArgs)
+{
+  struct Error
+  {
+    enum Type
+    {
+      Usage = 0, NoShape = 1, NoViewer = 2
+    };
+
+    static int print (const Type theType, TCollection_AsciiString theInfo = "")
+    {
+      if (theType == Usage)
+      {
+        std::cout << "Usage: rtprogressive <shape name 1> ... <shape name N> [-explode|-ex] [-noupdate]" << "\n";
+      }
+      else if (theType == NoShape)
+      {
+        std::cout << "Error: Shape with the name \'" << theInfo << "\' does not exist" << "\n";
+      }
+      else if (theType == NoViewer)
+      {
+        std::cout << "Error: No active viewer" << "\n";
+      }
+
+      return 1; // TCL_ERROR
+    }
+  };
+
+  Handle (AIS_InteractiveContext) aContext = ViewerTest::GetAISContext ();
+
+  if (aContext.IsNull ())
+  {
+    return Error::print (Error::NoViewer);
+  }
+
+  std::vector<TCollection_AsciiString> aNames;
+
+  bool toExplode = false;
+  bool toUpdate  = true;
+
+  for (int anArgIdx = 1; anArgIdx < theNbArgs; ++anArgIdx)
+  {
+    TCollection_AsciiString aFlag (theArgs[anArgIdx]);
+
+    aFlag.LowerCase (); // convert string to lower case
+
+    if (aFlag == "-explode" || aFlag == "-ex")
+    {
+      toExplode = true;
+    }
+    else if (aFlag == "-noupdate")
+    {
+      toUpdate = false;
+    }
+    else if (aFlag.Value (1) == '-')
+    {
+      return Error::print (Error::Usage);
+    }
+    else
+    {
+      aNames.push_back (theArgs[anArgIdx]);
+    }
+  }
+
+  if (aNames.empty ())
+  {
+    return Error::print (Error::Usage);
+  }
+
+  model::DataModel* aModel = model::DataModel::GetDefault ();
+
+  if (aModel == NULL)
+  {
+    Standard_ASSERT_INVOKE ("Error! Failed to get default data model");
+  }
+
+  struct ShapeQueue : public model::DataNode::NodeProcessor
+  {
+    virtual void operator() (const Handle (AIS_InteractiveObject)& theObject)
+    {
+      Handle (AIS_Shape) aShape = Handle (AIS_Shape)::DownCast (theObject);
+
+      if (!aShape.IsNull ())
+      {
+        ie::MeshQueue::GetInstance ()->Display (aShape);
+      }
+    }
+  };
+
+  ShapeQueue aQueue;
+
+  for (size_t aNameID = 0; aNameID < aNames.size (); ++aNameID)
+  {
+    const TopoDS_Shape aShape = DBRep::Get (aNames[aNameID].ToCString ());
+
+    if (aShape.IsNull ())
+    {
+      return Error::print (Error::NoShape, aNames[aNameID]);
+    }
+
+    const TCollection_AsciiString& aName = aNames[aNameID];
+
+    Handle (AIS_Shape) anObject = Handle (AIS_Shape)::DownCast (model::DataContext::BoundObject (aName));
+
+    if (anObject.IsNull () || !anObject->Shape ().IsEqual (aShape))
+    {
+      Handle (AIS_InteractiveObject) anOldObject = model::DataContext::BoundObject (aName);
+
+      if (!anOldObject.IsNull ())
+      {
+        aContext->Remove (anOldObject, Standard_False);
+
+        model::DataContext::UnbindObject (aName);
+      }
+
+      anObject = new AIS_Shape (aShape);
+
+      model::DataContext::RebindObject (aName, anObject);
+    }
+
+    aModel->SynchronizeWithDraw ();
+
+    const model::DataNodePtr& aNode = aModel->Get (aName);
+
+    if (aNode == NULL)
+    {
+      Standard_ASSERT_INVOKE ("Error! Failed to create data node");
+    }
+
+    // Each part becomes a child node with its own object, so parts are meshed in order of their sizes
+    if (toExplode && aShape.ShapeType () == TopAbs_COMPOUND && !aNode->Object ().IsNull ())
+    {
+      aNode->Explode ();
+    }
+
+    aNode->Traverse (aQueue);
+  }
+
+  if (toUpdate)
+  {
+    aContext->UpdateCurrentViewer ();
+  }
+
+  return 0;
+}
+
+//===========================================================================
+//function : RTRefine
+//purpose  : Controls view-dependent tessellation of CAD shapes
+//===========================================================================
+static int RTRefine (Draw_Interpretor& /*theDI*/, int theNbArgs, const char** theArgs)
+{
+  struct Error
+  {
+    enum Type
+    {
+      Usage = 0
+    };
+
+    static int print (const Type theType)
+    {
+      if (theType == Usage)
+      {
+        std::cout << "Usage: rtrefine [-on|-off] [-budget <triangles>] [-tolerance <pixels>]" << "\n";
+      }
+
+      return 1; // TCL_ERROR
+    }
+  };
+
+  ie::MeshRefiner* aRefiner = ie::MeshRefiner::GetInstance ();
+
+  for (int anArgIdx = 1; anArgIdx < theNbArgs; ++anArgIdx)
+  {
+    TCollection_AsciiString aFlag (theArgs[anArgIdx]);
+
+    aFlag.LowerCase (); // convert string to lower case
+
+    if (aFlag == "-on" || aFlag == "-off")
+    {
+      aRefiner->SetEnabled (aFlag == "-on");
+    }
+    else if (aFlag == "-budget")
+    {
+      ++anArgIdx;
+
+      if (theNbArgs == anArgIdx || !TCollection_AsciiString (theArgs[anArgIdx]).IsIntegerValue ())
+      {
+        return Error::print (Error::Usage);
+      }
+
+      aRefiner->SetBudget (std::max (1, TCollection_AsciiString (theArgs[anArgIdx]).IntegerValue ()));
+    }
+    else if (aFlag == "-tolerance")
+    {
+      ++anArgIdx;
+
+      if (theNbArgs == anArgIdx || !TCollection_AsciiString (theArgs[anArgIdx]).IsRealValue ())
+      {
+        return Error::print (Error::Usage);
+      }
+
+      aRefiner->SetTolerance (std::max (0.1f, static_cast<float> (TCollection_AsciiString (theArgs[anArgIdx]).RealValue ())));
+    }
+    else
+    {
+      return Error::print (Error::Usage);
+    }
+  }
+
+  std::cout << "View-dependent refinement: " << (aRefiner->IsEnabled () ? "on" : "off") << "\n"
+            << "Triangle budget: " << aRefiner->Budget () << "\n"
+            << "Tolerance (pixels): " << aRefiner->Tolerance () << "\n"
+            << "Triangles in use: " << aRefiner->NbTriangles () << "\n"
+            << "Pending jobs: " << aRefiner->NbJobs () << "\n";
+
+  return 0;
+}
+
+//===========================================================================
+//function : RTMeshBudget
+//purpose  : Distributes triangle budget over CAD shapes of data model
+//===========================================================================
+static int RTMeshBudget (Draw_Interpretor& theDI, int theNbArgs, const char** theArgs)
+{
+  struct Error
+  {
+    enum Type
+    {
+      Usage = 0, NoViewer = 1
+    };
+
+    static int print (const Type theType)
+    {
+      if (theType == Usage)
+      {
+        std::cout << "Usage: rtmeshbudget <number of triangles> [-noupdate]" << "\n";
+      }
+      else if (theType == NoViewer)
+      {
+        std::cout << "Error: No active viewer" << "\n";
+      }
+
+      return 1; // TCL_ERROR
+    }
+  };
+
+  if (theNbArgs < 2 || theNbArgs > 3 || !TCollection_AsciiString (theArgs[1]).IsIntegerValue ())
+  {
+    return Error::print (Error::Usage);
+  }
+
+  bool toUpdate = true;
+
+  if (theNbArgs == 3)
+  {
+    TCollection_AsciiString aFlag (theArgs[2]);
+
+    aFlag.LowerCase (); // convert string to lower case
+
+    if (aFlag != "-noupdate")
+    {
+      return Error::print (Error::Usage);
+    }
+
+    toUpdate = false;
+  }
+
+  Handle (AIS_InteractiveContext) aContext = ViewerTest::GetAISContext ();
+
+  if (aContext.IsNull ())
+  {
+    return Error::print (Error::NoViewer);
+  }
+
+  model::DataModel* aModel = model::DataModel::GetDefault ();
+
+  if (aModel == NULL)
+  {
+    Standard_ASSERT_INVOKE ("Error! Failed to get default data model");
+  }
+
+  if (ie::MeshRefiner::GetInstance ()->IsEnabled ())
+  {
+    std::cout << "Warning: View-dependent refinement is disabled to keep planned deflections" << "\n";
+
+    ie::MeshRefiner::GetInstance ()->SetEnabled (false);
+  }
+
+  const int aNbTriangles = std::max (1, TCollection_AsciiString (theArgs[1]).IntegerValue ());
+
+  ie::MeshPlanner aPlanner (aModel);
+
+  aPlanner.Analyze ();
+
+  aPlanner.Plan (aNbTriangles);
+
+  aPlanner.Perform ();
+
+  if (toUpdate)
+  {
+    aContext->UpdateCurrentViewer ();
+  }
+
+  // Result is returned as key-value list to be used in scripts
+  theDI << "triangles "  << aPlanner.NbTriangles ()
+        << " estimated "  << static_cast<int> (aPlanner.NbEstimated ())
+        << " deflection " << aPlanner.MeanDeflection ()
+        << " shapes "     << aPlanner.NbShapes ()
+        << " time "       << aPlanner.ElapsedTime ()
+        << " memory "     << static_cast<double> (aPlanner.MemorySize ()) / (1024.0 * 1024.0);
+
+  return 0;
+}
+
+//===========================================================================
+//function : RTInstance
+//purpose  : Creates located instance of shape (sharing its TShape)
+//===========================================================================
+static int RTInstance (Draw_Interpretor& /*theDI*/, int theNbArgs, const char** theArgs)
+{
+  struct Error
+  {
+    enum Type
+    {
+      Usage = 0, NoShape = 1
+    };
+
+    static int print (const Type theType, TCollection_AsciiString theInfo = "")
+    {
+      if (theType == Usage)
+      {
+        std::cout << "Usage: rtinstance <name> <base shape> [-orient F|R|I|E] [-location <a11 a12 a13 a14 a21 ... a34>]" << "\n";
+      }
+      else if (theType == NoShape)
+      {
+        std::cout << "Error: Shape with the name \'" << theInfo << "\' does not exist" << "\n";
+      }
+
+      return 1; // TCL_ERROR
+    }
+  };
+
+  if (theNbArgs < 3)
+  {
+    return Error::print (Error::Usage);
+  }
+
+  const TopoDS_Shape aBase = DBRep::Get (theArgs[2]);
+
+  if (aBase.IsNull ())
+  {
+    return Error::print (Error::NoShape, theArgs[2]);
+  }
+
+  TopAbs_Orientation anOrient = aBase.Orientation ();
+
+  TopLoc_Location aLocation;
+
+  for (int anArgIdx = 3; anArgIdx < theNbArgs; ++anArgIdx)
+  {
+    TCollection_AsciiString aFlag (theArgs[anArgIdx]);
+
+    aFlag.LowerCase (); // convert string to lower case
+
+    if (aFlag == "-orient")
+    {
+      if (theNbArgs == ++anArgIdx)
+      {
+        return Error::print (Error::Usage);
+      }
+
+      switch (theArgs[anArgIdx][0])
+      {
+        case 'F': anOrient = TopAbs_FORWARD;  break;
+        case 'R': anOrient = TopAbs_REVERSED; break;
+        case 'I': anOrient = TopAbs_INTERNAL; break;
+        case 'E': anOrient = TopAbs_EXTERNAL; break;
+
+        default:
+          return Error::print (Error::Usage);
+      }
+    }
+    else if (aFlag == "-location")
+    {
+      double aValues[12];
+
+      for (int aValueID = 0; aValueID < 12; ++aValueID)
+      {
+        if (theNbArgs == ++anArgIdx || !TCollection_AsciiString (theArgs[anArgIdx]).IsRealValue ())
+        {
+          return Error::print (Error::Usage);
+        }
+
+        aValues[aValueID] = TCollection_AsciiString (theArgs[anArgIdx]).RealValue ();
+      }
+
+      gp_Trsf aTrsf;
+
+      aTrsf.SetValues (aValues[0], aValues[1], aValues[2],  aValues[3],
+                       aValues[4], aValues[5], aValues[6],  aValues[7],
+                       aValues[8], aValues[9], aValues[10], aValues[11]);
+
+      aLocation = TopLoc_Location (aTrsf);
+    }
+    else
+    {
+      return Error::print (Error::Usage);
+    }
+  }
+
+  DBRep::Set (theArgs[1], aBase.Located (aLocation).Oriented (anOrient));
+
+  return 0;
+}
+
+//===========================================================================
+//function : RTGltfWrite
+//purpose  : Exports data nodes to binary glTF 2.0 file
+//===========================================================================
+static int RTGltfWrite (Draw_Interpretor& /*theDI*/, int theNbArgs, const char** theArgs)
+{
+  struct Error
+  {
+    enum Type
+    {
+      Usage = 0, NoObject = 1, Failed = 2
+    };
+
+    static int print (const Type theType, TCollection_AsciiString theInfo = "")
+    {
+      if (theType == Usage)
+      {
+        std::cout << "Usage: rtgltfwrite <file name> [<node name 1> ... <node name N>]" << "\n";
+      }
+      else if (theType == NoObject)
+      {
+        std::cout << "Error: Node with the name \'" << theInfo << "\' does not exist" << "\n";
+      }
+      else if (theType == Failed)
+      {
+        std::cout << "Error: Failed to write GLB file \'" << theInfo << "\'" << "\n";
+      }
+
+      return 1; // TCL_ERROR
+    }
+  };
+
+  if (theNbArgs < 2)
+  {
+    return Error::print (Error::Usage);
+  }
+
+  model::DataModel* aModel = model::DataModel::GetDefault ();
+
+  if (aModel == NULL)
+  {
+    Standard_ASSERT_INVOKE ("Error! Failed to get default data model");
+  }
+
+  std::vector<model::DataNode*> aNodes;
+
+  for (int anArgIdx = 2; anArgIdx < theNbArgs; ++anArgIdx)
+  {
+    const model::DataNodePtr& aNode = aModel->Get (theArgs[anArgIdx]);
+
+    if (aNode == NULL)
+    {
+      return Error::print (Error::NoObject, theArgs[anArgIdx]);
+    }
+
+    aNodes.push_back (aNode.get ());
+  }
+
+  if (aNodes.empty ()) // export the whole model
+  {
+    for (size_t aNodeIdx = 0; aNodeIdx < aModel->Shapes ().size (); ++aNodeIdx)
+    {
+      aNodes.push_back (aModel->Shapes ()[aNodeIdx].get ());
+    }
+
+    for (size_t aNodeIdx = 0; aNodeIdx < aModel->Meshes ().size (); ++aNodeIdx)
+    {
+      aNodes.push_back (aModel->Meshes ()[aNodeIdx].get ());
+    }
+  }
+
+  if (!ie::GltfIO::Write (theArgs[1], aNodes))
+  {
+    return Error::print (Error::Failed, theArgs[1]);
+  }
+
+  return 0;
+}
+
+//===========================================================================
+//function : RTGltfRead
+//purpose  : Imports binary glTF 2.0 file without ASSIMP
+//===========================================================================
+static int RTGltfRead (Draw_Interpretor& /*theDI*/, int theNbArgs, const char** theArgs)
+{
+  struct Error
+  {
+    enum Type
+    {
+      Usage = 0, NoFile = 1, Exists = 2, Failed = 3
+    };
+
+    static int print (const Type theType, TCollection_AsciiString theInfo = "")
+    {
+      if (theType == Usage)
+      {
+        std::cout << "Usage: rtgltfread <file name> <node name> [-rename|-rn]" << "\n";
+      }
+      else if (theType == NoFile)
+      {
+        std::cout << "Error: Failed to find file at the path \'" << theInfo << "\'" << "\n";
+      }
+      else if (theType == Exists)
+      {
+        std::cout << "Error: Mesh with the name \'" << theInfo << "\' already exists" << "\n";
+      }
+      else if (theType == Failed)
+      {
+        std::cout << "Error: Failed to import GLB file: " << theInfo << "\n";
+      }
+
+      return 1; // TCL_ERROR
+    }
+  };
+
+  if (theNbArgs < 3 || theNbArgs > 4)
+  {
+    return Error::print (Error::Usage);
+  }
+
+  model::DataModel* aModel = model::DataModel::GetDefault ();
+
+  if (aModel == NULL)
+  {
+    Standard_ASSERT_INVOKE ("Error! Failed to get default data model");
+  }
+
+  bool toCorrectName = false;
+
+  if (theNbArgs == 4)
+  {
+    const TCollection_AsciiString anArg (theArgs[3]);
+
+    if (anArg == "-rename" || anArg == "-rn")
+    {
+      toCorrectName = true;
+    }
+    else
+    {
+      return Error::print (Error::Usage);
+    }
+  }
+
+  const TCollection_AsciiString aFileName = theArgs[1];
+
+  if (!OSD_File (aFileName).Exists ())
+  {
+    return Error::print (Error::NoFile, aFileName);
+  }
+
+  TCollection_AsciiString aMeshName = theArgs[2];
+
+  if (aMeshName.IsEmpty () || !isalpha (aMeshName.Value (1)))
+  {
+    return Error::print (Error::Usage);
+  }
+
+  if (aModel->Has (aMeshName))
+  {
+    if (!toCorrectName)
+    {
+      return Error::print (Error::Exists, aMeshName);
+    }
+
+    for (int aMeshID = 1, aMaxAttempts = 1024; aMeshID < aMaxAttempts; /* none */)
+    {
+      aMeshName = TCollection_AsciiString (theArgs[2]) + "_" + TCollection_AsciiString (aMeshID);
+
+      if (!aModel->Has (aMeshName))
+      {
+        break;
+      }
+      else if (++aMeshID == aMaxAttempts)
+      {
+        return Error::print (Error::Exists, aMeshName);
+      }
+    }
+  }
+
+  model::DataNodePtr aMeshNode;
+
+  try
+  {
+    aMeshNode = ie::GltfIO::Read (aFileName, aMeshName);
+  }
+  catch (std::exception& theError)
+  {
+    return Error::print (Error::Failed, theError.what ());
+  }
+
+  aModel->Add (aMeshNode);
+
+  return 0;
+}
+
+//===========================================================================
+//function : RTStepRead
+//purpose  : Imports STEP file preserving assembly structure
+//===========================================================================
+static int RTStepRead (Draw_Interpretor& /*theDI*/, int theNbArgs, const char** theArgs)
+{
+  struct Error
+  {
+    enum Type
+    {
+      Usage = 0, NoFile = 1, Exists = 2, Failed = 3
+    };
+
+    static int print (const Type theType, TCollection_AsciiString theInfo = "")
+    {
+      if (theType == Usage)
+      {
+        std::cout << "Usage: rtstepread <file name> <node name> [-rename|-rn] [-nocache]" << "\n";
+      }
+      else if (theType == NoFile)
+      {
+        std::cout << "Error: Failed to find file at the path \'" << theInfo << "\'" << "\n";
+      }
+      else if (theType == Exists)
+      {
+        std::cout << "Error: Node with the name \'" << theInfo << "\' already exists" << "\n";
+      }
+      else if (theType == Failed)
+      {
+        std::cout << "Error: Failed to import STEP file: " << theInfo << "\n";
+      }
+
+      return 1; // TCL_ERROR
+    }
+  };
+
+  if (theNbArgs < 3 || theNbArgs > 5)
+  {
+    return Error::print (Error::Usage);
+  }
+
+  model::DataModel* aModel = model::DataModel::GetDefault ();
+
+  if (aModel == NULL)
+  {
+    Standard_ASSERT_INVOKE ("Error! Failed to get default data model");
+  }
+
+  bool toCorrectName = false;
+  bool toUseCache    = true;
+
+  for (int anArgIdx = 3; anArgIdx < theNbArgs; ++anArgIdx)
+  {
+    const TCollection_AsciiString anArg (theArgs[anArgIdx]);
+
+    if (anArg == "-rename" || anArg == "-rn")
+    {
+      toCorrectName = true;
+    }
+    else if (anArg == "-nocache")
+    {
+      toUseCache = false;
+    }
+    else
+    {
+      return Error::print (Error::Usage);
+    }
+  }
+
+  const TCollection_AsciiString aFileName = theArgs[1];
+
+  if (!OSD_File (aFileName).Exists ())
+  {
+    return Error::print (Error::NoFile, aFileName);
+  }
+
+  TCollection_AsciiString aNodeName = theArgs[2];
+
+  if (aNodeName.IsEmpty () || !isalpha (aNodeName.Value (1)))
+  {
+    return Error::print (Error::Usage);
+  }
+
+  if (aModel->Has (aNodeName))
+  {
+    if (!toCorrectName)
+    {
+      return Error::print (Error::Exists, aNodeName);
+    }
+
+    for (int aNodeID = 1, aMaxAttempts = 1024; aNodeID < aMaxAttempts; /* none */)
+    {
+      aNodeName = TCollection_AsciiString (theArgs[2]) + "_" + TCollection_AsciiString (aNodeID);
+
+      if (!aModel->Has (aNodeName))
+      {
+        break;
+      }
+      else if (++aNodeID == aMaxAttempts)
+      {
+        return Error::print (Error::Exists, aNodeName);
+      }
+    }
+  }
+
+  ie::ImportCache* aCache = ie::ImportCache::GetInstance ();
+
+  // Translation options are part of the key (reader produces names and colors)
+  const TCollection_AsciiString aKey = toUseCache && aCache->IsEnabled () ? ie::ImportCache::Key (aFileName, "step:xcaf:names:colors")
+                                                                          : TCollection_AsciiString ();
+
+  model::DataNodePtr aNode = aCache->Load (aKey, aNodeName);
+
+  if (aNode != NULL)
+  {
+    std::cout << "Info: STEP file restored from cache entry " << aKey << std::endl;
+  }
+  else
+  {
+    try
+    {
+      aNode = ie::StepIO::Read (aFileName, aNodeName);
+    }
+    catch (std::exception& theError)
+    {
+      return Error::print (Error::Failed, theError.what ());
+    }
+
+    aCache->Store (aKey, aNode.get ());
+  }
+
+  aModel->Add (aNode);
+
+  return 0;
+}
+
+//===========================================================================
+//function : RTCache
+//purpose  : Configures on-disk cache of translated CAD files
+//===========================================================================
+static int RTCache (Draw_Interpretor& /*theDI*/, int theNbArgs, const char** theArgs)
+{
+  struct Error
+  {
+    enum Type
+    {
+      Usage = 0, NoObject = 1
+    };
+
+    static int print (const Type theType, TCollection_AsciiString theInfo = "")
+    {
+      if (theType == Usage)
+      {
+        std::cout << "Usage: rtcache [-on|-off] [-dir <path>] [-size <megabytes>] [-update <node name>] [-clear]" << "\n";
+      }
+      else if (theType == NoObject)
+      {
+        std::cout << "Error: Node with the name \'" << theInfo << "\' does not exist" << "\n";
+      }
+
+      return 1; // TCL_ERROR
+    }
+  };
+
+  ie::ImportCache* aCache = ie::ImportCache::GetInstance ();
+
+  for (int anArgIdx = 1; anArgIdx < theNbArgs; ++anArgIdx)
+  {
+    TCollection_AsciiString aFlag (theArgs[anArgIdx]);
+
+    aFlag.LowerCase ();
+
+    if (aFlag == "-on" || aFlag == "-off")
+    {
+      aCache->SetEnabled (aFlag == "-on");
+    }
+    else if (aFlag == "-dir" && anArgIdx + 1 < theNbArgs)
+    {
+      aCache->SetDirectory (theArgs[++anArgIdx]);
+    }
+    else if (aFlag == "-size" && anArgIdx + 1 < theNbArgs)
+    {
+      const TCollection_AsciiString aValue (theArgs[++anArgIdx]);
+
+      if (!aValue.IsIntegerValue () || aValue.IntegerValue () < 0)
+      {
+        return Error::print (Error::Usage);
+      }
+
+      aCache->SetMaxSize (aValue.IntegerValue ());
+
+      aCache->Evict ();
+    }
+    else if (aFlag == "-update" && anArgIdx + 1 < theNbArgs)
+    {
+      model::DataModel* aModel = model::DataModel::GetDefault ();
+
+      const TCollection_AsciiString aNodeName (theArgs[++anArgIdx]);
+
+      if (aModel == NULL || !aModel->Has (aNodeName))
+      {
+        return Error::print (Error::NoObject, aNodeName);
+      }
+
+      if (aCache->Update (aModel->Get (aNodeName).get ()))
+      {
+        std::cout << "Info: Triangulation of \'" << aNodeName << "\' stored in cache" << std::endl;
+      }
+    }
+    else if (aFlag == "-clear")
+    {
+      aCache->Clear ();
+    }
+    else
+    {
+      return Error::print (Error::Usage);
+    }
+  }
+
+  std::cout << "Cache: " << (aCache->IsEnabled () ? "on" : "off")
+            << ", directory \'" << aCache->Directory () << "\'"
+            << ", size " << aCache->Size () / (1 << 20) << " of " << aCache->MaxSize () << " MB" << std::endl;
+
+  return 0;
+}
+
+//=======================================================================
+//function : RTConvergence
+//purpose  : Sets stop criteria of path tracing and returns its progress
+//=======================================================================
+static int RTConvergence (Draw_Interpretor& theDI, int theNbArgs, const char** theArgs)
+{
+  struct Error
+  {
+    enum Type
+    {
+      Usage = 0
+    };
+
+    static int print (const Type theType)
+    {
+      if (theType == Usage)
+      {
+        std::cout << "Usage: rtconvergence [-samples <count>] [-time <seconds>] [-noise <level>] [-reset]" << "\n";
+      }
+
+      return 1; // TCL_ERROR
+    }
+  };
+
+  ie::Convergence* aConvergence = ie::Convergence::GetInstance ();
+
+  for (int anArgIdx = 1; anArgIdx < theNbArgs; ++anArgIdx)
+  {
+    TCollection_AsciiString aFlag (theArgs[anArgIdx]);
+
+    aFlag.LowerCase ();
+
+    if (aFlag == "-reset")
+    {
+      aConvergence->Reset ();
+
+      continue;
+    }
+
+    if (anArgIdx + 1 >= theNbArgs)
+    {
+      return Error::print (Error::Usage);
+    }
+
+    const TCollection_AsciiString aValue (theArgs[++anArgIdx]);
+
+    if (!aValue.IsRealValue () || aValue.RealValue () < 0.0)
+    {
+      return Error::print (Error::Usage);
+    }
+
+    if (aFlag == "-samples" && aValue.IsIntegerValue ())
+    {
+      aConvergence->SetMaxSamples (aValue.IntegerValue ());
+    }
+    else if (aFlag == "-time")
+    {
+      aConvergence->SetMaxTime (aValue.RealValue ());
+    }
+    else if (aFlag == "-noise")
+    {
+      aConvergence->SetMaxNoise (aValue.RealValue ());
+    }
+    else
+    {
+      return Error::print (Error::Usage);
+    }
+  }
+
+  // Progress is returned as key-value list to be used in scripts
+  theDI << "samples "   << aConvergence->NbTotalSamples ()
+        << " time "     << aConvergence->ElapsedTime ()
+        << " noise "    << aConvergence->Noise ()
+        << " progress " << aConvergence->Progress ()
+        << " converged " << (aConvergence->IsConverged () ? 1 : 0);
+
+  return 0;
+}
+
+//=======================================================================
+//function : RTCheckpoint
+//purpose  : Configures checkpoints of progressive rendering
+//=======================================================================
+static int RTCheckpoint (Draw_Interpretor& /*theDI*/, int theNbArgs, const char** theArgs)
+{
+  struct Error
+  {
+    enum Type
+    {
+      Usage = 0, NoView = 1, NotWritten = 2
+    };
+
+    static int print (const Type theType)
+    {
+      if (theType == Usage)
+      {
+        std::cout << "Usage: rtcheckpoint [-on|-off] [-dir <path>] [-interval <seconds>] [-write] [-clear]" << "\n";
+      }
+      else if (theType == NoView)
+      {
+        std::cout << "Error: No active view" << "\n";
+      }
+      else if (theType == NotWritten)
+      {
+        std::cout << "Error: Checkpoint was not written (path tracing is off or too few samples)" << "\n";
+      }
+
+      return 1; // TCL_ERROR
+    }
+  };
+
+  ie::Checkpoint* aCheckpoint = ie::Checkpoint::GetInstance ();
+
+  for (int anArgIdx = 1; anArgIdx < theNbArgs; ++anArgIdx)
+  {
+    TCollection_AsciiString aFlag (theArgs[anArgIdx]);
+
+    aFlag.LowerCase ();
+
+    if (aFlag == "-on" || aFlag == "-off")
+    {
+      aCheckpoint->SetEnabled (aFlag == "-on");
+    }
+    else if (aFlag == "-dir" && anArgIdx + 1 < theNbArgs)
+    {
+      aCheckpoint->SetDirectory (theArgs[++anArgIdx]);
+    }
+    else if (aFlag == "-interval" && anArgIdx + 1 < theNbArgs)
+    {
+      const TCollection_AsciiString aValue (theArgs[++anArgIdx]);
+
+      if (!aValue.IsRealValue () || aValue.RealValue () <= 0.0)
+      {
+        return Error::print (Error::Usage);
+      }
+
+      aCheckpoint->SetInterval (aValue.RealValue ());
+    }
+    else if (aFlag == "-write")
+    {
+      const Handle (V3d_View)& aView = ViewerTest::CurrentView ();
+
+      if (aView.IsNull ())
+      {
+        return Error::print (Error::NoView);
+      }
+
+      if (!aCheckpoint->Write (aView))
+      {
+        return Error::print (Error::NotWritten);
+      }
+    }
+    else if (aFlag == "-clear")
+    {
+      aCheckpoint->Clear ();
+    }
+    else
+    {
+      return Error::print (Error::Usage);
+    }
+  }
+
+  std::cout << "Checkpoints: " << (aCheckpoint->IsEnabled () ? "on" : "off")
+            << ", directory \'" << aCheckpoint->Directory () << "\'"
+            << ", interval " << aCheckpoint->Interval () << " sec"
+            << ", restored samples " << aCheckpoint->NbRestoredSamples () << std::endl;
+
+  return 0;
+}
+
+//=======================================================================
+//function : RTAov
+//purpose  : Writes radiance and auxiliary buffers of the view
+//=======================================================================
+static int RTAov (Draw_Interpretor& theDI, int theNbArgs, const char** theArgs)
+{
+  struct Error
+  {
+    enum Type
+    {
+      Usage = 0, NoView = 1, NoImage = 2, NotWritten = 3
+    };
+
+    static int print (const Type theType, const char* theFileName = "")
+    {
+      if (theType == Usage)
+      {
+        std::cout << "Usage: rtaov <file name>.exr [-denoise]" << "\n";
+      }
+      else if (theType == NoView)
+      {
+        std::cout << "Error: No active view" << "\n";
+      }
+      else if (theType == NoImage)
+      {
+        std::cout << "Error: Failed to read image of the view" << "\n";
+      }
+      else if (theType == NotWritten)
+      {
+        std::cout << "Error: Failed to write file " << theFileName << "\n";
+      }
+
+      return 1; // TCL_ERROR
+    }
+  };
+
+  bool toDenoise = false;
+
+  if (theNbArgs == 3)
+  {
+    TCollection_AsciiString aFlag (theArgs[2]);
+
+    aFlag.LowerCase ();
+
+    if (aFlag != "-denoise")
+    {
+      return Error::print (Error::Usage);
+    }
+
+    toDenoise = true;
+  }
+  else if (theNbArgs != 2)
+  {
+    return Error::print (Error::Usage);
+  }
+
+  const Handle (V3d_View)& aView = ViewerTest::CurrentView ();
+
+  if (aView.IsNull ())
+  {
+    return Error::print (Error::NoView);
+  }
+
+  ie::AovBuffers aBuffers;
+
+  if (!aBuffers.Perform (aView))
+  {
+    return Error::print (Error::NoImage);
+  }
+
+  if (toDenoise)
+  {
+    ie::Denoiser::GetInstance ()->Perform (aBuffers);
+  }
+
+  if (!aBuffers.WriteExr (theArgs[1]))
+  {
+    return Error::print (Error::NotWritten, theArgs[1]);
+  }
+
+  // Mapping of object IDs is returned as key-value list to be used in scripts
+  for (size_t anIdx = 0; anIdx < aBuffers.Objects ().size (); ++anIdx)
+  {
+    theDI << static_cast<int> (anIdx + 1) << " " << aBuffers.Objects ()[anIdx] << " ";
+  }
+
+  return 0;
+}
+
+//=======================================================================
+//function : RTDenoise
+//purpose  : Configures denoising of progressive rendering
+//=======================================================================
+static int RTDenoise (Draw_Interpretor& /*theDI*/, int theNbArgs, const char** theArgs)
+{
+  struct Error
+  {
+    enum Type
+    {
+      Usage = 0
+    };
+
+    static int print (const Type /*theType*/)
+    {
+      std::cout << "Usage: rtdenoise [-on|-off] [-iterations <1-8>] [-color <sigma>]"
+                   " [-normal <sigma>] [-depth <sigma>] [-albedo <sigma>]" << "\n";
+
+      return 1; // TCL_ERROR
+    }
+  };
+
+  ie::Denoiser* aDenoiser = ie::Denoiser::GetInstance ();
+
+  for (int anArgIdx = 1; anArgIdx < theNbArgs; ++anArgIdx)
+  {
+    TCollection_AsciiString aFlag (theArgs[anArgIdx]);
+
+    aFlag.LowerCase ();
+
+    if (aFlag == "-on" || aFlag == "-off")
+    {
+      aDenoiser->SetEnabled (aFlag == "-on");
+
+      continue;
+    }
+
+    if (anArgIdx + 1 >= theNbArgs)
+    {
+      return Error::print (Error::Usage);
+    }
+
+    const TCollection_AsciiString aValue (theArgs[++anArgIdx]);
+
+    if (aFlag == "-iterations" && aValue.IsIntegerValue ())
+    {
+      aDenoiser->SetNbIterations (aValue.IntegerValue ());
+    }
+    else if (!aValue.IsRealValue ())
+    {
+      return Error::print (Error::Usage);
+    }
+    else if (aFlag == "-color")
+    {
+      aDenoiser->SetColorSigma (static_cast<float> (aValue.RealValue ()));
+    }
+    else if (aFlag == "-normal")
+    {
+      aDenoiser->SetNormalSigma (static_cast<float> (aValue.RealValue ()));
+    }
+    else if (aFlag == "-depth")
+    {
+      aDenoiser->SetDepthSigma (static_cast<float> (aValue.RealValue ()));
+    }
+    else if (aFlag == "-albedo")
+    {
+      aDenoiser->SetAlbedoSigma (static_cast<float> (aValue.RealValue ()));
+    }
+    else
+    {
+      return Error::print (Error::Usage);
+    }
+  }
+
+  std::cout << "Denoising: " << (aDenoiser->IsEnabled () ? "on" : "off")
+            << ", iterations " << aDenoiser->NbIterations ()
+            << ", color " << aDenoiser->ColorSigma ()
+            << ", normal " << aDenoiser->NormalSigma ()
+            << ", depth " << aDenoiser->DepthSigma ()
+            << ", albedo " << aDenoiser->AlbedoSigma () << std::endl;
+
+  return 0;
+}
+
+//=======================================================================
+//function : Commands
+//purpose  : 
+//=======================================================================
+void ImportExport_Plugin::Commands (Draw_Interpretor& theCommands)
+{
+  const char* aGroupIE = "Commands for import mesh files";
+
+  theCommands.Add ("rtmeshread", "rtmeshread <file name> <node name> [-rename|-rn] [-group|-gr] [-pretrans|-pt] [-gensmooth|-gs] [-fixnorms|-fn] [-genuv|-uv] [-up X|Y|Z|-X|-Y|-Z]", __FILE__, RTMeshRead, aGroupIE);
+
+  theCommands.Add ("rtrestore", "rtrestore <file name> <shape name> [-nomesh]", __FILE__, RTRestore, aGroupIE);
+
+  theCommands.Add ("rtgltfread", "rtgltfread <file name> <node name> [-rename|-rn]", __FILE__, RTGltfRead, aGroupIE);
+
+  theCommands.Add ("rtstepread", "rtstepread <file name> <node name> [-rename|-rn] [-nocache]", __FILE__, RTStepRead, aGroupIE);
+
+  theCommands.Add ("rtcache", "rtcache [-on|-off] [-dir <path>] [-size <megabytes>] [-update <node name>] [-clear]", __FILE__, RTCache, aGroupIE);
+
+  theCommands.Add ("rtgltfwrite", "rtgltfwrite <file name> [<node name 1> ... <node name N>]", __FILE__, RTGltfWrite, aGroupIE);
+
+  theCommands.Add ("rtmesh", "rtmesh <shape name> [-absDefl <value>|-devCoeff <value>] [-angDefl <degrees>]", __FILE__, RTMesh, aGroupIE);
+
+  theCommands.Add ("rtmeshbudget", "rtmeshbudget <number of triangles> [-noupdate]", __FILE__, RTMeshBudget, aGroupIE);
+
+  theCommands.Add ("rtrefine", "rtrefine [-on|-off] [-budget <triangles>] [-tolerance <pixels>]", __FILE__, RTRefine, aGroupIE);
+
+  theCommands.Add ("rtprogressive", "rtprogressive <shape name 1> ... <shape name N> [-explode|-ex] [-noupdate]", __FILE__, RTProgressive, aGroupIE);
+
+  theCommands.Add ("rtinstance", "rtinstance <name> <base shape> [-orient F|R|I|E] [-location <a11 a12 a13 a14 a21 ... a34>]", __FILE__, RTInstance, aGroupIE);
+
+  const char* aGroupDM = "Commands for management data models";
+
+  theCommands.Add ("rtmodel", "rtmodel [-print <model>] [-sync <model>] [-textures <model>] [-all]", __FILE__, RTModel, aGroupDM);
+
+  theCommands.Add ("rtdisplay", "rtdisplay <node name> [-progressive|-pr]", __FILE__, RTDisplay, aGroupDM);
+
+  theCommands.Add ("rterase", "rterase <node name>", __FILE__, RTErase, aGroupDM);
+
+  theCommands.Add ("rttexture", "rttexture <node name> <file name> [-scale <S> <T>] [-on|-off]", __FILE__, RTTexture, aGroupDM);
+
+  theCommands.Add ("rtmaterial", "rtmaterial <node name(s)> <BSDF> [-material <name>] [-texture <file name>] [-scale <S> <T>] [-noupdate]", __FILE__, RTMaterial, aGroupDM);
+
+  theCommands.Add ("rtlight", "rtlight <index> -color <R G B>", __FILE__, RTLight, aGroupDM);
+
+  theCommands.Add ("rtrotate", "rtrotate <node name> <dx dy dz> <angle>", __FILE__, RTRotate, aGroupDM);
+
+  theCommands.Add ("rtgroup", "rtgroup <group name> <node name 1> ... <node name N>", __FILE__, RTGroup, aGroupDM);
+
+  const char* aGroupRT = "Commands for rendering control";
+
+  theCommands.Add ("rtconvergence", "rtconvergence [-samples <count>] [-time <seconds>] [-noise <level>] [-reset]", __FILE__, RTConvergence, aGroupRT);
+
+  theCommands.Add ("rtcheckpoint", "rtcheckpoint [-on|-off] [-dir <path>] [-interval <seconds>] [-write] [-clear]", __FILE__, RTCheckpoint, aGroupRT);
+
+  theCommands.Add ("rtaov", "rtaov <file name>.exr [-denoise]", __FILE__, RTAov, aGroupRT);
+
+  theCommands.Add ("rtdenoise", "rtdenoise [-on|-off] [-iterations <1-8>] [-color <sigma>] [-normal <sigma>] [-depth <sigma>] [-albedo <sigma>]", __FILE__, RTDenoise, aGroupRT);
 }
 
 // ======================================================================
@@ -0,0 +1,542 @@
+// Created: 2019-06-27
+//
+// Copyright (c) 2019 OPEN CASCADE SAS
+//
+// This file is a part of CADRays software.
+//
+// CADRays is free software; you can use it under the terms of the MIT license,
+// refer to file LICENSE.txt for complete text of the license and disclaimer of
+// any warranty.
+
+#include <ViewerTest.hxx>
+
+#include <BRep_Tool.hxx>
+#include <BRepBndLib.hxx>
+#include <BRepGProp.hxx>
+#include <BRepTools.hxx>
+#include <BRepLProp_SLProps.hxx>
+#include <BRepAdaptor_Surface.hxx>
+#include <BRepMesh_IncrementalMesh.hxx>
+#include <GProp_GProps.hxx>
+#include <Poly_Triangulation.hxx>
+#include <Precision.hxx>
+#include <Standard_Failure.hxx>
+
+#include <TopoDS.hxx>
+#include <TopExp_Explorer.hxx>
+
+#include <OSD_Parallel.hxx>
+#include <OSD_Timer.hxx>
+
+#include <set>
+#include <map>
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
+#include "Utils.hxx"
+#include "MeshQueue.hxx"
+#include "MeshPlanner.hxx"
+
+namespace ie
+{
+  //! Coarsest and finest deflections relative to the shape size.
+  static const double THE_MAX_DEFLECTION = 5.0e-2;
+  static const double THE_MIN_DEFLECTION = 1.0e-5;
+
+  //! Deflection of planar shapes if there are no curved ones.
+  static const double THE_DEF_DEFLECTION = 1.0e-3;
+
+  //! Number of samples in each parametric direction to estimate curvature.
+  static const int THE_NB_SAMPLES = 5;
+
+  namespace
+  {
+    //! Returns average curvature of the face (0 for planar faces).
+    static double faceCurvature (const TopoDS_Face& theFace)
+    {
+      BRepAdaptor_Surface aSurface (theFace, Standard_False);
+
+      if (aSurface.GetType () == GeomAbs_Plane)
+      {
+        return 0.0;
+      }
+
+      Standard_Real aMinU, aMaxU, aMinV, aMaxV;
+
+      BRepTools::UVBounds (theFace, aMinU, aMaxU, aMinV, aMaxV);
+
+      BRepLProp_SLProps aProps (aSurface, 2, Precision::Confusion ());
+
+      double aSum = 0.0;
+
+      int aNbSamples = 0;
+
+      for (int aSampleU = 0; aSampleU < THE_NB_SAMPLES; ++aSampleU)
+      {
+        for (int aSampleV = 0; aSampleV < THE_NB_SAMPLES; ++aSampleV)
+        {
+          aProps.SetParameters (aMinU + (aMaxU - aMinU) * (aSampleU + 0.5) / THE_NB_SAMPLES,
+                                aMinV + (aMaxV - aMinV) * (aSampleV + 0.5) / THE_NB_SAMPLES);
+
+          if (aProps.IsCurvatureDefined ())
+          {
+            aSum += std::max (std::abs (aProps.MaxCurvature ()), std::abs (aProps.MinCurvature ()));
+
+            ++aNbSamples;
+          }
+        }
+      }
+
+      return aNbSamples > 0 ? aSum / aNbSamples : 0.0;
+    }
+
+    //! Functor to estimate complexity of shape in a worker thread.
+    struct AnalyzeFunctor
+    {
+      AnalyzeFunctor (std::vector<MeshPlanner::Item>& theItems)
+        : myItems (theItems)
+      {
+        //
+      }
+
+      void operator() (const int theItemID) const
+      {
+        MeshPlanner::Item& anItem = myItems[theItemID];
+
+        for (TopExp_Explorer anExp (anItem.Shape, TopAbs_FACE); anExp.More (); anExp.Next ())
+        {
+          const TopoDS_Face& aFace = TopoDS::Face (anExp.Current ());
+
+          GProp_GProps aProps;
+
+          int aNbEdges = 0;
+
+          for (TopExp_Explorer anEdgeExp (aFace, TopAbs_EDGE); anEdgeExp.More (); anEdgeExp.Next ())
+          {
+            ++aNbEdges;
+          }
+
+          // Even flat face needs a couple of triangles per boundary edge
+          anItem.Constant += 2.0 * std::max (aNbEdges, 2);
+
+          try
+          {
+            BRepGProp::SurfaceProperties (aFace, aProps);
+
+            const double anArea = std::abs (aProps.Mass ());
+
+            // Chord of length L has sagitta K * L^2 / 8 on a surface with
+            // curvature K, so deflection D requires A * K / (4 * D) triangles
+            anItem.Area       += anArea;
+            anItem.Complexity += anArea * faceCurvature (aFace) / 4.0;
+          }
+          catch (Standard_Failure&)
+          {
+            // face is treated as flat one
+          }
+        }
+
+        Bnd_Box aBox;
+
+        BRepBndLib::Add (anItem.Shape, aBox, Standard_False);
+
+        anItem.Diagonal = aBox.IsVoid () ? 0.0 : std::sqrt (aBox.SquareExtent ());
+      }
+
+    private:
+
+      std::vector<MeshPlanner::Item>& myItems;
+    };
+
+    //! Functor to tessellate group of shapes in a worker thread.
+    struct MeshFunctor
+    {
+      MeshFunctor (const std::vector<MeshPlanner::Item>&  theItems,
+                   const std::vector<std::vector<int> >& theGroups)
+        : myItems (theItems),
+          myGroups (theGroups)
+      {
+        //
+      }
+
+      void operator() (const int theGroupID) const
+      {
+        const std::vector<int>& aGroup = myGroups[theGroupID];
+
+        // Shapes of the group share edges, so all of them are cleaned
+        // first (otherwise edge polygons of meshed shape will be lost)
+        for (size_t anItemID = 0; anItemID < aGroup.size (); ++anItemID)
+        {
+          BRepTools::Clean (myItems[aGroup[anItemID]].Shape);
+        }
+
+        for (size_t anItemID = 0; anItemID < aGroup.size (); ++anItemID)
+        {
+          const MeshPlanner::Item& anItem = myItems[aGroup[anItemID]];
+
+          try
+          {
+            BRepMesh_IncrementalMesh aMesher (anItem.Shape, anItem.Deflection, Standard_False, anItem.Angle, Standard_False);
+          }
+          catch (Standard_Failure&)
+          {
+            // AIS will try to mesh the shape again on display
+          }
+        }
+      }
+
+    private:
+
+      const std::vector<MeshPlanner::Item>&  myItems;
+      const std::vector<std::vector<int> >& myGroups;
+    };
+  }
+
+  //===========================================================================
+  //function : MeshPlanner
+  //purpose  :
+  //===========================================================================
+  MeshPlanner::MeshPlanner (const model::DataModel* theModel)
+    : myNbEstimated (0.0),
+      myMeanDeflection (0.0),
+      myNbTriangles (0),
+      myMemorySize (0),
+      myElapsedTime (0.0)
+  {
+    std::map<const void*, size_t> anItemIDs;
+
+    std::vector<model::DataNode*> aStack;
+
+    for (size_t aNodeID = 0; aNodeID < theModel->Shapes ().size (); ++aNodeID)
+    {
+      aStack.push_back (theModel->Shapes ()[aNodeID].get ());
+    }
+
+    while (!aStack.empty ())
+    {
+      model::DataNode* aNode = aStack.back ();
+
+      aStack.pop_back ();
+
+      for (size_t aSubID = 0; aSubID < aNode->SubNodes ().size (); ++aSubID)
+      {
+        aStack.push_back (aNode->SubNodes ()[aSubID].get ());
+      }
+
+      Handle (AIS_Shape) anObject = Handle (AIS_Shape)::DownCast (aNode->Object ());
+
+      if (anObject.IsNull () || anObject->Shape ().IsNull ())
+      {
+        continue;
+      }
+
+      // Instances share triangulation (it is stored in TShape)
+      std::map<const void*, size_t>::iterator aFound = anItemIDs.find (anObject->Shape ().TShape ().get ());
+
+      if (aFound != anItemIDs.end ())
+      {
+        myItems[aFound->second].Objects.push_back (anObject);
+
+        continue;
+      }
+
+      anItemIDs[anObject->Shape ().TShape ().get ()] = myItems.size ();
+
+      Item anItem;
+
+      anItem.Shape      = anObject->Shape ();
+      anItem.Area       = 0.0;
+      anItem.Complexity = 0.0;
+      anItem.Constant   = 0.0;
+      anItem.Diagonal   = 0.0;
+      anItem.Angle      = anObject->Attributes ()->DeviationAngle ();
+      anItem.Deflection = 0.0;
+
+      anItem.Objects.push_back (anObject);
+
+      myItems.push_back (anItem);
+    }
+  }
+
+  //===========================================================================
+  //function : Analyze
+  //purpose  :
+  //===========================================================================
+  void MeshPlanner::Analyze ()
+  {
+    OSD_Parallel::For (0, static_cast<int> (myItems.size ()), AnalyzeFunctor (myItems));
+  }
+
+  //===========================================================================
+  //function : Plan
+  //purpose  :
+  //===========================================================================
+  void MeshPlanner::Plan (const int theNbTriangles)
+  {
+    double aBudget = theNbTriangles;
+
+    for (size_t anItemID = 0; anItemID < myItems.size (); ++anItemID)
+    {
+      aBudget -= myItems[anItemID].Constant;
+    }
+
+    // Minimizing the sum of Area * Deflection for the fixed number of triangles
+    // gives Deflection ~ sqrt (Complexity / Area). Shapes exceeding deflection
+    // limits are clamped, and the rest of budget is distributed again
+    std::vector<bool> isFixed (myItems.size (), false);
+
+    for (bool isChanged = true; isChanged; )
+    {
+      isChanged = false;
+
+      double aFree = aBudget;
+      double aSum  = 0.0;
+
+      for (size_t anItemID = 0; anItemID < myItems.size (); ++anItemID)
+      {
+        const Item& anItem = myItems[anItemID];
+
+        if (anItem.Complexity <= 0.0 || anItem.Area <= 0.0)
+        {
+          continue;
+        }
+
+        if (isFixed[anItemID])
+        {
+          aFree -= anItem.Complexity / anItem.Deflection;
+        }
+        else
+        {
+          aSum += std::sqrt (anItem.Complexity * anItem.Area);
+        }
+      }
+
+      const double aScale = aFree > 0.0 ? aSum / aFree : std::numeric_limits<double>::max ();
+
+      for (size_t anItemID = 0; anItemID < myItems.size (); ++anItemID)
+      {
+        Item& anItem = myItems[anItemID];
+
+        if (anItem.Complexity <= 0.0 || anItem.Area <= 0.0 || isFixed[anItemID])
+        {
+          continue;
+        }
+
+        const double aDeflection = aScale * std::sqrt (anItem.Complexity / anItem.Area);
+
+        anItem.Deflection = std::max (anItem.Diagonal * THE_MIN_DEFLECTION,
+                            std::min (anItem.Diagonal * THE_MAX_DEFLECTION, aDeflection));
+
+        if (anItem.Deflection != aDeflection)
+        {
+          isFixed[anItemID] = isChanged = true;
+        }
+      }
+    }
+
+    // Flat shapes only need accurate boundaries, so they
+    // use average deflection of curved shapes
+    double aMeanDeflection = 0.0;
+    double aCurvedArea     = 0.0;
+
+    for (size_t anItemID = 0; anItemID < myItems.size (); ++anItemID)
+    {
+      if (myItems[anItemID].Complexity > 0.0)
+      {
+        aMeanDeflection += myItems[anItemID].Deflection * myItems[anItemID].Area;
+        aCurvedArea     += myItems[anItemID].Area;
+      }
+    }
+
+    myNbEstimated    = 0.0;
+    myMeanDeflection = 0.0;
+
+    double aTotalArea = 0.0;
+
+    for (size_t anItemID = 0; anItemID < myItems.size (); ++anItemID)
+    {
+      Item& anItem = myItems[anItemID];
+
+      if (anItem.Complexity <= 0.0 || anItem.Area <= 0.0)
+      {
+        const double aDeflection = aCurvedArea > 0.0 ? aMeanDeflection / aCurvedArea : anItem.Diagonal * THE_DEF_DEFLECTION;
+
+        anItem.Deflection = std::max (anItem.Diagonal * THE_MIN_DEFLECTION,
+                            std::min (anItem.Diagonal * THE_MAX_DEFLECTION, aDeflection));
+      }
+      else
+      {
+        myNbEstimated += anItem.Complexity / anItem.Deflection;
+      }
+
+      if (anItem.Deflection <= 0.0)
+      {
+        anItem.Deflection = Precision::Confusion (); // degenerated shape
+      }
+
+      myNbEstimated += anItem.Constant;
+
+      myMeanDeflection += anItem.Deflection * anItem.Area;
+      aTotalArea       += anItem.Area;
+    }
+
+    if (aTotalArea > 0.0)
+    {
+      myMeanDeflection /= aTotalArea;
+    }
+  }
+
+  //===========================================================================
+  //function : makeGroups
+  //purpose  :
+  //===========================================================================
+  void MeshPlanner::makeGroups ()
+  {
+    std::vector<int> aParents (myItems.size ());
+
+    for (size_t anItemID = 0; anItemID < myItems.size (); ++anItemID)
+    {
+      aParents[anItemID] = static_cast<int> (anItemID);
+    }
+
+    struct Tool
+    {
+      static int root (std::vector<int>& theParents, int theID)
+      {
+        while (theParents[theID] != theID)
+        {
+          theID = theParents[theID] = theParents[theParents[theID]];
+        }
+
+        return theID;
+      }
+    };
+
+    std::map<const void*, int> anEdgeOwners;
+
+    for (size_t anItemID = 0; anItemID < myItems.size (); ++anItemID)
+    {
+      for (TopExp_Explorer anExp (myItems[anItemID].Shape, TopAbs_EDGE); anExp.More (); anExp.Next ())
+      {
+        std::map<const void*, int>::iterator aFound = anEdgeOwners.find (anExp.Current ().TShape ().get ());
+
+        if (aFound == anEdgeOwners.end ())
+        {
+          anEdgeOwners[anExp.Current ().TShape ().get ()] = static_cast<int> (anItemID);
+        }
+        else
+        {
+          aParents[Tool::root (aParents, static_cast<int> (anItemID))] = Tool::root (aParents, aFound->second);
+        }
+      }
+    }
+
+    std::map<int, size_t> aGroupIDs;
+
+    myGroups.clear ();
+
+    for (size_t anItemID = 0; anItemID < myItems.size (); ++anItemID)
+    {
+      const int aRoot = Tool::root (aParents, static_cast<int> (anItemID));
+
+      if (aGroupIDs.find (aRoot) == aGroupIDs.end ())
+      {
+        aGroupIDs[aRoot] = myGroups.size ();
+
+        myGroups.push_back (std::vector<int> ());
+      }
+
+      myGroups[aGroupIDs[aRoot]].push_back (static_cast<int> (anItemID));
+    }
+  }
+
+  //===========================================================================
+  //function : Perform
+  //purpose  :
+  //===========================================================================
+  void MeshPlanner::Perform ()
+  {
+    // Shapes being tessellated in background cannot be cleaned
+    MeshQueue::GetInstance ()->Wait ();
+
+    OSD_Timer aTimer;
+
+    aTimer.Start ();
+
+    makeGroups ();
+
+    OSD_Parallel::For (0, static_cast<int> (myGroups.size ()), MeshFunctor (myItems, myGroups));
+
+    myElapsedTime = aTimer.ElapsedTime ();
+
+    computeStatistics ();
+
+    Handle (AIS_InteractiveContext) aContext = ViewerTest::GetAISContext ();
+
+    if (aContext.IsNull ())
+    {
+      return;
+    }
+
+    for (size_t anItemID = 0; anItemID < myItems.size (); ++anItemID)
+    {
+      const Item& anItem = myItems[anItemID];
+
+      for (size_t anObjectID = 0; anObjectID < anItem.Objects.size (); ++anObjectID)
+      {
+        const Handle (AIS_Shape)& anObject = anItem.Objects[anObjectID];
+
+        // Absolute deflection of the object prevents re-meshing on display
+        anObject->Attributes ()->SetTypeOfDeflection (Aspect_TOD_ABSOLUTE);
+        anObject->Attributes ()->SetMaximalChordialDeviation (anItem.Deflection);
+
+        model::Redisplay (aContext, anObject);
+
+        aContext->RecomputeSelectionOnly (anObject);
+      }
+    }
+  }
+
+  //===========================================================================
+  //function : computeStatistics
+  //purpose  :
+  //===========================================================================
+  void MeshPlanner::computeStatistics ()
+  {
+    std::set<const Poly_Triangulation*> aTriangulations;
+
+    myNbTriangles = 0;
+    myMemorySize  = 0;
+
+    for (size_t anItemID = 0; anItemID < myItems.size (); ++anItemID)
+    {
+      for (TopExp_Explorer anExp (myItems[anItemID].Shape, TopAbs_FACE); anExp.More (); anExp.Next ())
+      {
+        TopLoc_Location aLocation;
+
+        const Handle (Poly_Triangulation)& aTriangulation = BRep_Tool::Triangulation (TopoDS::Face (anExp.Current ()), aLocation);
+
+        if (aTriangulation.IsNull () || !aTriangulations.insert (aTriangulation.get ()).second)
+        {
+          continue;
+        }
+
+        myNbTriangles += aTriangulation->NbTriangles ();
+
+        myMemorySize += aTriangulation->NbNodes () * sizeof (gp_Pnt)
+                      + aTriangulation->NbTriangles () * sizeof (Poly_Triangle);
+
+        if (aTriangulation->HasUVNodes ())
+        {
+          myMemorySize += aTriangulation->NbNodes () * sizeof (gp_Pnt2d);
+        }
+
+        if (aTriangulation->HasNormals ())
+        {
+          myMemorySize += aTriangulation->NbNodes () * 3 * sizeof (Standard_ShortReal);
+        }
+      }
+    }
+  }
+}
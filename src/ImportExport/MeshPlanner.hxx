@@ -0,0 +1,112 @@
+// Created: 2019-06-27
+//
+// Copyright (c) 2019 OPEN CASCADE SAS
+//
+// This file is a part of CADRays software.
+//
+// CADRays is free software; you can use it under the terms of the MIT license,
+// refer to file LICENSE.txt for complete text of the license and disclaimer of
+// any warranty.
+
+#ifndef _RT_MeshPlanner_Header
+#define _RT_MeshPlanner_Header
+
+#include <AIS_Shape.hxx>
+
+#include <DataModel.hxx>
+
+#include <vector>
+
+namespace ie
+{
+  //! Tool class distributing the global triangle budget over CAD shapes
+  //! of the data model. Number of triangles of each face is estimated from
+  //! its area and curvature, and deflections are chosen to minimize the
+  //! area-weighted deflection of the scene for the given budget.
+  class MeshPlanner
+  {
+  public:
+
+    //! Creates planner for CAD shapes of the given data model.
+    //! Shapes shared by several nodes (instances) are planned once.
+    Standard_EXPORT MeshPlanner (const model::DataModel* theModel);
+
+    //! Estimates area and curvature of shapes (in parallel).
+    Standard_EXPORT void Analyze ();
+
+    //! Distributes deflections to fit the given number of triangles.
+    Standard_EXPORT void Plan (const int theNbTriangles);
+
+    //! Re-tessellates shapes (in parallel) and updates their presentations.
+    //! Should be called from the main thread.
+    Standard_EXPORT void Perform ();
+
+  public:
+
+    //! Returns number of unique shapes.
+    int NbShapes () const { return static_cast<int> (myItems.size ()); }
+
+    //! Returns estimated number of triangles for planned deflections.
+    double NbEstimated () const { return myNbEstimated; }
+
+    //! Returns area-weighted mean of planned linear deflections.
+    double MeanDeflection () const { return myMeanDeflection; }
+
+    //! Returns number of triangles produced (valid after tessellation).
+    int NbTriangles () const { return myNbTriangles; }
+
+    //! Returns memory used by triangulations (in bytes).
+    size_t MemorySize () const { return myMemorySize; }
+
+    //! Returns tessellation time (in seconds).
+    double ElapsedTime () const { return myElapsedTime; }
+
+  public:
+
+    //! Unique shape with its estimated complexity.
+    struct Item
+    {
+      TopoDS_Shape                    Shape;      //!< Shape to tessellate
+      std::vector<Handle (AIS_Shape)> Objects;    //!< Objects displaying the shape
+      double                          Area;       //!< Surface area
+      double                          Complexity; //!< Sum of area * curvature / 4 over faces
+      double                          Constant;   //!< Triangles not depending on deflection
+      double                          Diagonal;   //!< Bounding box diagonal
+      double                          Angle;      //!< Angular deflection
+      double                          Deflection; //!< Planned linear deflection
+    };
+
+  protected:
+
+    //! Groups shapes sharing edges (they cannot be meshed concurrently).
+    void makeGroups ();
+
+    //! Computes number of triangles and memory of triangulations.
+    void computeStatistics ();
+
+  protected:
+
+    //! Unique shapes.
+    std::vector<Item> myItems;
+
+    //! Groups of shapes meshed in the same thread.
+    std::vector<std::vector<int> > myGroups;
+
+    //! Estimated number of triangles.
+    double myNbEstimated;
+
+    //! Mean planned deflection.
+    double myMeanDeflection;
+
+    //! Number of produced triangles.
+    int myNbTriangles;
+
+    //! Memory used by triangulations.
+    size_t myMemorySize;
+
+    //! Tessellation time.
+    double myElapsedTime;
+  };
+}
+
+#endif // _RT_MeshPlanner_Header
@@ -0,0 +1,608 @@
+// Created: 2019-06-25
+//
+// Copyright (c) 2019 OPEN CASCADE SAS
+//
+// This file is a part of CADRays software.
+//
+// CADRays is free software; you can use it under the terms of the MIT license,
+// refer to file LICENSE.txt for complete text of the license and disclaimer of
+// any warranty.
+
+#include <Prs3d.hxx>
+#include <ViewerTest.hxx>
+#include <StdPrs_ToolTriangulatedShape.hxx>
+
+#include <BRepMesh_IncrementalMesh.hxx>
+#include <Standard_Failure.hxx>
+#include <TopExp_Explorer.hxx>
+
+#include <limits>
+#include <algorithm>
+
+#include "MeshQueue.hxx"
+
+namespace ie
+{
+  std::shared_ptr<MeshQueue> MeshQueue::myInstance;
+
+  //===========================================================================
+  //function : MeshQueue
+  //purpose  :
+  //===========================================================================
+  MeshQueue::MeshQueue ()
+    : myCameraState (0),
+      myNbRunning (0),
+      myToSort (false),
+      myToStop (false)
+  {
+    //
+  }
+
+  //===========================================================================
+  //function : ~MeshQueue
+  //purpose  :
+  //===========================================================================
+  MeshQueue::~MeshQueue ()
+  {
+    {
+      std::lock_guard<std::mutex> aLock (myMutex);
+
+      myToStop = true;
+    }
+
+    myTaskAdded.notify_all ();
+
+    for (size_t aThreadID = 0; aThreadID < myWorkers.size (); ++aThreadID)
+    {
+      myWorkers[aThreadID].join ();
+    }
+  }
+
+  //===========================================================================
+  //function : GetInstance
+  //purpose  :
+  //===========================================================================
+  MeshQueue* MeshQueue::GetInstance ()
+  {
+    if (myInstance == NULL)
+    {
+      myInstance.reset (new MeshQueue);
+    }
+
+    return myInstance.get ();
+  }
+
+  //===========================================================================
+  //function : startWorkers
+  //purpose  :
+  //===========================================================================
+  void MeshQueue::startWorkers ()
+  {
+    if (!myWorkers.empty ())
+    {
+      return;
+    }
+
+    // Keep one core for the main (rendering) thread
+    const int aNbThreads = std::max (1, static_cast<int> (std::thread::hardware_concurrency ()) - 1);
+
+    for (int aThreadID = 0; aThreadID < aNbThreads; ++aThreadID)
+    {
+      myWorkers.push_back (std::thread (&MeshQueue::performTasks, this));
+    }
+  }
+
+  //===========================================================================
+  //function : performTasks
+  //purpose  :
+  //===========================================================================
+  void MeshQueue::performTasks ()
+  {
+    for (;;)
+    {
+      TaskPtr aTask;
+
+      {
+        std::unique_lock<std::mutex> aLock (myMutex);
+
+        myTaskAdded.wait (aLock, [this] { return myToStop || !myPending.empty (); });
+
+        if (myToStop)
+        {
+          return;
+        }
+
+        std::vector<TaskPtr>::iterator aTop = std::max_element (myPending.begin (), myPending.end (),
+          [] (const TaskPtr& theTask1, const TaskPtr& theTask2) { return theTask1->Priority < theTask2->Priority; });
+
+        aTask = *aTop;
+
+        myPending.erase (aTop);
+
+        aTask->IsRunning = true;
+
+        ++myNbRunning;
+      }
+
+      // Tasks do not share edges, so each one is meshed in sequential mode
+      for (size_t aShapeID = 0; aShapeID < aTask->Shapes.size (); ++aShapeID)
+      {
+        try
+        {
+          BRepMesh_IncrementalMesh aMesher (aTask->Shapes[aShapeID],
+                                            aTask->LinDefl[aShapeID],
+                                            Standard_False,
+                                            aTask->AngDefl[aShapeID],
+                                            Standard_False);
+        }
+        catch (Standard_Failure&)
+        {
+          // AIS will try to mesh the shape again on display
+        }
+      }
+
+      // Callbacks read the triangulation, so they are called while edges are still owned
+      for (size_t aCallbackID = 0; aCallbackID < aTask->Callbacks.size (); ++aCallbackID)
+      {
+        aTask->Callbacks[aCallbackID] ();
+      }
+
+      {
+        std::lock_guard<std::mutex> aLock (myMutex);
+
+        aTask->IsRunning = false;
+        aTask->IsDone    = true;
+
+        --myNbRunning;
+
+        myFinished.push_back (aTask);
+      }
+
+      myTaskDone.notify_all ();
+    }
+  }
+
+  //===========================================================================
+  //function : Display
+  //purpose  :
+  //===========================================================================
+  void MeshQueue::Display (const Handle (AIS_Shape)& theObject, const bool theToUpdate)
+  {
+    Handle (AIS_InteractiveContext) aContext = ViewerTest::GetAISContext ();
+
+    if (theObject.IsNull () || aContext.IsNull ())
+    {
+      return;
+    }
+
+    if (IsQueued (theObject))
+    {
+      if (!aContext->IsDisplayed (theObject))
+      {
+        aContext->Display (theObject, BBOX_MODE, -1, theToUpdate);
+      }
+
+      return;
+    }
+
+    const TopoDS_Shape& aShape = theObject->Shape ();
+
+    std::vector<const void*> anEdges;
+
+    for (TopExp_Explorer anExp (aShape, TopAbs_EDGE); anExp.More (); anExp.Next ())
+    {
+      anEdges.push_back (anExp.Current ().TShape ().get ());
+    }
+
+    std::unique_lock<std::mutex> aLock (myMutex);
+
+    TaskPtr aTask = linkTask (aLock, anEdges);
+
+    const Handle (Prs3d_Drawer)& aDrawer = theObject->Attributes ();
+
+    if (aTask == NULL && (aShape.IsNull () || StdPrs_ToolTriangulatedShape::IsTessellated (aShape, aDrawer)))
+    {
+      aLock.unlock ();
+
+      aContext->Display (theObject, theToUpdate);
+
+      return;
+    }
+
+    if (aTask == NULL)
+    {
+      aTask.reset (new Task);
+
+      myPending.push_back (aTask);
+    }
+
+    // Deflection and bounding box are computed here, since they
+    // read the shared drawer and geometry of the shared edges
+    Bnd_Box aBox = theObject->BoundingBox ();
+
+    if (theObject->HasTransformation ())
+    {
+      aBox = aBox.Transformed (theObject->LocalTransformation ());
+    }
+
+    aTask->Objects.push_back (theObject);
+    aTask->Modes  .push_back (theObject->HasDisplayMode () ? theObject->DisplayMode () : -1);
+    aTask->Shapes .push_back (aShape);
+    aTask->LinDefl.push_back (Prs3d::GetDeflection (aShape, aDrawer));
+    aTask->AngDefl.push_back (aDrawer->DeviationAngle ());
+
+    aTask->Box.Add (aBox);
+
+    for (size_t anEdgeID = 0; anEdgeID < anEdges.size (); ++anEdgeID)
+    {
+      aTask->Edges.push_back (anEdges[anEdgeID]);
+
+      myEdgeTasks[anEdges[anEdgeID]] = aTask;
+    }
+
+    myObjectTasks[theObject.get ()] = aTask;
+
+    myToSort = true;
+
+    startWorkers ();
+
+    aLock.unlock ();
+
+    myTaskAdded.notify_one ();
+
+    // Selection is not activated to prevent meshing in the main thread
+    if (aContext->IsDisplayed (theObject))
+    {
+      aContext->Deactivate (theObject);
+
+      aContext->SetDisplayMode (theObject, BBOX_MODE, theToUpdate);
+    }
+    else
+    {
+      aContext->Display (theObject, BBOX_MODE, -1, theToUpdate);
+    }
+  }
+
+  //===========================================================================
+  //function : linkTask
+  //purpose  :
+  //===========================================================================
+  MeshQueue::TaskPtr MeshQueue::linkTask (std::unique_lock<std::mutex>& theLock, const std::vector<const void*>& theEdges)
+  {
+    // Collect unfinished tasks sharing the edges. Running tasks
+    // modify the edges, so we have to wait until they are finished
+    std::vector<TaskPtr> aLinked;
+
+    for (bool isReady = false; !isReady; )
+    {
+      isReady = true;
+
+      aLinked.clear ();
+
+      for (size_t anEdgeID = 0; anEdgeID < theEdges.size () && isReady; ++anEdgeID)
+      {
+        std::map<const void*, TaskPtr>::iterator aFound = myEdgeTasks.find (theEdges[anEdgeID]);
+
+        if (aFound == myEdgeTasks.end () || aFound->second->IsDone)
+        {
+          continue;
+        }
+
+        if (aFound->second->IsRunning)
+        {
+          waitTask (theLock, aFound->second);
+
+          isReady = false;
+        }
+        else if (std::find (aLinked.begin (), aLinked.end (), aFound->second) == aLinked.end ())
+        {
+          aLinked.push_back (aFound->second);
+        }
+      }
+    }
+
+    if (aLinked.empty ())
+    {
+      return TaskPtr ();
+    }
+
+    // Merge all linked tasks into the first one
+    TaskPtr aTask = aLinked.front ();
+
+    for (size_t aTaskID = 1; aTaskID < aLinked.size (); ++aTaskID)
+    {
+      const TaskPtr& aMerged = aLinked[aTaskID];
+
+      aTask->Objects  .insert (aTask->Objects  .end (), aMerged->Objects  .begin (), aMerged->Objects  .end ());
+      aTask->Modes    .insert (aTask->Modes    .end (), aMerged->Modes    .begin (), aMerged->Modes    .end ());
+      aTask->Shapes   .insert (aTask->Shapes   .end (), aMerged->Shapes   .begin (), aMerged->Shapes   .end ());
+      aTask->LinDefl  .insert (aTask->LinDefl  .end (), aMerged->LinDefl  .begin (), aMerged->LinDefl  .end ());
+      aTask->AngDefl  .insert (aTask->AngDefl  .end (), aMerged->AngDefl  .begin (), aMerged->AngDefl  .end ());
+      aTask->Edges    .insert (aTask->Edges    .end (), aMerged->Edges    .begin (), aMerged->Edges    .end ());
+      aTask->Callbacks.insert (aTask->Callbacks.end (), aMerged->Callbacks.begin (), aMerged->Callbacks.end ());
+
+      aTask->Box.Add (aMerged->Box);
+
+      for (size_t anEdgeID = 0; anEdgeID < aMerged->Edges.size (); ++anEdgeID)
+      {
+        myEdgeTasks[aMerged->Edges[anEdgeID]] = aTask;
+      }
+
+      for (size_t anObjectID = 0; anObjectID < aMerged->Objects.size (); ++anObjectID)
+      {
+        myObjectTasks[aMerged->Objects[anObjectID].get ()] = aTask;
+      }
+
+      myPending.erase (std::find (myPending.begin (), myPending.end (), aMerged));
+    }
+
+    return aTask;
+  }
+
+  //===========================================================================
+  //function : Submit
+  //purpose  :
+  //===========================================================================
+  void MeshQueue::Submit (const TopoDS_Shape&           theShape,
+                          const double                  theLinDefl,
+                          const double                  theAngDefl,
+                          const std::function<void ()>& theCallback)
+  {
+    std::vector<const void*> anEdges;
+
+    for (TopExp_Explorer anExp (theShape, TopAbs_EDGE); anExp.More (); anExp.Next ())
+    {
+      anEdges.push_back (anExp.Current ().TShape ().get ());
+    }
+
+    std::unique_lock<std::mutex> aLock (myMutex);
+
+    TaskPtr aTask = linkTask (aLock, anEdges);
+
+    if (aTask == NULL)
+    {
+      aTask.reset (new Task);
+
+      myPending.push_back (aTask);
+    }
+
+    if (!theShape.IsNull ())
+    {
+      aTask->Shapes .push_back (theShape);
+      aTask->LinDefl.push_back (theLinDefl);
+      aTask->AngDefl.push_back (theAngDefl);
+
+      for (size_t anEdgeID = 0; anEdgeID < anEdges.size (); ++anEdgeID)
+      {
+        aTask->Edges.push_back (anEdges[anEdgeID]);
+
+        myEdgeTasks[anEdges[anEdgeID]] = aTask;
+      }
+    }
+
+    aTask->Callbacks.push_back (theCallback);
+
+    startWorkers ();
+
+    aLock.unlock ();
+
+    myTaskAdded.notify_one ();
+  }
+
+  //===========================================================================
+  //function : Update
+  //purpose  :
+  //===========================================================================
+  bool MeshQueue::Update (const Handle (Graphic3d_Camera)& theCamera)
+  {
+    std::vector<TaskPtr> aFinished;
+
+    {
+      std::lock_guard<std::mutex> aLock (myMutex);
+
+      if (!theCamera.IsNull () && !myPending.empty ())
+      {
+        if (myToSort || myCameraState != theCamera->WorldViewState ())
+        {
+          for (size_t aTaskID = 0; aTaskID < myPending.size (); ++aTaskID)
+          {
+            myPending[aTaskID]->Priority = ProjectedSize (myPending[aTaskID]->Box, theCamera);
+          }
+
+          myCameraState = theCamera->WorldViewState ();
+
+          myToSort = false;
+        }
+      }
+
+      aFinished.swap (myFinished);
+
+      for (size_t aTaskID = 0; aTaskID < aFinished.size (); ++aTaskID)
+      {
+        const TaskPtr& aTask = aFinished[aTaskID];
+
+        for (size_t anEdgeID = 0; anEdgeID < aTask->Edges.size (); ++anEdgeID)
+        {
+          std::map<const void*, TaskPtr>::iterator aFound = myEdgeTasks.find (aTask->Edges[anEdgeID]);
+
+          if (aFound != myEdgeTasks.end () && aFound->second == aTask)
+          {
+            myEdgeTasks.erase (aFound);
+          }
+        }
+
+        for (size_t anObjectID = 0; anObjectID < aTask->Objects.size (); ++anObjectID)
+        {
+          myObjectTasks.erase (aTask->Objects[anObjectID].get ());
+        }
+      }
+    }
+
+    Handle (AIS_InteractiveContext) aContext = ViewerTest::GetAISContext ();
+
+    if (aFinished.empty () || aContext.IsNull ())
+    {
+      return false;
+    }
+
+    for (size_t aTaskID = 0; aTaskID < aFinished.size (); ++aTaskID)
+    {
+      const TaskPtr& aTask = aFinished[aTaskID];
+
+      for (size_t anObjectID = 0; anObjectID < aTask->Objects.size (); ++anObjectID)
+      {
+        const Handle (AIS_Shape)& anObject = aTask->Objects[anObjectID];
+
+        if (aTask->Modes[anObjectID] < 0)
+        {
+          aContext->UnsetDisplayMode (anObject, Standard_False);
+        }
+        else
+        {
+          aContext->SetDisplayMode (anObject, aTask->Modes[anObjectID], Standard_False);
+        }
+
+        if (aContext->IsDisplayed (anObject) && aContext->GetAutoActivateSelection ())
+        {
+          aContext->Activate (anObject, anObject->GlobalSelectionMode ());
+        }
+      }
+    }
+
+    return true;
+  }
+
+  //===========================================================================
+  //function : waitTask
+  //purpose  :
+  //===========================================================================
+  void MeshQueue::waitTask (std::unique_lock<std::mutex>& theLock, const TaskPtr& theTask)
+  {
+    if (!theTask->IsRunning)
+    {
+      theTask->Priority = std::numeric_limits<float>::max ();
+    }
+
+    TaskPtr aTask = theTask; // keep the task alive
+
+    myTaskDone.wait (theLock, [&aTask] { return aTask->IsDone; });
+  }
+
+  //===========================================================================
+  //function : Flush
+  //purpose  :
+  //===========================================================================
+  void MeshQueue::Flush (const TopoDS_Shape& theShape)
+  {
+    std::unique_lock<std::mutex> aLock (myMutex);
+
+    if (myEdgeTasks.empty ())
+    {
+      return;
+    }
+
+    for (TopExp_Explorer anExp (theShape, TopAbs_EDGE); anExp.More (); anExp.Next ())
+    {
+      std::map<const void*, TaskPtr>::iterator aFound = myEdgeTasks.find (anExp.Current ().TShape ().get ());
+
+      if (aFound != myEdgeTasks.end () && !aFound->second->IsDone)
+      {
+        waitTask (aLock, aFound->second);
+      }
+    }
+  }
+
+  //===========================================================================
+  //function : Wait
+  //purpose  :
+  //===========================================================================
+  void MeshQueue::Wait ()
+  {
+    std::unique_lock<std::mutex> aLock (myMutex);
+
+    myTaskDone.wait (aLock, [this] { return myPending.empty () && myNbRunning == 0; });
+  }
+
+  //===========================================================================
+  //function : IsQueued
+  //purpose  :
+  //===========================================================================
+  bool MeshQueue::IsQueued (const Handle (AIS_InteractiveObject)& theObject)
+  {
+    std::lock_guard<std::mutex> aLock (myMutex);
+
+    return myObjectTasks.find (theObject.get ()) != myObjectTasks.end ();
+  }
+
+  //===========================================================================
+  //function : NbQueued
+  //purpose  :
+  //===========================================================================
+  int MeshQueue::NbQueued ()
+  {
+    std::lock_guard<std::mutex> aLock (myMutex);
+
+    return static_cast<int> (myObjectTasks.size ());
+  }
+
+  //===========================================================================
+  //function : ProjectedSize
+  //purpose  :
+  //===========================================================================
+  float MeshQueue::ProjectedSize (const Bnd_Box& theBox, const Handle (Graphic3d_Camera)& theCamera)
+  {
+    if (theBox.IsVoid ())
+    {
+      return 0.f;
+    }
+
+    Standard_Real aMinX, aMinY, aMinZ;
+    Standard_Real aMaxX, aMaxY, aMaxZ;
+
+    theBox.Get (aMinX, aMinY, aMinZ, aMaxX, aMaxY, aMaxZ);
+
+    const gp_Pnt anEye = theCamera->Eye ();
+    const gp_Vec aDir (theCamera->Direction ());
+
+    float aScrMinX = std::numeric_limits<float>::max (), aScrMaxX = -std::numeric_limits<float>::max ();
+    float aScrMinY = std::numeric_limits<float>::max (), aScrMaxY = -std::numeric_limits<float>::max ();
+
+    int aNbBehind = 0;
+
+    for (int aCornerID = 0; aCornerID < 8; ++aCornerID)
+    {
+      const gp_Pnt aCorner ((aCornerID & 1) ? aMaxX : aMinX,
+                            (aCornerID & 2) ? aMaxY : aMinY,
+                            (aCornerID & 4) ? aMaxZ : aMinZ);
+
+      if (!theCamera->IsOrthographic () && gp_Vec (anEye, aCorner).Dot (aDir) <= 0.0)
+      {
+        ++aNbBehind;
+
+        continue;
+      }
+
+      const gp_Pnt aPoint = theCamera->Project (aCorner);
+
+      aScrMinX = std::min (aScrMinX, static_cast<float> (aPoint.X ()));
+      aScrMaxX = std::max (aScrMaxX, static_cast<float> (aPoint.X ()));
+      aScrMinY = std::min (aScrMinY, static_cast<float> (aPoint.Y ()));
+      aScrMaxY = std::max (aScrMaxY, static_cast<float> (aPoint.Y ()));
+    }
+
+    if (aNbBehind == 8)
+    {
+      return 0.f; // box is behind the camera
+    }
+    else if (aNbBehind > 0)
+    {
+      return 4.f; // camera is inside the box (whole screen)
+    }
+
+    // Area of the box projection clipped by the screen (NDC)
+    const float aSizeX = std::min (aScrMaxX, 1.f) - std::max (aScrMinX, -1.f);
+    const float aSizeY = std::min (aScrMaxY, 1.f) - std::max (aScrMinY, -1.f);
+
+    return std::max (aSizeX, 0.f) * std::max (aSizeY, 0.f);
+  }
+}
@@ -0,0 +1,172 @@
+// Created: 2019-06-25
+//
+// Copyright (c) 2019 OPEN CASCADE SAS
+//
+// This file is a part of CADRays software.
+//
+// CADRays is free software; you can use it under the terms of the MIT license,
+// refer to file LICENSE.txt for complete text of the license and disclaimer of
+// any warranty.
+
+#ifndef _RT_MeshQueue_Header
+#define _RT_MeshQueue_Header
+
+#include <AIS_Shape.hxx>
+#include <Graphic3d_Camera.hxx>
+
+#include <map>
+#include <mutex>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <functional>
+#include <condition_variable>
+
+namespace ie
+{
+  //! Queue for progressive tessellation of CAD shapes in background threads.
+  //! Shapes are displayed as bounding boxes immediately, meshed in the order
+  //! of their screen-space size and switched to the requested presentation
+  //! as soon as their triangulation is ready.
+  class MeshQueue
+  {
+  public:
+
+    //! Display mode of AIS shape showing its bounding box.
+    static const int BBOX_MODE = 2;
+
+  public:
+
+    //! Returns the instance of tessellation queue.
+    static Standard_EXPORT MeshQueue* GetInstance ();
+
+    //! Stops worker threads (pending tasks are discarded).
+    Standard_EXPORT ~MeshQueue ();
+
+  public:
+
+    //! Displays the shape (as bounding box if it is not tessellated yet)
+    //! and schedules its tessellation. Should be called from the main thread.
+    Standard_EXPORT void Display (const Handle (AIS_Shape)& theObject, const bool theToUpdate = false);
+
+    //! Schedules tessellation of the given shape (not displayed) with the given
+    //! deflections and calls the given function from the worker thread once the
+    //! shape is tessellated (null shape is just passed to the worker with the
+    //! function). Should be called from the main thread.
+    Standard_EXPORT void Submit (const TopoDS_Shape&           theShape,
+                                 const double                  theLinDefl,
+                                 const double                  theAngDefl,
+                                 const std::function<void ()>& theCallback);
+
+    //! Updates task priorities for the given camera and swaps presentations of
+    //! tessellated shapes. Should be called from the main thread (each frame).
+    //! Returns true if some presentation was changed.
+    Standard_EXPORT bool Update (const Handle (Graphic3d_Camera)& theCamera);
+
+    //! Waits until the given shape is tessellated (if it was scheduled).
+    Standard_EXPORT void Flush (const TopoDS_Shape& theShape);
+
+    //! Waits until all scheduled shapes are tessellated.
+    Standard_EXPORT void Wait ();
+
+    //! Checks whether the given object is waiting for its presentation.
+    Standard_EXPORT bool IsQueued (const Handle (AIS_InteractiveObject)& theObject);
+
+    //! Returns number of objects waiting for their presentations.
+    Standard_EXPORT int NbQueued ();
+
+  public:
+
+    //! Returns screen-space area of the given box in NDC units (4 for whole screen).
+    static Standard_EXPORT float ProjectedSize (const Bnd_Box& theBox, const Handle (Graphic3d_Camera)& theCamera);
+
+  protected:
+
+    //! Tessellation task (set of shapes sharing some edges).
+    struct Task
+    {
+      //! Creates new empty task.
+      Task () : Priority (0.f), IsRunning (false), IsDone (false)
+      {
+        //
+      }
+
+      std::vector<Handle (AIS_Shape)> Objects; //!< Objects waiting for presentations
+      std::vector<int>                Modes;   //!< Own display modes of objects (-1 if not set)
+      std::vector<TopoDS_Shape>       Shapes;  //!< Shapes to tessellate
+      std::vector<double>             LinDefl; //!< Linear deflections of shapes
+      std::vector<double>             AngDefl; //!< Angular deflections of shapes
+      std::vector<const void*>        Edges;   //!< Edges (TShape) owned by the task
+      std::vector<std::function<void ()> > Callbacks; //!< Functions called after tessellation
+      Bnd_Box                         Box;     //!< Bounding box of the task
+      float                           Priority;
+      bool                            IsRunning;
+      bool                            IsDone;
+    };
+
+    typedef std::shared_ptr<Task> TaskPtr;
+
+  protected:
+
+    //! Creates new tessellation queue.
+    MeshQueue ();
+
+    //! Starts worker threads (if not started yet).
+    void startWorkers ();
+
+    //! Tessellates pending tasks (worker thread function).
+    void performTasks ();
+
+    //! Returns unfinished task owning some of the given edges (other such tasks
+    //! are merged into it) or NULL. Waits for running tasks owning the edges.
+    TaskPtr linkTask (std::unique_lock<std::mutex>& theLock, const std::vector<const void*>& theEdges);
+
+    //! Moves the given task to the front and waits for it.
+    void waitTask (std::unique_lock<std::mutex>& theLock, const TaskPtr& theTask);
+
+  protected:
+
+    //! Tasks waiting for tessellation.
+    std::vector<TaskPtr> myPending;
+
+    //! Tessellated tasks waiting for presentation swap.
+    std::vector<TaskPtr> myFinished;
+
+    //! Maps edges (TShape) to tasks that own them.
+    std::map<const void*, TaskPtr> myEdgeTasks;
+
+    //! Maps queued objects to their tasks.
+    std::map<const AIS_InteractiveObject*, TaskPtr> myObjectTasks;
+
+    //! Worker threads.
+    std::vector<std::thread> myWorkers;
+
+    //! Guards all the fields above.
+    std::mutex myMutex;
+
+    //! Notifies workers about new tasks.
+    std::condition_variable myTaskAdded;
+
+    //! Notifies waiting threads about finished tasks.
+    std::condition_variable myTaskDone;
+
+    //! Camera state used to compute task priorities.
+    Standard_Size myCameraState;
+
+    //! Number of tasks being tessellated.
+    int myNbRunning;
+
+    //! Set when new tasks should be prioritized.
+    bool myToSort;
+
+    //! Set when worker threads should stop.
+    bool myToStop;
+
+  private:
+
+    //! Instance of tessellation queue.
+    static std::shared_ptr<MeshQueue> myInstance;
+  };
+}
+
+#endif // _RT_MeshQueue_Header
@@ -0,0 +1,630 @@
+// Created: 2019-06-26
+//
+// Copyright (c) 2019 OPEN CASCADE SAS
+//
+// This file is a part of CADRays software.
+//
+// CADRays is free software; you can use it under the terms of the MIT license,
+// refer to file LICENSE.txt for complete text of the license and disclaimer of
+// any warranty.
+
+#include <Prs3d.hxx>
+#include <ViewerTest.hxx>
+#include <AIS_DisplayMode.hxx>
+#include <AIS_ListOfInteractive.hxx>
+#include <AIS_ListIteratorOfListOfInteractive.hxx>
+
+#include <BRep_Tool.hxx>
+#include <BRep_Builder.hxx>
+#include <BRepBuilderAPI_Copy.hxx>
+#include <BRepMesh_IncrementalMesh.hxx>
+#include <Poly_Triangulation.hxx>
+#include <Standard_Failure.hxx>
+
+#include <TopoDS.hxx>
+#include <TopExp_Explorer.hxx>
+
+#include <cmath>
+#include <algorithm>
+
+#include "Utils.hxx"
+#include "MeshQueue.hxx"
+#include "MeshRefiner.hxx"
+
+namespace ie
+{
+  //! Time the camera should stay still before refinement (in seconds).
+  static const double THE_STILL_TIME = 0.5;
+
+  //! Maximum number of shapes copied for re-meshing per frame.
+  static const int THE_COPIES_PER_FRAME = 8;
+
+  //! Maximum number of triangulations swapped per frame.
+  static const int THE_SWAPS_PER_FRAME = 4;
+
+  //! Coarsest and finest deflections relative to the shape size.
+  static const double THE_MAX_DEFLECTION = 2.0e-2;
+  static const double THE_MIN_DEFLECTION = 1.0e-4;
+
+  //! Shapes are re-meshed only if deflection changes more than twice.
+  static const double THE_HYSTERESIS = 2.0;
+
+  std::shared_ptr<MeshRefiner> MeshRefiner::myInstance;
+
+  //===========================================================================
+  //function : MeshRefiner
+  //purpose  :
+  //===========================================================================
+  MeshRefiner::MeshRefiner ()
+    : myCameraState (0),
+      myBudget (10000000),
+      myTolerance (1.f),
+      myIsEnabled (false),
+      myToPlan (false),
+      myToStop (false)
+  {
+    //
+  }
+
+  //===========================================================================
+  //function : ~MeshRefiner
+  //purpose  :
+  //===========================================================================
+  MeshRefiner::~MeshRefiner ()
+  {
+    {
+      std::lock_guard<std::mutex> aLock (myMutex);
+
+      myToStop = true;
+    }
+
+    myJobAdded.notify_all ();
+
+    if (myWorker.joinable ())
+    {
+      myWorker.join ();
+    }
+  }
+
+  //===========================================================================
+  //function : GetInstance
+  //purpose  :
+  //===========================================================================
+  MeshRefiner* MeshRefiner::GetInstance ()
+  {
+    if (myInstance == NULL)
+    {
+      myInstance.reset (new MeshRefiner);
+    }
+
+    return myInstance.get ();
+  }
+
+  //===========================================================================
+  //function : SetEnabled
+  //purpose  :
+  //===========================================================================
+  void MeshRefiner::SetEnabled (const bool theToEnable)
+  {
+    myIsEnabled = theToEnable;
+
+    myToPlan = theToEnable;
+
+    if (!theToEnable)
+    {
+      myPlanned.clear ();
+
+      {
+        std::lock_guard<std::mutex> aLock (myMutex);
+
+        myPending.clear ();
+        myFinished.clear ();
+      }
+
+      restoreObjects ();
+    }
+    else if (!myWorker.joinable ())
+    {
+      myWorker = std::thread (&MeshRefiner::performJobs, this);
+    }
+  }
+
+  //===========================================================================
+  //function : NbTriangles
+  //purpose  :
+  //===========================================================================
+  int MeshRefiner::NbTriangles () const
+  {
+    int aNbTriangles = 0;
+
+    for (std::map<const TopoDS_TShape*, Entry>::const_iterator anIter = myEntries.begin (); anIter != myEntries.end (); ++anIter)
+    {
+      aNbTriangles += anIter->second.NbTriangles;
+    }
+
+    return aNbTriangles;
+  }
+
+  //===========================================================================
+  //function : NbJobs
+  //purpose  :
+  //===========================================================================
+  int MeshRefiner::NbJobs ()
+  {
+    std::lock_guard<std::mutex> aLock (myMutex);
+
+    return static_cast<int> (myPlanned.size () + myPending.size () + myFinished.size ());
+  }
+
+  //===========================================================================
+  //function : restoreObjects
+  //purpose  :
+  //===========================================================================
+  void MeshRefiner::restoreObjects ()
+  {
+    Handle (AIS_InteractiveContext) aContext = ViewerTest::GetAISContext ();
+
+    for (std::map<const AIS_Shape*, Original>::iterator anIter = myOriginals.begin (); anIter != myOriginals.end (); ++anIter)
+    {
+      const Handle (Prs3d_Drawer)& aDrawer = anIter->second.Object->Attributes ();
+
+      aDrawer->SetTypeOfDeflection (anIter->second.Type);
+      aDrawer->SetMaximalChordialDeviation (anIter->second.Deviation);
+
+      // Presentation is re-meshed if refined triangulation is too coarse
+      if (!aContext.IsNull () && aContext->IsDisplayed (anIter->second.Object))
+      {
+        model::Redisplay (aContext, anIter->second.Object);
+      }
+    }
+
+    myOriginals.clear ();
+
+    myEntries.clear (); // deflections are changed
+  }
+
+  //===========================================================================
+  //function : attachTriangulation
+  //purpose  :
+  //===========================================================================
+  void MeshRefiner::attachTriangulation (const TopoDS_Shape& theCopy, const TopoDS_Shape& theSource)
+  {
+    BRep_Builder aBuilder;
+
+    // Copy has the same structure, so faces are explored in the same order
+    TopExp_Explorer aCopyExp (theCopy, TopAbs_FACE);
+    TopExp_Explorer aSourceExp (theSource, TopAbs_FACE);
+
+    for (; aCopyExp.More () && aSourceExp.More (); aCopyExp.Next (), aSourceExp.Next ())
+    {
+      TopLoc_Location aLocation;
+
+      const Handle (Poly_Triangulation)& aTriangulation = BRep_Tool::Triangulation (TopoDS::Face (aCopyExp.Current ()), aLocation);
+
+      if (!aTriangulation.IsNull ())
+      {
+        aBuilder.UpdateFace (TopoDS::Face (aSourceExp.Current ()), aTriangulation);
+      }
+    }
+  }
+
+  //===========================================================================
+  //function : countTriangles
+  //purpose  :
+  //===========================================================================
+  int MeshRefiner::countTriangles (const TopoDS_Shape& theShape)
+  {
+    int aNbTriangles = 0;
+
+    for (TopExp_Explorer anExp (theShape, TopAbs_FACE); anExp.More (); anExp.Next ())
+    {
+      TopLoc_Location aLocation;
+
+      const Handle (Poly_Triangulation)& aTriangulation = BRep_Tool::Triangulation (TopoDS::Face (anExp.Current ()), aLocation);
+
+      if (!aTriangulation.IsNull ())
+      {
+        aNbTriangles += aTriangulation->NbTriangles ();
+      }
+    }
+
+    return aNbTriangles;
+  }
+
+  //===========================================================================
+  //function : isSourceDisplayed
+  //purpose  :
+  //===========================================================================
+  bool MeshRefiner::isSourceDisplayed (const Job& theJob)
+  {
+    for (size_t anObjectID = 0; anObjectID < theJob.Objects.size (); ++anObjectID)
+    {
+      if (theJob.Objects[anObjectID]->Shape ().TShape () == theJob.Source.TShape ())
+      {
+        return true;
+      }
+    }
+
+    return false;
+  }
+
+  //===========================================================================
+  //function : performJobs
+  //purpose  :
+  //===========================================================================
+  void MeshRefiner::performJobs ()
+  {
+    for (;;)
+    {
+      JobPtr aJob;
+
+      {
+        std::unique_lock<std::mutex> aLock (myMutex);
+
+        myJobAdded.wait (aLock, [this] { return myToStop || !myPending.empty (); });
+
+        if (myToStop)
+        {
+          return;
+        }
+
+        aJob = myPending.front ();
+
+        myPending.erase (myPending.begin ());
+      }
+
+      // The copy is not referenced by the viewer yet, so faces
+      // can be meshed in parallel without any synchronization
+      try
+      {
+        BRepMesh_IncrementalMesh aMesher (aJob->Copy, aJob->Deflection, Standard_False, aJob->Angle, Standard_True);
+
+        aJob->NbTriangles = countTriangles (aJob->Copy);
+      }
+      catch (Standard_Failure&)
+      {
+        aJob->Copy.Nullify (); // keep current triangulation
+      }
+
+      std::lock_guard<std::mutex> aLock (myMutex);
+
+      myFinished.push_back (aJob);
+    }
+  }
+
+  //===========================================================================
+  //function : updateEntries
+  //purpose  :
+  //===========================================================================
+  void MeshRefiner::updateEntries (const Handle (AIS_InteractiveContext)& theContext)
+  {
+    AIS_ListOfInteractive anObjects;
+
+    theContext->DisplayedObjects (anObjects);
+
+    std::map<const TopoDS_TShape*, Entry> anEntries;
+
+    for (AIS_ListIteratorOfListOfInteractive anIter (anObjects); anIter.More (); anIter.Next ())
+    {
+      Handle (AIS_Shape) anObject = Handle (AIS_Shape)::DownCast (anIter.Value ());
+
+      if (anObject.IsNull () || anObject->Shape ().IsNull () || MeshQueue::GetInstance ()->IsQueued (anObject))
+      {
+        continue;
+      }
+
+      // Only shaded and textured presentations depend on triangulation
+      const int aMode = anObject->HasDisplayMode () ? anObject->DisplayMode () : theContext->DisplayMode ();
+
+      if (aMode == AIS_WireFrame || aMode == MeshQueue::BBOX_MODE)
+      {
+        continue;
+      }
+
+      // Triangulation is stored in TShape, so instances are tracked together
+      const TopoDS_TShape* aKey = anObject->Shape ().TShape ().get ();
+
+      std::map<const TopoDS_TShape*, Entry>::iterator aFound = anEntries.find (aKey);
+
+      if (aFound == anEntries.end ())
+      {
+        std::map<const TopoDS_TShape*, Entry>::iterator anOld = myEntries.find (aKey);
+
+        Entry anEntry;
+
+        if (anOld != myEntries.end ())
+        {
+          anEntry = anOld->second;
+
+          anEntry.Objects.clear ();
+          anEntry.Boxes.clear ();
+        }
+        else
+        {
+          anEntry.Shape       = anObject->Shape ();
+          anEntry.Deflection  = Prs3d::GetDeflection (anEntry.Shape, anObject->Attributes ());
+          anEntry.NbTriangles = countTriangles (anEntry.Shape);
+        }
+
+        if (anEntry.Deflection <= 0.0)
+        {
+          continue;
+        }
+
+        anEntry.Diagonal = 0.0;
+        anEntry.Target   = anEntry.Deflection;
+        anEntry.Size     = 0.f;
+
+        aFound = anEntries.insert (std::make_pair (aKey, anEntry)).first;
+      }
+
+      // Object can be moved since the last check
+      Bnd_Box aBox = anObject->BoundingBox ();
+
+      if (anObject->HasTransformation () && !aBox.IsVoid ())
+      {
+        aBox = aBox.Transformed (anObject->LocalTransformation ());
+      }
+
+      aFound->second.Objects.push_back (anObject);
+      aFound->second.Boxes.push_back (aBox);
+    }
+
+    myEntries.swap (anEntries);
+  }
+
+  //===========================================================================
+  //function : plan
+  //purpose  :
+  //===========================================================================
+  void MeshRefiner::plan (const Handle (Graphic3d_Camera)& theCamera, const int theViewHeight)
+  {
+    for (std::map<const TopoDS_TShape*, Entry>::iterator anIter = myEntries.begin (); anIter != myEntries.end (); ++anIter)
+    {
+      Entry& anEntry = anIter->second;
+
+      anEntry.Diagonal = 0.0;
+      anEntry.Size     = 0.f;
+
+      // Shared triangulation should fit the instance which is the largest on the screen
+      for (size_t aBoxID = 0; aBoxID < anEntry.Boxes.size (); ++aBoxID)
+      {
+        const Bnd_Box& aBox = anEntry.Boxes[aBoxID];
+
+        if (aBox.IsVoid ())
+        {
+          continue;
+        }
+
+        // Projected extent of the shape in pixels (NDC range is 2)
+        const float aSize = std::sqrt (MeshQueue::ProjectedSize (aBox, theCamera)) * theViewHeight * 0.5f;
+
+        if (anEntry.Diagonal <= 0.0 || aSize > anEntry.Size)
+        {
+          anEntry.Diagonal = std::sqrt (aBox.SquareExtent ());
+          anEntry.Size     = aSize;
+        }
+      }
+
+      if (anEntry.Diagonal <= 0.0)
+      {
+        continue;
+      }
+
+      if (anEntry.Size > 0.f)
+      {
+        anEntry.Target = std::max (anEntry.Diagonal * THE_MIN_DEFLECTION,
+                         std::min (anEntry.Diagonal * THE_MAX_DEFLECTION, myTolerance * anEntry.Diagonal / anEntry.Size));
+      }
+      else
+      {
+        anEntry.Target = anEntry.Diagonal * THE_MAX_DEFLECTION; // shape is out of the screen
+      }
+    }
+
+    // Number of triangles is assumed to be inversely proportional
+    // to the deflection, so all deflections are scaled uniformly
+    for (int anIteration = 0; anIteration < 4; ++anIteration)
+    {
+      double aNbTriangles = 0.0;
+
+      for (std::map<const TopoDS_TShape*, Entry>::iterator anIter = myEntries.begin (); anIter != myEntries.end (); ++anIter)
+      {
+        aNbTriangles += anIter->second.NbTriangles * anIter->second.Deflection / anIter->second.Target;
+      }
+
+      if (aNbTriangles <= myBudget)
+      {
+        break;
+      }
+
+      const double aScale = aNbTriangles / std::max (myBudget, 1);
+
+      for (std::map<const TopoDS_TShape*, Entry>::iterator anIter = myEntries.begin (); anIter != myEntries.end (); ++anIter)
+      {
+        Entry& anEntry = anIter->second;
+
+        if (anEntry.Diagonal > 0.0)
+        {
+          anEntry.Target = std::min (anEntry.Target * aScale, anEntry.Diagonal * THE_MAX_DEFLECTION);
+        }
+      }
+    }
+
+    std::vector<const Entry*> aChanged;
+
+    for (std::map<const TopoDS_TShape*, Entry>::iterator anIter = myEntries.begin (); anIter != myEntries.end (); ++anIter)
+    {
+      const double aRatio = anIter->second.Target / anIter->second.Deflection;
+
+      if (aRatio > THE_HYSTERESIS || aRatio < 1.0 / THE_HYSTERESIS)
+      {
+        aChanged.push_back (&anIter->second);
+      }
+    }
+
+    // Shapes which are larger on the screen are re-meshed first
+    std::sort (aChanged.begin (), aChanged.end (), [] (const Entry* theEntry1, const Entry* theEntry2) { return theEntry1->Size > theEntry2->Size; });
+
+    {
+      std::lock_guard<std::mutex> aLock (myMutex);
+
+      myPending.clear (); // discard jobs planned for previous view
+    }
+
+    myPlanned.clear ();
+
+    for (size_t anEntryID = 0; anEntryID < aChanged.size (); ++anEntryID)
+    {
+      JobPtr aJob (new Job);
+
+      aJob->Objects     = aChanged[anEntryID]->Objects;
+      aJob->Source      = aChanged[anEntryID]->Shape;
+      aJob->Deflection  = aChanged[anEntryID]->Target;
+      aJob->Angle       = aChanged[anEntryID]->Objects.front ()->Attributes ()->DeviationAngle ();
+      aJob->NbTriangles = 0;
+
+      for (size_t anObjectID = 1; anObjectID < aJob->Objects.size (); ++anObjectID)
+      {
+        aJob->Angle = std::min (aJob->Angle, aJob->Objects[anObjectID]->Attributes ()->DeviationAngle ());
+      }
+
+      myPlanned.push_back (aJob);
+    }
+  }
+
+  //===========================================================================
+  //function : Update
+  //purpose  :
+  //===========================================================================
+  bool MeshRefiner::Update (const Handle (Graphic3d_Camera)& theCamera, const int theViewHeight)
+  {
+    Handle (AIS_InteractiveContext) aContext = ViewerTest::GetAISContext ();
+
+    if (!myIsEnabled || theCamera.IsNull () || aContext.IsNull ())
+    {
+      return false;
+    }
+
+    if (myCameraState != theCamera->WorldViewState ())
+    {
+      myCameraState = theCamera->WorldViewState ();
+
+      myStillTimer.Reset ();
+      myStillTimer.Start ();
+
+      myToPlan = true;
+    }
+
+    // Shapes being meshed by tessellation queue are not safe to copy
+    const bool isQueueEmpty = MeshQueue::GetInstance ()->NbQueued () == 0;
+
+    if (myToPlan && isQueueEmpty && myStillTimer.ElapsedTime () > THE_STILL_TIME)
+    {
+      updateEntries (aContext);
+
+      plan (theCamera, theViewHeight);
+
+      myToPlan = false;
+    }
+
+    // Topology is copied in the main thread, since the viewer
+    // may access the shapes (only new copies are meshed)
+    for (int aCopyID = 0; aCopyID < THE_COPIES_PER_FRAME && isQueueEmpty && !myPlanned.empty (); ++aCopyID)
+    {
+      JobPtr aJob = myPlanned.front ();
+
+      myPlanned.erase (myPlanned.begin ());
+
+      if (!isSourceDisplayed (*aJob))
+      {
+        continue; // shape was replaced
+      }
+
+      BRepBuilderAPI_Copy aCopier (aJob->Source, Standard_False /* geometry */, Standard_False /* mesh */);
+
+      aJob->Copy = aCopier.Shape ();
+
+      {
+        std::lock_guard<std::mutex> aLock (myMutex);
+
+        myPending.push_back (aJob);
+      }
+
+      myJobAdded.notify_one ();
+    }
+
+    std::vector<JobPtr> aFinished;
+
+    // Faces of the source shape should not be meshed by the queue at swap
+    if (isQueueEmpty)
+    {
+      std::lock_guard<std::mutex> aLock (myMutex);
+
+      const size_t aNbSwaps = std::min (myFinished.size (), static_cast<size_t> (THE_SWAPS_PER_FRAME));
+
+      aFinished.assign (myFinished.begin (), myFinished.begin () + aNbSwaps);
+
+      myFinished.erase (myFinished.begin (), myFinished.begin () + aNbSwaps);
+    }
+
+    bool isChanged = false;
+
+    for (size_t aJobID = 0; aJobID < aFinished.size (); ++aJobID)
+    {
+      const JobPtr& aJob = aFinished[aJobID];
+
+      if (aJob->Copy.IsNull () || !isSourceDisplayed (*aJob))
+      {
+        continue;
+      }
+
+      // The shape itself is kept (TShapes may be shared by instances)
+      attachTriangulation (aJob->Copy, aJob->Source);
+
+      // All instances sharing the triangulation are updated
+      for (size_t anObjectID = 0; anObjectID < aJob->Objects.size (); ++anObjectID)
+      {
+        const Handle (AIS_Shape)& anObject = aJob->Objects[anObjectID];
+
+        if (anObject->Shape ().TShape () != aJob->Source.TShape ())
+        {
+          continue;
+        }
+
+        // Absolute deflection of the object prevents re-meshing on display
+        const Handle (Prs3d_Drawer)& aDrawer = anObject->Attributes ();
+
+        if (myOriginals.find (anObject.get ()) == myOriginals.end ())
+        {
+          Original anOriginal;
+
+          anOriginal.Object    = anObject;
+          anOriginal.Type      = aDrawer->TypeOfDeflection ();
+          anOriginal.Deviation = aDrawer->MaximalChordialDeviation ();
+
+          myOriginals[anObject.get ()] = anOriginal;
+        }
+
+        aDrawer->SetTypeOfDeflection (Aspect_TOD_ABSOLUTE);
+        aDrawer->SetMaximalChordialDeviation (aJob->Deflection);
+
+        model::Redisplay (aContext, anObject);
+
+        aContext->RecomputeSelectionOnly (anObject);
+      }
+
+      std::map<const TopoDS_TShape*, Entry>::iterator anEntry = myEntries.find (aJob->Source.TShape ().get ());
+
+      if (anEntry != myEntries.end ())
+      {
+        anEntry->second.Deflection  = aJob->Deflection;
+        anEntry->second.NbTriangles = aJob->NbTriangles;
+      }
+
+      isChanged = true;
+    }
+
+    return isChanged;
+  }
+}
@@ -0,0 +1,199 @@
+// Created: 2019-06-26
+//
+// Copyright (c) 2019 OPEN CASCADE SAS
+//
+// This file is a part of CADRays software.
+//
+// CADRays is free software; you can use it under the terms of the MIT license,
+// refer to file LICENSE.txt for complete text of the license and disclaimer of
+// any warranty.
+
+#ifndef _RT_MeshRefiner_Header
+#define _RT_MeshRefiner_Header
+
+#include <AIS_Shape.hxx>
+#include <Graphic3d_Camera.hxx>
+
+#include <OSD_Timer.hxx>
+
+#include <map>
+#include <mutex>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <condition_variable>
+
+namespace ie
+{
+  //! Service for view-dependent tessellation of displayed CAD shapes.
+  //! When the camera stops, deflection of each shape is chosen from its
+  //! projected size (scaled to fit the global triangle budget) and shapes
+  //! are re-meshed in background. Each shape is meshed as a copy of its
+  //! topology, so the triangulation in use is never modified by the worker.
+  //! Resulting triangulation is attached to faces of the original shape in
+  //! the main thread (so instancing and shapes of DRAW variables are kept).
+  //! Triangulation is stored in TShape, so instances sharing it are planned
+  //! together using the largest projected size among them.
+  class MeshRefiner
+  {
+  public:
+
+    //! Returns the instance of refinement service.
+    static Standard_EXPORT MeshRefiner* GetInstance ();
+
+    //! Stops worker thread (pending jobs are discarded).
+    Standard_EXPORT ~MeshRefiner ();
+
+  public:
+
+    //! Checks whether view-dependent refinement is enabled.
+    bool IsEnabled () const { return myIsEnabled; }
+
+    //! Enables or disables view-dependent refinement.
+    Standard_EXPORT void SetEnabled (const bool theToEnable);
+
+    //! Returns global triangle budget.
+    int Budget () const { return myBudget; }
+
+    //! Sets global triangle budget.
+    void SetBudget (const int theBudget) { myBudget = theBudget; myToPlan = true; }
+
+    //! Returns allowed deflection in pixels.
+    float Tolerance () const { return myTolerance; }
+
+    //! Sets allowed deflection in pixels.
+    void SetTolerance (const float theTolerance) { myTolerance = theTolerance; myToPlan = true; }
+
+    //! Returns number of triangles of tracked shapes.
+    Standard_EXPORT int NbTriangles () const;
+
+    //! Returns number of jobs waiting for re-meshing or swap.
+    Standard_EXPORT int NbJobs ();
+
+    //! Checks whether refinement is to be planned once the camera stops.
+    bool IsPlanning () const { return myIsEnabled && myToPlan; }
+
+  public:
+
+    //! Plans refinement when the camera stops and swaps triangulations of
+    //! re-meshed shapes. Should be called from the main thread (each frame).
+    //! Returns true if some presentation was changed.
+    Standard_EXPORT bool Update (const Handle (Graphic3d_Camera)& theCamera, const int theViewHeight);
+
+  protected:
+
+    //! Unique shape (TShape) tracked by the service.
+    struct Entry
+    {
+      std::vector<Handle (AIS_Shape)> Objects;     //!< Displayed objects sharing the shape
+      std::vector<Bnd_Box>            Boxes;       //!< Bounding boxes of objects in world space
+      TopoDS_Shape                    Shape;       //!< Shape at the time of last check
+      double                          Diagonal;    //!< Diagonal of the largest projected box
+      double                          Deflection;  //!< Current linear deflection
+      double                          Target;      //!< Planned linear deflection
+      int                             NbTriangles; //!< Current number of triangles
+      float                           Size;        //!< Largest projected size (in pixels)
+    };
+
+    //! Deflection parameters of the object before refinement.
+    struct Original
+    {
+      Handle (AIS_Shape)      Object;    //!< Refined object
+      Aspect_TypeOfDeflection Type;      //!< Type of deflection
+      double                  Deviation; //!< Maximal chordial deviation
+    };
+
+    //! Re-meshing job.
+    struct Job
+    {
+      std::vector<Handle (AIS_Shape)> Objects;     //!< Objects to update
+      TopoDS_Shape                    Source;      //!< Shared shape when job was created
+      TopoDS_Shape                    Copy;        //!< Copy of the shape to mesh
+      double                          Deflection;  //!< Linear deflection
+      double                          Angle;       //!< Angular deflection
+      int                             NbTriangles; //!< Resulting number of triangles
+    };
+
+    typedef std::shared_ptr<Job> JobPtr;
+
+  protected:
+
+    //! Creates new refinement service.
+    MeshRefiner ();
+
+    //! Synchronizes tracked entries with displayed objects.
+    void updateEntries (const Handle (AIS_InteractiveContext)& theContext);
+
+    //! Chooses deflections of tracked shapes and schedules jobs.
+    void plan (const Handle (Graphic3d_Camera)& theCamera, const int theViewHeight);
+
+    //! Re-meshes scheduled shapes (worker thread function).
+    void performJobs ();
+
+    //! Attaches triangulation of the meshed copy to faces of the source shape.
+    static void attachTriangulation (const TopoDS_Shape& theCopy, const TopoDS_Shape& theSource);
+
+    //! Restores deflection parameters of refined objects and re-displays them.
+    void restoreObjects ();
+
+    //! Returns number of triangles in the given shape.
+    static int countTriangles (const TopoDS_Shape& theShape);
+
+    //! Checks whether some object of the job still displays its source shape.
+    static bool isSourceDisplayed (const Job& theJob);
+
+  protected:
+
+    //! Tracked shapes (by TShape).
+    std::map<const TopoDS_TShape*, Entry> myEntries;
+
+    //! Deflection parameters of refined objects (restored on disabling).
+    std::map<const AIS_Shape*, Original> myOriginals;
+
+    //! Jobs waiting for copying of the shape (main thread).
+    std::vector<JobPtr> myPlanned;
+
+    //! Jobs waiting for re-meshing.
+    std::vector<JobPtr> myPending;
+
+    //! Re-meshed jobs waiting for swap.
+    std::vector<JobPtr> myFinished;
+
+    //! Worker thread.
+    std::thread myWorker;
+
+    //! Guards pending and finished jobs.
+    std::mutex myMutex;
+
+    //! Notifies worker about new jobs.
+    std::condition_variable myJobAdded;
+
+    //! Measures time since last camera change.
+    OSD_Timer myStillTimer;
+
+    //! Camera state at last change.
+    Standard_Size myCameraState;
+
+    //! Global triangle budget.
+    int myBudget;
+
+    //! Allowed deflection (in pixels).
+    float myTolerance;
+
+    //! Set when refinement is enabled.
+    bool myIsEnabled;
+
+    //! Set when refinement should be re-planned.
+    bool myToPlan;
+
+    //! Set when worker thread should stop.
+    bool myToStop;
+
+  private:
+
+    //! Instance of refinement service.
+    static std::shared_ptr<MeshRefiner> myInstance;
+  };
+}
+
+#endif // _RT_MeshRefiner_Header
@@ -0,0 +1,430 @@
+// Created: 2019-06-17
+//
+// Copyright (c) 2019 OPEN CASCADE SAS
+//
+// This file is a part of CADRays software.
+//
+// CADRays is free software; you can use it under the terms of the MIT license,
+// refer to file LICENSE.txt for complete text of the license and disclaimer of
+// any warranty.
+
+#include <BinTools.hxx>
+#include <BRepTools.hxx>
+#include <BRep_Builder.hxx>
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+#ifdef HAVE_ZLIB
+  #include <zlib.h>
+#endif
+
+#include "ShapeIO.hxx"
+
+namespace ie
+{
+  //! Signature of binary BREP files (written by BinTools).
+  static const char THE_BINARY_SIGNATURE[] = "Open CASCADE Topology";
+
+#ifdef HAVE_ZLIB
+
+  //! Output stream buffer compressing data with zlib (GZIP format).
+  class GzOutBuffer : public std::streambuf
+  {
+  public:
+
+    //! Creates stream buffer for the given GZIP file.
+    GzOutBuffer (gzFile theFile) : myFile (theFile), myNbWritten (0)
+    {
+      setp (myBuffer, myBuffer + sizeof (myBuffer));
+    }
+
+    //! Flushes remaining data.
+    ~GzOutBuffer ()
+    {
+      sync ();
+    }
+
+  protected:
+
+    //! Compresses buffered data.
+    virtual int sync ()
+    {
+      const int aSize = static_cast<int> (pptr () - pbase ());
+
+      if (aSize > 0 && gzwrite (myFile, pbase (), aSize) != aSize)
+      {
+        return -1;
+      }
+
+      myNbWritten += aSize;
+
+      setp (myBuffer, myBuffer + sizeof (myBuffer));
+
+      return 0;
+    }
+
+    //! Flushes full buffer.
+    virtual int_type overflow (int_type theChar)
+    {
+      if (sync () != 0)
+      {
+        return traits_type::eof ();
+      }
+
+      if (!traits_type::eq_int_type (theChar, traits_type::eof ()))
+      {
+        *pptr () = traits_type::to_char_type (theChar);
+
+        pbump (1);
+      }
+
+      return traits_type::not_eof (theChar);
+    }
+
+    //! Supports only position query (required by some OCCT writers).
+    virtual pos_type seekoff (off_type theOffset, std::ios_base::seekdir theDir, std::ios_base::openmode /*theMode*/)
+    {
+      if (theOffset != 0 || theDir != std::ios_base::cur)
+      {
+        return pos_type (off_type (-1));
+      }
+
+      return pos_type (myNbWritten + (pptr () - pbase ()));
+    }
+
+  private:
+
+    gzFile myFile;
+
+    off_type myNbWritten;
+
+    char myBuffer[1 << 16];
+  };
+
+  //! Input stream buffer decompressing data with zlib (also reads uncompressed files).
+  class GzInBuffer : public std::streambuf
+  {
+  public:
+
+    //! Creates stream buffer for the given GZIP file.
+    GzInBuffer (gzFile theFile) : myFile (theFile), myNbRead (0), myHasFailed (false)
+    {
+      setg (myBuffer, myBuffer, myBuffer);
+    }
+
+    //! Checks if decompression failed (e.g. the file is truncated).
+    bool HasFailed () const { return myHasFailed; }
+
+  protected:
+
+    //! Decompresses next block of data.
+    virtual int_type underflow ()
+    {
+      if (gptr () < egptr ())
+      {
+        return traits_type::to_int_type (*gptr ());
+      }
+
+      const int aSize = gzread (myFile, myBuffer, sizeof (myBuffer));
+
+      if (aSize <= 0)
+      {
+        myHasFailed = aSize < 0;
+
+        return traits_type::eof ();
+      }
+
+      myNbRead += aSize;
+
+      setg (myBuffer, myBuffer, myBuffer + aSize);
+
+      return traits_type::to_int_type (*gptr ());
+    }
+
+    //! Supports only position query (required by some OCCT readers).
+    virtual pos_type seekoff (off_type theOffset, std::ios_base::seekdir theDir, std::ios_base::openmode /*theMode*/)
+    {
+      if (theOffset != 0 || theDir != std::ios_base::cur)
+      {
+        return pos_type (off_type (-1));
+      }
+
+      return pos_type (myNbRead - (egptr () - gptr ()));
+    }
+
+  private:
+
+    gzFile myFile;
+
+    off_type myNbRead;
+
+    bool myHasFailed;
+
+    char myBuffer[1 << 16];
+  };
+
+#endif
+
+  //===========================================================================
+  //function : readShape
+  //purpose  : Reads binary or ASCII BREP shape from the stream
+  //===========================================================================
+  static bool readShape (std::istream& theStream, const bool isBinary, TopoDS_Shape& theShape)
+  {
+    try
+    {
+      if (isBinary)
+      {
+        BinTools::Read (theShape, theStream);
+      }
+      else // old-style ASCII BREP file
+      {
+        BRep_Builder aBuilder;
+
+        BRepTools::Read (theShape, theStream, aBuilder);
+      }
+    }
+    catch (Standard_Failure const&)
+    {
+      return false;
+    }
+
+    return !theShape.IsNull ();
+  }
+
+  //===========================================================================
+  //function : HasCompression
+  //purpose  :
+  //===========================================================================
+  bool ShapeIO::HasCompression ()
+  {
+#ifdef HAVE_ZLIB
+    return true;
+#else
+    return false;
+#endif
+  }
+
+  //===========================================================================
+  //function : Write
+  //purpose  :
+  //===========================================================================
+  bool ShapeIO::Write (const TopoDS_Shape& theShape, const TCollection_AsciiString& theFileName, const bool theToCompress)
+  {
+#ifdef HAVE_ZLIB
+    if (theToCompress)
+    {
+      gzFile aFile = gzopen (theFileName.ToCString (), "wb");
+
+      if (aFile == NULL)
+      {
+        return false;
+      }
+
+      bool isDone = true;
+
+      {
+        GzOutBuffer aBuffer (aFile);
+
+        std::ostream aStream (&aBuffer);
+
+        BinTools::Write (theShape, aStream);
+
+        isDone = aStream.flush ().good ();
+      }
+
+      return gzclose (aFile) == Z_OK && isDone;
+    }
+#else
+    if (theToCompress)
+    {
+      std::cout << "Warning: Compression is not supported, shape is stored uncompressed" << std::endl;
+    }
+#endif
+
+    std::ofstream aStream (theFileName.ToCString (), std::ios_base::out | std::ios_base::binary);
+
+    if (!aStream.is_open ())
+    {
+      return false;
+    }
+
+    BinTools::Write (theShape, aStream);
+
+    return aStream.good ();
+  }
+
+  //===========================================================================
+  //function : Read
+  //purpose  :
+  //===========================================================================
+  bool ShapeIO::Read (const TCollection_AsciiString& theFileName, TopoDS_Shape& theShape)
+  {
+    // Shape is parsed directly from the file (large files are not buffered in memory)
+    char aSignature[sizeof (THE_BINARY_SIGNATURE) - 1] = {};
+
+#ifdef HAVE_ZLIB
+    // GZIP reader transparently handles uncompressed files
+    gzFile aFile = gzopen (theFileName.ToCString (), "rb");
+
+    if (aFile == NULL)
+    {
+      return false;
+    }
+
+    const bool isBinary = gzread (aFile, aSignature, sizeof (aSignature)) == static_cast<int> (sizeof (aSignature))
+                       && memcmp (aSignature, THE_BINARY_SIGNATURE, sizeof (aSignature)) == 0;
+
+    if (gzrewind (aFile) != 0)
+    {
+      gzclose (aFile);
+
+      return false;
+    }
+
+    bool isDone = true;
+
+    {
+      GzInBuffer aBuffer (aFile);
+
+      std::istream aStream (&aBuffer);
+
+      isDone = readShape (aStream, isBinary, theShape) && !aBuffer.HasFailed ();
+    }
+
+    return gzclose (aFile) == Z_OK && isDone;
+#else
+    std::ifstream aStream (theFileName.ToCString (), std::ios_base::in | std::ios_base::binary);
+
+    if (!aStream.is_open ())
+    {
+      return false;
+    }
+
+    aStream.read (aSignature, sizeof (aSignature));
+
+    if (aStream.gcount () > 1
+     && static_cast<unsigned char> (aSignature[0]) == 0x1f
+     && static_cast<unsigned char> (aSignature[1]) == 0x8b)
+    {
+      std::cout << "Error: File " << theFileName << " is compressed, but compression is not supported" << std::endl;
+
+      return false;
+    }
+
+    const bool isBinary = aStream.gcount () == static_cast<std::streamsize> (sizeof (aSignature))
+                       && memcmp (aSignature, THE_BINARY_SIGNATURE, sizeof (aSignature)) == 0;
+
+    aStream.clear ();
+    aStream.seekg (0, std::ios_base::beg);
+
+    return readShape (aStream, isBinary, theShape);
+#endif
+  }
+
+  //===========================================================================
+  //function : WriteData
+  //purpose  :
+  //===========================================================================
+  bool ShapeIO::WriteData (const TCollection_AsciiString& theFileName, const std::string& theData, const bool theToCompress)
+  {
+#ifdef HAVE_ZLIB
+    if (theToCompress)
+    {
+      gzFile aFile = gzopen (theFileName.ToCString (), "wb");
+
+      if (aFile == NULL)
+      {
+        return false;
+      }
+
+      const bool isDone = theData.empty ()
+                       || gzwrite (aFile, theData.data (), static_cast<unsigned> (theData.size ())) == static_cast<int> (theData.size ());
+
+      return gzclose (aFile) == Z_OK && isDone;
+    }
+#else
+    (void )theToCompress;
+#endif
+
+    std::ofstream aStream (theFileName.ToCString (), std::ios_base::out | std::ios_base::binary);
+
+    if (!aStream.is_open ())
+    {
+      return false;
+    }
+
+    aStream.write (theData.data (), theData.size ());
+
+    return aStream.good ();
+  }
+
+  //===========================================================================
+  //function : ReadData
+  //purpose  :
+  //===========================================================================
+  bool ShapeIO::ReadData (const TCollection_AsciiString& theFileName, std::string& theData)
+  {
+    theData.clear ();
+
+#ifdef HAVE_ZLIB
+    // GZIP reader transparently handles uncompressed files
+    gzFile aFile = gzopen (theFileName.ToCString (), "rb");
+
+    if (aFile == NULL)
+    {
+      return false;
+    }
+
+    char aBuffer[1 << 16];
+
+    int aSize = 0;
+
+    while ((aSize = gzread (aFile, aBuffer, sizeof (aBuffer))) > 0)
+    {
+      theData.append (aBuffer, aSize);
+    }
+
+    return gzclose (aFile) == Z_OK && aSize == 0;
+#else
+    std::ifstream aStream (theFileName.ToCString (), std::ios_base::in | std::ios_base::binary);
+
+    if (!aStream.is_open ())
+    {
+      return false;
+    }
+
+    aStream.seekg (0, std::ios_base::end);
+
+    const std::streamoff aSize = aStream.tellg ();
+
+    // Size is not available for some streams (e.g. special files)
+    if (aSize == -1 || !aStream.seekg (0, std::ios_base::beg))
+    {
+      return false;
+    }
+
+    theData.resize (static_cast<size_t> (aSize));
+
+    if (!theData.empty () && !aStream.read (&theData[0], theData.size ()))
+    {
+      theData.clear ();
+
+      return false;
+    }
+
+    if (theData.size () > 1
+     && static_cast<unsigned char> (theData[0]) == 0x1f
+     && static_cast<unsigned char> (theData[1]) == 0x8b)
+    {
+      std::cout << "Error: File " << theFileName << " is compressed, but compression is not supported" << std::endl;
+
+      return false;
+    }
+
+    return true;
+#endif
+  }
+}
@@ -0,0 +1,49 @@
+// Created: 2019-06-17
+//
+// Copyright (c) 2019 OPEN CASCADE SAS
+//
+// This file is a part of CADRays software.
+//
+// CADRays is free software; you can use it under the terms of the MIT license,
+// refer to file LICENSE.txt for complete text of the license and disclaimer of
+// any warranty.
+
+#ifndef _RT_ShapeIO_Header
+#define _RT_ShapeIO_Header
+
+#include <TopoDS_Shape.hxx>
+#include <TCollection_AsciiString.hxx>
+
+#include <string>
+
+namespace ie
+{
+  //! Tool class for fast (binary) shape serialization with optional compression.
+  class ShapeIO
+  {
+  public:
+
+    //! Checks if compression of output files is supported (built with zlib).
+    Standard_EXPORT static bool HasCompression ();
+
+    //! Writes shape in binary BREP format (compressed if requested and supported).
+    Standard_EXPORT static bool Write (const TopoDS_Shape&            theShape,
+                                       const TCollection_AsciiString& theFileName,
+                                       const bool                     theToCompress = false);
+
+    //! Reads shape from binary or ASCII BREP file (compressed or not).
+    Standard_EXPORT static bool Read (const TCollection_AsciiString& theFileName, TopoDS_Shape& theShape);
+
+  public:
+
+    //! Writes raw data to the file (compressed if requested and supported).
+    Standard_EXPORT static bool WriteData (const TCollection_AsciiString& theFileName,
+                                           const std::string&             theData,
+                                           const bool                     theToCompress = false);
+
+    //! Reads raw data from the file (compressed or not).
+    Standard_EXPORT static bool ReadData (const TCollection_AsciiString& theFileName, std::string& theData);
+  };
+}
+
+#endif // _RT_ShapeIO_Header
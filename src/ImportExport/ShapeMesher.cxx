@@ -0,0 +1,163 @@
+// Created: 2019-06-24
+//
+// Copyright (c) 2019 OPEN CASCADE SAS
+//
+// This file is a part of CADRays software.
+//
+// CADRays is free software; you can use it under the terms of the MIT license,
+// refer to file LICENSE.txt for complete text of the license and disclaimer of
+// any warranty.
+
+#include <Prs3d.hxx>
+
+#include <BRep_Tool.hxx>
+#include <BRep_Builder.hxx>
+#include <BRepMesh_IncrementalMesh.hxx>
+#include <Poly_Triangulation.hxx>
+
+#include <TopoDS.hxx>
+#include <TopoDS_Compound.hxx>
+#include <TopoDS_Iterator.hxx>
+#include <TopExp_Explorer.hxx>
+
+#include <OSD_Timer.hxx>
+
+#include <algorithm>
+
+#include "ShapeMesher.hxx"
+
+namespace ie
+{
+  //! Number of batches to report tessellation progress.
+  static const int THE_NB_BATCHES = 32;
+
+  //===========================================================================
+  //function : ShapeMesher
+  //purpose  :
+  //===========================================================================
+  ShapeMesher::ShapeMesher (const TopoDS_Shape& theShape, const Handle (Prs3d_Drawer)& theDrawer)
+    : myLinDeflection (0.0),
+      myAngDeflection (theDrawer->DeviationAngle ()),
+      myNbFaces (0),
+      myNbFacesDone (0),
+      myNbTriangles (0),
+      myElapsedTime (0.0)
+  {
+    // Local drawer keeps shared one untouched (deflection is cached in drawer)
+    Handle (Prs3d_Drawer) aDrawer = new Prs3d_Drawer;
+
+    aDrawer->Link (theDrawer);
+
+    myLinDeflection = Prs3d::GetDeflection (theShape, aDrawer);
+
+    for (TopExp_Explorer anExp (theShape, TopAbs_FACE); anExp.More (); anExp.Next ())
+    {
+      ++myNbFaces;
+    }
+
+    addBatches (theShape);
+  }
+
+  //===========================================================================
+  //function : addBatches
+  //purpose  :
+  //===========================================================================
+  void ShapeMesher::addBatches (const TopoDS_Shape& theShape)
+  {
+    const int aBatchSize = std::max (1, myNbFaces / THE_NB_BATCHES);
+
+    std::vector<TopoDS_Shape> aStack (1, theShape);
+
+    BRep_Builder aBuilder;
+
+    TopoDS_Compound aBatch;
+
+    int aNbBatchFaces = 0;
+
+    while (!aStack.empty ())
+    {
+      const TopoDS_Shape aShape = aStack.back ();
+
+      aStack.pop_back ();
+
+      if (aShape.ShapeType () == TopAbs_COMPOUND)
+      {
+        std::vector<TopoDS_Shape> aSubShapes;
+
+        for (TopoDS_Iterator anIter (aShape); anIter.More (); anIter.Next ())
+        {
+          aSubShapes.push_back (anIter.Value ());
+        }
+
+        aStack.insert (aStack.end (), aSubShapes.rbegin (), aSubShapes.rend ()); // keep original order
+
+        continue;
+      }
+
+      if (aNbBatchFaces == 0)
+      {
+        aBuilder.MakeCompound (aBatch);
+      }
+
+      aBuilder.Add (aBatch, aShape);
+
+      for (TopExp_Explorer anExp (aShape, TopAbs_FACE); anExp.More (); anExp.Next ())
+      {
+        ++aNbBatchFaces;
+      }
+
+      if (aNbBatchFaces >= aBatchSize)
+      {
+        myBatches.push_back (aBatch);
+        myBatchFaces.push_back (aNbBatchFaces);
+
+        aNbBatchFaces = 0;
+      }
+    }
+
+    if (aNbBatchFaces > 0)
+    {
+      myBatches.push_back (aBatch);
+      myBatchFaces.push_back (aNbBatchFaces);
+    }
+  }
+
+  //===========================================================================
+  //function : Perform
+  //purpose  :
+  //===========================================================================
+  void ShapeMesher::Perform ()
+  {
+    OSD_Timer aTimer;
+
+    aTimer.Start ();
+
+    // Batches may share edges, so they are processed one after another,
+    // while faces of each batch are meshed concurrently by BRepMesh
+    for (size_t aBatchID = 0; aBatchID < myBatches.size (); ++aBatchID)
+    {
+      BRepMesh_IncrementalMesh aMesher (myBatches[aBatchID], myLinDeflection, Standard_False, myAngDeflection, Standard_True);
+
+      myNbFacesDone += myBatchFaces[aBatchID];
+    }
+
+    myElapsedTime = aTimer.ElapsedTime ();
+
+    myNbTriangles = 0;
+
+    for (size_t aBatchID = 0; aBatchID < myBatches.size (); ++aBatchID)
+    {
+      for (TopExp_Explorer anExp (myBatches[aBatchID], TopAbs_FACE); anExp.More (); anExp.Next ())
+      {
+        TopLoc_Location aLocation;
+
+        const Handle (Poly_Triangulation)& aTriangulation = BRep_Tool::Triangulation (TopoDS::Face (anExp.Current ()), aLocation);
+
+        if (!aTriangulation.IsNull ())
+        {
+          myNbTriangles += aTriangulation->NbTriangles ();
+        }
+      }
+    }
+  }
+}
@@ -0,0 +1,89 @@
+// Created: 2019-06-24
+//
+// Copyright (c) 2019 OPEN CASCADE SAS
+//
+// This file is a part of CADRays software.
+//
+// CADRays is free software; you can use it under the terms of the MIT license,
+// refer to file LICENSE.txt for complete text of the license and disclaimer of
+// any warranty.
+
+#ifndef _RT_ShapeMesher_Header
+#define _RT_ShapeMesher_Header
+
+#include <TopoDS_Shape.hxx>
+#include <Prs3d_Drawer.hxx>
+
+#include <atomic>
+#include <vector>
+
+namespace ie
+{
+  //! Tool class for import-time tessellation of CAD shape in parallel mode.
+  //! Deflection is derived from the shape size in the same way as AIS does,
+  //! so the triangulation is reused (not re-computed) on display.
+  class ShapeMesher
+  {
+  public:
+
+    //! Creates mesher for the given shape and presentation parameters.
+    //! Should be called from the main thread (reads shared drawer).
+    Standard_EXPORT ShapeMesher (const TopoDS_Shape& theShape, const Handle (Prs3d_Drawer)& theDrawer);
+
+    //! Performs tessellation (can be called from a worker thread).
+    Standard_EXPORT void Perform ();
+
+  public:
+
+    //! Returns linear deflection used for tessellation.
+    double LinearDeflection () const { return myLinDeflection; }
+
+    //! Returns angular deflection used for tessellation (in radians).
+    double AngularDeflection () const { return myAngDeflection; }
+
+    //! Returns total number of faces to tessellate.
+    int NbFaces () const { return myNbFaces; }
+
+    //! Returns number of faces tessellated so far (safe to call from any thread).
+    int NbFacesDone () const { return myNbFacesDone; }
+
+    //! Returns number of triangles produced (valid after tessellation).
+    int NbTriangles () const { return myNbTriangles; }
+
+    //! Returns tessellation time (in seconds).
+    double ElapsedTime () const { return myElapsedTime; }
+
+  protected:
+
+    //! Splits the shape into batches of top-level sub-shapes.
+    void addBatches (const TopoDS_Shape& theShape);
+
+  protected:
+
+    //! Batches of sub-shapes meshed one after another (each in parallel mode).
+    std::vector<TopoDS_Shape> myBatches;
+
+    //! Number of faces in each batch.
+    std::vector<int> myBatchFaces;
+
+    //! Linear deflection.
+    double myLinDeflection;
+
+    //! Angular deflection.
+    double myAngDeflection;
+
+    //! Total number of faces.
+    int myNbFaces;
+
+    //! Number of faces tessellated so far.
+    std::atomic<int> myNbFacesDone;
+
+    //! Number of produced triangles.
+    int myNbTriangles;
+
+    //! Tessellation time.
+    double myElapsedTime;
+  };
+}
+
+#endif // _RT_ShapeMesher_Header
@@ -0,0 +1,287 @@
+// Created: 2019-06-28
+//
+// Copyright (c) 2019 OPEN CASCADE SAS
+//
+// This file is a part of CADRays software.
+//
+// CADRays is free software; you can use it under the terms of the MIT license,
+// refer to file LICENSE.txt for complete text of the license and disclaimer of
+// any warranty.
+
+#include <AIS_Shape.hxx>
+
+#include <BRep_Builder.hxx>
+#include <TopoDS_Compound.hxx>
+
+#include <TDF_Label.hxx>
+#include <TDF_LabelMap.hxx>
+#include <TDF_LabelSequence.hxx>
+#include <TDataStd_Name.hxx>
+#include <TDocStd_Document.hxx>
+#include <XCAFApp_Application.hxx>
+#include <XCAFDoc_ColorTool.hxx>
+#include <XCAFDoc_ShapeTool.hxx>
+#include <XCAFDoc_DocumentTool.hxx>
+#include <STEPCAFControl_Reader.hxx>
+
+#include <OSD_Timer.hxx>
+
+#include <set>
+#include <cctype>
+#include <iostream>
+#include <stdexcept>
+
+#include "StepIO.hxx"
+
+namespace ie
+{
+  namespace
+  {
+    //! Tool class to map XCAF product structure to data nodes.
+    class StepReader
+    {
+    public:
+
+      //! Creates reader for the given XCAF document.
+      StepReader (const Handle (TDocStd_Document)& theDocument)
+        : myShapeTool (XCAFDoc_DocumentTool::ShapeTool (theDocument->Main ())),
+          myColorTool (XCAFDoc_DocumentTool::ColorTool (theDocument->Main ())),
+          myNbInstances (0)
+      {
+        //
+      }
+
+      //! Adds nodes for the given label (product or its instance).
+      void AddLabel (const TDF_Label& theLabel, const TopLoc_Location& theLocation, model::DataNode* theParent);
+
+      //! Returns number of unique parts.
+      int NbParts () const { return myParts.Extent (); }
+
+      //! Returns number of part instances.
+      int NbInstances () const { return myNbInstances; }
+
+    private:
+
+      //! Returns valid name of the given label.
+      static TCollection_AsciiString labelName (const TDF_Label& theLabel, const TCollection_AsciiString& theParent);
+
+    private:
+
+      //! Tool to access shapes of XCAF document.
+      Handle (XCAFDoc_ShapeTool) myShapeTool;
+
+      //! Tool to access colors of XCAF document.
+      Handle (XCAFDoc_ColorTool) myColorTool;
+
+      //! Parts already added to the data model.
+      TDF_LabelMap myParts;
+
+      //! Number of part instances.
+      int myNbInstances;
+    };
+
+    //===========================================================================
+    //function : labelName
+    //purpose  :
+    //===========================================================================
+    TCollection_AsciiString StepReader::labelName (const TDF_Label& theLabel, const TCollection_AsciiString& theParent)
+    {
+      Handle (TDataStd_Name) anAttribute;
+
+      TCollection_AsciiString aName;
+
+      if (theLabel.FindAttribute (TDataStd_Name::GetID (), anAttribute))
+      {
+        const TCollection_AsciiString aRawName (anAttribute->Get (), '_');
+
+        for (int aCharIdx = 1; aCharIdx <= aRawName.Length (); ++aCharIdx)
+        {
+          const char aChar = aRawName.Value (aCharIdx);
+
+          aName += (isalnum (static_cast<unsigned char> (aChar)) && static_cast<unsigned char> (aChar) < 0x80) ? aChar : '_';
+        }
+      }
+
+      if (aName.IsEmpty ())
+      {
+        return theParent + "_"; // take the name of parent
+      }
+
+      return isalpha (aName.Value (1)) ? aName : theParent + "_" + aName;
+    }
+
+    //===========================================================================
+    //function : AddLabel
+    //purpose  :
+    //===========================================================================
+    void StepReader::AddLabel (const TDF_Label& theLabel, const TopLoc_Location& theLocation, model::DataNode* theParent)
+    {
+      TDF_Label aLabel = theLabel;
+
+      TopLoc_Location aLocation = theLocation;
+
+      // Instance name is preferred, since it is unique within assembly
+      TCollection_AsciiString aName = labelName (theLabel, theParent->Name ());
+
+      if (XCAFDoc_ShapeTool::IsReference (theLabel))
+      {
+        XCAFDoc_ShapeTool::GetReferredShape (theLabel, aLabel);
+
+        aLocation = theLocation * XCAFDoc_ShapeTool::GetLocation (theLabel);
+
+        if (aName == theParent->Name () + "_")
+        {
+          aName = labelName (aLabel, theParent->Name ());
+        }
+      }
+
+      if (XCAFDoc_ShapeTool::IsAssembly (aLabel))
+      {
+        theParent->SubNodes ().push_back (model::DataNodePtr (new model::DataNode (aName, model::DataNode::DataNode_Type_CadShape, true)));
+
+        model::DataNode* aGroup = theParent->SubNodes ().back ().get ();
+
+        TDF_LabelSequence aComponents;
+
+        XCAFDoc_ShapeTool::GetComponents (aLabel, aComponents);
+
+        for (TDF_LabelSequence::Iterator anIter (aComponents); anIter.More (); anIter.Next ())
+        {
+          AddLabel (anIter.Value (), aLocation, aGroup);
+        }
+
+        if (aGroup->SubNodes ().empty ())
+        {
+          theParent->SubNodes ().pop_back (); // empty assembly
+        }
+
+        return;
+      }
+
+      // Shape of the product is shared by all its instances
+      const TopoDS_Shape aShape = XCAFDoc_ShapeTool::GetShape (aLabel);
+
+      if (aShape.IsNull ())
+      {
+        return;
+      }
+
+      myParts.Add (aLabel);
+
+      ++myNbInstances;
+
+      Handle (AIS_Shape) anObject = new AIS_Shape (aShape.Moved (aLocation));
+
+      Quantity_Color aColor;
+
+      if (myColorTool->GetColor (aLabel, XCAFDoc_ColorSurf, aColor)
+       || myColorTool->GetColor (aLabel, XCAFDoc_ColorGen,  aColor))
+      {
+        anObject->SetColor (aColor);
+      }
+
+      theParent->SubNodes ().push_back (model::DataNodePtr (new model::DataNode (anObject, aName)));
+    }
+  }
+
+  //===========================================================================
+  //function : Read
+  //purpose  :
+  //===========================================================================
+  model::DataNodePtr StepIO::Read (const TCollection_AsciiString& theFileName,
+                                   const TCollection_AsciiString& theNodeName)
+  {
+    Handle (XCAFApp_Application) anApplication = XCAFApp_Application::GetApplication ();
+
+    Handle (TDocStd_Document) aDocument;
+
+    anApplication->NewDocument ("BinXCAF", aDocument);
+
+    OSD_Timer aTimer;
+
+    aTimer.Start ();
+
+    STEPCAFControl_Reader aReader;
+
+    aReader.SetNameMode  (Standard_True);
+    aReader.SetColorMode (Standard_True);
+    aReader.SetLayerMode (Standard_False);
+
+    if (aReader.ReadFile (theFileName.ToCString ()) != IFSelect_RetDone)
+    {
+      anApplication->Close (aDocument);
+
+      throw std::runtime_error ("Failed to read STEP file");
+    }
+
+    const double aReadTime = aTimer.ElapsedTime ();
+
+    if (!aReader.Transfer (aDocument))
+    {
+      anApplication->Close (aDocument);
+
+      throw std::runtime_error ("Failed to translate STEP file");
+    }
+
+    const double aTransferTime = aTimer.ElapsedTime () - aReadTime;
+
+    model::DataNodePtr aRoot (new model::DataNode (theNodeName, model::DataNode::DataNode_Type_CadShape));
+
+    StepReader aMapper (aDocument);
+
+    TDF_LabelSequence aFreeShapes;
+
+    XCAFDoc_DocumentTool::ShapeTool (aDocument->Main ())->GetFreeShapes (aFreeShapes);
+
+    for (TDF_LabelSequence::Iterator anIter (aFreeShapes); anIter.More (); anIter.Next ())
+    {
+      aMapper.AddLabel (anIter.Value (), TopLoc_Location (), aRoot.get ());
+    }
+
+    anApplication->Close (aDocument);
+
+    if (aRoot->SubNodes ().empty ())
+    {
+      throw std::runtime_error ("STEP file contains no shapes");
+    }
+
+    std::cout << "Read STEP file in " << aReadTime << " sec, translated in " << aTransferTime << " sec: "
+              << aMapper.NbParts () << " parts, " << aMapper.NbInstances () << " instances" << std::endl;
+
+    return aRoot;
+  }
+
+  //===========================================================================
+  //function : UniqueShapes
+  //purpose  :
+  //===========================================================================
+  TopoDS_Shape StepIO::UniqueShapes (model::DataNode* theNode)
+  {
+    struct ShapeCollector : public model::DataNode::NodeProcessor
+    {
+      BRep_Builder Builder;
+
+      TopoDS_Compound Compound;
+
+      std::set<const void*> TShapes;
+
+      virtual void operator() (const Handle (AIS_InteractiveObject)& theObject)
+      {
+        Handle (AIS_Shape) aShape = Handle (AIS_Shape)::DownCast (theObject);
+
+        if (!aShape.IsNull () && !aShape->Shape ().IsNull () && TShapes.insert (aShape->Shape ().TShape ().get ()).second)
+        {
+          Builder.Add (Compound, aShape->Shape ().Located (TopLoc_Location ()));
+        }
+      }
+    };
+
+    ShapeCollector aCollector;
+
+    aCollector.Builder.MakeCompound (aCollector.Compound);
+
+    theNode->Traverse (aCollector);
+
+    return aCollector.Compound;
+  }
+}
@@ -0,0 +1,36 @@
+// Created: 2019-06-28
+//
+// Copyright (c) 2019 OPEN CASCADE SAS
+//
+// This file is a part of CADRays software.
+//
+// CADRays is free software; you can use it under the terms of the MIT license,
+// refer to file LICENSE.txt for complete text of the license and disclaimer of
+// any warranty.
+
+#ifndef _RT_StepIO_Header
+#define _RT_StepIO_Header
+
+#include <DataModel.hxx>
+
+namespace ie
+{
+  //! Tool class for reading STEP files with assembly structure.
+  //! Product structure is mapped to hierarchy of data nodes, and
+  //! instances of the same product share the geometry (TShape).
+  class StepIO
+  {
+  public:
+
+    //! Reads STEP file into the new data node with the given name (not added to data model).
+    //! Throws std::runtime_error if the file is invalid or contains no shapes.
+    Standard_EXPORT static model::DataNodePtr Read (const TCollection_AsciiString& theFileName,
+                                                    const TCollection_AsciiString& theNodeName);
+
+    //! Returns compound of unique shapes (without locations) of the given node.
+    //! Such compound can be tessellated once for all instances.
+    Standard_EXPORT static TopoDS_Shape UniqueShapes (model::DataNode* theNode);
+  };
+}
+
+#endif // _RT_StepIO_Header
@@ -13,6 +13,8 @@
 
 #include <Graphic3d_Texture2Dmanual.hxx>
 
+#include <sys/stat.h>
+
 #include "TextureManager.hxx"
 
 namespace model
@@ -130,12 +132,19 @@ namespace model
   //function : CopyTo
   //purpose  :
   //===========================================================================
-  bool TextureManager::CopyTo (const TCollection_AsciiString& theDirectory)
+  bool TextureManager::CopyTo (const TCollection_AsciiString& theDirectory,
+                               const bool                     theToSkipUnchanged,
+                               const std::set<std::string>*   theNames)
   {
     NCollection_DoubleMap<TCollection_AsciiString, TCollection_AsciiString>::Iterator aFileIter (myFileMap);
 
     for (; aFileIter.More (); aFileIter.Next ())
     {
+      if (theNames != NULL && theNames->find (aFileIter.Key2 ().ToCString ()) == theNames->end ())
+      {
+        continue;
+      }
+
       OSD_File aFile (aFileIter.Key1 ());
 
       if (!aFile.Exists ())
@@ -144,7 +153,24 @@ namespace model
       }
       else
       {
-        aFile.Copy (theDirectory + "/" + aFileIter.Key2 ());
+        const TCollection_AsciiString aTarget = theDirectory + "/" + aFileIter.Key2 ();
+
+        if (theToSkipUnchanged)
+        {
+          struct stat aSrcStat;
+          struct stat aDstStat;
+
+          // Same size and newer modification time means the copy is up-to-date
+          if (stat (aFileIter.Key1 ().ToCString (), &aSrcStat) == 0
+           && stat (aTarget.ToCString (), &aDstStat) == 0
+           && aSrcStat.st_size == aDstStat.st_size
+           && aSrcStat.st_mtime <= aDstStat.st_mtime)
+          {
+            continue;
+          }
+        }
+
+        aFile.Copy (aTarget);
       }
     }
 
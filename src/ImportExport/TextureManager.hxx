@@ -16,6 +16,9 @@
 #include <NCollection_DataMap.hxx>
 #include <NCollection_DoubleMap.hxx>
 
+#include <set>
+#include <string>
+
 namespace model
 {
   //! Tool object for management texture maps.
@@ -40,8 +43,11 @@ namespace model
     //! Prints all textures registered.
     Standard_EXPORT void Print ();
 
-    //! Copies all textures to the given directory.
-    Standard_EXPORT bool CopyTo (const TCollection_AsciiString& theDirectory);
+    //! Copies all textures (or textures with the given unique names) to the given
+    //! directory (optionally skips up-to-date copies).
+    Standard_EXPORT bool CopyTo (const TCollection_AsciiString& theDirectory,
+                                 const bool                     theToSkipUnchanged = false,
+                                 const std::set<std::string>*   theNames = NULL);
 
     //! Registers the given file in texture manager.
     Standard_EXPORT TCollection_AsciiString RegisterName (const OSD_Path& thePath);
@@ -13,8 +13,13 @@
 
 #include <AIS_DisplayMode.hxx>
 #include <AIS_InteractiveObject.hxx>
+#include <AIS_InteractiveContext.hxx>
 
 #include <Prs3d_ShadingAspect.hxx>
+#include <Graphic3d_TextureParams.hxx>
+
+#include <limits>
+#include <sstream>
 
 namespace model
 {
@@ -92,6 +97,160 @@ namespace model
     }
   }
 
+  //=======================================================================
+  //function : TextureInstance
+  //purpose  :
+  //=======================================================================
+  TextureInstance::TextureInstance (const Handle (Graphic3d_TextureMap)& theBase, const Standard_Transient* theOwner)
+    : Graphic3d_Texture2Dmanual (theBase->Path ().Name ().IsEmpty () ? Handle (Image_PixMap) (theBase->GetImage ()) : Handle (Image_PixMap) ()),
+      myOwner (theOwner)
+  {
+    myPath = theBase->Path ();
+
+    Handle (TextureInstance) anInstance = Handle (TextureInstance)::DownCast (theBase);
+
+    myBaseId = anInstance.IsNull () ? theBase->GetId () : anInstance->BaseId ();
+
+    // same ID makes OpenGL driver share the texture resource (until scaled)
+    myTexId = myBaseId;
+
+    const Handle (Graphic3d_TextureParams)& aParams = theBase->GetParams ();
+
+    myParams->SetModulate (aParams->IsModulate ());
+    myParams->SetRepeat (aParams->IsRepeat ());
+    myParams->SetFilter (aParams->Filter ());
+    myParams->SetAnisoFilter (aParams->AnisoFilter ());
+  }
+
+  //=======================================================================
+  //function : SetScale
+  //purpose  :
+  //=======================================================================
+  void TextureInstance::SetScale (const Graphic3d_Vec2& theScale)
+  {
+    myParams->SetScale (theScale);
+
+    // OpenGL texture keeps sampler parameters, so it can be shared only
+    // by the instances having the same transformation of UV coordinates
+    myTexId = myBaseId;
+
+    if (theScale.x () != 1.f || theScale.y () != 1.f)
+    {
+      myTexId += TCollection_AsciiString ("_scale_") + static_cast<Standard_Real> (theScale.x ())
+                                                          + "_" + static_cast<Standard_Real> (theScale.y ());
+    }
+  }
+
+  //=======================================================================
+  //function : GetTextureScale
+  //purpose  :
+  //=======================================================================
+  bool GetTextureScale (const Handle (AIS_InteractiveObject)& theObject, double& theScaleS, double& theScaleT)
+  {
+    Handle (AIS_TexturedShape) aTexShape = Handle (AIS_TexturedShape)::DownCast (theObject);
+
+    if (aTexShape.IsNull ())
+    {
+      return false;
+    }
+
+    // scale used to generate UV coordinates
+    theScaleS = aTexShape->TextureScale () ? aTexShape->TextureScaleU () : 1.0;
+    theScaleT = aTexShape->TextureScale () ? aTexShape->TextureScaleV () : 1.0;
+
+    Handle (TextureInstance) anInstance = Handle (TextureInstance)::DownCast (GetAspect (theObject)->TextureMap ());
+
+    if (!anInstance.IsNull () && anInstance->Owner () == theObject.get ())
+    {
+      theScaleS /= anInstance->GetParams ()->Scale ().x ();
+      theScaleT /= anInstance->GetParams ()->Scale ().y ();
+    }
+
+    return true;
+  }
+
+  //=======================================================================
+  //function : SetTextureScale
+  //purpose  :
+  //=======================================================================
+  bool SetTextureScale (const Handle (AIS_InteractiveObject)& theObject, const double theScaleS, const double theScaleT)
+  {
+    Handle (AIS_TexturedShape) aTexShape = Handle (AIS_TexturedShape)::DownCast (theObject);
+
+    if (aTexShape.IsNull () || theScaleS <= 0.0 || theScaleT <= 0.0)
+    {
+      return false;
+    }
+
+    Graphic3d_AspectFillArea3d* anAspect = GetAspect (theObject);
+
+    if (anAspect->TextureMap ().IsNull ())
+    {
+      return false;
+    }
+
+    // UV coordinates are divided by the scale
+    const Graphic3d_Vec2 aFactor (static_cast<float> ((aTexShape->TextureScale () ? aTexShape->TextureScaleU () : 1.0) / theScaleS),
+                                  static_cast<float> ((aTexShape->TextureScale () ? aTexShape->TextureScaleV () : 1.0) / theScaleT));
+
+    Handle (TextureInstance) anInstance = Handle (TextureInstance)::DownCast (anAspect->TextureMap ());
+
+    if (anInstance.IsNull () || anInstance->Owner () != theObject.get ())
+    {
+      if (aFactor.x () == 1.f && aFactor.y () == 1.f)
+      {
+        return true; // texture can be shared
+      }
+
+      // texture parameters are per object, while image is shared
+      anInstance = new TextureInstance (anAspect->TextureMap (), theObject.get ());
+
+      anAspect->SetTextureMap (anInstance);
+    }
+
+    anInstance->SetScale (aFactor);
+
+    theObject->SynchronizeAspects ();
+
+    return true;
+  }
+
+  //=======================================================================
+  //function : SetTextureMap
+  //purpose  :
+  //=======================================================================
+  void SetTextureMap (const Handle (AIS_InteractiveObject)& theObject, const Handle (Graphic3d_TextureMap)& theMap)
+  {
+    double aScaleS = 1.0;
+    double aScaleT = 1.0;
+
+    const bool isScaled = GetTextureScale (theObject, aScaleS, aScaleT);
+
+    GetAspect (theObject)->SetTextureMap (theMap);
+
+    if (isScaled && !theMap.IsNull ())
+    {
+      SetTextureScale (theObject, aScaleS, aScaleT);
+    }
+  }
+
+  //=======================================================================
+  //function : Redisplay
+  //purpose  :
+  //=======================================================================
+  void Redisplay (const Handle (AIS_InteractiveContext)& theContext, const Handle (AIS_InteractiveObject)& theObject)
+  {
+    Handle (Graphic3d_AspectFillArea3d) anAspect = GetAspect (theObject);
+
+    theContext->Redisplay (theObject, Standard_False);
+
+    if (theObject->IsKind (STANDARD_TYPE (AIS_TexturedShape)) && !anAspect.IsNull ())
+    {
+      // restore texture map (and its instance) replaced on recomputation
+      static_cast<TexturedShape*> (theObject.get ())->SetGraphicAspect (anAspect);
+    }
+  }
+
   //=======================================================================
   //function : SetAspect
   //purpose  :
@@ -109,4 +268,191 @@ namespace model
       static_cast<TexturedShape*> (theObject.get ())->SetGraphicAspect (theAspect);
     }
   }
+
+  //=======================================================================
+  //function : serializeFresnel
+  //purpose  :
+  //=======================================================================
+  static void serializeFresnel (std::ostream& theStream, const Graphic3d_Fresnel& theFresnel)
+  {
+    const Graphic3d_Vec4 aFresnel = theFresnel.Serialize ();
+
+    // Same layout as used by 'vbsdf' command
+    switch (theFresnel.FresnelType ())
+    {
+      case Graphic3d_FM_SCHLICK:
+      {
+        theStream << " Schlick " << aFresnel.r () << " " << aFresnel.g () << " " << aFresnel.b ();
+      }
+      break;
+
+      case Graphic3d_FM_CONSTANT:
+      {
+        theStream << " Constant " << aFresnel.z ();
+      }
+      break;
+
+      case Graphic3d_FM_CONDUCTOR:
+      {
+        theStream << " Conductor " << aFresnel.y () << " " << aFresnel.z ();
+      }
+      break;
+
+      case Graphic3d_FM_DIELECTRIC:
+      {
+        theStream << " Dielectric " << aFresnel.y ();
+      }
+      break;
+    }
+  }
+
+  //=======================================================================
+  //function : deserializeFresnel
+  //purpose  :
+  //=======================================================================
+  static bool deserializeFresnel (std::istream& theStream, Graphic3d_Fresnel& theFresnel)
+  {
+    std::string aType;
+
+    theStream >> aType;
+
+    if (aType == "Schlick")
+    {
+      Graphic3d_Vec3 aColor;
+
+      theStream >> aColor.r () >> aColor.g () >> aColor.b ();
+
+      theFresnel = Graphic3d_Fresnel::CreateSchlick (aColor);
+    }
+    else if (aType == "Constant")
+    {
+      float aReflection = 0.f;
+
+      theStream >> aReflection;
+
+      theFresnel = Graphic3d_Fresnel::CreateConstant (aReflection);
+    }
+    else if (aType == "Conductor")
+    {
+      float aRefractionIndex = 0.f;
+      float anAbsorptionIndex = 0.f;
+
+      theStream >> aRefractionIndex >> anAbsorptionIndex;
+
+      theFresnel = Graphic3d_Fresnel::CreateConductor (aRefractionIndex, anAbsorptionIndex);
+    }
+    else if (aType == "Dielectric")
+    {
+      float aRefractionIndex = 0.f;
+
+      theStream >> aRefractionIndex;
+
+      theFresnel = Graphic3d_Fresnel::CreateDielectric (aRefractionIndex);
+    }
+    else
+    {
+      return false;
+    }
+
+    return !theStream.fail ();
+  }
+
+  //=======================================================================
+  //function : SerializeBSDF
+  //purpose  :
+  //=======================================================================
+  TCollection_AsciiString SerializeBSDF (const Graphic3d_BSDF& theBSDF)
+  {
+    std::ostringstream aStream;
+
+    aStream.precision (std::numeric_limits<float>::max_digits10);
+
+    aStream << "Kc "  << theBSDF.Kc.x () << " " << theBSDF.Kc.y () << " " << theBSDF.Kc.z () << " " << theBSDF.Kc.w ()
+            << " Kd " << theBSDF.Kd.x () << " " << theBSDF.Kd.y () << " " << theBSDF.Kd.z ()
+            << " Ks " << theBSDF.Ks.x () << " " << theBSDF.Ks.y () << " " << theBSDF.Ks.z () << " " << theBSDF.Ks.w ()
+            << " Kt " << theBSDF.Kt.x () << " " << theBSDF.Kt.y () << " " << theBSDF.Kt.z ()
+            << " Le " << theBSDF.Le.x () << " " << theBSDF.Le.y () << " " << theBSDF.Le.z ()
+            << " Absorption " << theBSDF.Absorption.r () << " "
+                              << theBSDF.Absorption.g () << " "
+                              << theBSDF.Absorption.b () << " "
+                              << theBSDF.Absorption.w ();
+
+    aStream << " FresnelCoat";
+
+    serializeFresnel (aStream, theBSDF.FresnelCoat);
+
+    aStream << " FresnelBase";
+
+    serializeFresnel (aStream, theBSDF.FresnelBase);
+
+    return aStream.str ().c_str ();
+  }
+
+  //=======================================================================
+  //function : DeserializeBSDF
+  //purpose  :
+  //=======================================================================
+  bool DeserializeBSDF (const TCollection_AsciiString& theString, Graphic3d_BSDF& theBSDF)
+  {
+    std::istringstream aStream (theString.ToCString ());
+
+    Graphic3d_BSDF aBSDF = theBSDF;
+
+    std::string aToken;
+
+    while (aStream >> aToken)
+    {
+      if (aToken == "Kc")
+      {
+        aStream >> aBSDF.Kc.x () >> aBSDF.Kc.y () >> aBSDF.Kc.z () >> aBSDF.Kc.w ();
+      }
+      else if (aToken == "Kd")
+      {
+        aStream >> aBSDF.Kd.x () >> aBSDF.Kd.y () >> aBSDF.Kd.z ();
+      }
+      else if (aToken == "Ks")
+      {
+        aStream >> aBSDF.Ks.x () >> aBSDF.Ks.y () >> aBSDF.Ks.z () >> aBSDF.Ks.w ();
+      }
+      else if (aToken == "Kt")
+      {
+        aStream >> aBSDF.Kt.x () >> aBSDF.Kt.y () >> aBSDF.Kt.z ();
+      }
+      else if (aToken == "Le")
+      {
+        aStream >> aBSDF.Le.x () >> aBSDF.Le.y () >> aBSDF.Le.z ();
+      }
+      else if (aToken == "Absorption")
+      {
+        aStream >> aBSDF.Absorption.r () >> aBSDF.Absorption.g () >> aBSDF.Absorption.b () >> aBSDF.Absorption.w ();
+      }
+      else if (aToken == "FresnelCoat")
+      {
+        if (!deserializeFresnel (aStream, aBSDF.FresnelCoat))
+        {
+          return false;
+        }
+      }
+      else if (aToken == "FresnelBase")
+      {
+        if (!deserializeFresnel (aStream, aBSDF.FresnelBase))
+        {
+          return false;
+        }
+      }
+      else
+      {
+        return false;
+      }
+
+      if (aStream.fail ())
+      {
+        return false;
+      }
+    }
+
+    theBSDF = aBSDF;
+
+    return true;
+  }
 }
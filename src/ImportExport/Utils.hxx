@@ -13,6 +13,8 @@
 
 #include <AIS_Shape.hxx>
 #include <AIS_TexturedShape.hxx>
+#include <Graphic3d_BSDF.hxx>
+#include <Graphic3d_Texture2Dmanual.hxx>
 
 namespace model
 {
@@ -46,6 +48,60 @@ namespace model
 
   };
 
+  //! Texture map sharing the image of the base texture, but having its own
+  //! parameters (e.g. transformation of UV coordinates). Texture ID depends
+  //! on the transformation, so GPU resource is shared only by instances of
+  //! the same base texture with the same UV scale.
+  class TextureInstance : public Graphic3d_Texture2Dmanual
+  {
+  public:
+
+    //! Creates instance of the given texture for the given owner object.
+    Standard_EXPORT TextureInstance (const Handle (Graphic3d_TextureMap)& theBase, const Standard_Transient* theOwner);
+
+    //! Returns object owning this instance.
+    const Standard_Transient* Owner () const
+    {
+      return myOwner;
+    }
+
+    //! Returns ID of the base texture.
+    const TCollection_AsciiString& BaseId () const
+    {
+      return myBaseId;
+    }
+
+    //! Sets scale of UV coordinates (and updates texture ID).
+    Standard_EXPORT void SetScale (const Graphic3d_Vec2& theScale);
+
+  protected:
+
+    //! Object owning this instance.
+    const Standard_Transient* myOwner;
+
+    //! ID of the base texture.
+    TCollection_AsciiString myBaseId;
+
+  public:
+
+    DEFINE_STANDARD_RTTI_INLINE (TextureInstance, Graphic3d_Texture2Dmanual)
+  };
+
+  //! Returns UV scale of the given textured shape (false for other objects).
+  Standard_EXPORT bool GetTextureScale (const Handle (AIS_InteractiveObject)& theObject, double& theScaleS, double& theScaleT);
+
+  //! Changes UV scale of the given textured shape without rebuilding its presentation.
+  //! UV coordinates are kept, and the difference is applied as texture transformation.
+  Standard_EXPORT bool SetTextureScale (const Handle (AIS_InteractiveObject)& theObject, const double theScaleS, const double theScaleT);
+
+  //! Replaces texture map of the given object keeping its UV scale (texture
+  //! transformation is re-applied to the new map).
+  Standard_EXPORT void SetTextureMap (const Handle (AIS_InteractiveObject)& theObject, const Handle (Graphic3d_TextureMap)& theMap);
+
+  //! Re-displays the given object keeping its graphic aspect (recomputation
+  //! of textured shape resets its aspect to default texture).
+  Standard_EXPORT void Redisplay (const Handle (AIS_InteractiveContext)& theContext, const Handle (AIS_InteractiveObject)& theObject);
+
   //! Returns graphic aspect of the given AIS object.
   Standard_EXPORT Graphic3d_AspectFillArea3d* GetAspect (const Handle (AIS_InteractiveObject)& theObject);
 
@@ -54,6 +110,12 @@ namespace model
 
   //! Applies the given graphic aspect to the given AIS object.
   Standard_EXPORT void SetAspect (const Handle (AIS_InteractiveObject)& theObject, const Handle (Graphic3d_AspectFillArea3d)& theAspect);
+
+  //! Converts the given BSDF to string (single line of space-separated tokens).
+  Standard_EXPORT TCollection_AsciiString SerializeBSDF (const Graphic3d_BSDF& theBSDF);
+
+  //! Restores BSDF from the string produced by SerializeBSDF.
+  Standard_EXPORT bool DeserializeBSDF (const TCollection_AsciiString& theString, Graphic3d_BSDF& theBSDF);
 }
 
 #endif // _RT_Utils_Header
@@ -51,11 +51,17 @@
 #include "DataModelWidget.hxx"
 #include "TransformWidget.hxx"
 #include "ImportSettingsEditor.hxx"
+#include "FrameProfiler.hxx"
+#include "ImageCapture.hxx"
 
 #include "OrbitControls.h"
 #include "FlightControls.h"
 
+#include <ShapeIO.hxx>
 #include <ImportExport.hxx>
+#include <Convergence.hxx>
+#include <Checkpoint.hxx>
+#include <Denoiser.hxx>
 
 #include <Settings.hxx>
 
@@ -93,6 +99,85 @@ void onSelectionEvent (GuiBase* theGui)
   }
 }
 
+//=======================================================================
+//function : blendLogo
+//purpose  : Blends RGBA logo into RGB image (called by encoding thread,
+//           so the logo is scaled without OpenGL)
+//=======================================================================
+void blendLogo (Image_PixMap& theImage, const std::vector<GLubyte>& theLogo, int theLogoW, int theLogoH, const int thePosition)
+{
+  float aScalePer = 7.0f;
+  float aScale = std::fmin (std::fmin (theImage.Width() / aScalePer / theLogoW, 1.0f),
+                            std::fmin (theImage.Height() / aScalePer / theLogoH, 1.0f));
+
+  const int aLogoW = std::max (static_cast<int> (theLogoW * aScale), 1);
+  const int aLogoH = std::max (static_cast<int> (theLogoH * aScale), 1);
+
+  // Box filter (each target pixel averages its footprint in source logo)
+  std::vector<GLubyte> aScaledValues (aLogoW * aLogoH * 4);
+
+  for (int j = 0; j < aLogoH; j++)
+    for (int i = 0; i < aLogoW; i++)
+    {
+      const int aMinX = i * theLogoW / aLogoW;
+      const int aMinY = j * theLogoH / aLogoH;
+      const int aMaxX = std::max ((i + 1) * theLogoW / aLogoW, aMinX + 1);
+      const int aMaxY = std::max ((j + 1) * theLogoH / aLogoH, aMinY + 1);
+
+      int aSum[4] = { 0, 0, 0, 0 };
+
+      for (int y = aMinY; y < aMaxY; y++)
+        for (int x = aMinX; x < aMaxX; x++)
+          for (int c = 0; c < 4; c++)
+          {
+            aSum[c] += theLogo[(y * theLogoW + x) * 4 + c];
+          }
+
+      for (int c = 0; c < 4; c++)
+      {
+        aScaledValues[(j * aLogoW + i) * 4 + c] = static_cast<GLubyte> (aSum[c] / ((aMaxX - aMinX) * (aMaxY - aMinY)));
+      }
+    }
+
+  int offsetX, offsetY;
+  switch (thePosition)
+  {
+  case 1:
+    offsetX = 1;
+    offsetY = 1;
+    break;
+  case 2:
+    offsetX = 1;
+    offsetY = static_cast<int> (theImage.Height()) - aLogoH;
+    break;
+  case 3:
+    offsetX = static_cast<int> (theImage.Width()) - aLogoW;
+    offsetY = 1;
+    break;
+  case 4:
+    offsetX = static_cast<int> (theImage.Width()) - aLogoW;
+    offsetY = static_cast<int> (theImage.Height()) - aLogoH;
+    break;
+  case 5:
+    offsetX = static_cast<int> (theImage.Width()) / 2 - aLogoW / 2;
+    offsetY = static_cast<int> (theImage.Height()) / 2 - aLogoH / 2;
+    break;
+  default:
+    offsetX = 1;
+    offsetY = 1;
+    break;
+  }
+  for (int i = 0; i < aLogoW; i++)
+    for (int j = 0; j < aLogoH; j++)
+    {
+      unsigned char* anImageValue = theImage.ChangeValue<unsigned char[3]> (j + offsetY, i + offsetX);
+      unsigned char aTransparency = aScaledValues[(j * aLogoW + i) * 4 + 3];
+      anImageValue[0] = (aScaledValues[(j * aLogoW + i) * 4 + 0] * aTransparency + anImageValue[0] * (255 - aTransparency)) / 255;
+      anImageValue[1] = (aScaledValues[(j * aLogoW + i) * 4 + 1] * aTransparency + anImageValue[1] * (255 - aTransparency)) / 255;
+      anImageValue[2] = (aScaledValues[(j * aLogoW + i) * 4 + 2] * aTransparency + anImageValue[2] * (255 - aTransparency)) / 255;
+    }
+}
+
 //=======================================================================
 //function : AppGui
 //purpose  :
@@ -101,7 +186,8 @@ AppGui::AppGui (AppViewer* theViewer, Draw_Interpretor* theTclInterpretor)
   : GuiBase (SETTINGS_FILE),
     myViewer (theViewer),
     myTclInterpretor (theTclInterpretor),
-    isInitialized (false)
+    isInitialized (false),
+    myExportDone (false)
 {
   //
 }
@@ -112,6 +198,11 @@ AppGui::AppGui (AppViewer* theViewer, Draw_Interpretor* theTclInterpretor)
 //=======================================================================
 AppGui::~AppGui()
 {
+  if (myExportThread.joinable())
+  {
+    myExportThread.join();
+  }
+
   GetSettings().Dump (SETTINGS_FILE);
 }
 
@@ -178,11 +269,12 @@ void AppGui::Draw (AIS_InteractiveContext* theAISContext, V3d_View* theView, boo
                                    "*.3ds", "*.blend",
                                    "*.stl", "*.dxf",
                                    "*.tcl", "*.brep",
+                                   "*.bbrep", "*.glb",
                                    "*.step", "*.stp",
                                    "*.iges", "*.igs" };
 
-        const char* aFileName = tinyfd_openFileDialog ("Select file to open", aDefaultPath.c_str(), 11, aFilters,
-                                                       "All supported formats (*.obj, *.ply, *.3ds, *.blend, *.stl, *.dxf, *.tcl, *.brep, *.step, *.stp, *.iges, *.igs)", 0);
+        const char* aFileName = tinyfd_openFileDialog ("Select file to open", aDefaultPath.c_str(), 14, aFilters,
+                                                       "All supported formats (*.obj, *.ply, *.3ds, *.blend, *.stl, *.dxf, *.tcl, *.brep, *.bbrep, *.glb, *.step, *.stp, *.iges, *.igs)", 0);
 
         if (aFileName != NULL)
         {
@@ -196,10 +288,8 @@ void AppGui::Draw (AIS_InteractiveContext* theAISContext, V3d_View* theView, boo
 
       if (ImGui::BeginMenu (ICON_FA_SHARE " Export"))
       {
-        if (ImGui::MenuItem ("CADRays script"))
+        if (ImGui::MenuItem ("CADRays script", NULL, false, !myExporter))
         {
-          ie::ImportExport IE;
-
           std::string aDefaultPath = GetSettings().Get ("files", "last_exported_cadrays", "");
 
           const char* aDirName = tinyfd_selectFolderDialog ("Save to directory", aDefaultPath.c_str());
@@ -208,19 +298,52 @@ void AppGui::Draw (AIS_InteractiveContext* theAISContext, V3d_View* theView, boo
           {
             GetSettings().Set ("files", "last_exported_cadrays", aDirName);
 
-            IE.Export (aDirName, theView);
+            startExport (aDirName, theView, false);
           }
         }
         AddTooltip ("Export TCL script and all scene resources.\n"
                     "Scene could be fully recovered later from this script.");
 
-        if (ImGui::MenuItem ("OCCT DRAW script"))
+        bool toCompressShapes = GetSettings().GetBoolean ("export", "compress_shapes", false);
+
+        if (ImGui::MenuItem ("Compress shapes", NULL, &toCompressShapes, ie::ShapeIO::HasCompression()))
+        {
+          GetSettings().SetBoolean ("export", "compress_shapes", toCompressShapes);
+        }
+        AddTooltip ("Compress binary BREP files of exported CADRays scripts.\n"
+                    "Reduces package size at the cost of export time.");
+
+        if (ImGui::MenuItem ("OCCT DRAW script", NULL, false, !myExporter))
         {
           toShowDrawExportDialog = true;
         }
         AddTooltip ("Export TCL script compatible with OCCT DRAW.\n"
                     "Scene hierarchy and ALL mesh shapes will be lost.");
 
+        if (ImGui::MenuItem ("glTF binary (GLB)", NULL, false, !myExporter))
+        {
+          std::string aDefaultPath = GetSettings().Get ("files", "last_exported_gltf", "");
+
+          const char* aFilters[] = { "*.glb" };
+          const char* aFileName = tinyfd_saveFileDialog ("Export scene to", aDefaultPath.c_str(), 1, aFilters, "glTF binary files (*.glb)");
+
+          if (aFileName != NULL)
+          {
+            GetSettings().Set ("files", "last_exported_gltf", aFileName);
+
+            TCollection_AsciiString aGltfFileName (aFileName);
+
+            if (OSD_Path (aGltfFileName).Extension ().IsEmpty ())
+            {
+              aGltfFileName += ".glb";
+            }
+
+            ConsoleExec ((TCollection_AsciiString ("rtgltfwrite \"") + aGltfFileName + "\"").ToCString ());
+          }
+        }
+        AddTooltip ("Export scene hierarchy, meshes and materials to single GLB file.\n"
+                    "CAD shapes are exported as triangulations.");
+
         ImGui::EndMenu();
       }
 
@@ -309,8 +432,6 @@ void AppGui::Draw (AIS_InteractiveContext* theAISContext, V3d_View* theView, boo
 
       if (ImGui::Button ("OK", ImVec2 (ImGui::GetContentRegionAvailWidth () / 2 - ImGui::GetStyle ().ItemSpacing.x / 2, 0)))
       {
-        ie::ImportExport IE (true /* Compatible with DRAW */);
-
         std::string aDefaultPath = GetSettings().Get ("files", "last_exported_draw", "");
 
         const char* aDirName = tinyfd_selectFolderDialog ("Save to directory", aDefaultPath.c_str());
@@ -319,7 +440,7 @@ void AppGui::Draw (AIS_InteractiveContext* theAISContext, V3d_View* theView, boo
         {
           GetSettings().Set ("files", "last_exported_draw", aDirName);
 
-          IE.Export (aDirName, theView);
+          startExport (aDirName, theView, true /* Compatible with DRAW */);
         }
 
         ImGui::CloseCurrentPopup ();
@@ -334,6 +455,8 @@ void AppGui::Draw (AIS_InteractiveContext* theAISContext, V3d_View* theView, boo
       ImGui::EndPopup();
     }
 
+    drawExportProgress ();
+
     if (toSave)
     {
       Image_AlienPixMap aPixMap;
@@ -421,7 +544,58 @@ void AppGui::Draw (AIS_InteractiveContext* theAISContext, V3d_View* theView, boo
 
       if (!toShowSaveDialog)
       {
-        if (!aPixMap.InitZero (aFormat, Standard_Size (GetAppViewer()->RTSize().x), Standard_Size (GetAppViewer()->RTSize().y)))
+        if (aBufferType == Graphic3d_BT_RGB)
+        {
+          ImageCapture::Filter aFilter;
+
+          int aLogoW = 0;
+          int aLogoH = 0;
+
+          std::vector<GLubyte> aValues;
+
+          if (aLogoPos > 0)
+          {
+            int aLogoTexture = myViewer->GetLogoTexture (&aLogoW, &aLogoH);
+
+            aValues.resize (aLogoW * aLogoH * 4);
+
+            glBindTexture (GL_TEXTURE_2D, aLogoTexture);
+            glGetTexImage (GL_TEXTURE_2D, 0, GL_RGBA, GL_UNSIGNED_BYTE, &aValues[0]);
+            glBindTexture (GL_TEXTURE_2D, 0);
+          }
+
+          std::shared_ptr<ie::AovBuffers> aGuides;
+
+          if (ie::Denoiser::GetInstance ()->IsEnabled ())
+          {
+            aGuides = ie::Denoiser::GetInstance ()->Guides (View());
+          }
+
+          const int aPosition = aLogoPos;
+
+          if (aPosition > 0 || aGuides != NULL)
+          {
+            // Image is denoised, logo is scaled and blended by encoding thread
+            aFilter = [aValues, aLogoW, aLogoH, aPosition, aGuides] (Image_PixMap& thePixMap)
+            {
+              if (aGuides != NULL)
+              {
+                aGuides->Compute ();
+
+                ie::Denoiser::GetInstance ()->Perform (*aGuides, thePixMap);
+              }
+
+              if (aPosition > 0)
+              {
+                blendLogo (thePixMap, aValues, aLogoW, aLogoH, aPosition);
+              }
+            };
+          }
+
+          // LDR image is read back asynchronously (without pipeline stall) and saved in background
+          myViewer->GetCapture().Request (aFileNameCorrected, aFilter);
+        }
+        else if (!aPixMap.InitZero (aFormat, Standard_Size (GetAppViewer()->RTSize().x), Standard_Size (GetAppViewer()->RTSize().y)))
         {
           std::cout << "[error] Could not allocate image for export" << std::endl;
         }
@@ -431,73 +605,20 @@ void AppGui::Draw (AIS_InteractiveContext* theAISContext, V3d_View* theView, boo
           {
             std::cout << "[error] Could not dump image from FBO" << std::endl;
           }
-          
-          if (aLogoPos > 0)
+
+          // Add samples restored from checkpoint (HDR image keeps linear radiance)
+          ie::Checkpoint::GetInstance ()->Combine (aPixMap, aBufferType == Graphic3d_BT_RGB_RayTraceHdrLeft);
+
+          if (ie::Denoiser::GetInstance ()->IsEnabled ())
           {
-            int aLogoW, aLogoH;
-            int aLogoTexture = myViewer->GetLogoTexture (&aLogoW, &aLogoH);
-            
-            std::vector<GLubyte> aValues (aLogoW * aLogoH * 4);
-            
-            glBindTexture (GL_TEXTURE_2D, aLogoTexture);
-            glGetTexImage (GL_TEXTURE_2D, 0, GL_RGBA, GL_UNSIGNED_BYTE, &aValues[0]);
-            glBindTexture (GL_TEXTURE_2D, 0);
-            
-            float aScalePer = 7.0f;
-            float aScale = std::fmin (std::fmin (aPixMap.Width() / aScalePer / aLogoW, 1.0f),
-                                      std::fmin (aPixMap.Height() / aScalePer / aLogoH, 1.0f));
-            
-            std::vector<GLubyte> aScaledValues (static_cast<int>(aLogoW * aLogoH * 4 * aScale * aScale));
-
-            gluScaleImage (GL_RGBA,
-                           aLogoW,
-                           aLogoH,
-                           GL_UNSIGNED_BYTE,
-                           &aValues[0],
-                           (GLint) (aScale * aLogoW),
-                           (GLint) (aScale * aLogoH),
-                           GL_UNSIGNED_BYTE,
-                           &aScaledValues[0]);
-            aLogoW = static_cast<int> (aLogoW * aScale);
-            aLogoH = static_cast<int> (aLogoH * aScale);
-            
-            int offsetX, offsetY;
-            switch (aLogoPos)
+            std::shared_ptr<ie::AovBuffers> aGuides = ie::Denoiser::GetInstance ()->Guides (View());
+
+            if (aGuides != NULL)
             {
-            case 1:
-              offsetX = 1;
-              offsetY = 1;
-              break;
-            case 2:
-              offsetX = 1;
-              offsetY = static_cast<int> (aPixMap.Height()) - aLogoH;
-              break;
-            case 3:
-              offsetX = static_cast<int> (aPixMap.Width()) - aLogoW;
-              offsetY = 1;
-              break;
-            case 4:
-              offsetX = static_cast<int> (aPixMap.Width()) - aLogoW;
-              offsetY = static_cast<int> (aPixMap.Height()) - aLogoH;
-              break;
-            case 5:
-              offsetX = static_cast<int> (aPixMap.Width()) / 2 - aLogoW / 2;
-              offsetY = static_cast<int> (aPixMap.Height()) / 2 - aLogoH / 2;
-              break;
-            default:
-              offsetX = 1;
-              offsetY = 1;
-              break;
+              aGuides->Compute ();
+
+              ie::Denoiser::GetInstance ()->Perform (*aGuides, aPixMap, true /* linear radiance */);
             }
-            for (int i = 0; i < aLogoW; i++)
-              for (int j = 0; j < aLogoH; j++)
-              {
-                unsigned char* anImageValue = aPixMap.ChangeValue<unsigned char[3]> (j + offsetY, i + offsetX);
-                unsigned char aTransparency = aScaledValues[(j * aLogoW + i) * 4 + 3];
-                anImageValue[0] = (aScaledValues[(j * aLogoW + i) * 4 + 0] * aTransparency + anImageValue[0] * (255 - aTransparency)) / 255;
-                anImageValue[1] = (aScaledValues[(j * aLogoW + i) * 4 + 1] * aTransparency + anImageValue[1] * (255 - aTransparency)) / 255;
-                anImageValue[2] = (aScaledValues[(j * aLogoW + i) * 4 + 2] * aTransparency + anImageValue[2] * (255 - aTransparency)) / 255;
-              }
           }
 
           aPixMap.Save (aFileNameCorrected.c_str());
@@ -556,6 +677,45 @@ void AppGui::Draw (AIS_InteractiveContext* theAISContext, V3d_View* theView, boo
       }
       AddTooltip ("Scale UI according to monitor DPI");
 
+      ImGui::Separator();
+
+      FrameProfiler& aProfiler = myViewer->GetProfiler();
+
+      bool isProfiling = aProfiler.IsEnabled();
+
+      if (ImGui::Checkbox ("Frame timings", &isProfiling))
+      {
+        aProfiler.SetEnabled (isProfiling);
+      }
+      AddTooltip ("Show time spent on each stage of recent frames.\n"
+                  "Rendering is synchronized with GPU while enabled.");
+
+      if (ImGui::MenuItem ("Export frame timings", NULL, false, aProfiler.NbFrames() > 0))
+      {
+        std::string aDefaultPath = GetSettings().Get ("files", "last_exported_timings", "");
+
+        const char* aFilters[] = { "*.csv" };
+        const char* aFileName = tinyfd_saveFileDialog ("Export frame timings to", aDefaultPath.c_str(), 1, aFilters, "CSV files (*.csv)");
+
+        if (aFileName != NULL)
+        {
+          GetSettings().Set ("files", "last_exported_timings", aFileName);
+
+          TCollection_AsciiString aCsvFileName (aFileName);
+
+          if (OSD_Path (aCsvFileName).Extension ().IsEmpty ())
+          {
+            aCsvFileName += ".csv";
+          }
+
+          if (!aProfiler.ExportCsv (aCsvFileName.ToCString ()))
+          {
+            ConsoleAddLog ((TCollection_AsciiString ("Error: failed to write ") + aCsvFileName).ToCString ());
+          }
+        }
+      }
+      AddTooltip ("Save timings of recent frames to CSV file");
+
       ImGui::EndMenu();
     }
 
@@ -849,11 +1009,14 @@ void AppGui::Draw (AIS_InteractiveContext* theAISContext, V3d_View* theView, boo
   Handle(AIS_InteractiveObject) aSelectedObject = theAISContext->FirstSelectedObject();
   if (!aSelectedObject.IsNull())
   {
-    ImGui::AttachGizmo (theAISContext,
-                        theView,
-                        aSelectedObject,
-                        GetManipulatorSettings().Operation,
-                        GetManipulatorSettings().Snap ? &GetManipulatorSettings().SnapValue : NULL);
+    if (ImGui::AttachGizmo (theAISContext,
+                            theView,
+                            aSelectedObject,
+                            GetManipulatorSettings().Operation,
+                            GetManipulatorSettings().Snap ? &GetManipulatorSettings().SnapValue : NULL))
+    {
+      myViewer->RestartRendering(); // moved objects are not tracked by the view state
+    }
     if (ImGui::IsMouseDoubleClicked (0) && !theHasFocus)
     {
       GetManipulatorSettings().Operation = (GetManipulatorSettings().Operation + 1) % 3;
@@ -1030,6 +1193,11 @@ void AppGui::ConsoleExec (const char* theCommand, bool theEcho)
   AppConsole* aConsole = static_cast<AppConsole*> (getPanel("AppConsole"));
 
   aConsole->ExecCommand (theCommand, theEcho);
+
+  // Command may change the scene, so accumulation is restarted
+  ie::Convergence::GetInstance ()->Reset ();
+
+  myViewer->StopUpdating (false);
 }
 
 //=======================================================================
@@ -1041,6 +1209,96 @@ bool AppGui::IsViewBlocked()
   return ImGui::IsAnyPopupOpen();
 }
 
+//=======================================================================
+//function : IsBusy
+//purpose  :
+//=======================================================================
+bool AppGui::IsBusy()
+{
+  return myExporter.get() != NULL;
+}
+
+//=======================================================================
+//function : startExport
+//purpose  :
+//=======================================================================
+void AppGui::startExport (const char* thePath, V3d_View* theView, const bool theIsDrawCompatible)
+{
+  if (myExporter)
+  {
+    return; // previous export is still running
+  }
+
+  myExporter.reset (new ie::ImportExport (theIsDrawCompatible));
+
+  myExporter->SetCompression (GetSettings().GetBoolean ("export", "compress_shapes", false));
+
+  myExportDone = false;
+  myShowExportDialog = true;
+
+  // OCCT objects (AIS aspects, view, lights) are read here in the main thread
+  if (!myExporter->Prepare (thePath, theView))
+  {
+    myExportDone = true;
+
+    return;
+  }
+
+  // UI stays responsive (and blocked by modal dialog) while shapes are meshed and files are written
+  myExportThread = std::thread ([this]()
+  {
+    myExporter->Store ();
+
+    myExportDone = true;
+  });
+}
+
+//=======================================================================
+//function : drawExportProgress
+//purpose  :
+//=======================================================================
+void AppGui::drawExportProgress()
+{
+  if (myShowExportDialog)
+  {
+    ImGui::OpenPopup ("Export scene##Dialog");
+  }
+
+  if (ImGui::BeginPopupModal ("Export scene##Dialog", NULL, ImGuiWindowFlags_AlwaysAutoResize))
+  {
+    myShowExportDialog = false;
+
+    const int aNbFiles = myExporter ? myExporter->NbFilesToStore() : 0;
+    const int aNbDone  = myExporter ? myExporter->NbFilesStored()  : 0;
+
+    const int aNbPending = myExporter ? myExporter->NbFilesPending() : 0;
+
+    if (aNbPending > 0)
+    {
+      ImGui::Text ("Meshing scene shapes: %d left", aNbPending);
+    }
+    else
+    {
+      ImGui::Text ("Writing scene files: %d of %d", aNbDone, aNbFiles);
+    }
+
+    ImGui::ProgressBar (aNbFiles > 0 ? aNbDone / static_cast<float> (aNbFiles) : 0.f, ImVec2 (300.f, 0.f));
+
+    if (myExportDone)
+    {
+      if (myExportThread.joinable())
+      {
+        myExportThread.join();
+      }
+      myExporter.reset();
+
+      ImGui::CloseCurrentPopup();
+    }
+
+    ImGui::EndPopup();
+  }
+}
+
 //=======================================================================
 //function : getPanel
 //purpose  :
@@ -12,6 +12,8 @@
 #define _AppGui_HeaderFile
 
 #include <memory>
+#include <thread>
+#include <atomic>
 
 #include <GuiBase.hxx>
 #include <GuiPanel.hxx>
@@ -19,6 +21,11 @@
 
 #include <Draw_Interpretor.hxx>
 
+namespace ie
+{
+  class ImportExport;
+}
+
 //! This class implements main UI of the application.
 class AppGui : public GuiBase
 {
@@ -61,10 +68,19 @@ protected:
   //! Handles file drag & drop event.
   virtual void HandleFileDrop (const char* thePath);
 
+  //! Returns TRUE if scene export is in progress.
+  virtual bool IsBusy();
+
 protected:
 
   GuiPanel* getPanel (const char* theID);
 
+  //! Starts scene export in background thread.
+  void startExport (const char* thePath, V3d_View* theView, const bool theIsDrawCompatible);
+
+  //! Shows export progress and finishes export.
+  void drawExportProgress ();
+
 protected:
 
   //! Viewer used for UI rendering.
@@ -88,5 +104,17 @@ protected:
   //! Indicates that import settings dialog should be opened.
   bool myShowImportDialog = false;
 
+  //! Indicates that export progress dialog should be opened.
+  bool myShowExportDialog = false;
+
+  //! Scene exporter running in background thread.
+  std::unique_ptr<ie::ImportExport> myExporter;
+
+  //! Background thread performing scene export.
+  std::thread myExportThread;
+
+  //! Indicates that background export is finished.
+  std::atomic<bool> myExportDone;
+
 };
 #endif // _AppGui_HeaderFile
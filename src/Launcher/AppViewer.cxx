@@ -18,14 +18,29 @@
   #include <GL/glx.h>
 #endif
 
+#if defined(HAVE_EGL)
+  #include <EGL/egl.h>
+  #include <EGL/eglext.h>
+#endif
+
 #include <OpenGl_Context.hxx>
 
 #include "AppViewer.hxx"
 #include "GuiBase.hxx"
 #include "ViewControls.h"
 #include "CustomWindow.hxx"
+#include "FrameProfiler.hxx"
+#include "TileWriter.hxx"
+#include "ImageCapture.hxx"
 
 #include <DataModel.hxx>
+#include <MeshQueue.hxx>
+#include <MeshRefiner.hxx>
+#include <ImportCache.hxx>
+#include <Convergence.hxx>
+#include <Checkpoint.hxx>
+#include <AovBuffers.hxx>
+#include <Denoiser.hxx>
 #include <DataContext.hxx>
 
 #include <imgui.h>
@@ -41,11 +56,16 @@
 #include <OpenGl_GraphicDriver.hxx>
 #include <OpenGl_FrameBuffer.hxx>
 #include <OpenGl_View.hxx>
+#include <Graphic3d_CameraTile.hxx>
 
 #include <V3d_Viewer.hxx>
 #include <V3d_View.hxx>
+#include <OSD.hxx>
+#include <OSD_Timer.hxx>
+#include <Draw_Interpretor.hxx>
 #include <AIS_InteractiveContext.hxx>
 #include <WNT_Window.hxx>
+#include <Aspect_NeutralWindow.hxx>
 #include <V3d_RectangularGrid.hxx>
 #include <gp_Ax3.hxx>
 
@@ -76,6 +96,9 @@ Standard_IMPORT ViewerTest_DoubleMapOfInteractiveAndName& GetMapOfAIS();
 #include <DataModel.hxx>
 
 #include <set>
+#include <vector>
+#include <cmath>
+#include <fstream>
 
 //! Internal state of viewer.
 struct AppViewer_Internal
@@ -101,8 +124,6 @@ struct AppViewer_Internal
       NeedToOpenPopup (false),
       NeedToStopUpdating (false),
       CurFramesCount (0)
-      //WorkingTime (0),
-      //MaxWorkingTime (0)
   {}
 
   double MouseStartX;
@@ -119,6 +140,8 @@ struct AppViewer_Internal
 
   bool NeedToResizeFBO = false;
 
+  bool IsHeadless = false;
+
   bool ImguiHasFocus;
   bool ImguiHasKeyboardFocus = false;
   bool RenderWindowHasFocus;
@@ -147,9 +170,53 @@ struct AppViewer_Internal
 
   int CurFramesCount;
 
-  //float WorkingTime;
+  FrameProfiler Profiler;
+
+  //! Number of input and window events since the last check.
+  int NbEvents = 0;
+
+  //! Time of the last event (in seconds).
+  double LastEventTime = 0.0;
+
+  //! Set when the main loop has been waiting for events.
+  bool WasIdle = false;
+
+  //! Current scale of render resolution.
+  float ResolutionScale = 1.f;
+
+  //! Set when the previous frame was rendered during camera interaction.
+  bool WasMoving = false;
+
+  //! Scale of render resolution adapted during camera interaction.
+  float InteractiveScale = 1.f;
+
+  //! Time of the last camera change (in seconds).
+  double LastMotionTime = -1.0;
+
+  //! Camera state at the last camera change.
+  Standard_Size MotionCameraState = 0;
+
+  //! Texture of image restored from checkpoint.
+  GLuint RestoredTexture = 0;
+
+  //! Revision of image uploaded to the texture.
+  int RestoredRevision = 0;
+
+  //! Texture of denoised image.
+  GLuint DenoisedTexture = 0;
+
+  //! Revision of denoised image uploaded to the texture.
+  int DenoisedRevision = 0;
+
+  //! Asynchronous capture of rendered frames.
+  ImageCapture Capture;
 
-  //float MaxWorkingTime;
+#if defined(HAVE_EGL)
+  //! Off-screen EGL context of headless mode (no window system is used).
+  EGLDisplay EglDisplay = EGL_NO_DISPLAY;
+  EGLContext EglContext = EGL_NO_CONTEXT;
+  EGLSurface EglSurface = EGL_NO_SURFACE;
+#endif
 
   void (*SelectionCallback)(GuiBase* theGui) = NULL;
 
@@ -166,7 +233,13 @@ struct AppViewer_Testing
     Script (""),
     MaxFramesCount (0),
     AverageFramerate (0.f),
-    NeedToRunScript (false)
+    FramesCount (0),
+    RenderTime (0.0),
+    FirstFrameTime (0.0),
+    NeedToRunScript (false),
+    TileSize (0),
+    ToDenoise (false),
+    IsConverged (true)
   {}
 
   std::string Script;
@@ -175,9 +248,33 @@ struct AppViewer_Testing
 
   double AverageFramerate;
 
+  int FramesCount;
+
+  double RenderTime;
+
+  double FirstFrameTime;
+
   bool NeedToRunScript;
 
   Image_AlienPixMap PixMap;
+
+  //! Size of tiles (0 if image is rendered at once).
+  int TileSize;
+
+  //! Output file of tiled rendering.
+  std::string OutputFile;
+
+  //! Output file of radiance and auxiliary buffers (empty if not needed).
+  std::string AovFile;
+
+  //! Set if output image and radiance are denoised.
+  bool ToDenoise;
+
+  //! Report file of denoiser benchmark (empty if not needed).
+  std::string DenoiseReport;
+
+  //! Cleared if rendering was stopped by the safety limit before reaching the noise target.
+  bool IsConverged;
 };
 
 struct AppViewer_Camera
@@ -287,6 +384,8 @@ void MouseButtonCallback (GLFWwindow* theWindow, int theButton, int theAction, i
 
   assert (aViewerInternal);
 
+  ++aViewerInternal->NbEvents;
+
   if (aViewerInternal->NeedToShowHint && aViewerInternal->ExternalGui != NULL)
   {
     aViewerInternal->NeedToShowHint = false;
@@ -470,6 +569,8 @@ void MouseMoveCallback (GLFWwindow* window, double xpos, double ypos)
 
   assert (aViewerInternal);
 
+  ++aViewerInternal->NbEvents;
+
   aViewerInternal->MouseCurrentX = xpos;
   aViewerInternal->MouseCurrentY = ypos;
 
@@ -495,6 +596,8 @@ void ScrollCallback (GLFWwindow* window, double xoffset, double yoffset)
 
   assert (aViewerInternal);
 
+  ++aViewerInternal->NbEvents;
+
   ImGui_ImplGlfwGL3_ScrollCallback (window, xoffset, yoffset);
 
   if (aViewerInternal->ImguiHasFocus || aViewerInternal->IsViewBlocked())
@@ -519,6 +622,8 @@ void KeyCallback (GLFWwindow* theWindow, int theKey, int theScancode, int theAct
 
   assert (aViewerInternal);
 
+  ++aViewerInternal->NbEvents;
+
   ImGui_ImplGlfwGL3_KeyCallback (theWindow, theKey, theScancode, theAction, theMods);
 
   if (aViewerInternal->CurrentViewControls != NULL && theAction == GLFW_RELEASE)
@@ -551,6 +656,8 @@ void fileDropCallback (GLFWwindow* theWindow, int theCount, const char** thePath
   AppViewer_Internal* aViewerInternal = reinterpret_cast<AppViewer_Internal*> (
     glfwGetWindowUserPointer (theWindow));
 
+  ++aViewerInternal->NbEvents;
+
   if (aViewerInternal->ExternalGui == NULL || theCount == 0)
   {
     return;
@@ -560,428 +667,965 @@ void fileDropCallback (GLFWwindow* theWindow, int theCount, const char** thePath
   aViewerInternal->ExternalGui->HandleFileDrop (thePaths[0]);
 }
 
-} // namespace
+//=======================================================================
+//function : CharCallback
+//purpose  :
+//=======================================================================
+void CharCallback (GLFWwindow* theWindow, unsigned int theChar)
+{
+  AppViewer_Internal* aViewerInternal = reinterpret_cast<AppViewer_Internal*> (
+    glfwGetWindowUserPointer (theWindow));
+
+  ++aViewerInternal->NbEvents;
+
+  ImGui_ImplGlfwGL3_CharCallback (theWindow, theChar);
+}
 
 //=======================================================================
-//function : AppViewer
+//function : WindowStateCallback
+//purpose  : Handles focus and iconification of the window
+//=======================================================================
+void WindowStateCallback (GLFWwindow* theWindow, int /*theState*/)
+{
+  AppViewer_Internal* aViewerInternal = reinterpret_cast<AppViewer_Internal*> (
+    glfwGetWindowUserPointer (theWindow));
+
+  ++aViewerInternal->NbEvents;
+}
+
+//=======================================================================
+//function : WindowSizeCallback
 //purpose  :
 //=======================================================================
-AppViewer::AppViewer (const std::string theTitle,
-                      const std::string theDataDir,
-                      const int theWidth /*= 1600*/,
-                      const int theHeight /*= 900*/)
-  : myTitle (theTitle),
-    myDataDir (theDataDir),
-    myInternal (new AppViewer_Internal),
-    myTestingData (NULL),
-    myCameraMovingData (new AppViewer_Camera)
+void WindowSizeCallback (GLFWwindow* theWindow, int /*theSizeX*/, int /*theSizeY*/)
+{
+  AppViewer_Internal* aViewerInternal = reinterpret_cast<AppViewer_Internal*> (
+    glfwGetWindowUserPointer (theWindow));
+
+  ++aViewerInternal->NbEvents;
+}
+
+//=======================================================================
+//function : WindowRefreshCallback
+//purpose  :
+//=======================================================================
+void WindowRefreshCallback (GLFWwindow* theWindow)
 {
-  glfwSetErrorCallback (errorCallback);
+  AppViewer_Internal* aViewerInternal = reinterpret_cast<AppViewer_Internal*> (
+    glfwGetWindowUserPointer (theWindow));
+
+  ++aViewerInternal->NbEvents;
+}
 
-  if (!glfwInit())
+//=======================================================================
+//function : drawFrameTimings
+//purpose  : Draws stacked graph of frame timings with average values
+//=======================================================================
+void drawFrameTimings (ImDrawList* theDrawList, const FrameProfiler& theProfiler, const ImVec2& thePos)
+{
+  static const ImU32 THE_COLORS[FrameProfiler::Stage_NB] =
   {
-    throw std::runtime_error ("Could not initialize window");
-  }
+    IM_COL32 (120, 120, 120, 255), // events
+    IM_COL32 ( 80, 160, 255, 255), // GUI build
+    IM_COL32 (255, 140,  40, 255), // scene update
+    IM_COL32 ( 80, 200,  80, 255), // accumulation
+    IM_COL32 (200,  80, 200, 255)  // GUI render
+  };
 
-#ifdef WIN32
-  // Tell Windows we can handle custom DPI
-  SetProcessDPIAware();
-#endif
+  const float aScale = ImGui::GetIO().FontGlobalScale;
 
-  // Create GLFW window
-  myInternal->Window = glfwCreateWindow (theWidth, theHeight, theTitle.c_str(), NULL, NULL);
-  glfwMakeContextCurrent (myInternal->Window);
+  const ImVec2 aGraphSize (256.f * aScale, 64.f * aScale);
 
-#if (GLFW_VERSION_MAJOR * 10 + GLFW_VERSION_MINOR >= 32)
-  glfwMaximizeWindow (myInternal->Window);
-#endif
+  const float aLineHeight = ImGui::GetTextLineHeight();
 
-  glfwSetWindowUserPointer (myInternal->Window, myInternal);
+  // Full height of the graph corresponds to 33 ms (30 FPS)
+  const float aMaxTime = 1000.f / 30.f;
 
-  Handle (Aspect_DisplayConnection) aDisplayConnection = new Aspect_DisplayConnection;
-  Handle (OpenGl_GraphicDriver) aGraphicDriver = new OpenGl_GraphicDriver (aDisplayConnection);
+  theDrawList->AddRectFilled (thePos,
+                              ImVec2 (thePos.x + aGraphSize.x, thePos.y + aGraphSize.y + aLineHeight * (FrameProfiler::Stage_NB + 1)),
+                              IM_COL32 (0, 0, 0, 160));
 
-  aGraphicDriver->ChangeOptions().buffersNoSwap = Standard_True;
+  const int aNbFrames = std::min (theProfiler.NbFrames(), static_cast<int> (aGraphSize.x));
 
-  // Create viewer
-  TCollection_ExtendedString a3DName ("Vis3D");
+  const float aBarWidth = aGraphSize.x / std::max (aNbFrames, 1);
 
-  Handle (V3d_Viewer) a3DViewer = new V3d_Viewer (aGraphicDriver,
-    a3DName.ToExtString(), "", 1000.0, V3d_XposYnegZpos, Quantity_NOC_GRAY20, V3d_ZBUFFER, V3d_PHONG);
+  for (int aFrameIdx = 0; aFrameIdx < aNbFrames; ++aFrameIdx)
+  {
+    const FrameProfiler::Frame& aFrame = theProfiler.Value (theProfiler.NbFrames() - aNbFrames + aFrameIdx);
 
-  myInternal->AISContext = new AIS_InteractiveContext (a3DViewer);
+    float aBottom = thePos.y + aGraphSize.y;
 
-  glfwSetDropCallback (myInternal->Window, fileDropCallback);
+    for (int aStage = 0; aStage < FrameProfiler::Stage_NB; ++aStage)
+    {
+      const float aTop = std::max (aBottom - aFrame.Times[aStage] / aMaxTime * aGraphSize.y, thePos.y);
 
-  // View setup
-  myInternal->View = a3DViewer->CreateView();
-#ifdef WIN32
-  Handle (CustomWindow) aWindow = new CustomWindow ((Aspect_Handle) glfwGetWin32Window (myInternal->Window));
-  Aspect_RenderingContext aRenderingContext = (Aspect_RenderingContext) wglGetCurrentContext();
-#else
-  Handle (CustomWindow) aWindow = new CustomWindow (aGraphicDriver->GetDisplayConnection(), glfwGetX11Window (myInternal->Window));
-  Aspect_RenderingContext aRenderingContext = NULL;
-#endif
+      theDrawList->AddRectFilled (ImVec2 (thePos.x + aFrameIdx * aBarWidth, aTop),
+                                  ImVec2 (thePos.x + (aFrameIdx + 1) * aBarWidth, aBottom), THE_COLORS[aStage]);
 
-  myInternal->View->SetWindow (aWindow, aRenderingContext);
+      aBottom = aTop;
+    }
+  }
 
-  a3DViewer->SetDefaultLights();
-  a3DViewer->SetLightOn();
+  const FrameProfiler::Frame anAverage = theProfiler.Average();
 
-  // Setup FBO
-  myInternal->GLContext = aGraphicDriver->GetSharedContext();
+  char aText[64];
 
-  myInternal->View->SetImmediateUpdate (Standard_False);
-  myInternal->View->Redraw();
-  myInternal->ScreenFBO = Handle(OpenGl_FrameBuffer)::DownCast (myInternal->View->View()->FBOCreate (theWidth, theHeight));
-  myInternal->ScreenFBO->ColorTexture()->Sampler()->Parameters()->SetFilter(Graphic3d_TOTF_BILINEAR);
-  myInternal->View->View()->SetFBO (myInternal->ScreenFBO);
+  ImVec2 aTextPos (thePos.x + aLineHeight * 1.5f, thePos.y + aGraphSize.y + aLineHeight * 0.5f);
 
-  // Setup ImGui
-  ImGui_ImplGlfwGL3_Init (myInternal->Window, true);
+  for (int aStage = 0; aStage < FrameProfiler::Stage_NB; ++aStage, aTextPos.y += aLineHeight)
+  {
+    theDrawList->AddRectFilled (ImVec2 (thePos.x + aLineHeight * 0.25f, aTextPos.y + aLineHeight * 0.25f),
+                                ImVec2 (thePos.x + aLineHeight, aTextPos.y + aLineHeight), THE_COLORS[aStage]);
 
-  // Setup fonts
-  ImGuiIO& anIo = ImGui::GetIO();
-  anIo.Fonts->AddFontFromFileTTF ((myDataDir + "fonts/Monoid-Italic.ttf").c_str(), 16.f);
-//  anIo.Fonts->AddFontFromMemoryCompressedTTF (DroidSans_compressed_data, DroidSans_compressed_size, 15.0f);
+    sprintf (aText, "%-13s %6.2f ms", FrameProfiler::StageName (static_cast<FrameProfiler::Stage> (aStage)), anAverage.Times[aStage]);
 
-  // merge in icons from Font Awesome
-  static const ImWchar anIconsRanges[] = { ICON_MIN_FA, ICON_MAX_FA, 0 };
-  ImFontConfig anIconsConfig;
-  anIconsConfig.MergeMode = true;
-  anIconsConfig.PixelSnapH = true;
-  // TODO: embed into sources
-  anIo.Fonts->AddFontFromFileTTF ((myDataDir + "fonts/fontawesome-webfont.ttf").c_str(), 16.0f, &anIconsConfig, anIconsRanges);
+    theDrawList->AddText (aTextPos, IM_COL32 (255, 255, 255, 255), aText);
+  }
+}
 
-  anIo.Fonts->AddFontFromFileTTF ((myDataDir + "fonts/Monoid-Regular.ttf").c_str(), 16.f);
-//  anIo.Fonts->AddFontFromMemoryCompressedTTF (EnvyItalic_compressed_data, EnvyItalic_compressed_size, 15.0f);
+//=======================================================================
+//function : uploadImage
+//purpose  : Uploads RGB float image (top-down rows) to the texture
+//=======================================================================
+void uploadImage (GLuint& theTexture, const Image_PixMap& theImage)
+{
+  if (theImage.IsEmpty ())
+  {
+    return;
+  }
 
-  // Setup OCCT logo texture
-  int aTexComp;
-  void* aTexData = stbi_load_from_memory (reinterpret_cast<const unsigned char*> (OcctLogoPng_data),
-                                          static_cast<int> (OcctLogoPng_size),
-                                          &myInternal->LogoW,
-                                          &myInternal->LogoH,
-                                          &aTexComp,
-                                          0);
+  // Rows of texture go from bottom to top (as in FBO)
+  std::vector<float> aData (theImage.SizeX () * theImage.SizeY () * 3);
 
-  glGenTextures (1, &myInternal->LogoTexture);
+  for (Standard_Size aRow = 0; aRow < theImage.SizeY (); ++aRow)
+  {
+    memcpy (&aData[(theImage.SizeY () - 1 - aRow) * theImage.SizeX () * 3], theImage.Row (aRow), theImage.SizeX () * 3 * sizeof (float));
+  }
 
-  glBindTexture (GL_TEXTURE_2D, myInternal->LogoTexture);
+  if (theTexture == 0)
+  {
+    glGenTextures (1, &theTexture);
+  }
+
+  glBindTexture (GL_TEXTURE_2D, theTexture);
 
   glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
   glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 
-  glTexImage2D (GL_TEXTURE_2D, 0, GL_RGBA,
-    myInternal->LogoW, myInternal->LogoH, 0, GL_RGBA, GL_UNSIGNED_BYTE, static_cast<const GLubyte*> (aTexData));
+  glTexImage2D (GL_TEXTURE_2D, 0, GL_RGB8, static_cast<GLsizei> (theImage.SizeX ()), static_cast<GLsizei> (theImage.SizeY ()),
+    0, GL_RGB, GL_FLOAT, &aData[0]);
 
   glBindTexture (GL_TEXTURE_2D, 0);
+}
 
-  stbi_image_free (aTexData);
+//=======================================================================
+//function : updateRestoredTexture
+//purpose  : Uploads image restored from checkpoint to the texture
+//=======================================================================
+void updateRestoredTexture (AppViewer_Internal* theInternal)
+{
+  theInternal->RestoredRevision = ie::Checkpoint::GetInstance ()->Revision ();
 
-  ImGui_ImplGlfwGL3_NewFrame();
+  // Restored image keeps linear radiance, so it is tone mapped for display
+  Image_PixMap anImage;
 
-  // Set input callbacks
-  glfwSetMouseButtonCallback (myInternal->Window, MouseButtonCallback);
-  glfwSetScrollCallback (myInternal->Window, ScrollCallback);
-  glfwSetCursorPosCallback (myInternal->Window, MouseMoveCallback);
-  glfwSetKeyCallback (myInternal->Window, KeyCallback);
+  if (anImage.InitCopy (ie::Checkpoint::GetInstance ()->RestoredImage ()))
+  {
+    ie::Checkpoint::GetInstance ()->ToDisplay (anImage);
 
-  // Setup camera
-  Handle (Graphic3d_Camera) aCamera = myInternal->View->Camera();
+    uploadImage (theInternal->RestoredTexture, anImage);
+  }
 }
 
 //=======================================================================
-//function : Display
-//purpose  :
+//function : updateDenoisedTexture
+//purpose  : Uploads denoised image to the texture
 //=======================================================================
-void AppViewer::DisplayPointCloud (Handle(AIS_InteractiveObject) thePointCloud)
+void updateDenoisedTexture (AppViewer_Internal* theInternal)
 {
-  thePointCloud->SetZLayer (Graphic3d_ZLayerId_Top);
-  thePointCloud->SetToUpdate();
-  myInternal->AISContext->Display (thePointCloud, Standard_False);
+  theInternal->DenoisedRevision = ie::Denoiser::GetInstance ()->Revision ();
 
-  myInternal->View->FitAll();
+  uploadImage (theInternal->DenoisedTexture, ie::Denoiser::GetInstance ()->Image ());
 }
 
+//! Time (in seconds) to keep reduced resolution after the last camera change.
+static const double THE_MOTION_DELAY = 0.2;
+
+//! Minimum scale of render resolution during camera interaction.
+static const float THE_MIN_RESOLUTION_SCALE = 0.25f;
+
+//! Step of render resolution scale (prevents re-allocation of FBO each frame).
+static const float THE_RESOLUTION_SCALE_STEP = 0.0625f;
+
 //=======================================================================
-//function : Run
-//purpose  :
+//function : updateResolutionScale
+//purpose  : Adapts scale of render resolution to reach the target frame
+//           time while the camera is moving (returns 1 otherwise)
 //=======================================================================
-void AppViewer::Run()
+float updateResolutionScale (AppViewer_Internal* theInternal, const double theTargetTime, const float theDeltaTime)
 {
-  if (myInternal == NULL)
+  const double aTime = glfwGetTime();
+
+  const Handle (Graphic3d_Camera)& aCamera = theInternal->View->Camera();
+
+  const Standard_Size aCameraState = aCamera->WorldViewState() + aCamera->ProjectionState();
+
+  if (aCameraState != theInternal->MotionCameraState
+   || (theInternal->CurrentViewControls != NULL && theInternal->CurrentViewControls->IsMoving()))
   {
-    return;
+    theInternal->MotionCameraState = aCameraState;
+    theInternal->LastMotionTime = aTime;
   }
 
-  if (myInternal->ExternalGui != NULL)
+  const bool isMoving = theTargetTime > 0.0
+                     && theInternal->LastMotionTime >= 0.0
+                     && aTime - theInternal->LastMotionTime < THE_MOTION_DELAY;
+
+  const bool wasMoving = theInternal->WasMoving;
+
+  theInternal->WasMoving = isMoving;
+
+  if (!isMoving)
   {
-    ImGui::LoadDocks (myInternal->ExternalGui->GetSettings());
+    theInternal->ResolutionScale = 1.f; // last interactive scale is kept for the next interaction
+
+    return 1.f;
   }
 
-  ImDrawList* AppOverlayDrawList;
+  // Previous frame was rendered with the current scale, so its time is
+  // used to correct the scale (rendering time is proportional to area)
+  if (wasMoving && theDeltaTime > 0.f)
+  {
+    const float aDesiredScale = theInternal->ResolutionScale * static_cast<float> (std::sqrt (theTargetTime / theDeltaTime));
 
-  bool show_test_window = false;
+    // Smooth changes to avoid oscillations
+    theInternal->InteractiveScale = std::max (THE_MIN_RESOLUTION_SCALE,
+      std::min (0.5f * (theInternal->InteractiveScale + aDesiredScale), 1.f));
+  }
 
-  // Main loop
-  while (!glfwWindowShouldClose (myInternal->Window))
+  theInternal->ResolutionScale = std::max (THE_MIN_RESOLUTION_SCALE,
+    std::floor (theInternal->InteractiveScale / THE_RESOLUTION_SCALE_STEP + 0.5f) * THE_RESOLUTION_SCALE_STEP);
+
+  return theInternal->ResolutionScale;
+}
+
+//! Time (in seconds) to keep drawing after the last event (for GUI
+//! animations and delayed tooltips).
+static const double THE_IDLE_DELAY = 0.5;
+
+//! Time (in seconds) to wait for events while background work is running.
+static const double THE_BUSY_TIMEOUT = 0.05;
+
+//! Time (in seconds) to wait for events when there is nothing to do.
+static const double THE_IDLE_TIMEOUT = 0.5;
+
+//=======================================================================
+//function : waitEvents
+//purpose  : Blocks until some event if rendering is paused, converged or
+//           the window is minimized. Returns false if frame can be skipped
+//=======================================================================
+bool waitEvents (AppViewer_Internal* theInternal)
+{
+  const double aTime = glfwGetTime();
+
+  if (theInternal->NbEvents > 0 || theInternal->IsHoldingMouseButton)
   {
-    glfwPollEvents();
+    theInternal->NbEvents = 0;
+    theInternal->LastEventTime = aTime;
+  }
 
-    ImGui_ImplGlfwGL3_NewFrame();
+  const bool isIconified = glfwGetWindowAttrib (theInternal->Window, GLFW_ICONIFIED) != 0;
 
-    ImGuiIO& anIo = ImGui::GetIO();
+  if (!isIconified && (!theInternal->NeedToStopUpdating || aTime - theInternal->LastEventTime < THE_IDLE_DELAY))
+  {
+    return true;
+  }
 
-    AppOverlayDrawList = ImGui::GetOverlayWindowDrawList();
+  // Background work is finished by the main loop (swap of meshes, export progress)
+  const bool isBusy = ie::MeshQueue::GetInstance ()->NbQueued () > 0
+                   || ie::MeshRefiner::GetInstance ()->NbJobs () > 0
+                   || ie::MeshRefiner::GetInstance ()->IsPlanning ()
+                   || (theInternal->ExternalGui != NULL && theInternal->ExternalGui->IsBusy())
+                   || theInternal->Capture.IsBusy()
+                   || ie::Denoiser::GetInstance ()->IsBusy ();
 
-    if (myInternal->NeedToInitViewControls && myInternal->CurrentViewControls != NULL)
-    {
-      myInternal->CurrentViewControls->Init (myInternal->View->Camera(), static_cast<int> (myInternal->Viewport.x),
-                                                                         static_cast<int> (myInternal->Viewport.y));
+  const double aTimeout = isBusy && !isIconified ? THE_BUSY_TIMEOUT : THE_IDLE_TIMEOUT;
 
-      myInternal->CurrentViewControls->RegisterKey (ViewControls::MOUSE_LEFT, GLFW_MOUSE_BUTTON_1);
-      myInternal->CurrentViewControls->RegisterKey (ViewControls::MOUSE_RIGHT, GLFW_MOUSE_BUTTON_2);
-      myInternal->CurrentViewControls->RegisterKey (ViewControls::MOUSE_MIDDLE, GLFW_MOUSE_BUTTON_3);
+#if (GLFW_VERSION_MAJOR * 10 + GLFW_VERSION_MINOR >= 32)
+  glfwWaitEventsTimeout (aTimeout);
+#else
+  glfwPollEvents();
 
-      myInternal->CurrentViewControls->RegisterKey (ViewControls::KEY_UP, GLFW_KEY_UP);
-      myInternal->CurrentViewControls->RegisterKey (ViewControls::KEY_DOWN, GLFW_KEY_DOWN);
-      myInternal->CurrentViewControls->RegisterKey (ViewControls::KEY_LEFT, GLFW_KEY_LEFT);
-      myInternal->CurrentViewControls->RegisterKey (ViewControls::KEY_RIGHT, GLFW_KEY_RIGHT);
+  OSD::MilliSecSleep (static_cast<int> (aTimeout * 1000.0));
+#endif
 
-      myInternal->CurrentViewControls->RegisterKey (ViewControls::KEY_W, GLFW_KEY_W);
-      myInternal->CurrentViewControls->RegisterKey (ViewControls::KEY_S, GLFW_KEY_S);
-      myInternal->CurrentViewControls->RegisterKey (ViewControls::KEY_A, GLFW_KEY_A);
-      myInternal->CurrentViewControls->RegisterKey (ViewControls::KEY_D, GLFW_KEY_D);
-      myInternal->NeedToInitViewControls = false;
-    }
+  theInternal->WasIdle = true;
 
-    if (myInternal->CurrentViewControls)
+  return !isIconified && (theInternal->NbEvents > 0 || isBusy);
+}
+
+#if defined(HAVE_EGL)
+
+#ifndef EGL_PLATFORM_SURFACELESS_MESA
+  #define EGL_PLATFORM_SURFACELESS_MESA 0x31DD
+#endif
+
+//=======================================================================
+//function : initEglContext
+//purpose  : Creates off-screen context, which does not need X server
+//=======================================================================
+bool initEglContext (AppViewer_Internal* theInternal, const int theWidth, const int theHeight, EGLConfig& theConfig)
+{
+  PFNEGLGETPLATFORMDISPLAYEXTPROC aGetPlatformDisplay =
+    reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC> (eglGetProcAddress ("eglGetPlatformDisplayEXT"));
+
+  EGLDisplay aDisplay = EGL_NO_DISPLAY;
+
+  // Surfaceless platform of Mesa works without display server,
+  // otherwise default display of the driver is used (e.g. NVIDIA)
+  if (aGetPlatformDisplay != NULL)
+  {
+    aDisplay = aGetPlatformDisplay (EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+
+    if (aDisplay != EGL_NO_DISPLAY && eglInitialize (aDisplay, NULL, NULL) != EGL_TRUE)
     {
-      myInternal->CurrentViewControls->Update (anIo.DeltaTime);
+      aDisplay = EGL_NO_DISPLAY;
     }
+  }
 
-    if (myInternal->NeedToFitAll)
+  if (aDisplay == EGL_NO_DISPLAY)
+  {
+    aDisplay = eglGetDisplay (EGL_DEFAULT_DISPLAY);
+
+    if (aDisplay == EGL_NO_DISPLAY || eglInitialize (aDisplay, NULL, NULL) != EGL_TRUE)
     {
-      myInternal->View->FitAll();
-      myInternal->NeedToFitAll = false;
+      return false;
     }
+  }
 
-    auto& aStyle = ImGui::GetStyle();
-    ImVec2 aNormalWinPadding = aStyle.WindowPadding;
-    aStyle.WindowPadding = ImVec2 (0.f, 0.f);
+  theInternal->EglDisplay = aDisplay;
 
-    ImVec2 aMainWinPos (0.f, ImGui::GetTextLineHeightWithSpacing() + 1);
-    ImVec2 aMainWinSize = anIo.DisplaySize;
-    aMainWinSize.y -= aMainWinPos.y;
-    ImGui::SetNextWindowPos (aMainWinPos);
-    ImGui::SetNextWindowSize (aMainWinSize);
-    if (!ImGui::Begin ("Main window", NULL, ImVec2(0,0), 1.0f, ImGuiWindowFlags_NoTitleBar|ImGuiWindowFlags_NoResize|ImGuiWindowFlags_NoMove|ImGuiWindowFlags_NoSavedSettings))
+  if (eglBindAPI (EGL_OPENGL_API) != EGL_TRUE)
+  {
+    return false;
+  }
+
+  const EGLint aConfigAttribs[] =
+  {
+    EGL_SURFACE_TYPE,    EGL_PBUFFER_BIT,
+    EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+    EGL_RED_SIZE,        8,
+    EGL_GREEN_SIZE,      8,
+    EGL_BLUE_SIZE,       8,
+    EGL_DEPTH_SIZE,      24,
+    EGL_STENCIL_SIZE,    8,
+    EGL_NONE
+  };
+
+  EGLint aNbConfigs = 0;
+
+  if (eglChooseConfig (aDisplay, aConfigAttribs, &theConfig, 1, &aNbConfigs) != EGL_TRUE || aNbConfigs < 1)
+  {
+    return false;
+  }
+
+  theInternal->EglContext = eglCreateContext (aDisplay, theConfig, EGL_NO_CONTEXT, NULL);
+
+  if (theInternal->EglContext == EGL_NO_CONTEXT)
+  {
+    return false;
+  }
+
+  // Image is rendered to FBO, pbuffer is only used to bind the context
+  const EGLint aSurfaceAttribs[] = { EGL_WIDTH, theWidth, EGL_HEIGHT, theHeight, EGL_NONE };
+
+  theInternal->EglSurface = eglCreatePbufferSurface (aDisplay, theConfig, aSurfaceAttribs);
+
+  return theInternal->EglSurface != EGL_NO_SURFACE
+      && eglMakeCurrent (aDisplay, theInternal->EglSurface, theInternal->EglSurface, theInternal->EglContext) == EGL_TRUE;
+}
+
+//=======================================================================
+//function : releaseEglContext
+//purpose  :
+//=======================================================================
+void releaseEglContext (EGLDisplay theDisplay, EGLContext theContext, EGLSurface theSurface)
+{
+  if (theDisplay == EGL_NO_DISPLAY)
+  {
+    return;
+  }
+
+  eglMakeCurrent (theDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+
+  if (theSurface != EGL_NO_SURFACE)
+  {
+    eglDestroySurface (theDisplay, theSurface);
+  }
+
+  if (theContext != EGL_NO_CONTEXT)
+  {
+    eglDestroyContext (theDisplay, theContext);
+  }
+
+  eglTerminate (theDisplay);
+}
+
+#endif // HAVE_EGL
+
+} // namespace
+
+//=======================================================================
+//function : AppViewer
+//purpose  :
+//=======================================================================
+AppViewer::AppViewer (const std::string theTitle,
+                      const std::string theDataDir,
+                      const int theWidth /*= 1600*/,
+                      const int theHeight /*= 900*/,
+                      const bool theIsHeadless /*= false*/)
+  : myTitle (theTitle),
+    myDataDir (theDataDir),
+    myInternal (new AppViewer_Internal),
+    myTestingData (NULL),
+    myCameraMovingData (new AppViewer_Camera)
+{
+  myInternal->IsHeadless = theIsHeadless;
+
+  Handle (OpenGl_GraphicDriver) aGraphicDriver;
+
+  Handle (Aspect_Window) aWindow;
+
+  Aspect_RenderingContext aRenderingContext = NULL;
+
+#if defined(HAVE_EGL)
+  if (theIsHeadless)
+  {
+    // Headless mode renders to FBO of off-screen context, so neither
+    // GLFW window nor X server (e.g. xvfb) is needed
+    EGLConfig anEglConfig = NULL;
+
+    if (!initEglContext (myInternal, theWidth, theHeight, anEglConfig))
     {
-      aStyle.WindowPadding = aNormalWinPadding;
-      ImGui::End();
-      continue;
+      releaseEglContext (myInternal->EglDisplay, myInternal->EglContext, myInternal->EglSurface);
+
+      throw std::runtime_error ("Could not create EGL context");
     }
-    aStyle.WindowPadding = aNormalWinPadding;
-    ImGui::BeginWorkspace (AppOverlayDrawList);
 
-    myInternal->View->ZFitAll();
+    aGraphicDriver = new OpenGl_GraphicDriver (Handle (Aspect_DisplayConnection)(), Standard_False);
 
-    Handle (Graphic3d_Camera) aCamera = myInternal->View->Camera();
+    if (!aGraphicDriver->InitEglContext ((Aspect_Display) myInternal->EglDisplay, (Aspect_RenderingContext) myInternal->EglContext, anEglConfig))
+    {
+      releaseEglContext (myInternal->EglDisplay, myInternal->EglContext, myInternal->EglSurface);
 
-    ImGuizmo::BeginFrame (static_cast<int> (myInternal->Viewport.x),
-                          static_cast<int> (myInternal->Viewport.y),
-                          static_cast<int> (myInternal->ViewPos.x),
-                          static_cast<int> (myInternal->ViewPos.y),
-                          AppOverlayDrawList);
+      throw std::runtime_error ("Could not initialize OpenGL driver with EGL context");
+    }
 
-    ImGuizmo::Enable (!myInternal->IsHoldingMouseButton);
+    Handle (Aspect_NeutralWindow) aNeutralWindow = new Aspect_NeutralWindow();
 
-    // Screen
-    if (ImGui::BeginDock ("Viewport", NULL, ImGuiWindowFlags_NoScrollbar | ImGuiWindowFlags_NoScrollWithMouse))
-    {
-      unsigned int aTextureID;
-      ImVec2 aButtonSize (32, 32);
-      
-      ImGui::Columns (2, "", false);
-      ImGui::SetColumnOffset (1, ImGui::GetWindowContentRegionWidth() - ImGui::GetStyle().FramePadding.x - aButtonSize.x - 10);
-      
-      ImGui::PushStyleColor (ImGuiCol_Button, ImVec4 (0.5f, 0.5f, 0.5f, 1.00f));
-      ImGui::Spacing();
-      ImGui::SameLine();
-      aTextureID = Textures["Front"].Texture;
-      if (ImGui::ImageButton ((ImTextureID )(uintptr_t )aTextureID, aButtonSize, ImVec2 (0, 0), ImVec2 (1, 1), 2))
-      {
-        SetCameraRotating (gp_Vec (0, 1, 0), gp_Vec (0, 0, 1));
-      }
-      myInternal->ExternalGui->AddTooltip ("Front view");
+    aNeutralWindow->SetSize (theWidth, theHeight);
+    aNeutralWindow->SetVirtual (Standard_True);
 
-      ImGui::SameLine();
-      aTextureID = Textures["Back"].Texture;
-      if (ImGui::ImageButton ((ImTextureID )(uintptr_t )aTextureID, aButtonSize, ImVec2 (0, 0), ImVec2 (1, 1), 2))
-      {
-        SetCameraRotating (gp_Vec (0, -1, 0), gp_Vec (0, 0, 1));
-      }
-      myInternal->ExternalGui->AddTooltip ("Back view");
+    aWindow = aNeutralWindow;
 
-      ImGui::SameLine();
-      aTextureID = Textures["Left"].Texture;
-      if (ImGui::ImageButton ((ImTextureID )(uintptr_t )aTextureID, aButtonSize, ImVec2 (0, 0), ImVec2 (1, 1), 2))
-      {
-        SetCameraRotating (gp_Vec (1, 0, 0), gp_Vec (0, 0, 1));
-      }
-      myInternal->ExternalGui->AddTooltip ("Left view");
+    aRenderingContext = (Aspect_RenderingContext) myInternal->EglContext;
+  }
+  else
+#endif
+  {
+    glfwSetErrorCallback (errorCallback);
 
-      ImGui::SameLine();
-      aTextureID = Textures["Right"].Texture;
-      if (ImGui::ImageButton ((ImTextureID )(uintptr_t )aTextureID, aButtonSize, ImVec2 (0, 0), ImVec2 (1, 1), 2))
-      {
-        SetCameraRotating (gp_Vec (-1, 0, 0), gp_Vec (0, 0, 1));
-      }
-      myInternal->ExternalGui->AddTooltip ("Right view");
+    if (!glfwInit())
+    {
+      throw std::runtime_error ("Could not initialize window");
+    }
 
-      ImGui::SameLine();
-      aTextureID = Textures["Down"].Texture;
-      if (ImGui::ImageButton ((ImTextureID )(uintptr_t )aTextureID, aButtonSize, ImVec2 (0, 0), ImVec2 (1, 1), 2))
-      {
-        SetCameraRotating (gp_Vec (0, 0, 1), gp_Vec (1, 0, 0));
-      }
-      myInternal->ExternalGui->AddTooltip ("Down view");
+#ifdef WIN32
+    // Tell Windows we can handle custom DPI
+    SetProcessDPIAware();
+#endif
 
-      ImGui::SameLine();
-      aTextureID = Textures["Up"].Texture;
-      if (ImGui::ImageButton((ImTextureID )(uintptr_t )aTextureID, aButtonSize, ImVec2 (0, 0), ImVec2 (1, 1), 2))
-      {
-        SetCameraRotating (gp_Vec (0, 0, -1), gp_Vec (1, 0, 0));
-      }
-      myInternal->ExternalGui->AddTooltip ("Up view");
+    if (theIsHeadless)
+    {
+      // Window is only needed to create rendering context
+      glfwWindowHint (GLFW_VISIBLE, GLFW_FALSE);
+    }
 
-      ImGui::SameLine (0.0f, aStyle.ItemSpacing.x * 3.0f);
-      aTextureID = Textures["Focus"].Texture;
-      if (ImGui::ImageButton ((ImTextureID )(uintptr_t )aTextureID, aButtonSize, ImVec2 (0, 0), ImVec2 (1, 1), 2))
-      {
-        Bnd_Box aBndSelected;
-        Handle (AIS_InteractiveContext) aContext = myInternal->AISContext;
+#if defined(HAVE_EGL)
+    // OCCT built with EGL renders with the context of the window
+    glfwWindowHint (GLFW_CONTEXT_CREATION_API, GLFW_EGL_CONTEXT_API);
+#endif
 
-        for (aContext->InitSelected(); aContext->MoreSelected(); aContext->NextSelected())
-        {
-          Bnd_Box aTmpBnd;
-          aContext->SelectedInteractive().get()->BoundingBox (aTmpBnd);
-          aBndSelected.Add (aTmpBnd);
-        }
+    // Create GLFW window
+    myInternal->Window = glfwCreateWindow (theWidth, theHeight, theTitle.c_str(), NULL, NULL);
 
-        if (aBndSelected.SquareExtent() > 0)
-        {
-          gp_Pnt anObjectsCenter = aBndSelected.CornerMax().Translated (gp_Vec (aBndSelected.CornerMax(), aBndSelected.CornerMin()).Scaled (0.5f));
-          gp_Pnt aNewCameraEye = anObjectsCenter.Translated (gp_Vec (aCamera->Center(), aCamera->Eye()));
-          SetCameraMoving (aNewCameraEye);
-        }
-      }
-      myInternal->ExternalGui->AddTooltip ("Move camera to the selected objects");
+    if (myInternal->Window == NULL)
+    {
+      glfwTerminate();
 
-      ImGui::SameLine();
-      aTextureID = Textures["Home"].Texture;
-      if (ImGui::ImageButton ((ImTextureID )(uintptr_t )aTextureID, aButtonSize, ImVec2 (0, 0), ImVec2 (1, 1), 2))
-      {
-        myInternal->ExternalGui->ConsoleExec ("vfit");
-      }
-      myInternal->ExternalGui->AddTooltip ("Fit view to the scene");
+      throw std::runtime_error ("Could not create window");
+    }
 
-      ImGui::PopStyleColor();
-      ImGui::SameLine(0.0f, aStyle.ItemSpacing.x * 3.0f);
+    glfwMakeContextCurrent (myInternal->Window);
 
-      static TCollection_AsciiString aTextureTransform[3] = { "Translate", "Rotate", "Scale" };
-      for (int i = 0; i < 3; i++)
-      {
-        if (myInternal->ExternalGui->GetManipulatorSettings().Operation == i)
-        {
-          ImGui::PushStyleColor (ImGuiCol_Button, ImGui::GetStyle().Colors[ImGuiCol_Button]);
-        }
-        else
-        {
-          ImGui::PushStyleColor (ImGuiCol_Button, ImVec4 (0.5f, 0.5f, 0.5f, 1.00f));
-        }
-        aTextureID = Textures[aTextureTransform[i].ToCString()].Texture;
-        if (ImGui::ImageButton ((ImTextureID )(uintptr_t )aTextureID, aButtonSize, ImVec2 (0, 0), ImVec2 (1, 1), 2))
-        {
-          myInternal->ExternalGui->GetManipulatorSettings().Operation = i;
-        }
-        myInternal->ExternalGui->AddTooltip (aTextureTransform[i].ToCString());
-        ImGui::PopStyleColor();
-        ImGui::SameLine();
-      }
+#if (GLFW_VERSION_MAJOR * 10 + GLFW_VERSION_MINOR >= 32)
+    if (!theIsHeadless)
+    {
+      glfwMaximizeWindow (myInternal->Window);
+    }
+#endif
 
-      ImGui::PushStyleColor (ImGuiCol_Button, ImVec4 (1.0, 1.0, 1.0, 0.0));
-      ImGui::NextColumn();
-      aTextureID = Textures[myInternal->NeedToStopUpdating ? "Pause" : "Play"].Texture;
-      if (ImGui::ImageButton ((ImTextureID )(uintptr_t )aTextureID, aButtonSize, ImVec2 (0, 0), ImVec2 (1, 1), 2))
-      {
-        myInternal->NeedToStopUpdating = !myInternal->NeedToStopUpdating;
-      }
-      myInternal->ExternalGui->AddTooltip ("Pause/continue rendering");
-      ImGui::PopStyleColor();
+    glfwSetWindowUserPointer (myInternal->Window, myInternal);
 
-      ImGui::Columns(1);
+    Handle (Aspect_DisplayConnection) aDisplayConnection = new Aspect_DisplayConnection;
 
-      Handle(OpenGl_FrameBuffer) anFBO = myInternal->ScreenFBO;
-      if (!anFBO.IsNull())
-      {
-        ImVec2 aWindowSize = ImGui::GetContentRegionAvail();
-        float aWindowAspect = aWindowSize.x / aWindowSize.y;
-        float aTargetAspect = myRTSize.x / myRTSize.y;
+#if defined(HAVE_EGL)
+    aGraphicDriver = new OpenGl_GraphicDriver (aDisplayConnection, Standard_False);
 
-        ImVec2 aTargetSize = aWindowAspect < aTargetAspect
-          ? ImVec2 (aWindowSize.x, aWindowSize.x / aTargetAspect)
-          : ImVec2 (aWindowSize.y * aTargetAspect, aWindowSize.y);
+    EGLConfig anEglConfig = NULL;
+    EGLint    aConfigId   = 0;
+    EGLint    aNbConfigs  = 0;
 
-        if (myFitToArea)
-        {
-          aTargetSize = aWindowSize;
-          myRTSize = aWindowSize;
-          myInternal->Viewport = ImVec2 (0.f, 0.f);
-        }
+    eglQueryContext (eglGetCurrentDisplay(), eglGetCurrentContext(), EGL_CONFIG_ID, &aConfigId);
 
-        if (myInternal->Viewport.x != aTargetSize.x
-         || myInternal->Viewport.y != aTargetSize.y)
-        {
-          aCamera->SetAspect (aTargetAspect);
+    const EGLint aConfigAttribs[] = { EGL_CONFIG_ID, aConfigId, EGL_NONE };
 
-          if (myInternal->CurrentViewControls != NULL)
-          {
-            myInternal->CurrentViewControls->Init (aCamera,
-                                                   static_cast<int> (aTargetSize.x),
-                                                   static_cast<int> (aTargetSize.y));
-          }
+    eglChooseConfig (eglGetCurrentDisplay(), aConfigAttribs, &anEglConfig, 1, &aNbConfigs);
 
-          myInternal->Viewport = aTargetSize;
-        }
+    if (!aGraphicDriver->InitEglContext ((Aspect_Display) eglGetCurrentDisplay(), (Aspect_RenderingContext) eglGetCurrentContext(), anEglConfig))
+    {
+      glfwTerminate();
 
-        if (myInternal->NeedToResizeFBO
-         || myInternal->ScreenFBO->GetSizeX() != static_cast<GLsizei> (myRTSize.x)
-         || myInternal->ScreenFBO->GetSizeY() != static_cast<GLsizei> (myRTSize.y))
-        {
-          // Handle resize
-          myInternal->ScreenFBO->InitLazy (myInternal->GLContext,
-                                           static_cast<GLsizei> (myRTSize.x),
-                                           static_cast<GLsizei> (myRTSize.y),
-                                           GL_RGB8,
-                                           GL_DEPTH24_STENCIL8);
+      throw std::runtime_error ("Could not initialize OpenGL driver with EGL context");
+    }
 
-          myInternal->NeedToResizeFBO = false;
-        }
+    aRenderingContext = (Aspect_RenderingContext) eglGetCurrentContext();
+#else
+    aGraphicDriver = new OpenGl_GraphicDriver (aDisplayConnection);
+#endif
 
-        // Rendering
-        Handle(CustomWindow) aWindow = Handle(CustomWindow)::DownCast (myInternal->View->Window());
+#ifdef WIN32
+    aWindow = new CustomWindow ((Aspect_Handle) glfwGetWin32Window (myInternal->Window));
+    aRenderingContext = (Aspect_RenderingContext) wglGetCurrentContext();
+#else
+    aWindow = new CustomWindow (aGraphicDriver->GetDisplayConnection(), glfwGetX11Window (myInternal->Window));
+#endif
+  }
 
-        aWindow->SetSize (static_cast<int> (myInternal->Viewport.x),
-                          static_cast<int> (myInternal->Viewport.y));
-        
-        static Standard_Size aCameraViewState = aCamera->WorldViewState();
-        if (aCameraViewState != aCamera->WorldViewState())
-        {
-          myInternal->NeedToStopUpdating = false;
-          aCameraViewState = aCamera->WorldViewState();
-        }
+  aGraphicDriver->ChangeOptions().buffersNoSwap = Standard_True;
+
+  // Create viewer
+  TCollection_ExtendedString a3DName ("Vis3D");
+
+  Handle (V3d_Viewer) a3DViewer = new V3d_Viewer (aGraphicDriver,
+    a3DName.ToExtString(), "", 1000.0, V3d_XposYnegZpos, Quantity_NOC_GRAY20, V3d_ZBUFFER, V3d_PHONG);
+
+  myInternal->AISContext = new AIS_InteractiveContext (a3DViewer);
+
+  // View setup
+  myInternal->View = a3DViewer->CreateView();
+
+  myInternal->View->SetWindow (aWindow, aRenderingContext);
+
+  a3DViewer->SetDefaultLights();
+  a3DViewer->SetLightOn();
+
+  // Setup FBO
+  myInternal->GLContext = aGraphicDriver->GetSharedContext();
+
+  myInternal->View->SetImmediateUpdate (Standard_False);
+  myInternal->View->Redraw();
+  myInternal->ScreenFBO = Handle(OpenGl_FrameBuffer)::DownCast (myInternal->View->View()->FBOCreate (theWidth, theHeight));
+  myInternal->ScreenFBO->ColorTexture()->Sampler()->Parameters()->SetFilter(Graphic3d_TOTF_BILINEAR);
+  myInternal->View->View()->SetFBO (myInternal->ScreenFBO);
+
+  if (theIsHeadless)
+  {
+    return;
+  }
+
+  glfwSetDropCallback (myInternal->Window, fileDropCallback);
+
+  // Setup ImGui
+  ImGui_ImplGlfwGL3_Init (myInternal->Window, true);
+
+  // Setup fonts
+  ImGuiIO& anIo = ImGui::GetIO();
+  anIo.Fonts->AddFontFromFileTTF ((myDataDir + "fonts/Monoid-Italic.ttf").c_str(), 16.f);
+//  anIo.Fonts->AddFontFromMemoryCompressedTTF (DroidSans_compressed_data, DroidSans_compressed_size, 15.0f);
+
+  // merge in icons from Font Awesome
+  static const ImWchar anIconsRanges[] = { ICON_MIN_FA, ICON_MAX_FA, 0 };
+  ImFontConfig anIconsConfig;
+  anIconsConfig.MergeMode = true;
+  anIconsConfig.PixelSnapH = true;
+  // TODO: embed into sources
+  anIo.Fonts->AddFontFromFileTTF ((myDataDir + "fonts/fontawesome-webfont.ttf").c_str(), 16.0f, &anIconsConfig, anIconsRanges);
+
+  anIo.Fonts->AddFontFromFileTTF ((myDataDir + "fonts/Monoid-Regular.ttf").c_str(), 16.f);
+//  anIo.Fonts->AddFontFromMemoryCompressedTTF (EnvyItalic_compressed_data, EnvyItalic_compressed_size, 15.0f);
+
+  // Setup OCCT logo texture
+  int aTexComp;
+  void* aTexData = stbi_load_from_memory (reinterpret_cast<const unsigned char*> (OcctLogoPng_data),
+                                          static_cast<int> (OcctLogoPng_size),
+                                          &myInternal->LogoW,
+                                          &myInternal->LogoH,
+                                          &aTexComp,
+                                          0);
+
+  glGenTextures (1, &myInternal->LogoTexture);
+
+  glBindTexture (GL_TEXTURE_2D, myInternal->LogoTexture);
+
+  glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+  glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+  glTexImage2D (GL_TEXTURE_2D, 0, GL_RGBA,
+    myInternal->LogoW, myInternal->LogoH, 0, GL_RGBA, GL_UNSIGNED_BYTE, static_cast<const GLubyte*> (aTexData));
+
+  glBindTexture (GL_TEXTURE_2D, 0);
+
+  stbi_image_free (aTexData);
+
+  ImGui_ImplGlfwGL3_NewFrame();
+
+  // Set input callbacks
+  glfwSetMouseButtonCallback (myInternal->Window, MouseButtonCallback);
+  glfwSetScrollCallback (myInternal->Window, ScrollCallback);
+  glfwSetCursorPosCallback (myInternal->Window, MouseMoveCallback);
+  glfwSetKeyCallback (myInternal->Window, KeyCallback);
+  glfwSetCharCallback (myInternal->Window, CharCallback);
+
+  // Window events should wake up idle main loop
+  glfwSetWindowFocusCallback (myInternal->Window, WindowStateCallback);
+  glfwSetWindowIconifyCallback (myInternal->Window, WindowStateCallback);
+  glfwSetWindowSizeCallback (myInternal->Window, WindowSizeCallback);
+  glfwSetWindowRefreshCallback (myInternal->Window, WindowRefreshCallback);
+
+  // Setup camera
+  Handle (Graphic3d_Camera) aCamera = myInternal->View->Camera();
+}
+
+//=======================================================================
+//function : Display
+//purpose  :
+//=======================================================================
+void AppViewer::DisplayPointCloud (Handle(AIS_InteractiveObject) thePointCloud)
+{
+  thePointCloud->SetZLayer (Graphic3d_ZLayerId_Top);
+  thePointCloud->SetToUpdate();
+  myInternal->AISContext->Display (thePointCloud, Standard_False);
+
+  myInternal->View->FitAll();
+}
+
+//=======================================================================
+//function : Run
+//purpose  :
+//=======================================================================
+void AppViewer::Run()
+{
+  if (myInternal == NULL)
+  {
+    return;
+  }
+
+  if (myInternal->ExternalGui != NULL)
+  {
+    ImGui::LoadDocks (myInternal->ExternalGui->GetSettings());
+  }
+
+  ImDrawList* AppOverlayDrawList;
+
+  bool show_test_window = false;
+
+  // Main loop
+  while (!glfwWindowShouldClose (myInternal->Window))
+  {
+    // Do not spin when there is nothing new to draw
+    if (myTestingData == NULL && !waitEvents (myInternal))
+    {
+      continue;
+    }
+
+    myInternal->Profiler.BeginFrame();
+
+    glfwPollEvents();
+
+    ImGui_ImplGlfwGL3_NewFrame();
+
+    ImGuiIO& anIo = ImGui::GetIO();
+
+    AppOverlayDrawList = ImGui::GetOverlayWindowDrawList();
+
+    if (myInternal->NeedToInitViewControls && myInternal->CurrentViewControls != NULL)
+    {
+      myInternal->CurrentViewControls->Init (myInternal->View->Camera(), static_cast<int> (myInternal->Viewport.x),
+                                                                         static_cast<int> (myInternal->Viewport.y));
+
+      myInternal->CurrentViewControls->RegisterKey (ViewControls::MOUSE_LEFT, GLFW_MOUSE_BUTTON_1);
+      myInternal->CurrentViewControls->RegisterKey (ViewControls::MOUSE_RIGHT, GLFW_MOUSE_BUTTON_2);
+      myInternal->CurrentViewControls->RegisterKey (ViewControls::MOUSE_MIDDLE, GLFW_MOUSE_BUTTON_3);
+
+      myInternal->CurrentViewControls->RegisterKey (ViewControls::KEY_UP, GLFW_KEY_UP);
+      myInternal->CurrentViewControls->RegisterKey (ViewControls::KEY_DOWN, GLFW_KEY_DOWN);
+      myInternal->CurrentViewControls->RegisterKey (ViewControls::KEY_LEFT, GLFW_KEY_LEFT);
+      myInternal->CurrentViewControls->RegisterKey (ViewControls::KEY_RIGHT, GLFW_KEY_RIGHT);
+
+      myInternal->CurrentViewControls->RegisterKey (ViewControls::KEY_W, GLFW_KEY_W);
+      myInternal->CurrentViewControls->RegisterKey (ViewControls::KEY_S, GLFW_KEY_S);
+      myInternal->CurrentViewControls->RegisterKey (ViewControls::KEY_A, GLFW_KEY_A);
+      myInternal->CurrentViewControls->RegisterKey (ViewControls::KEY_D, GLFW_KEY_D);
+      myInternal->NeedToInitViewControls = false;
+    }
+
+    if (myInternal->CurrentViewControls)
+    {
+      // Time spent waiting for events should not move the camera
+      myInternal->CurrentViewControls->Update (myInternal->WasIdle ? 0.f : anIo.DeltaTime);
+    }
+
+    myInternal->WasIdle = false;
+
+    if (myInternal->NeedToFitAll)
+    {
+      myInternal->View->FitAll();
+      myInternal->NeedToFitAll = false;
+    }
+
+    myInternal->Profiler.EndStage (FrameProfiler::Stage_Events);
+
+    auto& aStyle = ImGui::GetStyle();
+    ImVec2 aNormalWinPadding = aStyle.WindowPadding;
+    aStyle.WindowPadding = ImVec2 (0.f, 0.f);
+
+    ImVec2 aMainWinPos (0.f, ImGui::GetTextLineHeightWithSpacing() + 1);
+    ImVec2 aMainWinSize = anIo.DisplaySize;
+    aMainWinSize.y -= aMainWinPos.y;
+    ImGui::SetNextWindowPos (aMainWinPos);
+    ImGui::SetNextWindowSize (aMainWinSize);
+    if (!ImGui::Begin ("Main window", NULL, ImVec2(0,0), 1.0f, ImGuiWindowFlags_NoTitleBar|ImGuiWindowFlags_NoResize|ImGuiWindowFlags_NoMove|ImGuiWindowFlags_NoSavedSettings))
+    {
+      aStyle.WindowPadding = aNormalWinPadding;
+      ImGui::End();
+      continue;
+    }
+    aStyle.WindowPadding = aNormalWinPadding;
+    ImGui::BeginWorkspace (AppOverlayDrawList);
+
+    myInternal->View->ZFitAll();
+
+    Handle (Graphic3d_Camera) aCamera = myInternal->View->Camera();
+
+    ImGuizmo::BeginFrame (static_cast<int> (myInternal->Viewport.x),
+                          static_cast<int> (myInternal->Viewport.y),
+                          static_cast<int> (myInternal->ViewPos.x),
+                          static_cast<int> (myInternal->ViewPos.y),
+                          AppOverlayDrawList);
+
+    ImGuizmo::Enable (!myInternal->IsHoldingMouseButton);
+
+    // Screen
+    if (ImGui::BeginDock ("Viewport", NULL, ImGuiWindowFlags_NoScrollbar | ImGuiWindowFlags_NoScrollWithMouse))
+    {
+      unsigned int aTextureID;
+      ImVec2 aButtonSize (32, 32);
+      
+      ImGui::Columns (2, "", false);
+      ImGui::SetColumnOffset (1, ImGui::GetWindowContentRegionWidth() - ImGui::GetStyle().FramePadding.x - aButtonSize.x - 10);
+      
+      ImGui::PushStyleColor (ImGuiCol_Button, ImVec4 (0.5f, 0.5f, 0.5f, 1.00f));
+      ImGui::Spacing();
+      ImGui::SameLine();
+      aTextureID = Textures["Front"].Texture;
+      if (ImGui::ImageButton ((ImTextureID )(uintptr_t )aTextureID, aButtonSize, ImVec2 (0, 0), ImVec2 (1, 1), 2))
+      {
+        SetCameraRotating (gp_Vec (0, 1, 0), gp_Vec (0, 0, 1));
+      }
+      myInternal->ExternalGui->AddTooltip ("Front view");
+
+      ImGui::SameLine();
+      aTextureID = Textures["Back"].Texture;
+      if (ImGui::ImageButton ((ImTextureID )(uintptr_t )aTextureID, aButtonSize, ImVec2 (0, 0), ImVec2 (1, 1), 2))
+      {
+        SetCameraRotating (gp_Vec (0, -1, 0), gp_Vec (0, 0, 1));
+      }
+      myInternal->ExternalGui->AddTooltip ("Back view");
+
+      ImGui::SameLine();
+      aTextureID = Textures["Left"].Texture;
+      if (ImGui::ImageButton ((ImTextureID )(uintptr_t )aTextureID, aButtonSize, ImVec2 (0, 0), ImVec2 (1, 1), 2))
+      {
+        SetCameraRotating (gp_Vec (1, 0, 0), gp_Vec (0, 0, 1));
+      }
+      myInternal->ExternalGui->AddTooltip ("Left view");
+
+      ImGui::SameLine();
+      aTextureID = Textures["Right"].Texture;
+      if (ImGui::ImageButton ((ImTextureID )(uintptr_t )aTextureID, aButtonSize, ImVec2 (0, 0), ImVec2 (1, 1), 2))
+      {
+        SetCameraRotating (gp_Vec (-1, 0, 0), gp_Vec (0, 0, 1));
+      }
+      myInternal->ExternalGui->AddTooltip ("Right view");
+
+      ImGui::SameLine();
+      aTextureID = Textures["Down"].Texture;
+      if (ImGui::ImageButton ((ImTextureID )(uintptr_t )aTextureID, aButtonSize, ImVec2 (0, 0), ImVec2 (1, 1), 2))
+      {
+        SetCameraRotating (gp_Vec (0, 0, 1), gp_Vec (1, 0, 0));
+      }
+      myInternal->ExternalGui->AddTooltip ("Down view");
+
+      ImGui::SameLine();
+      aTextureID = Textures["Up"].Texture;
+      if (ImGui::ImageButton((ImTextureID )(uintptr_t )aTextureID, aButtonSize, ImVec2 (0, 0), ImVec2 (1, 1), 2))
+      {
+        SetCameraRotating (gp_Vec (0, 0, -1), gp_Vec (1, 0, 0));
+      }
+      myInternal->ExternalGui->AddTooltip ("Up view");
+
+      ImGui::SameLine (0.0f, aStyle.ItemSpacing.x * 3.0f);
+      aTextureID = Textures["Focus"].Texture;
+      if (ImGui::ImageButton ((ImTextureID )(uintptr_t )aTextureID, aButtonSize, ImVec2 (0, 0), ImVec2 (1, 1), 2))
+      {
+        Bnd_Box aBndSelected;
+        Handle (AIS_InteractiveContext) aContext = myInternal->AISContext;
+
+        for (aContext->InitSelected(); aContext->MoreSelected(); aContext->NextSelected())
+        {
+          Bnd_Box aTmpBnd;
+          aContext->SelectedInteractive().get()->BoundingBox (aTmpBnd);
+          aBndSelected.Add (aTmpBnd);
+        }
+
+        if (aBndSelected.SquareExtent() > 0)
+        {
+          gp_Pnt anObjectsCenter = aBndSelected.CornerMax().Translated (gp_Vec (aBndSelected.CornerMax(), aBndSelected.CornerMin()).Scaled (0.5f));
+          gp_Pnt aNewCameraEye = anObjectsCenter.Translated (gp_Vec (aCamera->Center(), aCamera->Eye()));
+          SetCameraMoving (aNewCameraEye);
+        }
+      }
+      myInternal->ExternalGui->AddTooltip ("Move camera to the selected objects");
+
+      ImGui::SameLine();
+      aTextureID = Textures["Home"].Texture;
+      if (ImGui::ImageButton ((ImTextureID )(uintptr_t )aTextureID, aButtonSize, ImVec2 (0, 0), ImVec2 (1, 1), 2))
+      {
+        myInternal->ExternalGui->ConsoleExec ("vfit");
+      }
+      myInternal->ExternalGui->AddTooltip ("Fit view to the scene");
+
+      ImGui::PopStyleColor();
+      ImGui::SameLine(0.0f, aStyle.ItemSpacing.x * 3.0f);
+
+      static TCollection_AsciiString aTextureTransform[3] = { "Translate", "Rotate", "Scale" };
+      for (int i = 0; i < 3; i++)
+      {
+        if (myInternal->ExternalGui->GetManipulatorSettings().Operation == i)
+        {
+          ImGui::PushStyleColor (ImGuiCol_Button, ImGui::GetStyle().Colors[ImGuiCol_Button]);
+        }
+        else
+        {
+          ImGui::PushStyleColor (ImGuiCol_Button, ImVec4 (0.5f, 0.5f, 0.5f, 1.00f));
+        }
+        aTextureID = Textures[aTextureTransform[i].ToCString()].Texture;
+        if (ImGui::ImageButton ((ImTextureID )(uintptr_t )aTextureID, aButtonSize, ImVec2 (0, 0), ImVec2 (1, 1), 2))
+        {
+          myInternal->ExternalGui->GetManipulatorSettings().Operation = i;
+        }
+        myInternal->ExternalGui->AddTooltip (aTextureTransform[i].ToCString());
+        ImGui::PopStyleColor();
+        ImGui::SameLine();
+      }
+
+      ImGui::PushStyleColor (ImGuiCol_Button, ImVec4 (1.0, 1.0, 1.0, 0.0));
+      ImGui::NextColumn();
+      aTextureID = Textures[myInternal->NeedToStopUpdating ? "Pause" : "Play"].Texture;
+      if (ImGui::ImageButton ((ImTextureID )(uintptr_t )aTextureID, aButtonSize, ImVec2 (0, 0), ImVec2 (1, 1), 2))
+      {
+        myInternal->NeedToStopUpdating = !myInternal->NeedToStopUpdating;
+
+        if (!myInternal->NeedToStopUpdating && ie::Convergence::GetInstance ()->IsConverged ())
+        {
+          ie::Convergence::GetInstance ()->Continue (); // render beyond stop criteria
+        }
+      }
+      myInternal->ExternalGui->AddTooltip ("Pause/continue rendering");
+      ImGui::PopStyleColor();
+
+      ImGui::Columns(1);
+
+      Handle(OpenGl_FrameBuffer) anFBO = myInternal->ScreenFBO;
+      if (!anFBO.IsNull())
+      {
+        ImVec2 aWindowSize = ImGui::GetContentRegionAvail();
+        float aWindowAspect = aWindowSize.x / aWindowSize.y;
+        float aTargetAspect = myRTSize.x / myRTSize.y;
+
+        ImVec2 aTargetSize = aWindowAspect < aTargetAspect
+          ? ImVec2 (aWindowSize.x, aWindowSize.x / aTargetAspect)
+          : ImVec2 (aWindowSize.y * aTargetAspect, aWindowSize.y);
+
+        if (myFitToArea)
+        {
+          aTargetSize = aWindowSize;
+          myRTSize = aWindowSize;
+          myInternal->Viewport = ImVec2 (0.f, 0.f);
+        }
+
+        if (myInternal->Viewport.x != aTargetSize.x
+         || myInternal->Viewport.y != aTargetSize.y)
+        {
+          aCamera->SetAspect (aTargetAspect);
+
+          if (myInternal->CurrentViewControls != NULL)
+          {
+            myInternal->CurrentViewControls->Init (aCamera,
+                                                   static_cast<int> (aTargetSize.x),
+                                                   static_cast<int> (aTargetSize.y));
+          }
+
+          myInternal->Viewport = aTargetSize;
+        }
+
+        // Reduce resolution while the camera is moving (image is upscaled on display)
+        const float aResolutionScale = updateResolutionScale (myInternal,
+          myTestingData == NULL ? myInteractiveFrameTime : 0.0, anIo.DeltaTime);
+
+        const GLsizei aSizeX = std::max (static_cast<GLsizei> (myRTSize.x * aResolutionScale), 1);
+        const GLsizei aSizeY = std::max (static_cast<GLsizei> (myRTSize.y * aResolutionScale), 1);
+
+        if (myInternal->NeedToResizeFBO
+         || myInternal->ScreenFBO->GetSizeX() != aSizeX
+         || myInternal->ScreenFBO->GetSizeY() != aSizeY)
+        {
+          // Handle resize
+          myInternal->ScreenFBO->InitLazy (myInternal->GLContext,
+                                           aSizeX,
+                                           aSizeY,
+                                           GL_RGB8,
+                                           GL_DEPTH24_STENCIL8);
+
+          myInternal->NeedToResizeFBO = false;
+
+          // Samples of different resolution can not be accumulated
+          ie::Convergence::GetInstance ()->Reset ();
+        }
+
+        // Rendering
+        Handle(CustomWindow) aWindow = Handle(CustomWindow)::DownCast (myInternal->View->Window());
+
+        aWindow->SetSize (static_cast<int> (myInternal->Viewport.x),
+                          static_cast<int> (myInternal->Viewport.y));
+        
+        static Standard_Size aCameraViewState = aCamera->WorldViewState();
+        if (aCameraViewState != aCamera->WorldViewState())
+        {
+          myInternal->NeedToStopUpdating = false;
+          aCameraViewState = aCamera->WorldViewState();
+        }
 
         if (myCameraMovingData->DirAngle >= 0 && myCameraMovingData->UpAngle >= 0)
         {
@@ -990,305 +1634,1045 @@ void AppViewer::Run()
           if (myCameraMovingData->DirAngle >= myCameraMovingData->StartDir.Angle (myCameraMovingData->FinishDir)
            && myCameraMovingData->UpAngle >= myCameraMovingData->StartUp.Angle (myCameraMovingData->FinishUp))
           {
-            myInternal->View->Camera()->SetDirection (myCameraMovingData->FinishDir);
-            myInternal->View->Camera()->SetUp (myCameraMovingData->FinishUp);
-            myCameraMovingData->DirAngle = -1;
-            myCameraMovingData->UpAngle = -1;
+            myInternal->View->Camera()->SetDirection (myCameraMovingData->FinishDir);
+            myInternal->View->Camera()->SetUp (myCameraMovingData->FinishUp);
+            myCameraMovingData->DirAngle = -1;
+            myCameraMovingData->UpAngle = -1;
+          }
+          else
+          {
+            gp_Vec aDirNormal;
+            gp_Vec anUpNormal;
+            if (myCameraMovingData->StartDir.IsParallel (myCameraMovingData->FinishDir, std::numeric_limits<float>::min()))
+            {
+              aDirNormal = myCameraMovingData->FinishUp;
+            }
+            else
+            {
+              aDirNormal = myCameraMovingData->StartDir.Crossed (myCameraMovingData->FinishDir);
+            }
+            if (myCameraMovingData->StartUp.IsParallel (myCameraMovingData->FinishUp, std::numeric_limits<float>::min()))
+            {
+              anUpNormal = myCameraMovingData->FinishDir;
+            }
+            else
+            {
+              anUpNormal = myCameraMovingData->StartUp.Crossed (myCameraMovingData->FinishUp);
+            }
+            gp_Ax1 aDirAxis (aCamera->Eye(), aDirNormal);
+            gp_Ax1 anUpAxis (aCamera->Center(), anUpNormal);
+            myInternal->View->Camera()->SetDirection (myCameraMovingData->StartDir.Rotated (aDirAxis, myCameraMovingData->DirAngle));
+            myInternal->View->Camera()->SetUp (myCameraMovingData->StartUp.Rotated (anUpAxis, myCameraMovingData->UpAngle));
+          }
+        }
+
+        if (myCameraMovingData->PointT >= 0)
+        {
+          myCameraMovingData->PointT += myCameraMovingData->TStep;
+          gp_Pnt aNewCameraEye;
+          gp_Vec aCameraDir (aCamera->Direction());
+          aCameraDir *= aCamera->Distance();
+          if (myCameraMovingData->PointT >= 1)
+          {
+            aNewCameraEye = myCameraMovingData->FinishPoint;
+            myCameraMovingData->PointT = -1;
+          }
+          else
+          {
+            aNewCameraEye = myCameraMovingData->StartPoint;
+            aNewCameraEye.BaryCenter (1 - myCameraMovingData->PointT, myCameraMovingData->FinishPoint, myCameraMovingData->PointT);
+          }
+          myInternal->View->Camera()->SetEye (aNewCameraEye);
+          myInternal->View->Camera()->SetCenter (aNewCameraEye.Translated(aCameraDir));
+        }
+
+        bool isSceneChanged = false;
+
+        // Swap bounding boxes of shapes tessellated in background
+        if (ie::MeshQueue::GetInstance ()->Update (aCamera))
+        {
+          myInternal->NeedToStopUpdating = false;
+          isSceneChanged = true;
+
+          // Store triangulation of progressively displayed models in the import cache
+          if (ie::MeshQueue::GetInstance ()->NbQueued () == 0 && ie::ImportCache::GetInstance ()->HasStored ())
+          {
+            ie::ImportCache::GetInstance ()->UpdateStored ();
+          }
+        }
+
+        // Swap triangulations re-meshed for the current view
+        if (ie::MeshRefiner::GetInstance ()->Update (aCamera, static_cast<int> (myInternal->Viewport.y)))
+        {
+          myInternal->NeedToStopUpdating = false;
+          isSceneChanged = true;
+        }
+
+        // Resume paused rendering if the view or scene was changed meanwhile
+        // (e.g. by material or light editors), so the image is not stale
+        if (myInternal->NeedToStopUpdating && ie::Convergence::GetInstance ()->IsOutdated (myInternal->View))
+        {
+          myInternal->NeedToStopUpdating = false;
+        }
+
+        if (!myInternal->NeedToStopUpdating)
+        {
+          myInternal->Profiler.EndStage (FrameProfiler::Stage_GuiBuild);
+
+          myInternal->View->Redraw();
+
+          if (myInternal->Profiler.IsEnabled())
+          {
+            glFinish(); // attribute GPU work to redraw instead of buffer swap
+          }
+
+          // Stop accumulation once some stop criterion is met
+          const bool isConverged = ie::Convergence::GetInstance ()->Update (myInternal->View);
+
+          // Resume accumulation from checkpoint or store it periodically
+          ie::Checkpoint::GetInstance ()->Update (myInternal->View);
+
+          // First sample after restart includes update of geometry and BVH
+          const bool isUpdateFrame = isSceneChanged
+                                  || !ie::Convergence::GetInstance ()->IsActive ()
+                                  ||  ie::Convergence::GetInstance ()->NbSamples () == 1;
+
+          myInternal->Profiler.EndStage (isUpdateFrame ? FrameProfiler::Stage_SceneUpdate : FrameProfiler::Stage_Accumulation);
+
+          if (isConverged)
+          {
+            myInternal->NeedToStopUpdating = true;
+          }
+
+          if (myTestingData != NULL)
+          {
+            if (!myTestingData->NeedToRunScript)
+            {
+              myInternal->CurFramesCount++;
+              myTestingData->AverageFramerate = ImGui::GetIO().Framerate;
+              if ((myInternal->CurFramesCount >= myTestingData->MaxFramesCount || isConverged)
+               && myTestingData->MaxFramesCount > 0)
+              {
+                break;
+              }
+            }
           }
           else
           {
-            gp_Vec aDirNormal;
-            gp_Vec anUpNormal;
-            if (myCameraMovingData->StartDir.IsParallel (myCameraMovingData->FinishDir, std::numeric_limits<float>::min()))
+            myInternal->CurFramesCount++;
+          }
+        }
+
+        // Complete finished readbacks and start requested ones
+        myInternal->Capture.Update (myInternal->GLContext, myInternal->ScreenFBO, ie::Convergence::GetInstance ()->NbTotalSamples ());
+
+        // Start filtering of the image (or pick up filtered one) if denoising is enabled
+        ie::Denoiser::GetInstance ()->Update (myInternal->View);
+
+        ImVec2 anOffset (ImGui::GetCursorPosX() + (aWindowSize.x - aTargetSize.x) * 0.5f,
+                         ImGui::GetCursorPosY() + (aWindowSize.y - aTargetSize.y) * 0.5f);
+        ImGui::SetCursorPos (anOffset);
+        myInternal->ViewPos = ImGui::GetCursorScreenPos();
+        ImGui::Image ((ImTextureID )(uintptr_t )anFBO->ColorTexture()->TextureId(),
+          ImVec2 (aTargetSize),
+          ImVec2 (0.f, 1.f),
+          ImVec2 (1.f, 0.f));
+        myInternal->RenderWindowHasFocus = ImGui::IsItemHoveredRect() && !(ImGuizmo::IsOver() || ImGuizmo::IsUsing());
+
+        // Blend image restored from checkpoint (weighted by number of samples)
+        const int aNbRestoredSamples = ie::Convergence::GetInstance ()->NbRestoredSamples ();
+
+        if (aNbRestoredSamples > 0)
+        {
+          if (myInternal->RestoredRevision != ie::Checkpoint::GetInstance ()->Revision ())
+          {
+            updateRestoredTexture (myInternal);
+          }
+
+          const float aWeight = static_cast<float> (aNbRestoredSamples)
+            / (aNbRestoredSamples + std::max (ie::Convergence::GetInstance ()->NbSamples (), 0));
+
+          ImGui::GetWindowDrawList()->AddImage ((ImTextureID )(uintptr_t )myInternal->RestoredTexture,
+            ImGui::GetItemRectMin(), ImGui::GetItemRectMax(), ImVec2 (0.f, 1.f), ImVec2 (1.f, 0.f),
+            IM_COL32 (255, 255, 255, static_cast<int> (aWeight * 255.f + 0.5f)));
+        }
+
+        // Show the last denoised image (if any) instead of noisy one
+        if (!ie::Denoiser::GetInstance ()->Image ().IsEmpty ())
+        {
+          if (myInternal->DenoisedRevision != ie::Denoiser::GetInstance ()->Revision ())
+          {
+            updateDenoisedTexture (myInternal);
+          }
+
+          ImGui::GetWindowDrawList()->AddImage ((ImTextureID )(uintptr_t )myInternal->DenoisedTexture,
+            ImGui::GetItemRectMin(), ImGui::GetItemRectMax(), ImVec2 (0.f, 1.f), ImVec2 (1.f, 0.f));
+        }
+
+        Handle(AIS_InteractiveObject) aSelectedObj = myInternal->AISContext->FirstSelectedObject();
+
+        if (myInternal->RenderWindowHasFocus && myInternal->NeedToOpenPopup)
+        {
+          ImGui::OpenPopup ("Menu##viewer");
+          myInternal->NeedToOpenPopup = false;
+        }
+
+        if (ImGui::BeginPopup ("Menu##viewer"))
+        {
+          if (ImGui::MenuItem ("Select all", NULL, false))
+          {
+            AIS_ListOfInteractive anObjectList;
+            myInternal->AISContext->DisplayedObjects (anObjectList);
+            for (AIS_ListIteratorOfListOfInteractive aSelIter (anObjectList); aSelIter.More(); aSelIter.Next())
             {
-              aDirNormal = myCameraMovingData->FinishUp;
+              myInternal->AISContext->AddSelect (aSelIter.Value());
             }
-            else
+            myInternal->AISContext->UpdateSelected (false);
+          }
+
+          if (ImGui::MenuItem ("Deselect all", NULL, false, !aSelectedObj.IsNull()))
+          {
+            while (!aSelectedObj.IsNull())
             {
-              aDirNormal = myCameraMovingData->StartDir.Crossed (myCameraMovingData->FinishDir);
+              myInternal->AISContext->AddOrRemoveSelected (aSelectedObj, false);
+              aSelectedObj = myInternal->AISContext->FirstSelectedObject();
             }
-            if (myCameraMovingData->StartUp.IsParallel (myCameraMovingData->FinishUp, std::numeric_limits<float>::min()))
+            myInternal->AISContext->UpdateSelected (false);
+          }
+
+          if (ImGui::MenuItem ("Invert selection", NULL, false))
+          {
+            AIS_ListOfInteractive anObjectList;
+            myInternal->AISContext->DisplayedObjects (anObjectList);
+            for (AIS_ListIteratorOfListOfInteractive aSelIter (anObjectList); aSelIter.More(); aSelIter.Next())
             {
-              anUpNormal = myCameraMovingData->FinishDir;
+              myInternal->AISContext->AddOrRemoveSelected (aSelIter.Value(), false);
             }
-            else
+            myInternal->AISContext->UpdateSelected (false);
+          }
+          
+          ImGui::Spacing();
+          ImGui::Spacing();
+          if (ImGui::MenuItem ("Hide selected", NULL, false, !aSelectedObj.IsNull()))
+          {
+            if (myInternal->AISContext->IsDisplayed (aSelectedObj))
             {
-              anUpNormal = myCameraMovingData->StartUp.Crossed (myCameraMovingData->FinishUp);
+              myInternal->AISContext->EraseSelected (false);
+              myInternal->AISContext->UpdateSelected (false);
             }
-            gp_Ax1 aDirAxis (aCamera->Eye(), aDirNormal);
-            gp_Ax1 anUpAxis (aCamera->Center(), anUpNormal);
-            myInternal->View->Camera()->SetDirection (myCameraMovingData->StartDir.Rotated (aDirAxis, myCameraMovingData->DirAngle));
-            myInternal->View->Camera()->SetUp (myCameraMovingData->StartUp.Rotated (anUpAxis, myCameraMovingData->UpAngle));
           }
+
+          if (ImGui::MenuItem ("Show all", NULL, false))
+          {
+            myInternal->AISContext->DisplayAll (false);
+            myInternal->AISContext->UpdateSelected(false);
+          }
+
+          ImGui::Spacing();
+          ImGui::Spacing();
+          if (ImGui::MenuItem ("Remove selected", NULL, false, !aSelectedObj.IsNull()))
+          {
+            while (!aSelectedObj.IsNull())
+            {
+              GetMapOfAIS().UnBind1(aSelectedObj);
+              myInternal->AISContext->Remove(aSelectedObj, false);
+              aSelectedObj = myInternal->AISContext->FirstSelectedObject();
+            }
+            //myInternal->AISContext->UpdateSelected(false);
+          }
+
+          ImGui::EndPopup ();
+        }
+
+
+        // Draw progress of accumulation
+        const ie::Convergence* aConvergence = ie::Convergence::GetInstance ();
+
+        if (aConvergence->IsActive ())
+        {
+          char aText[128];
+
+          int aLength = sprintf (aText, "%d spp  %.1f s", aConvergence->NbTotalSamples (), aConvergence->ElapsedTime ());
+
+          if (aConvergence->Noise () >= 0.0)
+          {
+            aLength += sprintf (aText + aLength, "  noise %.2f%%", aConvergence->Noise () * 100.0);
+          }
+
+          if (aConvergence->IsConverged ())
+          {
+            sprintf (aText + aLength, "  (converged)");
+          }
+
+          const ImVec2 aTextSize = ImGui::CalcTextSize (aText);
+
+          const ImVec2 aTextPos (myInternal->ViewPos.x + myInternal->Viewport.x - aTextSize.x - aStyle.ItemSpacing.x,
+                                 myInternal->ViewPos.y + myInternal->Viewport.y - aTextSize.y - aStyle.ItemSpacing.y * 2.f);
+
+          AppOverlayDrawList->AddText (ImGui::GetFont(), ImGui::GetFontSize(), aTextPos, ImGui::GetColorU32 (ImGuiCol_Text), aText);
+
+          if (aConvergence->HasCriteria ())
+          {
+            const float aBarY = myInternal->ViewPos.y + myInternal->Viewport.y - aStyle.ItemSpacing.y;
+
+            AppOverlayDrawList->AddRectFilled (ImVec2 (myInternal->ViewPos.x, aBarY),
+                                               ImVec2 (myInternal->ViewPos.x + myInternal->Viewport.x * static_cast<float> (aConvergence->Progress ()),
+                                                       myInternal->ViewPos.y + myInternal->Viewport.y),
+                                               ImGui::GetColorU32 (ImGuiCol_PlotHistogram));
+          }
+        }
+
+        // Draw timings of recent frames
+        if (myInternal->Profiler.IsEnabled())
+        {
+          drawFrameTimings (AppOverlayDrawList, myInternal->Profiler,
+            ImVec2 (myInternal->ViewPos.x + aStyle.ItemSpacing.x, myInternal->ViewPos.y + aStyle.ItemSpacing.y));
+        }
+
+        // Draw OCCT logo
+        ImVec2 aLogoOffset (anOffset.x,
+                            anOffset.y + aTargetSize.y - myInternal->LogoH * 0.5f);
+        ImGui::SetCursorPos (aLogoOffset);
+        ImGui::Image ((ImTextureID )(uintptr_t )myInternal->LogoTexture,
+          ImVec2 (myInternal->LogoW * 0.5f, myInternal->LogoH * 0.5f));
+
+        if (myInternal->NeedToShowHint)
+        {
+          char aText[] = "If you feel lost, please check examples in Script editor below";
+          ImVec2 aTextSize = ImGui::CalcTextSize (aText);
+          ImVec2 aTextPos = ImVec2 (myInternal->ViewPos.x + myInternal->Viewport.x * 0.5f - aTextSize.x * 0.5f,
+                                    myInternal->ViewPos.y + myInternal->Viewport.y * 0.5f - aTextSize.y * 0.5f);
+          AppOverlayDrawList->AddText (ImGui::GetFont(), ImGui::GetFontSize(), aTextPos, ImGui::GetColorU32 (ImGuiCol_Text), aText, aText + strlen (aText));
+
+          static float aTime = 0.f;
+          ImVec2 anArrowCenter = ImVec2 (myInternal->ViewPos.x + myInternal->Viewport.x * 0.5f,
+                                         myInternal->ViewPos.y + myInternal->Viewport.y * 0.5f + aTextSize.y * 3.f + aTextSize.y * sinf (aTime * 6.f) * 0.5f);
+          aTime += ImGui::GetIO().DeltaTime;
+
+          const float r = 40.0f;
+          ImVec2 center = anArrowCenter;
+
+          ImVec2 a, b, c;
+          a = ImVec2 (center.x + 0, center.y + r);
+          b = ImVec2 (center.x + r, center.y);
+          c = ImVec2 (center.x - r, center.y);
+
+          AppOverlayDrawList->AddTriangleFilled (a, b, c, ImGui::GetColorU32 (ImGuiCol_Text));
         }
+      }
+    }
+    ImGui::EndDock();
+
+    if (myInternal->ExternalGui != NULL)
+    {
+      myInternal->ExternalGui->Draw (myInternal->AISContext.operator->(), myInternal->View.operator->(), !myInternal->RenderWindowHasFocus);
+    }
+
+    if (myTestingData != NULL)
+    {
+      if (myTestingData->NeedToRunScript)
+      {
+        myInternal->ExternalGui->ConsoleExec(myTestingData->Script.c_str());
+        myTestingData->NeedToRunScript = false;
+      }
+    }
+
+    ImGui::EndWorkspace();
+    ImGui::End();
+
+    ImGui::BringOverlayWindowToFront();
+
+    if (show_test_window)
+    {
+      ImGui::SetNextWindowPos (ImVec2 (650, 20), ImGuiSetCond_FirstUseEver);
+      ImGui::ShowTestWindow (&show_test_window);
+    }
+
+    // ImGui::DockDebugWindow();
+
+    myInternal->ImguiHasFocus = ImGui::GetIO().WantCaptureMouse && !myInternal->RenderWindowHasFocus;
+    myInternal->ImguiHasKeyboardFocus = ImGui::GetIO().WantCaptureKeyboard;
+
+    myInternal->Profiler.EndStage (FrameProfiler::Stage_GuiBuild);
+
+    glClear (GL_COLOR_BUFFER_BIT);
+    ImGui::Render();
+
+    char aTitleString[128];
+    sprintf (aTitleString, "CADRays v%s [FPS %d]", CADRaysVersion::Get(), (int)ImGui::GetIO().Framerate);
+    SetTitle (aTitleString);
+
+    glfwSwapBuffers (myInternal->Window);
+
+    myInternal->Profiler.EndStage (FrameProfiler::Stage_GuiRender);
+    myInternal->Profiler.EndFrame();
+  }
+
+  // Keep progress of unfinished render
+  ie::Checkpoint::GetInstance ()->Write (myInternal->View);
+
+  // Save requested captures
+  myInternal->Capture.Flush (myInternal->GLContext, myInternal->ScreenFBO);
+
+  if (myTestingData != NULL)
+  {
+    if (myTestingData->MaxFramesCount > 0)
+    {
+      if (myTestingData->PixMap.InitZero (Image_PixMap::ImgRGB, Standard_Size(myRTSize.x), Standard_Size(myRTSize.y)))
+      {
+        myInternal->View->View()->BufferDump(myTestingData->PixMap, Graphic3d_BT_RGB);
+
+        ie::Checkpoint::GetInstance ()->Combine (myTestingData->PixMap);
+      }
+    }
+  }
+
+  ImGui::SaveDocks (myInternal->ExternalGui->GetSettings());
+
+  myInternal->ScreenFBO->Release (myInternal->GLContext.operator->());
+
+  // Cleanup
+  glDeleteTextures (1, &myInternal->LogoTexture);
+
+  myInternal->Capture.Release (myInternal->GLContext);
+
+  if (myInternal->RestoredTexture != 0)
+  {
+    glDeleteTextures (1, &myInternal->RestoredTexture);
+  }
+
+  if (myInternal->DenoisedTexture != 0)
+  {
+    glDeleteTextures (1, &myInternal->DenoisedTexture);
+  }
+
+  for (auto anIter : Textures)
+  {
+    glDeleteTextures (1, &anIter.second.Texture);
+  }
 
-        if (myCameraMovingData->PointT >= 0)
-        {
-          myCameraMovingData->PointT += myCameraMovingData->TStep;
-          gp_Pnt aNewCameraEye;
-          gp_Vec aCameraDir (aCamera->Direction());
-          aCameraDir *= aCamera->Distance();
-          if (myCameraMovingData->PointT >= 1)
-          {
-            aNewCameraEye = myCameraMovingData->FinishPoint;
-            myCameraMovingData->PointT = -1;
-          }
-          else
-          {
-            aNewCameraEye = myCameraMovingData->StartPoint;
-            aNewCameraEye.BaryCenter (1 - myCameraMovingData->PointT, myCameraMovingData->FinishPoint, myCameraMovingData->PointT);
-          }
-          myInternal->View->Camera()->SetEye (aNewCameraEye);
-          myInternal->View->Camera()->SetCenter (aNewCameraEye.Translated(aCameraDir));
-        }
-        
-        if (!myInternal->NeedToStopUpdating)
-        {
-          myInternal->View->Redraw();
+  Textures.clear();
 
-          //Handle (OpenGl_View) a = Handle (OpenGl_View)::DownCast (myInternal->View->View());
-          //if (a->GetAccumFrames() == 1 || a->NumberOfDisplayedStructures() == 0)
-          //{
-          //  myInternal->WorkingTime = 0;
-          //}
-          //else
-          //{
-          //  myInternal->WorkingTime += 1 / ImGui::GetIO().Framerate;
-          //}
+  myInternal->AISContext->RemoveAll (Standard_False);
 
-          if (myTestingData != NULL)
-          {
-            if (!myTestingData->NeedToRunScript)
-            {
-              myInternal->CurFramesCount++;
-              myTestingData->AverageFramerate = ImGui::GetIO().Framerate;
-              if (myInternal->CurFramesCount >= myTestingData->MaxFramesCount
-               && myTestingData->MaxFramesCount > 0)
-              {
-                break;
-              }
-            }
-          }
-          else
-          {
-            myInternal->CurFramesCount++;
-          }
-        }
-        //if (myInternal->WorkingTime >= myInternal->MaxWorkingTime
-        // && myInternal->WorkingTime < myInternal->MaxWorkingTime + 1.0f / ImGui::GetIO().Framerate
-        // && myInternal->MaxWorkingTime >= 0.00001
-        // && !myInternal->NeedToStopUpdating)
-        //{
-        //  myInternal->NeedToStopUpdating = true;
-        //  ImGui::OpenPopup("##Dialog");
-        //}
-        //if (ImGui::BeginPopupModal("##Dialog", NULL, ImGuiWindowFlags_AlwaysAutoResize))
-        //{
-        //  ImGui::TextUnformatted("Max time has been reached");
-        //  if (ImGui::Button("OK", ImVec2(ImGui::GetContentRegionAvailWidth(), 0)))
-        //  {
-        //    ImGui::CloseCurrentPopup();
-        //  }
-        //  ImGui::EndPopup();
-        //}
+  model::DataModel* aModel = model::DataModel::GetDefault();
+  aModel->Clear();
 
-        ImVec2 anOffset (ImGui::GetCursorPosX() + (aWindowSize.x - aTargetSize.x) * 0.5f,
-                         ImGui::GetCursorPosY() + (aWindowSize.y - aTargetSize.y) * 0.5f);
-        ImGui::SetCursorPos (anOffset);
-        myInternal->ViewPos = ImGui::GetCursorScreenPos();
-        ImGui::Image ((ImTextureID )(uintptr_t )anFBO->ColorTexture()->TextureId(),
-          ImVec2 (aTargetSize),
-          ImVec2 (0.f, 1.f),
-          ImVec2 (1.f, 0.f));
-        myInternal->RenderWindowHasFocus = ImGui::IsItemHoveredRect() && !(ImGuizmo::IsOver() || ImGuizmo::IsUsing());
+  delete myInternal;
+  myInternal = NULL;
 
-        Handle(AIS_InteractiveObject) aSelectedObj = myInternal->AISContext->FirstSelectedObject();
+  ImGui_ImplGlfwGL3_Shutdown();
+  glfwTerminate();
+}
 
-        if (myInternal->RenderWindowHasFocus && myInternal->NeedToOpenPopup)
-        {
-          ImGui::OpenPopup ("Menu##viewer");
-          myInternal->NeedToOpenPopup = false;
-        }
+//=======================================================================
+//function : InitHeadless
+//purpose  :
+//=======================================================================
+void AppViewer::InitHeadless (Draw_Interpretor& theDI)
+{
+  if (myTestingData == NULL)
+  {
+    myTestingData = new AppViewer_Testing();
+  }
 
-        if (ImGui::BeginPopup ("Menu##viewer"))
-        {
-          if (ImGui::MenuItem ("Select all", NULL, false))
-          {
-            AIS_ListOfInteractive anObjectList;
-            myInternal->AISContext->DisplayedObjects (anObjectList);
-            for (AIS_ListIteratorOfListOfInteractive aSelIter (anObjectList); aSelIter.More(); aSelIter.Next())
-            {
-              myInternal->AISContext->AddSelect (aSelIter.Value());
-            }
-            myInternal->AISContext->UpdateSelected (false);
-          }
+  // Attach viewer test to view (same defaults as in GUI mode)
+  ViewerTest::SetAISContext (myInternal->AISContext);
+  ViewerTest::CurrentView (myInternal->View);
+
+  theDI.Eval ("vvbo 0");
+  theDI.Eval ("vlight del 1");
+  theDI.Eval ("vlight change 0 head 0 direction -0.25 -1 -1 sm 0.3 int 10");
+  theDI.Eval ("vcamera -persp");
+  theDI.Eval ("vsetdispmode 1");
+  theDI.Eval ("vrenderparams -msaa 8");
+  theDI.Eval ("vaspects -isoontriangulation 1");
+  theDI.Eval ("vtextureenv on $::env(APP_DATA)maps/default.jpg");
+}
 
-          if (ImGui::MenuItem ("Deselect all", NULL, false, !aSelectedObj.IsNull()))
-          {
-            while (!aSelectedObj.IsNull())
-            {
-              myInternal->AISContext->AddOrRemoveSelected (aSelectedObj, false);
-              aSelectedObj = myInternal->AISContext->FirstSelectedObject();
-            }
-            myInternal->AISContext->UpdateSelected (false);
-          }
+//! Safety limits of headless rendering stopped by the noise target only
+//! (the target may be unreachable, e.g. for fireflies or too low level).
+static const int    THE_MAX_NOISE_FRAMES = 16384;
+static const double THE_MAX_NOISE_TIME   = 1800.0;
 
-          if (ImGui::MenuItem ("Invert selection", NULL, false))
-          {
-            AIS_ListOfInteractive anObjectList;
-            myInternal->AISContext->DisplayedObjects (anObjectList);
-            for (AIS_ListIteratorOfListOfInteractive aSelIter (anObjectList); aSelIter.More(); aSelIter.Next())
-            {
-              myInternal->AISContext->AddOrRemoveSelected (aSelIter.Value(), false);
-            }
-            myInternal->AISContext->UpdateSelected (false);
-          }
-          
-          ImGui::Spacing();
-          ImGui::Spacing();
-          if (ImGui::MenuItem ("Hide selected", NULL, false, !aSelectedObj.IsNull()))
-          {
-            if (myInternal->AISContext->IsDisplayed (aSelectedObj))
-            {
-              myInternal->AISContext->EraseSelected (false);
-              myInternal->AISContext->UpdateSelected (false);
-            }
-          }
+//=======================================================================
+//function : accumulateHeadless
+//purpose  :
+//=======================================================================
+bool AppViewer::accumulateHeadless (const int theSizeX, const int theSizeY, const int theMaxFramesCount, const double theMaxTime,
+                                    const bool theToRestart)
+{
+  myInternal->Viewport = ImVec2 (static_cast<float> (theSizeX), static_cast<float> (theSizeY));
 
-          if (ImGui::MenuItem ("Show all", NULL, false))
-          {
-            myInternal->AISContext->DisplayAll (false);
-            myInternal->AISContext->UpdateSelected(false);
-          }
+  if (!myInternal->ScreenFBO->InitLazy (myInternal->GLContext, theSizeX, theSizeY, GL_RGB8, GL_DEPTH24_STENCIL8))
+  {
+    return false;
+  }
+
+  Handle (CustomWindow) aWindow = Handle (CustomWindow)::DownCast (myInternal->View->Window());
+
+  // Off-screen EGL context uses neutral window (see constructor)
+  Handle (Aspect_NeutralWindow) aNeutralWindow = Handle (Aspect_NeutralWindow)::DownCast (myInternal->View->Window());
+
+  if (!aWindow.IsNull())
+  {
+    aWindow->SetSize (theSizeX, theSizeY);
+  }
+  else if (!aNeutralWindow.IsNull())
+  {
+    aNeutralWindow->SetSize (theSizeX, theSizeY);
+  }
+
+  Handle (Graphic3d_Camera) aCamera = myInternal->View->Camera();
+
+  // Scene should be complete before the first frame
+  ie::MeshQueue::GetInstance ()->Wait ();
+  ie::MeshQueue::GetInstance ()->Update (aCamera);
+
+  ie::Convergence* aConvergence = ie::Convergence::GetInstance ();
+
+  if (theToRestart)
+  {
+    aConvergence->Reset ();
+  }
+
+  // Noise target alone does not guarantee that rendering ever stops
+  const bool isNoiseOnly = theMaxFramesCount <= 0 && theMaxTime <= 0.0
+                        && aConvergence->MaxSamples() <= 0 && aConvergence->MaxTime() <= 0.0;
+
+  OSD_Timer aTimer;
+
+  aTimer.Start();
+
+  for (myInternal->CurFramesCount = 0;; )
+  {
+    myInternal->View->ZFitAll();
+
+    // Pixel size is defined by the whole image (not by the tile)
+    ie::MeshRefiner::GetInstance ()->Update (aCamera, static_cast<int> (myRTSize.y));
+
+    myInternal->View->Redraw();
+
+    glFinish(); // frame time should include GPU work
+
+    if (++myInternal->CurFramesCount == 1 && myTestingData->FirstFrameTime == 0.0)
+    {
+      myTestingData->FirstFrameTime = aTimer.ElapsedTime();
+    }
+
+    // Stop criteria set by script (rtconvergence) are checked as well
+    const bool isConverged = aConvergence->Update (myInternal->View);
+
+    // Resume accumulation from checkpoint (if enabled by rtcheckpoint)
+    ie::Checkpoint::GetInstance ()->Update (myInternal->View);
+
+    // Intermediate images (if continuous capture is enabled)
+    myInternal->Capture.Update (myInternal->GLContext, myInternal->ScreenFBO, aConvergence->NbTotalSamples ());
+
+    if (isConverged)
+    {
+      break;
+    }
+
+    if (theMaxFramesCount > 0 && myInternal->CurFramesCount >= theMaxFramesCount)
+    {
+      break;
+    }
+
+    if (theMaxTime > 0.0 && aTimer.ElapsedTime() >= theMaxTime)
+    {
+      break;
+    }
+
+    if (theMaxFramesCount <= 0 && theMaxTime <= 0.0 && !(aConvergence->IsActive() && aConvergence->HasCriteria()))
+    {
+      break;
+    }
+
+    if (isNoiseOnly && (myInternal->CurFramesCount >= THE_MAX_NOISE_FRAMES || aTimer.ElapsedTime() >= THE_MAX_NOISE_TIME))
+    {
+      std::cout << "Warning: noise target is not reached in " << myInternal->CurFramesCount << " frames (estimated noise "
+                << aConvergence->Noise() << ")" << std::endl;
+
+      myTestingData->IsConverged = false;
+
+      break;
+    }
+  }
+
+  myTestingData->FramesCount += myInternal->CurFramesCount;
+
+  myInternal->Capture.Flush (myInternal->GLContext, myInternal->ScreenFBO);
+
+  // Time budget may be split across several runs
+  ie::Checkpoint::GetInstance ()->Write (myInternal->View);
+
+  return true;
+}
+
+//=======================================================================
+//function : RenderHeadless
+//purpose  :
+//=======================================================================
+bool AppViewer::RenderHeadless (const int theMaxFramesCount, const double theMaxTime)
+{
+  if (myInternal == NULL || !myInternal->IsHeadless || myTestingData == NULL)
+  {
+    return false;
+  }
+
+  const GLsizei aSizeX = static_cast<GLsizei> (myRTSize.x);
+  const GLsizei aSizeY = static_cast<GLsizei> (myRTSize.y);
+
+  myInternal->View->Camera()->SetAspect (myRTSize.x / myRTSize.y);
+
+  OSD_Timer aTimer;
+
+  aTimer.Start();
+
+  myTestingData->FramesCount = 0;
+  myTestingData->FirstFrameTime = 0.0;
+  myTestingData->IsConverged = true;
+
+  const bool isDone = accumulateHeadless (aSizeX, aSizeY, theMaxFramesCount, theMaxTime);
+
+  myTestingData->RenderTime = aTimer.ElapsedTime();
+  myTestingData->AverageFramerate = myTestingData->FramesCount / std::max (myTestingData->RenderTime, 1.0e-6);
+
+  if (!isDone
+   || !myTestingData->PixMap.InitZero (Image_PixMap::ImgRGB, aSizeX, aSizeY)
+   || !myInternal->View->View()->BufferDump (myTestingData->PixMap, Graphic3d_BT_RGB))
+  {
+    return false;
+  }
+
+  ie::Checkpoint::GetInstance ()->Combine (myTestingData->PixMap);
+
+  return true;
+}
+
+//=======================================================================
+//function : RenderHeadlessTiled
+//purpose  :
+//=======================================================================
+bool AppViewer::RenderHeadlessTiled (const std::string& theFileName, const int theTileSize, const int theMaxFramesCount, const double theMaxTime)
+{
+  if (myInternal == NULL || !myInternal->IsHeadless || myTestingData == NULL || theTileSize < 1)
+  {
+    return false;
+  }
+
+  const int aSizeX = static_cast<int> (myRTSize.x);
+  const int aSizeY = static_cast<int> (myRTSize.y);
+
+  const int aNbTilesX = (aSizeX + theTileSize - 1) / theTileSize;
+  const int aNbTilesY = (aSizeY + theTileSize - 1) / theTileSize;
+
+  TileWriter aWriter;
+
+  if (!aWriter.Open (theFileName, aSizeX, aSizeY))
+  {
+    std::cout << "Error: failed to create image " << theFileName << std::endl;
+    return false;
+  }
+
+  Handle (Graphic3d_Camera) aCamera = myInternal->View->Camera();
+
+  // Projection of the whole image is split into sub-frusta of tiles
+  aCamera->SetAspect (myRTSize.x / myRTSize.y);
+
+  OSD_Timer aTimer;
+
+  aTimer.Start();
+
+  myTestingData->FramesCount = 0;
+  myTestingData->FirstFrameTime = 0.0;
+  myTestingData->IsConverged = true;
+
+  // Only one tile is kept in memory
+  Image_PixMap aTile;
+
+  bool isDone = true;
+
+  for (int aTileY = 0; aTileY < aNbTilesY && isDone; ++aTileY)
+  {
+    for (int aTileX = 0; aTileX < aNbTilesX && isDone; ++aTileX)
+    {
+      Graphic3d_CameraTile aCameraTile;
+
+      aCameraTile.TotalSize = Graphic3d_Vec2i (aSizeX, aSizeY);
+      aCameraTile.Offset    = Graphic3d_Vec2i (aTileX * theTileSize, aTileY * theTileSize);
+      aCameraTile.TileSize  = Graphic3d_Vec2i (std::min (theTileSize, aSizeX - aCameraTile.Offset.x()),
+                                               std::min (theTileSize, aSizeY - aCameraTile.Offset.y()));
+      aCameraTile.IsTopDown = true;
+
+      aCamera->SetTile (aCameraTile);
+
+      std::cout << "Rendering tile " << aTileY * aNbTilesX + aTileX + 1 << " of " << aNbTilesX * aNbTilesY
+                << " (" << aCameraTile.TileSize.x() << "x" << aCameraTile.TileSize.y() << ")" << std::endl;
+
+      // Time budget is shared by all tiles
+      isDone = accumulateHeadless (aCameraTile.TileSize.x(), aCameraTile.TileSize.y(),
+                                   theMaxFramesCount, theMaxTime / (aNbTilesX * aNbTilesY))
+            && aTile.InitZero (Image_PixMap::ImgRGB, aCameraTile.TileSize.x(), aCameraTile.TileSize.y())
+            && myInternal->View->View()->BufferDump (aTile, Graphic3d_BT_RGB);
+
+      if (isDone)
+      {
+        ie::Checkpoint::GetInstance ()->Combine (aTile);
+
+        isDone = aWriter.Write (aTile, aCameraTile.Offset.x(), aCameraTile.Offset.y());
+      }
+    }
+  }
+
+  aCamera->SetTile (Graphic3d_CameraTile());
+
+  myTestingData->RenderTime = aTimer.ElapsedTime();
+  myTestingData->AverageFramerate = myTestingData->FramesCount / std::max (myTestingData->RenderTime, 1.0e-6);
+
+  return aWriter.Close () && isDone;
+}
+
+//=======================================================================
+//function : imageError
+//purpose  : Returns RMSE of 8-bit RGB image relative to the reference
+//=======================================================================
+static double imageError (const Image_PixMap& theImage, const Image_PixMap& theReference)
+{
+  double aSum = 0.0;
+
+  for (Standard_Size aRow = 0; aRow < theImage.SizeY(); ++aRow)
+  {
+    const Standard_Byte* aPixel = theImage.Row (aRow);
+    const Standard_Byte* aRefPixel = theReference.Row (aRow);
+
+    for (Standard_Size anIdx = 0; anIdx < theImage.SizeX() * 3; ++anIdx)
+    {
+      const double aDelta = (aPixel[anIdx] - aRefPixel[anIdx]) / 255.0;
+
+      aSum += aDelta * aDelta;
+    }
+  }
+
+  return std::sqrt (aSum / std::max<Standard_Size> (theImage.SizeX() * theImage.SizeY() * 3, 1));
+}
+
+//! Number of frames of the reference image of denoiser benchmark (relative to the last stage).
+static const int THE_REFERENCE_FACTOR = 4;
+
+//=======================================================================
+//function : BenchmarkDenoiser
+//purpose  :
+//=======================================================================
+bool AppViewer::BenchmarkDenoiser (const std::string& theReportFile, const int theMaxFramesCount)
+{
+  if (myInternal == NULL || !myInternal->IsHeadless || myTestingData == NULL || theMaxFramesCount < 2)
+  {
+    return false;
+  }
 
-          ImGui::Spacing();
-          ImGui::Spacing();
-          if (ImGui::MenuItem ("Remove selected", NULL, false, !aSelectedObj.IsNull()))
-          {
-            while (!aSelectedObj.IsNull())
-            {
-              GetMapOfAIS().UnBind1(aSelectedObj);
-              myInternal->AISContext->Remove(aSelectedObj, false);
-              aSelectedObj = myInternal->AISContext->FirstSelectedObject();
-            }
-            //myInternal->AISContext->UpdateSelected(false);
-          }
+  std::ofstream aReport (theReportFile.c_str());
 
-          ImGui::EndPopup ();
-        }
+  if (!aReport.is_open())
+  {
+    return false;
+  }
 
+  const GLsizei aSizeX = static_cast<GLsizei> (myRTSize.x);
+  const GLsizei aSizeY = static_cast<GLsizei> (myRTSize.y);
 
-        // Draw OCCT logo
-        ImVec2 aLogoOffset (anOffset.x,
-                            anOffset.y + aTargetSize.y - myInternal->LogoH * 0.5f);
-        ImGui::SetCursorPos (aLogoOffset);
-        ImGui::Image ((ImTextureID )(uintptr_t )myInternal->LogoTexture,
-          ImVec2 (myInternal->LogoW * 0.5f, myInternal->LogoH * 0.5f));
+  myInternal->View->Camera()->SetAspect (myRTSize.x / myRTSize.y);
 
-        if (myInternal->NeedToShowHint)
-        {
-          char aText[] = "If you feel lost, please check examples in Script editor below";
-          ImVec2 aTextSize = ImGui::CalcTextSize (aText);
-          ImVec2 aTextPos = ImVec2 (myInternal->ViewPos.x + myInternal->Viewport.x * 0.5f - aTextSize.x * 0.5f,
-                                    myInternal->ViewPos.y + myInternal->Viewport.y * 0.5f - aTextSize.y * 0.5f);
-          AppOverlayDrawList->AddText (ImGui::GetFont(), ImGui::GetFontSize(), aTextPos, ImGui::GetColorU32 (ImGuiCol_Text), aText, aText + strlen (aText));
+  // Intermediate image of progressive rendering
+  struct Stage
+  {
+    int NbSamples;
+    int Fraction;
+    double RenderTime;
+    double GuidesTime;
+    double DenoiseTime;
+    Handle (Image_PixMap) Noisy;
+    Handle (Image_PixMap) Denoised;
+  };
 
-          static float aTime = 0.f;
-          ImVec2 anArrowCenter = ImVec2 (myInternal->ViewPos.x + myInternal->Viewport.x * 0.5f,
-                                         myInternal->ViewPos.y + myInternal->Viewport.y * 0.5f + aTextSize.y * 3.f + aTextSize.y * sinf (aTime * 6.f) * 0.5f);
-          aTime += ImGui::GetIO().DeltaTime;
+  std::vector<Stage> aStages;
 
-          const float r = 40.0f;
-          ImVec2 center = anArrowCenter;
+  OSD_Timer aTimer;
 
-          ImVec2 a, b, c;
-          a = ImVec2 (center.x + 0, center.y + r);
-          b = ImVec2 (center.x + r, center.y);
-          c = ImVec2 (center.x - r, center.y);
+  aTimer.Start();
 
-          AppOverlayDrawList->AddTriangleFilled (a, b, c, ImGui::GetColorU32 (ImGuiCol_Text));
-        }
-      }
+  myTestingData->FramesCount = 0;
+  myTestingData->FirstFrameTime = 0.0;
+  myTestingData->IsConverged = true;
+
+  // Stages of 1/64 ... 1/1 of frames are compared to separate reference image
+  for (int aFraction = 64, aNbFrames = 0; aFraction >= 1; aFraction /= 2)
+  {
+    const int aTargetFrames = std::max (theMaxFramesCount / aFraction, 1);
+
+    if (aTargetFrames <= aNbFrames)
+    {
+      continue;
     }
-    ImGui::EndDock();
 
-    if (myInternal->ExternalGui != NULL)
+    Stage aStage;
+
+    aStage.Fraction = aFraction;
+    aStage.Noisy = new Image_PixMap();
+
+    if (!accumulateHeadless (aSizeX, aSizeY, aTargetFrames - aNbFrames, 0.0, aNbFrames == 0)
+     || !aStage.Noisy->InitZero (Image_PixMap::ImgRGB, aSizeX, aSizeY)
+     || !myInternal->View->View()->BufferDump (*aStage.Noisy, Graphic3d_BT_RGB))
     {
-      myInternal->ExternalGui->Draw (myInternal->AISContext.operator->(), myInternal->View.operator->(), !myInternal->RenderWindowHasFocus);
+      return false;
     }
 
-    if (myTestingData != NULL)
+    aNbFrames = aTargetFrames;
+
+    ie::Checkpoint::GetInstance ()->Combine (*aStage.Noisy);
+
+    aStage.NbSamples = ie::Convergence::GetInstance ()->NbTotalSamples ();
+    aStage.RenderTime = aTimer.ElapsedTime();
+
+    // Denoising time is not included into render time
+    aTimer.Stop();
+
+    OSD_Timer aDenoiseTimer;
+
+    aDenoiseTimer.Start();
+
+    ie::AovBuffers aGuides;
+
+    if (!aGuides.Perform (myInternal->View, false))
     {
-      if (myTestingData->NeedToRunScript)
-      {
-        myInternal->ExternalGui->ConsoleExec(myTestingData->Script.c_str());
-        myTestingData->NeedToRunScript = false;
-      }
+      return false;
     }
 
-    ImGui::EndWorkspace();
-    ImGui::End();
+    aStage.GuidesTime = aDenoiseTimer.ElapsedTime();
 
-    ImGui::BringOverlayWindowToFront();
+    aStage.Denoised = new Image_PixMap();
 
-    if (show_test_window)
+    if (!aStage.Denoised->InitCopy (*aStage.Noisy)
+     || !ie::Denoiser::GetInstance ()->Perform (aGuides, *aStage.Denoised))
     {
-      ImGui::SetNextWindowPos (ImVec2 (650, 20), ImGuiSetCond_FirstUseEver);
-      ImGui::ShowTestWindow (&show_test_window);
+      return false;
     }
 
-    // ImGui::DockDebugWindow();
+    aStage.DenoiseTime = aDenoiseTimer.ElapsedTime() - aStage.GuidesTime;
 
-    myInternal->ImguiHasFocus = ImGui::GetIO().WantCaptureMouse && !myInternal->RenderWindowHasFocus;
-    myInternal->ImguiHasKeyboardFocus = ImGui::GetIO().WantCaptureKeyboard;
+    aStages.push_back (aStage);
 
-    glClear (GL_COLOR_BUFFER_BIT);
-    ImGui::Render();
+    aTimer.Start();
+  }
 
-    char aTitleString[128];
-    sprintf (aTitleString, "CADRays v%s [FPS %d]", CADRaysVersion::Get(), (int)ImGui::GetIO().Framerate);
-    SetTitle (aTitleString);
+  myTestingData->RenderTime = aTimer.ElapsedTime();
+  myTestingData->AverageFramerate = myTestingData->FramesCount / std::max (myTestingData->RenderTime, 1.0e-6);
 
-    glfwSwapBuffers (myInternal->Window);
+  if (!myTestingData->PixMap.InitCopy (myTestingData->ToDenoise ? *aStages.back().Denoised : *aStages.back().Noisy))
+  {
+    return false;
   }
 
-  if (myTestingData != NULL)
+  // Reference is accumulated further (not included into timings), so that
+  // its own noise does not reduce the error of the last stages
+  const int aNbStageFrames = myTestingData->FramesCount;
+
+  Image_PixMap aReference;
+
+  if (!accumulateHeadless (aSizeX, aSizeY, (THE_REFERENCE_FACTOR - 1) * std::max (theMaxFramesCount, 1), 0.0, false)
+   || !aReference.InitZero (Image_PixMap::ImgRGB, aSizeX, aSizeY)
+   || !myInternal->View->View()->BufferDump (aReference, Graphic3d_BT_RGB))
   {
-    if (myTestingData->MaxFramesCount > 0)
-    {
-      if (myTestingData->PixMap.InitZero (Image_PixMap::ImgRGB, Standard_Size(myRTSize.x), Standard_Size(myRTSize.y)))
-      {
-        myInternal->View->View()->BufferDump(myTestingData->PixMap, Graphic3d_BT_RGB);
-      }
-    }
+    return false;
   }
 
-  ImGui::SaveDocks (myInternal->ExternalGui->GetSettings());
+  ie::Checkpoint::GetInstance ()->Combine (aReference);
 
-  myInternal->ScreenFBO->Release (myInternal->GLContext.operator->());
+  const int aNbReferenceSamples = ie::Convergence::GetInstance ()->NbTotalSamples ();
 
-  // Cleanup
-  glDeleteTextures (1, &myInternal->LogoTexture);
+  myTestingData->FramesCount = aNbStageFrames;
 
-  for (auto anIter : Textures)
+  aReport << "samples,fraction,render_sec,guides_sec,denoise_sec,"
+             "rmse_noisy,psnr_noisy,rmse_denoised,psnr_denoised,equivalent_samples\n";
+
+  std::cout << "Denoiser benchmark (reference of " << aNbReferenceSamples << " samples):\n";
+
+  for (size_t aStageIdx = 0; aStageIdx < aStages.size(); ++aStageIdx)
   {
-    glDeleteTextures (1, &anIter.second.Texture);
+    const Stage& aStage = aStages[aStageIdx];
+
+    const double aNoisyError    = std::max (imageError (*aStage.Noisy,    aReference), 1.0e-6);
+    const double aDenoisedError = std::max (imageError (*aStage.Denoised, aReference), 1.0e-6);
+
+    // Error of progressive rendering decreases as 1 / sqrt (samples)
+    const double aNbEquivalent = aStage.NbSamples * (aNoisyError / aDenoisedError) * (aNoisyError / aDenoisedError);
+
+    aReport << aStage.NbSamples << ",1/" << aStage.Fraction << ","
+            << aStage.RenderTime << "," << aStage.GuidesTime << "," << aStage.DenoiseTime << ","
+            << aNoisyError << "," << -20.0 * std::log10 (aNoisyError) << ","
+            << aDenoisedError << "," << -20.0 * std::log10 (aDenoisedError) << ","
+            << aNbEquivalent << "\n";
+
+    std::cout << "  " << aStage.NbSamples << " samples (1/" << aStage.Fraction << "): PSNR "
+              << -20.0 * std::log10 (aNoisyError) << " -> " << -20.0 * std::log10 (aDenoisedError) << " dB in "
+              << (aStage.GuidesTime + aStage.DenoiseTime) * 1000.0 << " ms, equal to "
+              << static_cast<int> (aNbEquivalent) << " samples" << std::endl;
   }
 
-  Textures.clear();
+  return aReport.good();
+}
+
+//=======================================================================
+//function : ReleaseHeadless
+//purpose  :
+//=======================================================================
+void AppViewer::ReleaseHeadless()
+{
+  if (myInternal == NULL)
+  {
+    return;
+  }
+
+  myInternal->Capture.Release (myInternal->GLContext);
+
+  myInternal->ScreenFBO->Release (myInternal->GLContext.operator->());
 
+  // Cleanup
   myInternal->AISContext->RemoveAll (Standard_False);
 
   model::DataModel* aModel = model::DataModel::GetDefault();
   aModel->Clear();
 
+#if defined(HAVE_EGL)
+  EGLDisplay anEglDisplay = myInternal->EglDisplay;
+  EGLContext anEglContext = myInternal->EglContext;
+  EGLSurface anEglSurface = myInternal->EglSurface;
+#endif
+
   delete myInternal;
   myInternal = NULL;
 
-  ImGui_ImplGlfwGL3_Shutdown();
+#if defined(HAVE_EGL)
+  // Context is released after OCCT resources of the view
+  releaseEglContext (anEglDisplay, anEglContext, anEglSurface);
+#endif
+
+  // Does nothing if GLFW was not initialized (EGL context)
   glfwTerminate();
 }
 
+//=======================================================================
+//function : RunHeadless
+//purpose  :
+//=======================================================================
+bool AppViewer::RunHeadless (Draw_Interpretor& theDI)
+{
+  if (myInternal == NULL || !myInternal->IsHeadless)
+  {
+    return false;
+  }
+
+  InitHeadless (theDI);
+
+  OSD_Timer aTimer;
+
+  aTimer.Start();
+
+  bool isDone = theDI.Eval (myTestingData->Script.c_str()) == 0;
+
+  if (!isDone)
+  {
+    std::cout << "Error: script failed: " << theDI.Result() << std::endl;
+  }
+
+  const double aLoadTime = aTimer.ElapsedTime();
+
+  if (isDone)
+  {
+    if (myTestingData->TileSize > 0)
+    {
+      isDone = RenderHeadlessTiled (myTestingData->OutputFile, myTestingData->TileSize, myTestingData->MaxFramesCount);
+    }
+    else if (!myTestingData->DenoiseReport.empty())
+    {
+      isDone = BenchmarkDenoiser (myTestingData->DenoiseReport, myTestingData->MaxFramesCount);
+    }
+    else
+    {
+      isDone = RenderHeadless (myTestingData->MaxFramesCount);
+    }
+
+    std::cout << "Rendered " << myTestingData->FramesCount << " frames (" << myRTSize.x << "x" << myRTSize.y << ") in " << myTestingData->RenderTime << " sec\n"
+              << "  Script:      " << aLoadTime << " sec\n"
+              << "  First frame: " << myTestingData->FirstFrameTime * 1000.0 << " ms\n"
+              << "  Average:     " << myTestingData->RenderTime * 1000.0 / std::max (myTestingData->FramesCount, 1) << " ms (" << myTestingData->AverageFramerate << " FPS)" << std::endl;
+  }
+
+  // Buffers are read from the view, so they are available for the last tile only
+  if (isDone && (!myTestingData->AovFile.empty() || myTestingData->ToDenoise) && myTestingData->TileSize > 0)
+  {
+    std::cout << "Warning: AOV buffers and denoising are not supported in tiled rendering" << std::endl;
+  }
+  else if (isDone && myTestingData->ToDenoise && myTestingData->DenoiseReport.empty())
+  {
+    ie::AovBuffers aGuides;
+
+    isDone = aGuides.Perform (myInternal->View, false)
+          && ie::Denoiser::GetInstance ()->Perform (aGuides, myTestingData->PixMap);
+
+    if (!isDone)
+    {
+      std::cout << "Error: failed to denoise image" << std::endl;
+    }
+  }
+
+  if (isDone && !myTestingData->AovFile.empty() && myTestingData->TileSize == 0)
+  {
+    ie::AovBuffers aBuffers;
+
+    isDone = aBuffers.Perform (myInternal->View)
+          && (!myTestingData->ToDenoise || ie::Denoiser::GetInstance ()->Perform (aBuffers))
+          && aBuffers.WriteExr (myTestingData->AovFile.c_str());
+
+    if (!isDone)
+    {
+      std::cout << "Error: failed to write AOV buffers " << myTestingData->AovFile << std::endl;
+    }
+  }
+
+  ReleaseHeadless();
+
+  return isDone;
+}
+
+//=======================================================================
+//function : ResolutionScale
+//purpose  :
+//=======================================================================
+float AppViewer::ResolutionScale()
+{
+  return myInternal->ResolutionScale;
+}
+
+//=======================================================================
+//function : GetProfiler
+//purpose  :
+//=======================================================================
+FrameProfiler& AppViewer::GetProfiler()
+{
+  return myInternal->Profiler;
+}
+
+//=======================================================================
+//function : GetCapture
+//purpose  :
+//=======================================================================
+ImageCapture& AppViewer::GetCapture()
+{
+  return myInternal->Capture;
+}
+
 //=======================================================================
 //function : GetLogoTexture
 //purpose  :
@@ -1416,6 +2800,11 @@ void AppViewer::SetGui (GuiBase* theGui)
 //=======================================================================
 void AppViewer::SetTitle (const std::string& theTitle)
 {
+  if (myTitle == theTitle)
+  {
+    return;
+  }
+
   myTitle = theTitle;
   glfwSetWindowTitle (myInternal->Window, theTitle.c_str());
 }
@@ -1456,6 +2845,17 @@ void AppViewer::StopUpdating(bool theNeedToStopUpdating)
   myInternal->NeedToStopUpdating = theNeedToStopUpdating;
 }
 
+//=======================================================================
+//function : RestartRendering
+//purpose  :
+//=======================================================================
+void AppViewer::RestartRendering()
+{
+  ie::Convergence::GetInstance ()->Reset ();
+
+  myInternal->NeedToStopUpdating = false;
+}
+
 //=======================================================================
 //function : IsUpdatingEnabled
 //purpose  :
@@ -1477,6 +2877,47 @@ void AppViewer::SetScript (std::string theCommand, int theMaxFramesCount)
   myTestingData->NeedToRunScript = true;
 }
 
+//=======================================================================
+//function : SetTiledOutput
+//purpose  :
+//=======================================================================
+void AppViewer::SetTiledOutput (const std::string& theFileName, const int theTileSize)
+{
+  if (myTestingData == NULL)
+  {
+    myTestingData = new AppViewer_Testing();
+  }
+  myTestingData->OutputFile = theFileName;
+  myTestingData->TileSize = theTileSize;
+}
+
+//=======================================================================
+//function : SetAovOutput
+//purpose  :
+//=======================================================================
+void AppViewer::SetAovOutput (const std::string& theFileName)
+{
+  if (myTestingData == NULL)
+  {
+    myTestingData = new AppViewer_Testing();
+  }
+  myTestingData->AovFile = theFileName;
+}
+
+//=======================================================================
+//function : SetDenoising
+//purpose  :
+//=======================================================================
+void AppViewer::SetDenoising (const bool theToDenoise, const std::string& theReportFile)
+{
+  if (myTestingData == NULL)
+  {
+    myTestingData = new AppViewer_Testing();
+  }
+  myTestingData->ToDenoise = theToDenoise;
+  myTestingData->DenoiseReport = theReportFile;
+}
+
 //=======================================================================
 //function : GetAverageFramerate
 //purpose  :
@@ -1490,6 +2931,42 @@ double AppViewer::GetAverageFramerate ()
   return myTestingData->AverageFramerate;
 }
 
+//=======================================================================
+//function : GetFramesCount
+//purpose  :
+//=======================================================================
+int AppViewer::GetFramesCount()
+{
+  return myTestingData != NULL ? myTestingData->FramesCount : 0;
+}
+
+//=======================================================================
+//function : GetRenderTime
+//purpose  :
+//=======================================================================
+double AppViewer::GetRenderTime()
+{
+  return myTestingData != NULL ? myTestingData->RenderTime : 0.0;
+}
+
+//=======================================================================
+//function : GetFirstFrameTime
+//purpose  :
+//=======================================================================
+double AppViewer::GetFirstFrameTime()
+{
+  return myTestingData != NULL ? myTestingData->FirstFrameTime : 0.0;
+}
+
+//=======================================================================
+//function : IsTestingConverged
+//purpose  :
+//=======================================================================
+bool AppViewer::IsTestingConverged()
+{
+  return myTestingData == NULL || myTestingData->IsConverged;
+}
+
 //=======================================================================
 //function : GetAverageFramerate
 //purpose  :
@@ -1541,24 +3018,6 @@ void AppViewer::SetCameraMoving (gp_Pnt theFinishPoint)
   myCameraMovingData->TStep = 4 / ImGui::GetIO().Framerate;
 }
 
-////=======================================================================
-////function : GetWorkingTime
-////purpose  :
-////=======================================================================
-//float AppViewer::GetWorkingTime ()
-//{
-//  return myInternal->WorkingTime;
-//}
-//
-////=======================================================================
-////function : SetMaxWorkingTime
-////purpose  :
-////=======================================================================
-//void AppViewer::SetMaxWorkingTime (float theTime)
-//{
-//  myInternal->MaxWorkingTime = theTime;
-//}
-
 //=======================================================================
 //function : SetViewControls
 //purpose  :
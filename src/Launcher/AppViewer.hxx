@@ -21,6 +21,9 @@
 
 class GuiBase;
 class ViewControls;
+class Draw_Interpretor;
+class FrameProfiler;
+class ImageCapture;
 
 struct AppViewer_Internal;
 struct AppViewer_Testing;
@@ -42,7 +45,8 @@ class AppViewer
 public:
 
   //! Creates and initializes rendering window.
-  Standard_EXPORT AppViewer (const std::string theTitle, const std::string theDataDir, const int theWidth = 1600, const int theHeight = 900);
+  //! In headless mode the window is hidden and ImGui is not initialized.
+  Standard_EXPORT AppViewer (const std::string theTitle, const std::string theDataDir, const int theWidth = 1600, const int theHeight = 900, const bool theIsHeadless = false);
 
 public:
 
@@ -62,6 +66,35 @@ public:
   //! Starts internal message processing loop.
   Standard_EXPORT void Run();
 
+  //! Runs testing script and renders the given number of frames into offscreen
+  //! buffer of render target size without GUI. Resulting image and framerate are
+  //! available as testing data. Returns false if the script or rendering failed.
+  Standard_EXPORT bool RunHeadless (Draw_Interpretor& theDI);
+
+  //! Attaches viewer test commands to headless view and applies default view settings.
+  Standard_EXPORT void InitHeadless (Draw_Interpretor& theDI);
+
+  //! Renders current scene in headless mode until the given number of frames or
+  //! time limit (in seconds, 0 if not used) is reached. Image and timings are
+  //! stored as testing data. Can be called several times for the same scene.
+  Standard_EXPORT bool RenderHeadless (const int theMaxFramesCount, const double theMaxTime = 0.0);
+
+  //! Renders current scene in headless mode tile by tile (each tile is accumulated
+  //! until the given number of frames, time limit is shared by all tiles) and writes
+  //! tiles to the given PPM file. Memory usage does not depend on the image size.
+  Standard_EXPORT bool RenderHeadlessTiled (const std::string& theFileName, const int theTileSize,
+                                            const int theMaxFramesCount, const double theMaxTime = 0.0);
+
+  //! Renders current scene in headless mode to the given number of frames and
+  //! denoises intermediate images (1/64 ... 1/1 of frames). Render and denoise
+  //! time and error of noisy and denoised images (relative to the reference image
+  //! accumulated to 4x frames) are written to the given CSV file. The image of
+  //! the given number of frames is stored as testing data.
+  Standard_EXPORT bool BenchmarkDenoiser (const std::string& theReportFile, const int theMaxFramesCount);
+
+  //! Releases rendering resources of headless viewer.
+  Standard_EXPORT void ReleaseHeadless();
+
   //! Fits scene into view.
   Standard_EXPORT void FitAll();
 
@@ -80,15 +113,40 @@ public:
   //! Enables/disables screen updating
   Standard_EXPORT void StopUpdating(bool theNeedToStopUpdating);
   
+  //! Restarts accumulation of the image and resumes paused rendering. Should be
+  //! called on scene changes not tracked by the view state (materials, lights, etc).
+  Standard_EXPORT void RestartRendering();
+
   //! Check if screen updating is enabled
   Standard_EXPORT bool IsUpdatingEnabled();
   
   //! Set script for testing 
   Standard_EXPORT void SetScript(std::string theCommand, int theMaxFramesCount = 0);
+
+  //! Enables tiled rendering of testing script into the given PPM file (0 tile size disables it)
+  Standard_EXPORT void SetTiledOutput (const std::string& theFileName, const int theTileSize);
+
+  //! Enables output of radiance and auxiliary buffers of testing script into the given EXR file
+  Standard_EXPORT void SetAovOutput (const std::string& theFileName);
+
+  //! Enables denoising of testing script output (and benchmark of the denoiser if report file is not empty)
+  Standard_EXPORT void SetDenoising (const bool theToDenoise, const std::string& theReportFile = "");
   
   //! Get average framerate for testing script
   Standard_EXPORT double GetAverageFramerate();
   
+  //! Get number of frames rendered for testing script
+  Standard_EXPORT int GetFramesCount();
+
+  //! Get rendering time (in seconds) for testing script
+  Standard_EXPORT double GetRenderTime();
+
+  //! Get time of the first frame (in seconds) for testing script
+  Standard_EXPORT double GetFirstFrameTime();
+
+  //! Checks whether testing script was not stopped by the safety limit before reaching the noise target
+  Standard_EXPORT bool IsTestingConverged();
+
   //! Get resulting image for testing script
   Standard_EXPORT Image_AlienPixMap& GetTestingImage();
   
@@ -101,12 +159,6 @@ public:
   //! Set data for camera moving
   Standard_EXPORT void SetCameraMoving (gp_Pnt theFinishPoint);
 
-  ////! Get current working time
-  //Standard_EXPORT float GetWorkingTime ();
-
-  ////! Set max working time
-  //Standard_EXPORT void SetMaxWorkingTime (float theTime);
-
   //! Sets window title.
   Standard_EXPORT void SetTitle (const std::string& theTitle);
 
@@ -149,9 +201,32 @@ public:
     myFitToArea = theToFit;
   }
 
+  //! Returns target frame time (in seconds) during camera interaction
+  //! (0 if dynamic resolution is disabled).
+  double InteractiveFrameTime() const
+  {
+    return myInteractiveFrameTime;
+  }
+
+  //! Sets target frame time (in seconds) during camera interaction. Render
+  //! resolution is reduced to reach it (0 disables dynamic resolution).
+  void SetInteractiveFrameTime (const double theTime)
+  {
+    myInteractiveFrameTime = theTime;
+  }
+
+  //! Returns current scale of render resolution (1 if not reduced).
+  Standard_EXPORT float ResolutionScale();
+
   //! Returns OCCT logo texture id.
   Standard_EXPORT unsigned int GetLogoTexture (int* theWidth = NULL, int* theHeight = NULL);
 
+  //! Returns profiler of the main loop stages.
+  Standard_EXPORT FrameProfiler& GetProfiler();
+
+  //! Returns asynchronous capture of rendered frames.
+  Standard_EXPORT ImageCapture& GetCapture();
+
   //! Sets the callback called on selection.
   Standard_EXPORT void SetSelectionCallback (void (*theSelectionCallback)(GuiBase* theGui));
 
@@ -159,6 +234,13 @@ public:
 
   std::map<std::string, ImageInfo> Textures;
 
+private:
+
+  //! Accumulates frames of headless view of the given size until stop criteria are met
+  //! (stop criteria are not reset if accumulation is continued).
+  bool accumulateHeadless (const int theSizeX, const int theSizeY, const int theMaxFramesCount, const double theMaxTime,
+                           const bool theToRestart = true);
+
 private:
 
   //! Render target size.
@@ -167,6 +249,9 @@ private:
   //! Fit viewport size to available area.
   bool myFitToArea = true;
 
+  //! Target frame time during camera interaction.
+  double myInteractiveFrameTime = 1.0 / 30.0;
+
   //! Window title.
   std::string myTitle;
 
@@ -262,6 +262,24 @@ void FlightControls::Update (const float theDelta)
   myInternal->Translation = Graphic3d_Vec3 (0.f, 0.f, 0.f);
 };
 
+//=======================================================================
+//function : IsMoving
+//purpose  :
+//=======================================================================
+bool FlightControls::IsMoving() const
+{
+  if (myInternal == NULL)
+  {
+    return false;
+  }
+
+  return myInternal->State != OCS_NONE
+      || myInternal->MoveForward
+      || myInternal->MoveBackward
+      || myInternal->MoveLeft
+      || myInternal->MoveRight;
+}
+
 //=======================================================================
 //function : OnMouseDown
 //purpose  :
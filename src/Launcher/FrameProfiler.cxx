@@ -0,0 +1,159 @@
+// Created: 2019-07-03
+//
+// Copyright (c) 2019 OPEN CASCADE SAS
+//
+// This file is a part of CADRays software.
+//
+// CADRays is free software; you can use it under the terms of the MIT license,
+// refer to file LICENSE.txt for complete text of the license and disclaimer of
+// any warranty.
+
+#include "FrameProfiler.hxx"
+
+#include <fstream>
+
+//=======================================================================
+//function : FrameProfiler
+//purpose  :
+//=======================================================================
+FrameProfiler::FrameProfiler (const int theCapacity)
+  : myFirst (0),
+    myCapacity (static_cast<size_t> (theCapacity > 0 ? theCapacity : 1)),
+    myLastMark (0.0),
+    myIsEnabled (false)
+{
+  myFrames.reserve (myCapacity);
+
+  myCurrent = Frame ();
+}
+
+//=======================================================================
+//function : StageName
+//purpose  :
+//=======================================================================
+const char* FrameProfiler::StageName (const Stage theStage)
+{
+  switch (theStage)
+  {
+    case Stage_Events:       return "Events";
+    case Stage_GuiBuild:     return "GUI build";
+    case Stage_SceneUpdate:  return "Scene update";
+    case Stage_Accumulation: return "Accumulation";
+    case Stage_GuiRender:    return "GUI render";
+    default:                 return "";
+  }
+}
+
+//=======================================================================
+//function : BeginFrame
+//purpose  :
+//=======================================================================
+void FrameProfiler::BeginFrame ()
+{
+  myCurrent = Frame ();
+
+  myTimer.Reset ();
+  myTimer.Start ();
+
+  myLastMark = 0.0;
+}
+
+//=======================================================================
+//function : EndStage
+//purpose  :
+//=======================================================================
+void FrameProfiler::EndStage (const Stage theStage)
+{
+  const double aTime = myTimer.ElapsedTime ();
+
+  myCurrent.Times[theStage] += static_cast<float> ((aTime - myLastMark) * 1000.0);
+
+  myLastMark = aTime;
+}
+
+//=======================================================================
+//function : EndFrame
+//purpose  :
+//=======================================================================
+void FrameProfiler::EndFrame ()
+{
+  myTimer.Stop ();
+
+  if (!myIsEnabled)
+  {
+    return;
+  }
+
+  if (myFrames.size () < myCapacity)
+  {
+    myFrames.push_back (myCurrent);
+  }
+  else
+  {
+    myFrames[myFirst] = myCurrent;
+
+    myFirst = (myFirst + 1) % myCapacity;
+  }
+}
+
+//=======================================================================
+//function : Clear
+//purpose  :
+//=======================================================================
+void FrameProfiler::Clear ()
+{
+  myFrames.clear ();
+
+  myFirst = 0;
+}
+
+//=======================================================================
+//function : Average
+//purpose  :
+//=======================================================================
+FrameProfiler::Frame FrameProfiler::Average () const
+{
+  Frame anAverage = Frame ();
+
+  for (size_t aFrameIdx = 0; aFrameIdx < myFrames.size (); ++aFrameIdx)
+  {
+    for (int aStage = 0; aStage < Stage_NB; ++aStage)
+    {
+      anAverage.Times[aStage] += myFrames[aFrameIdx].Times[aStage] / myFrames.size ();
+    }
+  }
+
+  return anAverage;
+}
+
+//=======================================================================
+//function : ExportCsv
+//purpose  :
+//=======================================================================
+bool FrameProfiler::ExportCsv (const std::string& theFileName) const
+{
+  std::ofstream aFile (theFileName.c_str ());
+
+  if (!aFile.is_open ())
+  {
+    return false;
+  }
+
+  aFile << "frame,events_ms,gui_build_ms,scene_update_ms,accumulation_ms,gui_render_ms,total_ms\n";
+
+  for (int aFrameIdx = 0; aFrameIdx < NbFrames (); ++aFrameIdx)
+  {
+    const Frame& aFrame = Value (aFrameIdx);
+
+    aFile << aFrameIdx;
+
+    for (int aStage = 0; aStage < Stage_NB; ++aStage)
+    {
+      aFile << "," << aFrame.Times[aStage];
+    }
+
+    aFile << "," << aFrame.Total () << "\n";
+  }
+
+  return aFile.good ();
+}
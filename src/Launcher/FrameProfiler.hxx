@@ -0,0 +1,125 @@
+// Created: 2019-07-03
+//
+// Copyright (c) 2019 OPEN CASCADE SAS
+//
+// This file is a part of CADRays software.
+//
+// CADRays is free software; you can use it under the terms of the MIT license,
+// refer to file LICENSE.txt for complete text of the license and disclaimer of
+// any warranty.
+
+#ifndef _FrameProfiler_HeaderFile
+#define _FrameProfiler_HeaderFile
+
+#include <OSD_Timer.hxx>
+
+#include <string>
+#include <vector>
+
+//! Collects timings of the main loop stages for recent frames (ring buffer).
+//! Time of view redraw is attributed either to scene update (geometry, BVH and
+//! restart of accumulation) or to pure accumulation of path tracing samples.
+class FrameProfiler
+{
+public:
+
+  //! Stages of the main loop.
+  enum Stage
+  {
+    Stage_Events,       //!< Event polling and view controls
+    Stage_GuiBuild,     //!< Building of ImGui widgets
+    Stage_SceneUpdate,  //!< Redraw after scene or camera changes
+    Stage_Accumulation, //!< Redraw accumulating samples only
+    Stage_GuiRender,    //!< Rendering of ImGui and buffer swap
+    Stage_NB
+  };
+
+  //! Timings of single frame (in milliseconds).
+  struct Frame
+  {
+    float Times[Stage_NB];
+
+    //! Returns total time of the frame.
+    float Total () const
+    {
+      float aTotal = 0.f;
+
+      for (int aStage = 0; aStage < Stage_NB; ++aStage)
+      {
+        aTotal += Times[aStage];
+      }
+
+      return aTotal;
+    }
+  };
+
+public:
+
+  //! Creates profiler keeping the given number of frames.
+  FrameProfiler (const int theCapacity = 512);
+
+  //! Checks whether profiling is enabled.
+  bool IsEnabled () const { return myIsEnabled; }
+
+  //! Enables or disables profiling (collected frames are kept).
+  void SetEnabled (const bool theToEnable) { myIsEnabled = theToEnable; }
+
+  //! Returns name of the stage.
+  static const char* StageName (const Stage theStage);
+
+public:
+
+  //! Starts timing of new frame.
+  void BeginFrame ();
+
+  //! Adds time since the previous mark to the given stage.
+  void EndStage (const Stage theStage);
+
+  //! Stores timings of current frame in the ring buffer.
+  void EndFrame ();
+
+  //! Removes all collected frames.
+  void Clear ();
+
+public:
+
+  //! Returns number of collected frames.
+  int NbFrames () const { return static_cast<int> (myFrames.size ()); }
+
+  //! Returns collected frame (0 is the oldest one).
+  const Frame& Value (const int theIndex) const
+  {
+    return myFrames[(myFirst + theIndex) % myFrames.size ()];
+  }
+
+  //! Returns average timings of collected frames.
+  Frame Average () const;
+
+  //! Writes collected frames to CSV file. Returns false on error.
+  bool ExportCsv (const std::string& theFileName) const;
+
+private:
+
+  //! Collected frames.
+  std::vector<Frame> myFrames;
+
+  //! Index of the oldest frame.
+  size_t myFirst;
+
+  //! Capacity of the ring buffer.
+  size_t myCapacity;
+
+  //! Timings of current frame.
+  Frame myCurrent;
+
+  //! Measures time of current frame.
+  OSD_Timer myTimer;
+
+  //! Time of the last mark.
+  double myLastMark;
+
+  //! Set when profiling is enabled.
+  bool myIsEnabled;
+};
+
+#endif // _FrameProfiler_HeaderFile
@@ -58,6 +58,9 @@ public:
   //! Reacts to file drag&drop.
   Standard_EXPORT virtual void HandleFileDrop (const char* thePath) = 0;
 
+  //! Returns true if GUI shows progress of some background work.
+  Standard_EXPORT virtual bool IsBusy() { return false; }
+
   //! Adds message to console.
   Standard_EXPORT virtual void ConsoleAddLog (const char* /*theText*/) {}
 
@@ -0,0 +1,491 @@
+// Created: 2019-07-10
+//
+// Copyright (c) 2019 OPEN CASCADE SAS
+//
+// This file is a part of CADRays software.
+//
+// CADRays is free software; you can use it under the terms of the MIT license,
+// refer to file LICENSE.txt for complete text of the license and disclaimer of
+// any warranty.
+
+#include "ImageCapture.hxx"
+
+#include <Checkpoint.hxx>
+
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+//! Number of readbacks in flight (frames may be captured continuously).
+static const int THE_NB_READBACKS = 3;
+
+//! Maximum number of images waiting for encoding (further captures are delayed).
+static const int THE_MAX_IMAGES = 4;
+
+//=======================================================================
+//function : ImageCapture
+//purpose  :
+//=======================================================================
+ImageCapture::ImageCapture ()
+  : myReadbacks (THE_NB_READBACKS),
+    myInterval (0),
+    myFileName ("capture.png"),
+    myNextSamples (0),
+    myNbSamples (0),
+    myNbEncoding (0),
+    myToStop (false)
+{
+  //
+}
+
+//=======================================================================
+//function : ~ImageCapture
+//purpose  :
+//=======================================================================
+ImageCapture::~ImageCapture ()
+{
+  {
+    std::lock_guard<std::mutex> aLock (myMutex);
+
+    myToStop = true;
+  }
+
+  myImageAdded.notify_all ();
+
+  if (myWorker.joinable ())
+  {
+    myWorker.join ();
+  }
+}
+
+//=======================================================================
+//function : SampleFileName
+//purpose  :
+//=======================================================================
+std::string ImageCapture::SampleFileName (const std::string& theFileName, const int theNbSamples)
+{
+  std::ostringstream aSuffix;
+
+  aSuffix << "_" << std::setw (5) << std::setfill ('0') << theNbSamples;
+
+  const size_t aDotPos = theFileName.find_last_of ('.');
+
+  if (aDotPos == std::string::npos || theFileName.find_first_of ("/\\", aDotPos) != std::string::npos)
+  {
+    return theFileName + aSuffix.str () + ".png";
+  }
+
+  return theFileName.substr (0, aDotPos) + aSuffix.str () + theFileName.substr (aDotPos);
+}
+
+//=======================================================================
+//function : Request
+//purpose  :
+//=======================================================================
+void ImageCapture::Request (const std::string& theFileName, const Filter& theFilter)
+{
+  Task aTask;
+
+  aTask.FileName   = theFileName;
+  aTask.Processing = theFilter;
+
+  myTasks.push_back (aTask);
+}
+
+//=======================================================================
+//function : IsBusy
+//purpose  :
+//=======================================================================
+bool ImageCapture::IsBusy () const
+{
+  if (!myTasks.empty ())
+  {
+    return true;
+  }
+
+  for (size_t anIdx = 0; anIdx < myReadbacks.size (); ++anIdx)
+  {
+    if (myReadbacks[anIdx].IsBusy)
+    {
+      return true;
+    }
+  }
+
+  std::lock_guard<std::mutex> aLock (myMutex);
+
+  return !myImages.empty () || myNbEncoding > 0;
+}
+
+//=======================================================================
+//function : Update
+//purpose  :
+//=======================================================================
+void ImageCapture::Update (const Handle (OpenGl_Context)& theContext,
+                           const Handle (OpenGl_FrameBuffer)& theFBO,
+                           const int theNbSamples)
+{
+  if (theContext.IsNull ())
+  {
+    return;
+  }
+
+  // Fences are checked without waiting
+  for (size_t anIdx = 0; anIdx < myReadbacks.size (); ++anIdx)
+  {
+    Readback& aReadback = myReadbacks[anIdx];
+
+    if (aReadback.IsBusy)
+    {
+      const GLenum aStatus = theContext->core32->glClientWaitSync (aReadback.Fence, 0, 0);
+
+      if (aStatus == GL_ALREADY_SIGNALED || aStatus == GL_CONDITION_SATISFIED)
+      {
+        finishReadback (theContext, aReadback);
+      }
+    }
+  }
+
+  // Continuous capture (restarted together with accumulation)
+  if (theNbSamples < myNbSamples || myNextSamples == 0)
+  {
+    myNextSamples = myInterval;
+  }
+
+  myNbSamples = theNbSamples;
+
+  if (myInterval > 0 && theNbSamples >= myNextSamples)
+  {
+    bool isQueued = false;
+
+    for (size_t anIdx = 0; anIdx < myTasks.size (); ++anIdx)
+    {
+      isQueued |= myTasks[anIdx].FileName.empty ();
+    }
+
+    if (!isQueued)
+    {
+      myTasks.push_back (Task());
+    }
+
+    myNextSamples = (theNbSamples / myInterval + 1) * myInterval;
+  }
+
+  if (myTasks.empty () || theFBO.IsNull ())
+  {
+    return;
+  }
+
+  // Captures are delayed while the encoding thread is behind
+  {
+    std::lock_guard<std::mutex> aLock (myMutex);
+
+    if (static_cast<int> (myImages.size ()) + myNbEncoding >= THE_MAX_IMAGES)
+    {
+      return;
+    }
+  }
+
+  // All requests of the frame capture the same image, so one readback is started per frame
+  if (startReadback (theContext, theFBO, myTasks.front ()))
+  {
+    myTasks.pop_front ();
+  }
+}
+
+//=======================================================================
+//function : Flush
+//purpose  :
+//=======================================================================
+void ImageCapture::Flush (const Handle (OpenGl_Context)& theContext,
+                          const Handle (OpenGl_FrameBuffer)& theFBO)
+{
+  if (!theContext.IsNull ())
+  {
+    for (;;)
+    {
+      bool isBusy = false;
+
+      for (size_t anIdx = 0; anIdx < myReadbacks.size (); ++anIdx)
+      {
+        Readback& aReadback = myReadbacks[anIdx];
+
+        if (aReadback.IsBusy)
+        {
+          theContext->core32->glClientWaitSync (aReadback.Fence, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+
+          finishReadback (theContext, aReadback);
+        }
+      }
+
+      while (!myTasks.empty () && !theFBO.IsNull () && startReadback (theContext, theFBO, myTasks.front ()))
+      {
+        myTasks.pop_front ();
+
+        isBusy = true;
+      }
+
+      if (!isBusy)
+      {
+        break;
+      }
+    }
+  }
+
+  myTasks.clear ();
+
+  std::unique_lock<std::mutex> aLock (myMutex);
+
+  myImageSaved.wait (aLock, [this] { return myImages.empty () && myNbEncoding == 0; });
+}
+
+//=======================================================================
+//function : Release
+//purpose  :
+//=======================================================================
+void ImageCapture::Release (const Handle (OpenGl_Context)& theContext)
+{
+  for (size_t anIdx = 0; anIdx < myReadbacks.size (); ++anIdx)
+  {
+    Readback& aReadback = myReadbacks[anIdx];
+
+    if (!theContext.IsNull ())
+    {
+      if (aReadback.Fence != NULL)
+      {
+        theContext->core32->glDeleteSync (aReadback.Fence);
+      }
+
+      if (aReadback.Buffer != 0)
+      {
+        theContext->core15fwd->glDeleteBuffers (1, &aReadback.Buffer);
+      }
+    }
+
+    aReadback = Readback();
+  }
+
+  myTasks.clear ();
+}
+
+//=======================================================================
+//function : startReadback
+//purpose  :
+//=======================================================================
+bool ImageCapture::startReadback (const Handle (OpenGl_Context)& theContext,
+                                  const Handle (OpenGl_FrameBuffer)& theFBO,
+                                  const Task& theTask)
+{
+  Task aTask = theTask;
+
+  if (aTask.FileName.empty ())
+  {
+    aTask.FileName = SampleFileName (myFileName, myNbSamples);
+  }
+
+  const int aSizeX = theFBO->GetVPSizeX ();
+  const int aSizeY = theFBO->GetVPSizeY ();
+
+  // Fences require OpenGL 3.2, otherwise pixels are read back immediately
+  if (theContext->core32 == NULL || theContext->core15fwd == NULL)
+  {
+    std::shared_ptr<Image_AlienPixMap> aPixMap (new Image_AlienPixMap);
+
+    if (!aPixMap->InitTrash (Image_PixMap::ImgRGB, aSizeX, aSizeY))
+    {
+      return true;
+    }
+
+    std::vector<Standard_Byte> aPixels (aPixMap->SizeRowBytes () * aSizeY);
+
+    theFBO->BindReadBuffer (theContext);
+
+    glPixelStorei (GL_PACK_ALIGNMENT, 1);
+    glReadPixels (0, 0, aSizeX, aSizeY, GL_RGB, GL_UNSIGNED_BYTE, &aPixels[0]);
+    glPixelStorei (GL_PACK_ALIGNMENT, 4);
+
+    theFBO->UnbindBuffer (theContext);
+
+    for (int aRow = 0; aRow < aSizeY; ++aRow)
+    {
+      memcpy (aPixMap->ChangeRow (aSizeY - 1 - aRow), &aPixels[aRow * aSizeX * 3], aSizeX * 3);
+    }
+
+    ie::Checkpoint::GetInstance ()->Combine (*aPixMap);
+
+    addImage (aPixMap, aTask);
+
+    return true;
+  }
+
+  Readback* aReadback = NULL;
+
+  for (size_t anIdx = 0; anIdx < myReadbacks.size () && aReadback == NULL; ++anIdx)
+  {
+    if (!myReadbacks[anIdx].IsBusy)
+    {
+      aReadback = &myReadbacks[anIdx];
+    }
+  }
+
+  if (aReadback == NULL)
+  {
+    return false;
+  }
+
+  const size_t aSize = static_cast<size_t> (aSizeX) * aSizeY * 3;
+
+  if (aReadback->Buffer == 0)
+  {
+    theContext->core15fwd->glGenBuffers (1, &aReadback->Buffer);
+  }
+
+  theContext->core15fwd->glBindBuffer (GL_PIXEL_PACK_BUFFER, aReadback->Buffer);
+
+  if (aReadback->Size != aSize)
+  {
+    theContext->core15fwd->glBufferData (GL_PIXEL_PACK_BUFFER, aSize, NULL, GL_STREAM_READ);
+
+    aReadback->Size = aSize;
+  }
+
+  theFBO->BindReadBuffer (theContext);
+
+  // Copy is queued after rendering commands, glReadPixels returns immediately
+  glPixelStorei (GL_PACK_ALIGNMENT, 1);
+  glReadPixels (0, 0, aSizeX, aSizeY, GL_RGB, GL_UNSIGNED_BYTE, NULL);
+  glPixelStorei (GL_PACK_ALIGNMENT, 4);
+
+  theFBO->UnbindBuffer (theContext);
+
+  theContext->core15fwd->glBindBuffer (GL_PIXEL_PACK_BUFFER, 0);
+
+  aReadback->Fence  = theContext->core32->glFenceSync (GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+  aReadback->SizeX  = aSizeX;
+  aReadback->SizeY  = aSizeY;
+  aReadback->Target = aTask;
+  aReadback->IsBusy = true;
+
+  return true;
+}
+
+//=======================================================================
+//function : finishReadback
+//purpose  :
+//=======================================================================
+void ImageCapture::finishReadback (const Handle (OpenGl_Context)& theContext, Readback& theReadback)
+{
+  theContext->core32->glDeleteSync (theReadback.Fence);
+
+  theReadback.Fence  = NULL;
+  theReadback.IsBusy = false;
+
+  std::shared_ptr<Image_AlienPixMap> aPixMap (new Image_AlienPixMap);
+
+  if (!aPixMap->InitTrash (Image_PixMap::ImgRGB, theReadback.SizeX, theReadback.SizeY))
+  {
+    std::cout << "Error: Could not allocate image for capture " << theReadback.Target.FileName << std::endl;
+    return;
+  }
+
+  theContext->core15fwd->glBindBuffer (GL_PIXEL_PACK_BUFFER, theReadback.Buffer);
+
+  const Standard_Byte* aPixels = static_cast<const Standard_Byte*> (
+    theContext->core15fwd->glMapBuffer (GL_PIXEL_PACK_BUFFER, GL_READ_ONLY));
+
+  if (aPixels != NULL)
+  {
+    // Rows of FBO go from bottom to top
+    for (int aRow = 0; aRow < theReadback.SizeY; ++aRow)
+    {
+      memcpy (aPixMap->ChangeRow (theReadback.SizeY - 1 - aRow), aPixels + aRow * theReadback.SizeX * 3, theReadback.SizeX * 3);
+    }
+
+    theContext->core15fwd->glUnmapBuffer (GL_PIXEL_PACK_BUFFER);
+  }
+
+  theContext->core15fwd->glBindBuffer (GL_PIXEL_PACK_BUFFER, 0);
+
+  if (aPixels == NULL)
+  {
+    std::cout << "Error: Could not map pixel buffer for capture " << theReadback.Target.FileName << std::endl;
+    return;
+  }
+
+  ie::Checkpoint::GetInstance ()->Combine (*aPixMap);
+
+  addImage (aPixMap, theReadback.Target);
+}
+
+//=======================================================================
+//function : addImage
+//purpose  :
+//=======================================================================
+void ImageCapture::addImage (const std::shared_ptr<Image_AlienPixMap>& thePixMap, const Task& theTask)
+{
+  Image anImage;
+
+  anImage.PixMap = thePixMap;
+  anImage.Target = theTask;
+
+  {
+    std::lock_guard<std::mutex> aLock (myMutex);
+
+    myImages.push_back (anImage);
+
+    if (!myWorker.joinable ())
+    {
+      myWorker = std::thread (&ImageCapture::encodeImages, this);
+    }
+  }
+
+  myImageAdded.notify_one ();
+}
+
+//=======================================================================
+//function : encodeImages
+//purpose  :
+//=======================================================================
+void ImageCapture::encodeImages ()
+{
+  for (;;)
+  {
+    Image anImage;
+
+    {
+      std::unique_lock<std::mutex> aLock (myMutex);
+
+      myImageAdded.wait (aLock, [this] { return myToStop || !myImages.empty (); });
+
+      // Captured images are saved before exit
+      if (myImages.empty ())
+      {
+        return;
+      }
+
+      anImage = myImages.front ();
+
+      myImages.pop_front ();
+
+      ++myNbEncoding;
+    }
+
+    if (anImage.Target.Processing)
+    {
+      anImage.Target.Processing (*anImage.PixMap);
+    }
+
+    if (!anImage.PixMap->Save (anImage.Target.FileName.c_str ()))
+    {
+      std::cout << "Error: Could not save image " << anImage.Target.FileName << std::endl;
+    }
+
+    {
+      std::lock_guard<std::mutex> aLock (myMutex);
+
+      --myNbEncoding;
+    }
+
+    myImageSaved.notify_all ();
+  }
+}
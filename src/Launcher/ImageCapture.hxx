@@ -0,0 +1,177 @@
+// Created: 2019-07-10
+//
+// Copyright (c) 2019 OPEN CASCADE SAS
+//
+// This file is a part of CADRays software.
+//
+// CADRays is free software; you can use it under the terms of the MIT license,
+// refer to file LICENSE.txt for complete text of the license and disclaimer of
+// any warranty.
+
+#ifndef _ImageCapture_HeaderFile
+#define _ImageCapture_HeaderFile
+
+#include <OpenGl_Context.hxx>
+#include <OpenGl_FrameBuffer.hxx>
+#include <Image_AlienPixMap.hxx>
+
+#include <deque>
+#include <algorithm>
+#include <mutex>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <functional>
+#include <condition_variable>
+
+//! Asynchronous capture of rendered frames. Pixels are read back into pixel
+//! buffer objects guarded by fences, mapped a frame or two later (when the
+//! GPU has finished) and saved by the encoding thread, so neither the GPU
+//! pipeline nor the main loop is stalled. Captures can be requested once
+//! or continuously (each N samples of progressive rendering).
+class ImageCapture
+{
+public:
+
+  //! Processing of captured image (top-down RGB) done by the encoding thread before saving.
+  typedef std::function<void (Image_PixMap&)> Filter;
+
+public:
+
+  //! Creates new image capture.
+  ImageCapture ();
+
+  //! Saves already captured images and stops encoding thread.
+  ~ImageCapture ();
+
+  //! Requests capture of the next frame into the given file.
+  void Request (const std::string& theFileName, const Filter& theFilter = Filter());
+
+  //! Returns number of samples between continuous captures (0 if disabled).
+  int Interval () const { return myInterval; }
+
+  //! Sets number of samples between continuous captures (0 disables them).
+  void SetInterval (const int theNbSamples) { myInterval = std::max (theNbSamples, 0); }
+
+  //! Returns file name of continuous captures (number of samples is appended).
+  const std::string& FileName () const { return myFileName; }
+
+  //! Sets file name of continuous captures (number of samples is appended).
+  void SetFileName (const std::string& theFileName) { myFileName = theFileName; }
+
+  //! Returns file name of continuous capture for the given number of samples.
+  static std::string SampleFileName (const std::string& theFileName, const int theNbSamples);
+
+public:
+
+  //! Completes finished readbacks and starts requested ones. Should be called
+  //! each frame from the main thread (after redraw of the view).
+  void Update (const Handle (OpenGl_Context)& theContext,
+               const Handle (OpenGl_FrameBuffer)& theFBO,
+               const int theNbSamples);
+
+  //! Completes all requests and waits until captured images are saved.
+  void Flush (const Handle (OpenGl_Context)& theContext,
+              const Handle (OpenGl_FrameBuffer)& theFBO);
+
+  //! Releases OpenGL resources (pending readbacks are discarded).
+  void Release (const Handle (OpenGl_Context)& theContext);
+
+  //! Checks whether some capture is requested, read back or encoded.
+  bool IsBusy () const;
+
+protected:
+
+  //! Requested capture.
+  struct Task
+  {
+    std::string FileName;    //!< Output file (empty for continuous capture)
+    Filter      Processing;  //!< Processing of captured image
+  };
+
+  //! Readback into pixel buffer object.
+  struct Readback
+  {
+    Readback () : Buffer (0), Fence (NULL), Size (0), SizeX (0), SizeY (0), IsBusy (false)
+    {
+      //
+    }
+
+    GLuint Buffer;  //!< Pixel buffer object
+    GLsync Fence;   //!< Fence signaled once pixels are copied
+    size_t Size;    //!< Size of the buffer (in bytes)
+    int    SizeX;   //!< Width of image
+    int    SizeY;   //!< Height of image
+    bool   IsBusy;  //!< Set while waiting for the fence
+    Task   Target;  //!< Capture performed by readback
+  };
+
+  //! Captured image waiting for encoding.
+  struct Image
+  {
+    std::shared_ptr<Image_AlienPixMap> PixMap;
+    Task                               Target;
+  };
+
+protected:
+
+  //! Starts readback of the given task. Returns false if there is no free buffer.
+  bool startReadback (const Handle (OpenGl_Context)& theContext,
+                      const Handle (OpenGl_FrameBuffer)& theFBO,
+                      const Task& theTask);
+
+  //! Maps pixel buffer of finished readback and schedules encoding.
+  void finishReadback (const Handle (OpenGl_Context)& theContext, Readback& theReadback);
+
+  //! Adds captured image to encoding queue.
+  void addImage (const std::shared_ptr<Image_AlienPixMap>& thePixMap, const Task& theTask);
+
+  //! Saves captured images (encoding thread function).
+  void encodeImages ();
+
+protected:
+
+  //! Readbacks in flight.
+  std::vector<Readback> myReadbacks;
+
+  //! Requested captures.
+  std::deque<Task> myTasks;
+
+  //! Number of samples between continuous captures.
+  int myInterval;
+
+  //! File name of continuous captures.
+  std::string myFileName;
+
+  //! Number of samples of the next continuous capture.
+  int myNextSamples;
+
+  //! Number of samples of current frame.
+  int myNbSamples;
+
+protected:
+
+  //! Captured images waiting for encoding.
+  std::deque<Image> myImages;
+
+  //! Number of images being encoded.
+  int myNbEncoding;
+
+  //! Set to stop encoding thread.
+  bool myToStop;
+
+  //! Encoding thread (started on first capture).
+  std::thread myWorker;
+
+  //! Guards encoding queue.
+  mutable std::mutex myMutex;
+
+  //! Signaled when new image is added.
+  std::condition_variable myImageAdded;
+
+  //! Signaled when image is saved.
+  std::condition_variable myImageSaved;
+};
+
+#endif // _ImageCapture_HeaderFile
@@ -9,10 +9,14 @@
 // any warranty.
 
 #include <DBRep.hxx>
+#include <AIS_Shape.hxx>
 #include <OSD_Path.hxx>
 #include <OSD_File.hxx>
+#include <OSD_Timer.hxx>
+#include <ViewerTest.hxx>
 #include <TopoDS_Shape.hxx>
 
+#include <StepIO.hxx>
 #include <ImportSettingsEditor.hxx>
 
 //=======================================================================
@@ -22,7 +26,10 @@
 ImportSettingsEditor::ImportSettingsEditor () : myToGroupObjects (true),
                                                 myToGenSmoothNrm (false),
                                                 myToPreTransform (false),
-                                                myVerticalDirect (2)
+                                                myVerticalDirect (2),
+                                                myMeshDone (false),
+                                                myLoadTime (0.0),
+                                                myShowTime (0.0)
 {
   myToSetNameFocus = false;
 }
@@ -33,7 +40,10 @@ ImportSettingsEditor::ImportSettingsEditor () : myToGroupObjects (true),
 //=======================================================================
 ImportSettingsEditor::~ImportSettingsEditor ()
 {
-  //
+  if (myMeshThread.joinable ())
+  {
+    myMeshThread.join ();
+  }
 }
 
 //=======================================================================
@@ -143,9 +153,33 @@ void ImportSettingsEditor::ApplyTransform ()
     if (!aShape.IsNull ())
     {
       aShape.Location (aShape.Location ().Multiplied (TopLoc_Location (aRotation)));
+
+      setShapeFromName (myDrawName.ToCString (), aShape);
     }
+    else if (model::DataModel::GetDefault ()->Has (myDrawName))
+    {
+      // Assembly imported to data model: rotate its parts keeping shared geometry
+      struct PartRotator : public model::DataNode::NodeProcessor
+      {
+        TopLoc_Location Rotation;
+
+        virtual void operator() (const Handle (AIS_InteractiveObject)& theObject)
+        {
+          Handle (AIS_Shape) aPart = Handle (AIS_Shape)::DownCast (theObject);
 
-    setShapeFromName (myDrawName.ToCString (), aShape);
+          if (!aPart.IsNull ())
+          {
+            aPart->Set (aPart->Shape ().Moved (Rotation));
+          }
+        }
+      };
+
+      PartRotator aRotator;
+
+      aRotator.Rotation = TopLoc_Location (aRotation);
+
+      model::DataModel::GetDefault ()->Get (myDrawName)->Traverse (aRotator);
+    }
   }
 }
 
@@ -160,12 +194,146 @@ bool ImportSettingsEditor::CheckNameValid ()
   return !myToSetNameFocus;
 }
 
+//=======================================================================
+//function : DrawMeshSettings
+//purpose  : 
+//=======================================================================
+void ImportSettingsEditor::DrawMeshSettings ()
+{
+  bool toMeshInParallel = myMainGui->GetSettings ().GetBoolean ("import", "parallel_meshing", true);
+
+  if (ImGui::Checkbox ("Tessellate in parallel before display", &toMeshInParallel))
+  {
+    myMainGui->GetSettings ().SetBoolean ("import", "parallel_meshing", toMeshInParallel);
+  }
+
+  myMainGui->AddTooltip ("Mesh all faces using all CPU cores before the shape is displayed.\n"
+                         "Deflection is derived from the model size.");
+
+  bool toShowProgressive = myMainGui->GetSettings ().GetBoolean ("import", "progressive_display", false);
+
+  if (ImGui::Checkbox ("Display progressively", &toShowProgressive))
+  {
+    myMainGui->GetSettings ().SetBoolean ("import", "progressive_display", toShowProgressive);
+  }
+
+  myMainGui->AddTooltip ("Show bounding boxes of top-level parts immediately and replace\n"
+                         "them by shaded parts as they are tessellated in background.\n"
+                         "Larger parts on the screen are tessellated first.");
+}
+
+//=======================================================================
+//function : FinishImport
+//purpose  : 
+//=======================================================================
+void ImportSettingsEditor::FinishImport (const TCollection_AsciiString& theShowCommand)
+{
+  TopoDS_Shape aShape = getShapeFromName (myDrawName.ToCString ());
+
+  // Assembly imported to data model (no DRAW shape)
+  const bool isModelNode = aShape.IsNull () && model::DataModel::GetDefault ()->Has (myDrawName);
+
+  if (isModelNode)
+  {
+    // Each product is tessellated once for all its instances
+    aShape = ie::StepIO::UniqueShapes (model::DataModel::GetDefault ()->Get (myDrawName).get ());
+  }
+
+  Handle (AIS_InteractiveContext) aContext = ViewerTest::GetAISContext ();
+
+  if (myMainGui->GetSettings ().GetBoolean ("import", "progressive_display", false))
+  {
+    const TCollection_AsciiString aShowCommand = isModelNode ? TCollection_AsciiString ("rtdisplay ") + myDrawName + " -progressive\n" + "vfit"
+                                                             : TCollection_AsciiString ("rtprogressive ") + myDrawName + " -explode -noupdate\n" + "vfit";
+
+    myMainGui->ConsoleExec (aShowCommand.ToCString ());
+
+    ImGui::CloseCurrentPopup ();
+
+    return;
+  }
+
+  if (!myMainGui->GetSettings ().GetBoolean ("import", "parallel_meshing", true) || aShape.IsNull () || aContext.IsNull ())
+  {
+    myMainGui->ConsoleExec (theShowCommand.ToCString ());
+
+    ImGui::CloseCurrentPopup ();
+
+    return;
+  }
+
+  // Deflection is computed here, since it reads the shared drawer
+  myMesher.reset (new ie::ShapeMesher (aShape, aContext->DefaultDrawer ()));
+
+  myShowCommand = theShowCommand;
+
+  myMeshDone = false;
+
+  // Dialog stays open and shows progress while faces are meshed
+  myMeshThread = std::thread ([this]()
+  {
+    myMesher->Perform ();
+
+    myMeshDone = true;
+  });
+}
+
+//=======================================================================
+//function : DrawTessellation
+//purpose  : 
+//=======================================================================
+void ImportSettingsEditor::DrawTessellation ()
+{
+  ImGui::Text ("Loading: %.2f sec", myLoadTime);
+
+  if (!myMeshDone)
+  {
+    ImGui::Text ("Tessellating faces: %d of %d", myMesher->NbFacesDone (), myMesher->NbFaces ());
+
+    ImGui::ProgressBar (myMesher->NbFaces () > 0 ? myMesher->NbFacesDone () / static_cast<float> (myMesher->NbFaces ()) : 0.f, ImVec2 (300.f, 0.f));
+
+    return;
+  }
+
+  if (myMeshThread.joinable ()) // display the shape once
+  {
+    myMeshThread.join ();
+
+    OSD_Timer aTimer;
+
+    aTimer.Start ();
+
+    myMainGui->ConsoleExec (myShowCommand.ToCString ());
+
+    myShowTime = aTimer.ElapsedTime ();
+  }
+
+  ImGui::Text ("Tessellation: %.2f sec (%d faces, %d triangles)", myMesher->ElapsedTime (), myMesher->NbFaces (), myMesher->NbTriangles ());
+  ImGui::Text ("Display: %.2f sec", myShowTime);
+
+  ImGui::Text ("Deflection: %g (angular %.1f deg)", myMesher->LinearDeflection (), myMesher->AngularDeflection () * 180.0 / M_PI);
+
+  if (ImGui::Button ("OK", ImVec2 (ImGui::GetContentRegionAvailWidth (), 0)))
+  {
+    myMesher.reset ();
+
+    ImGui::CloseCurrentPopup ();
+  }
+}
+
 //=======================================================================
 //function : Draw
 //purpose  : 
 //=======================================================================
 void ImportSettingsEditor::Draw (const char* /*theTitle*/)
 {
+  if (myMesher)
+  {
+    DrawTessellation ();
+
+    return;
+  }
+
   TCollection_AsciiString aFileExt = OSD_Path (myFileName).Extension ();
 
   aFileExt.UpperCase (); // convert extension to lower case
@@ -287,21 +455,51 @@ void ImportSettingsEditor::Draw (const char* /*theTitle*/)
   {
     const TCollection_AsciiString aShowCommand = TCollection_AsciiString ("vdisplay ") + myDrawName + " -noupdate\n" + "vfit";
 
-    if (aFileExt == ".BREP")
+    if (aFileExt == ".BREP" || aFileExt == ".BBREP")
     {
       DrawTransform ();
 
+      DrawMeshSettings ();
+
       if (ImGui::Button ("Import", ImVec2 (ImGui::GetContentRegionAvailWidth () / 2 - ImGui::GetStyle ().ItemSpacing.x / 2, 0)))
       {
         if (CheckNameValid ())
         {
-          const TCollection_AsciiString aLoadCommand = TCollection_AsciiString ("restore") + " \"" + myFileName + "\" " + myDrawName;
+          // Handles both binary (compressed) and ASCII BREP files
+          const TCollection_AsciiString aLoadCommand = TCollection_AsciiString ("rtrestore") + " \"" + myFileName + "\" " + myDrawName;
+
+          OSD_Timer aTimer;
+
+          aTimer.Start ();
 
           myMainGui->ConsoleExec (aLoadCommand.ToCString ());
 
           ApplyTransform (); // apply rotation to shape location
 
-          myMainGui->ConsoleExec (aShowCommand.ToCString ());
+          myLoadTime = aTimer.ElapsedTime ();
+
+          FinishImport (aShowCommand);
+        }
+      }
+
+      ImGui::SameLine ();
+
+      if (ImGui::Button ("Cancel", ImVec2 (ImGui::GetContentRegionAvailWidth (), 0)))
+      {
+        ImGui::CloseCurrentPopup ();
+      }
+    }
+    else if (aFileExt == ".GLB")
+    {
+      if (ImGui::Button ("Import", ImVec2 (ImGui::GetContentRegionAvailWidth () / 2 - ImGui::GetStyle ().ItemSpacing.x / 2, 0)))
+      {
+        if (CheckNameValid ())
+        {
+          // Native GLB reader (much faster than ASSIMP on large meshes)
+          const TCollection_AsciiString aLoadCommand = TCollection_AsciiString ("rtgltfread") + " \"" + myFileName + "\" " + myDrawName;
+
+          myMainGui->ConsoleExec (aLoadCommand.ToCString ());
+          myMainGui->ConsoleExec ((TCollection_AsciiString ("rtdisplay ") + myDrawName + "\n" + "vfit").ToCString ());
 
           ImGui::CloseCurrentPopup ();
         }
@@ -318,19 +516,27 @@ void ImportSettingsEditor::Draw (const char* /*theTitle*/)
     {
       DrawTransform ();
 
+      DrawMeshSettings ();
+
       if (ImGui::Button ("Import", ImVec2 (ImGui::GetContentRegionAvailWidth () / 2 - ImGui::GetStyle ().ItemSpacing.x / 2, 0)))
       {
         if (CheckNameValid ())
         {
-          const TCollection_AsciiString aLoadCommand = TCollection_AsciiString ("testreadstep") + " \"" + myFileName + "\" " + myDrawName;
+          // Keeps assembly structure, names and colors (product instances share geometry)
+          const TCollection_AsciiString aLoadCommand = TCollection_AsciiString ("rtstepread") + " \"" + myFileName + "\" " + myDrawName;
+
+          OSD_Timer aTimer;
+
+          aTimer.Start ();
 
           myMainGui->ConsoleExec (aLoadCommand.ToCString ());
 
-          ApplyTransform (); // apply rotation to shape location
+          ApplyTransform (); // apply rotation to part locations
 
-          myMainGui->ConsoleExec (aShowCommand.ToCString ());
+          myLoadTime = aTimer.ElapsedTime ();
 
-          ImGui::CloseCurrentPopup ();
+          // Triangulation computed on import is kept in the cache entry
+          FinishImport (TCollection_AsciiString ("rtdisplay ") + myDrawName + "\n" + "vfit\n" + "rtcache -update " + myDrawName);
         }
       }
 
@@ -345,19 +551,25 @@ void ImportSettingsEditor::Draw (const char* /*theTitle*/)
     {
       DrawTransform ();
 
+      DrawMeshSettings ();
+
       if (ImGui::Button ("Import", ImVec2 (ImGui::GetContentRegionAvailWidth () / 2 - ImGui::GetStyle ().ItemSpacing.x / 2, 0)))
       {
         if (CheckNameValid ())
         {
           const TCollection_AsciiString aLoadCommand = TCollection_AsciiString ("testreadiges") + " \"" + myFileName + "\" " + myDrawName;
 
+          OSD_Timer aTimer;
+
+          aTimer.Start ();
+
           myMainGui->ConsoleExec (aLoadCommand.ToCString ());
 
           ApplyTransform (); // apply rotation to shape location
 
-          myMainGui->ConsoleExec (aShowCommand.ToCString ());
+          myLoadTime = aTimer.ElapsedTime ();
 
-          ImGui::CloseCurrentPopup ();
+          FinishImport (aShowCommand);
         }
       }
 
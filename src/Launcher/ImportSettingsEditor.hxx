@@ -13,6 +13,11 @@
 
 #include <imgui.h>
 #include <GuiPanel.hxx>
+#include <ShapeMesher.hxx>
+
+#include <atomic>
+#include <memory>
+#include <thread>
 
 //! Editor of import settings.
 class ImportSettingsEditor: public GuiPanel
@@ -38,12 +43,21 @@ private:
   //! Draws transform setting group.
   void DrawTransform ();
 
+  //! Draws tessellation setting group.
+  void DrawMeshSettings ();
+
   //! Sends transform command to TCL console.
   void ApplyTransform ();
 
   //! Checks correctness of DRAW object name.
   bool CheckNameValid ();
 
+  //! Tessellates loaded CAD shape (in background) and displays it.
+  void FinishImport (const TCollection_AsciiString& theShowCommand);
+
+  //! Draws progress and timings of shape tessellation.
+  void DrawTessellation ();
+
 private:
 
   //! Full path to importing file.
@@ -63,6 +77,26 @@ private:
   //! If TRUE focus should be set to name text edit.
   bool myToSetNameFocus;
 
+private:
+
+  //! Tool to tessellate loaded CAD shape.
+  std::unique_ptr<ie::ShapeMesher> myMesher;
+
+  //! Thread performing tessellation.
+  std::thread myMeshThread;
+
+  //! Set when tessellation is finished.
+  std::atomic<bool> myMeshDone;
+
+  //! Command to display the shape after tessellation.
+  TCollection_AsciiString myShowCommand;
+
+  //! Time of loading CAD file (in seconds).
+  double myLoadTime;
+
+  //! Time of displaying tessellated shape (in seconds).
+  double myShowTime;
+
 };
 
 #endif // _ImportSettingsEditor_HeaderFile
@@ -0,0 +1,595 @@
+// Created: 2019-07-01
+//
+// Copyright (c) 2019 OPEN CASCADE SAS
+//
+// This file is a part of CADRays software.
+//
+// CADRays is free software; you can use it under the terms of the MIT license,
+// refer to file LICENSE.txt for complete text of the license and disclaimer of
+// any warranty.
+
+#include "JobRunner.hxx"
+#include "AppViewer.hxx"
+#include "TileWriter.hxx"
+
+#include <Convergence.hxx>
+
+#include <Draw_Interpretor.hxx>
+#include <Graphic3d_Camera.hxx>
+#include <OSD_Timer.hxx>
+#include <ViewerTest.hxx>
+#include <V3d_View.hxx>
+#include <TCollection_AsciiString.hxx>
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <thread>
+
+namespace
+{
+  //=======================================================================
+  //function : isAbsolutePath
+  //purpose  :
+  //=======================================================================
+  bool isAbsolutePath (const std::string& thePath)
+  {
+    return (!thePath.empty () && (thePath[0] == '/' || thePath[0] == '\\'))
+        || (thePath.size () > 1 && thePath[1] == ':');
+  }
+
+  //=======================================================================
+  //function : isScript
+  //purpose  :
+  //=======================================================================
+  bool isScript (const std::string& thePath)
+  {
+    return thePath.size () > 4 && thePath.compare (thePath.size () - 4, 4, ".tcl") == 0;
+  }
+
+  //=======================================================================
+  //function : jsonString
+  //purpose  :
+  //=======================================================================
+  std::string jsonString (const std::string& theString)
+  {
+    std::string aResult ("\"");
+
+    for (size_t aCharIdx = 0; aCharIdx < theString.size (); ++aCharIdx)
+    {
+      const char aChar = theString[aCharIdx];
+
+      if (aChar == '"' || aChar == '\\')
+      {
+        aResult += '\\';
+        aResult += aChar;
+      }
+      else if (aChar == '\n')
+      {
+        aResult += "\\n";
+      }
+      else if (aChar == '\r')
+      {
+        aResult += "\\r";
+      }
+      else if (aChar == '\t')
+      {
+        aResult += "\\t";
+      }
+      else if (static_cast<unsigned char> (aChar) < 0x20)
+      {
+        char aCode[8];
+
+        sprintf (aCode, "\\u%04x", static_cast<unsigned> (aChar));
+
+        aResult += aCode;
+      }
+      else
+      {
+        aResult += aChar;
+      }
+    }
+
+    return aResult + "\"";
+  }
+
+  //=======================================================================
+  //function : writeJob
+  //purpose  : Writes fields describing the job (without braces)
+  //=======================================================================
+  void writeJob (std::ostream& theStream, const int theIndex, const JobRunner::Job& theJob)
+  {
+    theStream << "\"index\": "   << theIndex                   << ", "
+              << "\"scene\": "   << jsonString (theJob.Scene)  << ", "
+              << "\"camera\": "  << jsonString (theJob.Camera) << ", "
+              << "\"width\": "   << theJob.SizeX               << ", "
+              << "\"height\": "  << theJob.SizeY               << ", "
+              << "\"output\": "  << jsonString (theJob.Output);
+  }
+
+  //=======================================================================
+  //function : splitLine
+  //purpose  : Splits manifest line into tokens (double quotes group spaces)
+  //=======================================================================
+  std::vector<std::string> splitLine (const std::string& theLine)
+  {
+    std::vector<std::string> aTokens;
+
+    std::string aToken;
+
+    bool isQuoted = false;
+
+    for (size_t aCharIdx = 0; aCharIdx < theLine.size (); ++aCharIdx)
+    {
+      const char aChar = theLine[aCharIdx];
+
+      if (aChar == '"')
+      {
+        isQuoted = !isQuoted;
+      }
+      else if (!isQuoted && aChar == '#')
+      {
+        break;
+      }
+      else if (!isQuoted && isspace (static_cast<unsigned char> (aChar)))
+      {
+        if (!aToken.empty ())
+        {
+          aTokens.push_back (aToken);
+        }
+
+        aToken.clear ();
+      }
+      else
+      {
+        aToken += aChar;
+      }
+    }
+
+    if (!aToken.empty ())
+    {
+      aTokens.push_back (aToken);
+    }
+
+    return aTokens;
+  }
+}
+
+//=======================================================================
+//function : JobRunner
+//purpose  :
+//=======================================================================
+JobRunner::JobRunner (const std::string& theExecutable, const std::string& theDataDir)
+  : myExecutable (theExecutable),
+    myDataDir (theDataDir)
+{
+  //
+}
+
+//=======================================================================
+//function : ReadManifest
+//purpose  :
+//=======================================================================
+bool JobRunner::ReadManifest (const std::string& theFileName)
+{
+  std::ifstream aFile (theFileName.c_str ());
+
+  if (!aFile.is_open ())
+  {
+    std::cout << "Error: cannot open job manifest " << theFileName << std::endl;
+    return false;
+  }
+
+  myManifest = theFileName;
+
+  myJobs.clear ();
+
+  const size_t aSlashPos = theFileName.find_last_of ("/\\");
+
+  const std::string aBaseDir = aSlashPos != std::string::npos ? theFileName.substr (0, aSlashPos + 1) : "";
+
+  std::string aLine;
+
+  for (int aLineIdx = 1; std::getline (aFile, aLine); ++aLineIdx)
+  {
+    const std::vector<std::string> aTokens = splitLine (aLine);
+
+    if (aTokens.empty ())
+    {
+      continue;
+    }
+
+    Job aJob;
+
+    for (size_t aTokenIdx = 0; aTokenIdx < aTokens.size (); ++aTokenIdx)
+    {
+      const size_t aSplitPos = aTokens[aTokenIdx].find ('=');
+
+      const std::string aKey = aTokens[aTokenIdx].substr (0, aSplitPos);
+      const std::string aVal = aSplitPos != std::string::npos ? aTokens[aTokenIdx].substr (aSplitPos + 1) : "";
+
+      const TCollection_AsciiString aNumber (aVal.c_str ());
+
+      bool isValid = !aVal.empty ();
+
+      if (aKey == "scene")
+      {
+        aJob.Scene = isAbsolutePath (aVal) ? aVal : aBaseDir + aVal;
+      }
+      else if (aKey == "camera")
+      {
+        aJob.Camera = isScript (aVal) && !isAbsolutePath (aVal) ? aBaseDir + aVal : aVal;
+      }
+      else if (aKey == "out")
+      {
+        aJob.Output = isAbsolutePath (aVal) ? aVal : aBaseDir + aVal;
+      }
+      else if (aKey == "size")
+      {
+        isValid = sscanf (aVal.c_str (), "%dx%d", &aJob.SizeX, &aJob.SizeY) == 2 && aJob.SizeX > 0 && aJob.SizeY > 0;
+      }
+      else if (aKey == "frames")
+      {
+        isValid = aNumber.IsIntegerValue () && (aJob.Frames = aNumber.IntegerValue ()) > 0;
+      }
+      else if (aKey == "time")
+      {
+        isValid = aNumber.IsRealValue () && (aJob.Time = aNumber.RealValue ()) > 0.0;
+      }
+      else if (aKey == "noise")
+      {
+        isValid = aNumber.IsRealValue () && (aJob.Noise = aNumber.RealValue ()) > 0.0;
+      }
+      else if (aKey == "tile")
+      {
+        isValid = aNumber.IsIntegerValue () && (aJob.Tile = aNumber.IntegerValue ()) > 0;
+      }
+      else
+      {
+        isValid = false;
+      }
+
+      if (!isValid)
+      {
+        std::cout << "Error: invalid parameter '" << aTokens[aTokenIdx] << "' at line " << aLineIdx << " of job manifest" << std::endl;
+        return false;
+      }
+    }
+
+    if (aJob.Scene.empty () || aJob.Output.empty ())
+    {
+      std::cout << "Error: scene or output is not specified at line " << aLineIdx << " of job manifest" << std::endl;
+      return false;
+    }
+
+    // Tiles are streamed to uncompressed image
+    if (aJob.Tile > 0)
+    {
+      aJob.Output = TileWriter::FileName (aJob.Output);
+    }
+
+    if (aJob.Frames == 0 && aJob.Time == 0.0 && aJob.Noise == 0.0)
+    {
+      aJob.Frames = 1;
+    }
+
+    myJobs.push_back (aJob);
+  }
+
+  return true;
+}
+
+//=======================================================================
+//function : schedule
+//purpose  :
+//=======================================================================
+std::vector<std::vector<int> > JobRunner::schedule (const int theNbWorkers) const
+{
+  std::vector<std::vector<int> > aGroups;
+
+  std::map<std::string, size_t> aSceneGroups;
+
+  for (int aJobIdx = 0; aJobIdx < static_cast<int> (myJobs.size ()); ++aJobIdx)
+  {
+    auto anIter = aSceneGroups.find (myJobs[aJobIdx].Scene);
+
+    if (anIter == aSceneGroups.end ())
+    {
+      anIter = aSceneGroups.insert (std::make_pair (myJobs[aJobIdx].Scene, aGroups.size ())).first;
+
+      aGroups.push_back (std::vector<int> ());
+    }
+
+    aGroups[anIter->second].push_back (aJobIdx);
+  }
+
+  auto aBySize = [] (const std::vector<int>& theLeft, const std::vector<int>& theRight)
+  {
+    return theLeft.size () > theRight.size ();
+  };
+
+  // Scene is loaded by several workers only if there are idle workers
+  while (static_cast<int> (aGroups.size ()) < theNbWorkers)
+  {
+    std::sort (aGroups.begin (), aGroups.end (), aBySize);
+
+    if (aGroups.empty () || aGroups.front ().size () < 2)
+    {
+      break;
+    }
+
+    const size_t aHalf = aGroups.front ().size () / 2;
+
+    aGroups.push_back (std::vector<int> (aGroups.front ().begin () + aHalf, aGroups.front ().end ()));
+
+    aGroups.front ().resize (aHalf);
+  }
+
+  std::sort (aGroups.begin (), aGroups.end (), aBySize);
+
+  // Largest groups first, each one to the least loaded worker
+  std::vector<std::vector<int> > aWorkers (std::min (static_cast<int> (aGroups.size ()), theNbWorkers));
+
+  for (size_t aGroupIdx = 0; aGroupIdx < aGroups.size (); ++aGroupIdx)
+  {
+    std::vector<int>& aWorker = *std::min_element (aWorkers.begin (), aWorkers.end (),
+      [] (const std::vector<int>& theLeft, const std::vector<int>& theRight) { return theLeft.size () < theRight.size (); });
+
+    aWorker.insert (aWorker.end (), aGroups[aGroupIdx].begin (), aGroups[aGroupIdx].end ());
+  }
+
+  return aWorkers;
+}
+
+//=======================================================================
+//function : Run
+//purpose  :
+//=======================================================================
+int JobRunner::Run (const int theNbWorkers, const std::string& theReportFile)
+{
+  const std::vector<std::vector<int> > aWorkers = schedule (std::max (theNbWorkers, 1));
+
+  std::cout << "Running " << myJobs.size () << " jobs in " << aWorkers.size () << " worker processes" << std::endl;
+
+  OSD_Timer aTimer;
+
+  aTimer.Start ();
+
+  std::vector<std::thread> aThreads;
+
+  std::vector<int> aStatuses (aWorkers.size (), 0);
+
+  for (size_t aWorkerIdx = 0; aWorkerIdx < aWorkers.size (); ++aWorkerIdx)
+  {
+    std::stringstream aJobList;
+
+    for (size_t aJobIdx = 0; aJobIdx < aWorkers[aWorkerIdx].size (); ++aJobIdx)
+    {
+      aJobList << (aJobIdx > 0 ? "," : "") << aWorkers[aWorkerIdx][aJobIdx];
+    }
+
+    const std::string aPrefix = theReportFile + "." + std::to_string (aWorkerIdx);
+
+    std::remove ((aPrefix + ".jobs").c_str ());
+
+    std::string aCommand = "\"" + myExecutable + "\" --worker \"" + myManifest + "\" \"" + aPrefix + ".jobs\" "
+                         + aJobList.str () + " > \"" + aPrefix + ".log\" 2>&1";
+#ifdef _WIN32
+    aCommand = "\"" + aCommand + "\""; // cmd.exe strips outer quotes
+#endif
+
+    // Each thread waits for its own worker process
+    aThreads.push_back (std::thread ([aCommand, aWorkerIdx, &aStatuses] ()
+    {
+      aStatuses[aWorkerIdx] = system (aCommand.c_str ());
+    }));
+  }
+
+  for (size_t aWorkerIdx = 0; aWorkerIdx < aThreads.size (); ++aWorkerIdx)
+  {
+    aThreads[aWorkerIdx].join ();
+  }
+
+  const double aWallTime = aTimer.ElapsedTime ();
+
+  // Collect results written by workers
+  std::vector<std::string> aResults (myJobs.size ());
+
+  int aNbFailed = 0;
+
+  for (size_t aWorkerIdx = 0; aWorkerIdx < aWorkers.size (); ++aWorkerIdx)
+  {
+    const std::string aPrefix = theReportFile + "." + std::to_string (aWorkerIdx);
+
+    std::ifstream aFile ((aPrefix + ".jobs").c_str ());
+
+    std::string aLine;
+
+    while (std::getline (aFile, aLine))
+    {
+      int anIndex = -1;
+
+      if (sscanf (aLine.c_str (), "{\"index\": %d", &anIndex) == 1 && anIndex >= 0 && anIndex < static_cast<int> (aResults.size ()))
+      {
+        aResults[anIndex] = "{\"worker\": " + std::to_string (aWorkerIdx) + ", " + aLine.substr (1);
+      }
+    }
+
+    aFile.close ();
+
+    std::remove ((aPrefix + ".jobs").c_str ());
+
+    for (size_t aJobIdx = 0; aJobIdx < aWorkers[aWorkerIdx].size (); ++aJobIdx)
+    {
+      const int anIndex = aWorkers[aWorkerIdx][aJobIdx];
+
+      if (aResults[anIndex].empty ())
+      {
+        std::stringstream aStream;
+
+        aStream << "{\"worker\": " << aWorkerIdx << ", ";
+
+        writeJob (aStream, anIndex, myJobs[anIndex]);
+
+        aStream << ", \"status\": \"crashed\", \"exit_code\": " << aStatuses[aWorkerIdx] << "}";
+
+        aResults[anIndex] = aStream.str ();
+      }
+
+      if (aResults[anIndex].find ("\"status\": \"ok\"") == std::string::npos)
+      {
+        ++aNbFailed;
+      }
+    }
+  }
+
+  std::ofstream aReport (theReportFile.c_str ());
+
+  aReport << "{\n"
+          << "  \"manifest\": " << jsonString (myManifest) << ",\n"
+          << "  \"workers\": "  << aWorkers.size ()        << ",\n"
+          << "  \"wall_time\": " << aWallTime              << ",\n"
+          << "  \"failed\": "   << aNbFailed               << ",\n"
+          << "  \"jobs\": [\n";
+
+  for (size_t aJobIdx = 0; aJobIdx < aResults.size (); ++aJobIdx)
+  {
+    aReport << "    " << aResults[aJobIdx] << (aJobIdx + 1 < aResults.size () ? ",\n" : "\n");
+  }
+
+  aReport << "  ]\n}\n";
+
+  std::cout << "Finished " << myJobs.size () << " jobs (" << aNbFailed << " failed) in " << aWallTime << " sec, report: " << theReportFile << std::endl;
+
+  return aNbFailed;
+}
+
+//=======================================================================
+//function : RunWorker
+//purpose  :
+//=======================================================================
+int JobRunner::RunWorker (Draw_Interpretor& theDI, const std::vector<int>& theJobs, const std::string& theResultFile)
+{
+  std::ofstream aResult (theResultFile.c_str (), std::ios::app);
+
+  if (!aResult.is_open () || theJobs.empty ())
+  {
+    return static_cast<int> (theJobs.size ());
+  }
+
+  AppViewer aViewer ("CADRays", myDataDir, myJobs[theJobs.front ()].SizeX, myJobs[theJobs.front ()].SizeY, true);
+
+  aViewer.InitHeadless (theDI);
+
+  int aNbFailed = 0;
+
+  std::string aScene;
+
+  // View state set by the scene script (restored before each job,
+  // as camera and render parameters of the job are applied on top)
+  Handle (Graphic3d_Camera) aSceneCamera = new Graphic3d_Camera;
+
+  Graphic3d_RenderingParams aSceneParams;
+
+  for (size_t aJobIdx = 0; aJobIdx < theJobs.size (); ++aJobIdx)
+  {
+    const Job& aJob = myJobs[theJobs[aJobIdx]];
+
+    OSD_Timer aTimer;
+
+    aTimer.Start ();
+
+    bool isDone = true;
+
+    // Scene is reused by subsequent jobs
+    if (aJob.Scene != aScene)
+    {
+      if (!aScene.empty ())
+      {
+        theDI.Eval ("vclear");
+        theDI.Eval ("rtmodel -sync default");
+      }
+
+      aScene = aJob.Scene;
+
+      if (theDI.Eval (("source {" + aJob.Scene + "}").c_str ()) != 0)
+      {
+        std::cout << "Error: failed to load scene " << aJob.Scene << ": " << theDI.Result () << std::endl;
+
+        aScene.clear ();
+
+        isDone = false;
+      }
+      else if (!ViewerTest::CurrentView ().IsNull ())
+      {
+        aSceneCamera->Copy (ViewerTest::CurrentView ()->Camera ());
+
+        aSceneParams = ViewerTest::CurrentView ()->RenderingParams ();
+      }
+    }
+    else if (!ViewerTest::CurrentView ().IsNull ())
+    {
+      ViewerTest::CurrentView ()->Camera ()->Copy (aSceneCamera);
+
+      ViewerTest::CurrentView ()->ChangeRenderingParams () = aSceneParams;
+    }
+
+    const double aLoadTime = aTimer.ElapsedTime ();
+
+    if (isDone && !aJob.Camera.empty ())
+    {
+      isDone = theDI.Eval ((isScript (aJob.Camera) ? "source {" + aJob.Camera + "}" : aJob.Camera).c_str ()) == 0;
+    }
+
+    if (isDone)
+    {
+      aViewer.SetRTSize (ImVec2 (static_cast<float> (aJob.SizeX), static_cast<float> (aJob.SizeY)));
+
+      ie::Convergence::GetInstance ()->SetMaxNoise (aJob.Noise);
+
+      if (aJob.Tile > 0)
+      {
+        isDone = aViewer.RenderHeadlessTiled (aJob.Output, aJob.Tile, aJob.Frames, aJob.Time);
+      }
+      else
+      {
+        isDone = aViewer.RenderHeadless (aJob.Frames, aJob.Time)
+              && aViewer.GetTestingImage ().Save (aJob.Output.c_str ());
+      }
+    }
+
+    if (!isDone)
+    {
+      ++aNbFailed;
+    }
+
+    aResult << "{";
+
+    writeJob (aResult, theJobs[aJobIdx], aJob);
+
+    aResult << ", \"status\": "    << (isDone ? "\"ok\"" : "\"failed\"")
+            << ", \"load_time\": " << aLoadTime;
+
+    if (isDone)
+    {
+      aResult << ", \"frames\": "      << aViewer.GetFramesCount ()
+              << ", \"first_frame\": " << aViewer.GetFirstFrameTime ()
+              << ", \"render_time\": " << aViewer.GetRenderTime ()
+              << ", \"fps\": "         << aViewer.GetAverageFramerate ()
+              << ", \"converged\": "   << (aViewer.IsTestingConverged () ? "true" : "false");
+    }
+
+    aResult << ", \"total_time\": " << aTimer.ElapsedTime () << "}" << std::endl;
+
+    std::cout << "Job " << theJobs[aJobIdx] << (isDone ? " done: " : " failed: ") << aJob.Output << std::endl;
+  }
+
+  aViewer.ReleaseHeadless ();
+  aViewer.ReleaseTestingData ();
+
+  return aNbFailed;
+}
@@ -0,0 +1,100 @@
+// Created: 2019-07-01
+//
+// Copyright (c) 2019 OPEN CASCADE SAS
+//
+// This file is a part of CADRays software.
+//
+// CADRays is free software; you can use it under the terms of the MIT license,
+// refer to file LICENSE.txt for complete text of the license and disclaimer of
+// any warranty.
+
+#ifndef _JobRunner_HeaderFile
+#define _JobRunner_HeaderFile
+
+#include <string>
+#include <vector>
+
+class Draw_Interpretor;
+
+//! Batch renderer of jobs listed in manifest file. Each line of the manifest
+//! describes one job as a set of key=value pairs (relative paths are resolved
+//! against manifest directory, '#' starts a comment):
+//!
+//!   scene=cars.tcl camera=front.tcl size=1920x1080 frames=500 out=cars_front.png
+//!   scene=cars.tcl camera="vviewparams -scale 2" time=30 noise=0.01 out=cars_zoom.png
+//!   scene=cars.tcl size=16384x8192 tile=2048 frames=500 out=cars_print.ppm
+//!
+//! Jobs are distributed across worker processes running headless viewers.
+//! Jobs of the same scene are assigned to the same worker (if possible), so
+//! the scene is loaded only once. Timings and outputs of all jobs are written
+//! to JSON report.
+class JobRunner
+{
+public:
+
+  //! Rendering job.
+  struct Job
+  {
+    std::string Scene;  //!< Tcl script creating the scene
+    std::string Camera; //!< Tcl script or command setting the camera (optional)
+    std::string Output; //!< Output image file
+    int         SizeX;  //!< Width of output image
+    int         SizeY;  //!< Height of output image
+    int         Frames; //!< Number of frames to accumulate (0 if not limited)
+    double      Time;   //!< Time budget in seconds (0 if not limited)
+    double      Noise;  //!< Target noise level (0 if not used)
+    int         Tile;   //!< Size of tiles (0 if image is rendered at once)
+
+    Job()
+      : SizeX (1920),
+        SizeY (1080),
+        Frames (0),
+        Time (0.0),
+        Noise (0.0),
+        Tile (0)
+    {
+      //
+    }
+  };
+
+public:
+
+  //! Creates job runner using the given executable for worker processes.
+  JobRunner (const std::string& theExecutable, const std::string& theDataDir);
+
+  //! Reads jobs from the manifest file. Returns false on error.
+  bool ReadManifest (const std::string& theFileName);
+
+  //! Returns list of jobs.
+  const std::vector<Job>& Jobs() const { return myJobs; }
+
+  //! Runs all jobs in the given number of worker processes and writes JSON report.
+  //! Returns number of failed jobs.
+  int Run (const int theNbWorkers, const std::string& theReportFile);
+
+  //! Runs jobs with the given indices in current process and appends result of
+  //! each job (as JSON object) to the given file. Returns number of failed jobs.
+  int RunWorker (Draw_Interpretor& theDI, const std::vector<int>& theJobs, const std::string& theResultFile);
+
+protected:
+
+  //! Splits jobs into the given number of groups (jobs of the same scene
+  //! stay together unless there are fewer scenes than workers).
+  std::vector<std::vector<int> > schedule (const int theNbWorkers) const;
+
+private:
+
+  //! Executable to run workers.
+  std::string myExecutable;
+
+  //! Data directory of the application.
+  std::string myDataDir;
+
+  //! Manifest file.
+  std::string myManifest;
+
+  //! Jobs read from the manifest.
+  std::vector<Job> myJobs;
+};
+
+#endif // _JobRunner_HeaderFile
@@ -221,6 +221,7 @@ void LightSourcesEditor::Draw (const char* theTitle)
         bool aHeadLight = aCurrentLight->Headlight() != 0;
         aCurrentLight->SetHeadlight (!aHeadLight);
         myMainGui->View()->Viewer()->UpdateLights();
+        myMainGui->GetAppViewer()->RestartRendering();
       }
 
       ImGui::PopItemWidth();
@@ -236,6 +237,7 @@ void LightSourcesEditor::Draw (const char* theTitle)
           aColor.SetValues (aLightColor[0], aLightColor[1], aLightColor[2], Quantity_TOC_RGB);
           aCurrentLight->SetColor (aColor);
           myMainGui->View()->Viewer()->UpdateLights();
+          myMainGui->GetAppViewer()->RestartRendering();
         }
         myMainGui->AddTooltip ("Spectrum of emitted radiance");
 
@@ -248,6 +250,7 @@ void LightSourcesEditor::Draw (const char* theTitle)
           {
             aCurrentLight->SetIntensity (std::max (1e-3f, aLightPower));
             myMainGui->View()->Viewer()->UpdateLights();
+            myMainGui->GetAppViewer()->RestartRendering();
           }
           myMainGui->AddTooltip ("Scale factor of emitted radiance");
 
@@ -256,6 +259,7 @@ void LightSourcesEditor::Draw (const char* theTitle)
           {
             aLightDirectional->SetSmoothAngle (clamp (aLightAngle * 0.5f, 1e-3f, (float)M_PI * 0.5f));
             myMainGui->View()->Viewer()->UpdateLights();
+            myMainGui->GetAppViewer()->RestartRendering();
           }
           myMainGui->AddTooltip ("Solid angle in which the source emits light");
 
@@ -271,6 +275,7 @@ void LightSourcesEditor::Draw (const char* theTitle)
                                      clamp (anAngles.y(), 0.f + 1e-6f, (float)M_PI - 1e-6f));
             aLightDirectional->SetDirection (aDir.x(), aDir.y(), aDir.z());
             myMainGui->View()->Viewer()->UpdateLights();
+            myMainGui->GetAppViewer()->RestartRendering();
           }
 
           myMainGui->AddTooltip ("Direction of light encoded with angles");
@@ -284,6 +289,7 @@ void LightSourcesEditor::Draw (const char* theTitle)
           {
             aCurrentLight->SetIntensity (std::max (1e-3f, aLightPower));
             myMainGui->View()->Viewer()->UpdateLights();
+            myMainGui->GetAppViewer()->RestartRendering();
           }
           myMainGui->AddTooltip ("Scale factor of emitted radiance");
 
@@ -294,6 +300,7 @@ void LightSourcesEditor::Draw (const char* theTitle)
             {
               aLightPositional->SetSmoothRadius (std::max (0.f, aLightRadius));
               myMainGui->View()->Viewer()->UpdateLights();
+              myMainGui->GetAppViewer()->RestartRendering();
             }
             myMainGui->AddTooltip ("Radius of spherical light source");
 
@@ -304,6 +311,7 @@ void LightSourcesEditor::Draw (const char* theTitle)
             {
               aLightPositional->SetPosition (aLightPos[0], aLightPos[1], aLightPos[2]);
               myMainGui->View()->Viewer()->UpdateLights();
+              myMainGui->GetAppViewer()->RestartRendering();
             }
             myMainGui->AddTooltip ("Position of the light source");
           }
@@ -337,6 +345,7 @@ void LightSourcesEditor::Draw (const char* theTitle)
       if (aPressedButton == 2)
       {
         myMainGui->View()->SetTextureEnv (Handle(Graphic3d_TextureEnv) ());
+        myMainGui->GetAppViewer()->RestartRendering();
       }
 
       ImGui::PopItemWidth();
@@ -352,6 +361,7 @@ void LightSourcesEditor::Draw (const char* theTitle)
         {
           Handle(Graphic3d_TextureEnv) aTexEnv = new Graphic3d_TextureEnv (aFileName);
           myMainGui->View()->SetTextureEnv (aTexEnv);
+          myMainGui->GetAppViewer()->RestartRendering();
         }
       }
       myMainGui->AddTooltip ("Change environment map file");
@@ -361,6 +371,7 @@ void LightSourcesEditor::Draw (const char* theTitle)
       if (ImGui::Checkbox ("Show as background", &toShowAsBackground))
       {
         aParams.UseEnvironmentMapBackground = toShowAsBackground;
+        myMainGui->GetAppViewer()->RestartRendering();
       }
       myMainGui->AddTooltip ("Show environment map as background in viewer");
 
@@ -392,6 +403,7 @@ void LightSourcesEditor::Draw (const char* theTitle)
         {
           Handle(Graphic3d_TextureEnv) aTexEnv = new Graphic3d_TextureEnv (aFileName);
           myMainGui->View()->SetTextureEnv (aTexEnv);
+          myMainGui->GetAppViewer()->RestartRendering();
         }
       }
 
@@ -403,6 +415,7 @@ void LightSourcesEditor::Draw (const char* theTitle)
     {
       myMainGui->View()->Viewer()->SetLightOn (aLightNew);
       myMainGui->View()->Viewer()->UpdateLights();
+      myMainGui->GetAppViewer()->RestartRendering();
     }
 
     // Delete light if requested
@@ -410,6 +423,7 @@ void LightSourcesEditor::Draw (const char* theTitle)
     {
       myMainGui->View()->Viewer()->DelLight (aLightToDelete);
       myMainGui->View()->Viewer()->UpdateLights();
+      myMainGui->GetAppViewer()->RestartRendering();
     }
   }
   ImGui::EndDock();
@@ -272,6 +272,8 @@ void MaterialEditor::setMaterial (Graphic3d_MaterialAspect& theMaterial)
   {
     model::SetMaterial (aContext->SelectedInteractive (), theMaterial);
   }
+
+  myMainGui->GetAppViewer ()->RestartRendering ();
 }
 
 //=======================================================================
@@ -522,6 +524,8 @@ void MaterialEditor::Draw (const char* theTitle)
               // just to force state change in order to make these changes visible to path tracing
               model::SetMaterial (aContext->SelectedInteractive (), myGraphicAspect->FrontMaterial ());
             }
+
+            myMainGui->GetAppViewer ()->RestartRendering ();
           }
 
           break; // graphic aspects were synchronized
@@ -1175,6 +1179,8 @@ void MaterialEditor::Draw (const char* theTitle)
         }
 
         synchronizeAspects (myMainGui->InteractiveContext ());
+
+        myMainGui->GetAppViewer ()->RestartRendering ();
       }
     }
     else // already has texture
@@ -1196,6 +1202,8 @@ void MaterialEditor::Draw (const char* theTitle)
               model::SetAspect (aNode->Object (), myGraphicAspect);
             }
           }
+
+          myMainGui->GetAppViewer ()->RestartRendering ();
         }
 
         goto ExitTextureGroup;
@@ -1219,10 +1227,13 @@ void MaterialEditor::Draw (const char* theTitle)
 
             if (!aTextureMap.IsNull ())
             {
-              myGraphicAspect->SetTextureMap (aTextureMap);
+              // UV scale of the object is re-applied to the new map
+              model::SetTextureMap (myMainGui->InteractiveContext ()->FirstSelectedObject (), aTextureMap);
             }
 
             synchronizeAspects (myMainGui->InteractiveContext ());
+
+            myMainGui->GetAppViewer ()->RestartRendering ();
           }
         }
 
@@ -1245,6 +1256,8 @@ void MaterialEditor::Draw (const char* theTitle)
         }
 
         synchronizeAspects (myMainGui->InteractiveContext ());
+
+        myMainGui->GetAppViewer ()->RestartRendering ();
       }
 
       Handle (AIS_TexturedShape) aTexShape = Handle (AIS_TexturedShape)::DownCast (myMainGui->InteractiveContext ()->FirstSelectedObject ());
@@ -1258,8 +1271,13 @@ void MaterialEditor::Draw (const char* theTitle)
       {
         ImGui::Spacing (); ImGui::Unindent (3.f);
 
-        float aScaleU = static_cast<float> (aTexShape->TextureScaleU ());
-        float aScaleV = static_cast<float> (aTexShape->TextureScaleV ());
+        double aTexScaleU = 1.0;
+        double aTexScaleV = 1.0;
+
+        model::GetTextureScale (aTexShape, aTexScaleU, aTexScaleV);
+
+        float aScaleU = static_cast<float> (aTexScaleU);
+        float aScaleV = static_cast<float> (aTexScaleV);
 
         bool toChange = false;
 
@@ -1278,6 +1296,8 @@ void MaterialEditor::Draw (const char* theTitle)
             }
 
             aNode->Object ()->SynchronizeAspects ();
+
+            myMainGui->GetAppViewer ()->RestartRendering ();
           }
           else
           {
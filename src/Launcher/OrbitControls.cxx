@@ -206,6 +206,15 @@ void OrbitControls::Update (const float /*theDelta*/)
   //
 };
 
+//=======================================================================
+//function : IsMoving
+//purpose  :
+//=======================================================================
+bool OrbitControls::IsMoving() const
+{
+  return myInternal != NULL && myInternal->State != OCS_NONE;
+}
+
 //=======================================================================
 //function : OnMouseDown
 //purpose  :
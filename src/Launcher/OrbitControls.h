@@ -44,6 +44,9 @@ public:
   Standard_EXPORT virtual void OnKeyDown (const int theKey);
   Standard_EXPORT virtual void OnKeyUp (const int theKey);
 
+  //! Returns true if camera is being manipulated.
+  Standard_EXPORT virtual bool IsMoving() const;
+
   Standard_EXPORT virtual bool IsWalkthough() const
   {
     return false;
@@ -16,10 +16,16 @@
 #include <DataNode.hxx>
 #include <DataModel.hxx>
 #include <DataContext.hxx>
+#include <MeshRefiner.hxx>
+#include <ImportCache.hxx>
+#include <Convergence.hxx>
+#include <Checkpoint.hxx>
+#include <Denoiser.hxx>
 
 #include "AppViewer.hxx"
 #include "OrbitControls.h"
 #include "FlightControls.h"
+#include "ImageCapture.hxx"
 #include "IconsFontAwesome.h"
 
 #include "SettingsWidget.hxx"
@@ -88,6 +94,63 @@ void SettingsWidget::Init (GuiBase* theMainGui)
   {
     aParams.Method = Graphic3d_RM_RASTERIZATION;
   }
+
+  // Load import cache settings
+  ie::ImportCache* aCache = ie::ImportCache::GetInstance ();
+
+  aCache->SetEnabled (myMainGui->GetSettings ().GetBoolean ("cache", "enabled", true));
+
+  aCache->SetDirectory (myMainGui->GetSettings ().Get ("cache", "directory", "cache").c_str ());
+
+  aCache->SetMaxSize (static_cast<int> (myMainGui->GetSettings ().GetInteger ("cache", "size_limit", 2048)));
+
+  // Load checkpoint settings
+  ie::Checkpoint* aCheckpoint = ie::Checkpoint::GetInstance ();
+
+  aCheckpoint->SetEnabled (myMainGui->GetSettings ().GetBoolean ("checkpoint", "enabled", true));
+
+  aCheckpoint->SetDirectory (myMainGui->GetSettings ().Get ("checkpoint", "directory", "checkpoints").c_str ());
+
+  aCheckpoint->SetInterval (myMainGui->GetSettings ().GetReal ("checkpoint", "interval", 60.0));
+
+  // Load file name of continuous capture
+  myMainGui->GetAppViewer ()->GetCapture ().SetFileName (myMainGui->GetSettings ().Get ("capture", "file", "capture.png"));
+
+  // Load denoiser settings
+  ie::Denoiser* aDenoiser = ie::Denoiser::GetInstance ();
+
+  aDenoiser->SetEnabled (myMainGui->GetSettings ().GetBoolean ("denoiser", "enabled", false));
+
+  aDenoiser->SetNbIterations (static_cast<int> (myMainGui->GetSettings ().GetInteger ("denoiser", "iterations", 5)));
+
+  aDenoiser->SetColorSigma (static_cast<float> (myMainGui->GetSettings ().GetReal ("denoiser", "color", 0.5)));
+
+  aDenoiser->SetNormalSigma (static_cast<float> (myMainGui->GetSettings ().GetReal ("denoiser", "normal", 16.0)));
+
+  aDenoiser->SetDepthSigma (static_cast<float> (myMainGui->GetSettings ().GetReal ("denoiser", "depth", 0.01)));
+
+  aDenoiser->SetAlbedoSigma (static_cast<float> (myMainGui->GetSettings ().GetReal ("denoiser", "albedo", 0.1)));
+
+  // Load stop criteria of path tracing
+  ie::Convergence* aConvergence = ie::Convergence::GetInstance ();
+
+  aConvergence->SetMaxSamples (static_cast<int> (myMainGui->GetSettings ().GetInteger ("convergence", "samples", 0)));
+
+  aConvergence->SetMaxTime (myMainGui->GetSettings ().GetReal ("convergence", "time", 0.0));
+
+  aConvergence->SetMaxNoise (myMainGui->GetSettings ().GetReal ("convergence", "noise", 0.0));
+
+  // Load dynamic resolution settings
+  if (myMainGui->GetSettings ().GetBoolean ("resolution", "dynamic", true))
+  {
+    const int aTargetFps = static_cast<int> (myMainGui->GetSettings ().GetInteger ("resolution", "target_fps", 30));
+
+    myMainGui->GetAppViewer ()->SetInteractiveFrameTime (1.0 / std::max (aTargetFps, 1));
+  }
+  else
+  {
+    myMainGui->GetAppViewer ()->SetInteractiveFrameTime (0.0);
+  }
 }
 
 #define MIN_RES 128
@@ -167,6 +230,35 @@ void SettingsWidget::Draw (const char* theTitle)
       }
       myMainGui->AddTooltip ("Fit viewport size to available area");
 
+      const double aFrameTime = myMainGui->GetAppViewer ()->InteractiveFrameTime ();
+
+      bool isDynamic = aFrameTime > 0.0;
+
+      int aTargetFps = isDynamic ? static_cast<int> (1.0 / aFrameTime + 0.5)
+                                 : static_cast<int> (myMainGui->GetSettings ().GetInteger ("resolution", "target_fps", 30));
+
+      if (ImGui::Checkbox ("Dynamic resolution", &isDynamic))
+      {
+        myMainGui->GetAppViewer ()->SetInteractiveFrameTime (isDynamic ? 1.0 / std::max (aTargetFps, 1) : 0.0);
+
+        myMainGui->GetSettings ().SetBoolean ("resolution", "dynamic", isDynamic);
+      }
+      myMainGui->AddTooltip ("Reduce rendering resolution while the camera is moving\n"
+                             "to keep interactive frame rate");
+
+      if (isDynamic)
+      {
+        if (ImGui::SliderInt ("Target FPS", &aTargetFps, 5, 60))
+        {
+          aTargetFps = std::max (std::min (aTargetFps, 60), 5);
+
+          myMainGui->GetAppViewer ()->SetInteractiveFrameTime (1.0 / aTargetFps);
+
+          myMainGui->GetSettings ().SetInteger ("resolution", "target_fps", aTargetFps);
+        }
+        myMainGui->AddTooltip ("Frame rate to reach during camera interaction");
+      }
+
       ImGui::Spacing ();
     }
 
@@ -322,6 +414,8 @@ void SettingsWidget::Draw (const char* theTitle)
               aMaxRadiance = (aMaxRadiance < 1.f) ? 1.f : (aMaxRadiance > 1.0e3f ? 1.0e3f : aMaxRadiance);
 
               aParams.RadianceClampingValue = aMaxRadiance;
+
+              myMainGui->GetAppViewer()->RestartRendering();
             }
             myMainGui->AddTooltip ("Radiance clamping threshold (use it to decrease noise)");
 
@@ -330,6 +424,8 @@ void SettingsWidget::Draw (const char* theTitle)
             if (ImGui::Checkbox ("Two-sided shading", &aIsTwoSided))
             {
               aParams.TwoSidedBsdfModels = aIsTwoSided;
+
+              myMainGui->GetAppViewer()->RestartRendering();
             }
             myMainGui->AddTooltip ("Enable two-sided scattering models");
             
@@ -372,6 +468,8 @@ void SettingsWidget::Draw (const char* theTitle)
                   default:
                     break;
                   }
+
+                  myMainGui->GetAppViewer()->RestartRendering();
                 }
 
               }
@@ -391,6 +489,7 @@ void SettingsWidget::Draw (const char* theTitle)
               {
                 if (ImGui::SliderFloat("White point", &aParams.WhitePoint, 0.01f, 10.0f))
                 {
+                  myMainGui->GetAppViewer()->StopUpdating (false); // tone mapping is applied on display
                 }
                 myMainGui->AddTooltip("White point");
 
@@ -399,6 +498,7 @@ void SettingsWidget::Draw (const char* theTitle)
 
               if (ImGui::SliderFloat("Exposure", &aParams.Exposure, -10, 10))
               {
+                myMainGui->GetAppViewer()->StopUpdating (false); // tone mapping is applied on display
               }
               myMainGui->AddTooltip("Exposure");
             }
@@ -445,6 +545,8 @@ void SettingsWidget::Draw (const char* theTitle)
                 if (ImGui::Checkbox ("Show distribution", &aToShowSamples) && aIsAdaptive)
                 {
                   aParams.ShowSamplingTiles = aToShowSamples;
+
+                  myMainGui->GetAppViewer()->RestartRendering();
                 }
                 myMainGui->AddTooltip ("Show distribution of samples in adaptive mode (debug mode)");
 
@@ -489,88 +591,50 @@ void SettingsWidget::Draw (const char* theTitle)
             }
           }
           
-          /*// Working time settings
+          // Stop criteria settings
           {
-            ImGui::Indent(3.f);
+            ImGui::Indent (3.f);
 
-            if (ImGui::CollapsingHeader("Working time"))
+            if (ImGui::CollapsingHeader ("Stop criteria"))
             {
-              float aTimeInt, aTimeFract;
-              aTimeFract = std::modff(myMainGui->GetAppViewer()->GetWorkingTime(), &aTimeInt);
-              std::stringstream aTimeStr;
-              aTimeStr << std::setfill('0')
-                << std::setw(2) << (int)aTimeInt / 60 / 60
-                << ":"
-                << std::setw(2) << (int)aTimeInt / 60 % 60
-                << ":"
-                << std::setw(2) << (int)aTimeInt % 60
-                << "."
-                << std::setw(3) << (int)(aTimeFract * 1000);
-              ImGui::InputText("Cur time", const_cast<char*> (aTimeStr.str().c_str()), 15, ImGuiInputTextFlags_ReadOnly);
-              myMainGui->AddTooltip("Current rendering time");
-
-              static char anEndTime[14] = "00:00:00.000";
-              auto timeFilter = [](ImGuiTextEditCallbackData* data) -> int
+              ImGui::Spacing (); ImGui::Unindent (3.f);
+
+              ie::Convergence* aConvergence = ie::Convergence::GetInstance ();
+
+              int aMaxSamples = aConvergence->MaxSamples ();
+
+              if (ImGui::InputInt ("Samples", &aMaxSamples, 100, 1000))
               {
-                if (data->HasSelection())
-                {
-                  data->SelectionEnd = data->SelectionStart;
-                }
-                if (data->BufSize - data->BufTextLen == 1)
-                {
-                  char anInputChar = data->Buf[data->CursorPos - 1];
-                  int anIncorrectSymbol = 0;
-                  if (data->CursorPos >= data->BufTextLen
-                    || data->CursorPos == 3
-                    || data->CursorPos == 6
-                    || data->CursorPos == 9
-                    || (data->CursorPos == 4 || data->CursorPos == 7)
-                    && (anInputChar < '0' || anInputChar > '5')
-                    || (anInputChar >= '*' && anInputChar <= '-'))
-                  {
-                    anIncorrectSymbol = 1;
-                  }
-                  data->DeleteChars(data->CursorPos - anIncorrectSymbol, 1);
-                  if (!anIncorrectSymbol)
-                  {
-                    data->CursorPos++;
-                  }
-                  if (data->CursorPos == 2
-                    || data->CursorPos == 5
-                    || data->CursorPos == 8)
-                  {
-                    data->CursorPos++;
-                  }
-                  if (data->CursorPos > data->BufTextLen)
-                  {
-                    data->CursorPos = data->BufTextLen;
-                  }
-                  data->BufDirty = true;
-                }
-                return 0;
-              };
+                aConvergence->SetMaxSamples (std::max (aMaxSamples, 0));
+                myMainGui->GetSettings ().SetInteger ("convergence", "samples", aConvergence->MaxSamples ());
+              }
+              myMainGui->AddTooltip ("Stop rendering after the given number of samples per pixel (0 - unlimited)");
+
+              float aMaxTime = static_cast<float> (aConvergence->MaxTime ());
 
-              if (ImGui::InputText("Max time", anEndTime, 14, ImGuiInputTextFlags_CharsDecimal | ImGuiInputTextFlags_DisableDeleting | ImGuiInputTextFlags_CallbackAlways, timeFilter))
+              if (ImGui::InputFloat ("Time (sec)", &aMaxTime, 10.f, 60.f, 1))
               {
-                char aTime[4];
-                std::strncpy(aTime, anEndTime, 2);
-                aTime[2] = '\0';
-                float aMaxTime = 0;
-                aMaxTime = std::atoi(aTime) * 3600;
-                std::strncpy(aTime, anEndTime + 3, 2);
-                aTime[2] = '\0';
-                aMaxTime += std::atoi(aTime) * 60;
-                std::strncpy(aTime, anEndTime + 6, 2);
-                aTime[2] = '\0';
-                aMaxTime += std::atoi(aTime);
-                std::strncpy(aTime, anEndTime + 9, 3);
-                aTime[3] = '\0';
-                aMaxTime += std::atoi(aTime) / 1000.0f;
-                myMainGui->GetAppViewer()->SetMaxWorkingTime(aMaxTime);
+                aConvergence->SetMaxTime (std::max (aMaxTime, 0.f));
+                myMainGui->GetSettings ().SetReal ("convergence", "time", aConvergence->MaxTime ());
               }
-              myMainGui->AddTooltip("The maximum time at which the rendering will pause");
+              myMainGui->AddTooltip ("Stop rendering after the given time (0 - unlimited)");
+
+              float aMaxNoise = static_cast<float> (aConvergence->MaxNoise () * 100.0);
+
+              if (ImGui::SliderFloat ("Noise (%)", &aMaxNoise, 0.f, 5.f, "%.2f"))
+              {
+                aConvergence->SetMaxNoise (std::max (aMaxNoise, 0.f) / 100.0);
+                myMainGui->GetSettings ().SetReal ("convergence", "noise", aConvergence->MaxNoise ());
+              }
+              myMainGui->AddTooltip ("Stop rendering when estimated noise (relative RMS error of pixel) falls below the given level (0 - disabled)");
+
+              ImGui::ProgressBar (static_cast<float> (aConvergence->Progress ()));
             }
-          }*/
+            else
+            {
+              ImGui::Unindent (3.f);
+            }
+          }
         }
         else if (aRenderMode == 1) // ray tracing (RT)
         {
@@ -587,6 +651,8 @@ void SettingsWidget::Draw (const char* theTitle)
           if (ImGui::Checkbox ("Shadows", &aShadowsEnabled))
           {
             aParams.IsShadowEnabled = aShadowsEnabled;
+
+            myMainGui->GetAppViewer()->RestartRendering();
           }
           myMainGui->AddTooltip ("Enable hard shadows");
 
@@ -595,6 +661,8 @@ void SettingsWidget::Draw (const char* theTitle)
           if (ImGui::Checkbox ("Reflections", &aReflecEnabled))
           {
             aParams.IsReflectionEnabled = aReflecEnabled;
+
+            myMainGui->GetAppViewer()->RestartRendering();
           }
           myMainGui->AddTooltip ("Enable specular reflections");
 
@@ -603,6 +671,8 @@ void SettingsWidget::Draw (const char* theTitle)
           if (ImGui::Checkbox ("Anti-aliasing", &aFsaaEnabled))
           {
             aParams.IsAntialiasingEnabled = aFsaaEnabled;
+
+            myMainGui->GetAppViewer()->RestartRendering();
           }
           myMainGui->AddTooltip ("Enable adaptive full screen anti-aliasing");
         }
@@ -613,6 +683,8 @@ void SettingsWidget::Draw (const char* theTitle)
           if (ImGui::SliderInt ("MSAA", &aNbSamples, 0, 16))
           {
             aParams.NbMsaaSamples = (aNbSamples < 0) ? 0 : (aNbSamples > 16 ? 16 : aNbSamples);
+
+            myMainGui->GetAppViewer()->RestartRendering();
           }
 
           myMainGui->AddTooltip ("Number of MSAA samples");
@@ -620,6 +692,239 @@ void SettingsWidget::Draw (const char* theTitle)
       }
       ImGui::Spacing ();
     }
+
+    if (ImGui::CollapsingHeader ("Tessellation"))
+    {
+      ImGui::Spacing ();
+
+      int aBudget = myMainGui->GetSettings ().GetInteger ("tessellation", "budget", 5000000);
+
+      if (ImGui::InputInt ("Triangles", &aBudget, 100000, 1000000))
+      {
+        aBudget = std::max (aBudget, 1000);
+
+        myMainGui->GetSettings ().SetInteger ("tessellation", "budget", aBudget);
+      }
+      myMainGui->AddTooltip ("Global triangle budget for CAD shapes");
+
+      if (ImGui::Button ("Distribute budget", ImVec2 (ImGui::GetContentRegionAvailWidth (), 0)))
+      {
+        myMainGui->ConsoleExec ((TCollection_AsciiString ("rtmeshbudget ") + TCollection_AsciiString (aBudget)).ToCString ());
+      }
+      myMainGui->AddTooltip ("Re-tessellate all shapes to fit the budget (by surface area and curvature).\n"
+                             "Achieved number of triangles and memory are printed to console.");
+
+      bool toRefine = ie::MeshRefiner::GetInstance ()->IsEnabled ();
+
+      if (ImGui::Checkbox ("Refine for current view", &toRefine))
+      {
+        const TCollection_AsciiString aCommand = toRefine ? TCollection_AsciiString ("rtrefine -on -budget ") + TCollection_AsciiString (aBudget)
+                                                          : TCollection_AsciiString ("rtrefine -off");
+
+        myMainGui->ConsoleExec (aCommand.ToCString ());
+      }
+      myMainGui->AddTooltip ("Re-tessellate shapes in background according to their size on the screen");
+
+      ImGui::Spacing ();
+    }
+
+    if (ImGui::CollapsingHeader ("Import cache"))
+    {
+      ImGui::Spacing ();
+
+      ie::ImportCache* aCache = ie::ImportCache::GetInstance ();
+
+      bool toUseCache = aCache->IsEnabled ();
+
+      if (ImGui::Checkbox ("Cache translated files", &toUseCache))
+      {
+        aCache->SetEnabled (toUseCache);
+
+        myMainGui->GetSettings ().SetBoolean ("cache", "enabled", toUseCache);
+      }
+      myMainGui->AddTooltip ("Store translated STEP files (shapes and triangulation) on disk\n"
+                             "and reuse them while the source file is not changed");
+
+      char aDirectory[256] = "";
+
+      strncpy (aDirectory, aCache->Directory ().ToCString (), 255);
+
+      if (ImGui::InputText ("Directory", aDirectory, 256, ImGuiInputTextFlags_EnterReturnsTrue))
+      {
+        aCache->SetDirectory (aDirectory);
+
+        myMainGui->GetSettings ().Set ("cache", "directory", aDirectory);
+      }
+      myMainGui->AddTooltip ("Directory of cache entries (press Enter to apply)");
+
+      int aMaxSize = aCache->MaxSize ();
+
+      if (ImGui::InputInt ("Size limit (MB)", &aMaxSize, 256, 1024))
+      {
+        aMaxSize = std::max (aMaxSize, 0);
+
+        aCache->SetMaxSize (aMaxSize);
+
+        myMainGui->GetSettings ().SetInteger ("cache", "size_limit", aMaxSize);
+      }
+      myMainGui->AddTooltip ("Least recently used entries are removed when the limit is exceeded");
+
+      if (ImGui::Button ("Clear cache", ImVec2 (ImGui::GetContentRegionAvailWidth (), 0)))
+      {
+        myMainGui->ConsoleExec ("rtcache -clear");
+      }
+
+      ImGui::Spacing ();
+    }
+
+    if (ImGui::CollapsingHeader ("Checkpoints"))
+    {
+      ImGui::Spacing ();
+
+      ie::Checkpoint* aCheckpoint = ie::Checkpoint::GetInstance ();
+
+      bool toUseCheckpoints = aCheckpoint->IsEnabled ();
+
+      if (ImGui::Checkbox ("Resume progressive rendering", &toUseCheckpoints))
+      {
+        aCheckpoint->SetEnabled (toUseCheckpoints);
+
+        myMainGui->GetSettings ().SetBoolean ("checkpoint", "enabled", toUseCheckpoints);
+      }
+      myMainGui->AddTooltip ("Periodically store accumulated image on disk and continue\n"
+                             "from it when the same scene is rendered with the same view");
+
+      char aDirectory[256] = "";
+
+      strncpy (aDirectory, aCheckpoint->Directory ().ToCString (), 255);
+
+      if (ImGui::InputText ("Directory##Checkpoints", aDirectory, 256, ImGuiInputTextFlags_EnterReturnsTrue))
+      {
+        aCheckpoint->SetDirectory (aDirectory);
+
+        myMainGui->GetSettings ().Set ("checkpoint", "directory", aDirectory);
+      }
+      myMainGui->AddTooltip ("Directory of checkpoint files (press Enter to apply)");
+
+      int anInterval = static_cast<int> (aCheckpoint->Interval ());
+
+      if (ImGui::InputInt ("Interval (sec)", &anInterval, 10, 60))
+      {
+        anInterval = std::max (anInterval, 1);
+
+        aCheckpoint->SetInterval (anInterval);
+
+        myMainGui->GetSettings ().SetReal ("checkpoint", "interval", anInterval);
+      }
+      myMainGui->AddTooltip ("Time between checkpoints (checkpoint is also written on exit)");
+
+      if (ImGui::Button ("Clear checkpoints", ImVec2 (ImGui::GetContentRegionAvailWidth (), 0)))
+      {
+        myMainGui->ConsoleExec ("rtcheckpoint -clear");
+      }
+
+      ImGui::Spacing ();
+    }
+
+    if (ImGui::CollapsingHeader ("Capture"))
+    {
+      ImGui::Spacing ();
+
+      ImageCapture& aCapture = myMainGui->GetAppViewer ()->GetCapture ();
+
+      int anInterval = aCapture.Interval ();
+
+      if (ImGui::InputInt ("Every N samples", &anInterval, 10, 100))
+      {
+        aCapture.SetInterval (anInterval);
+      }
+      myMainGui->AddTooltip ("Save intermediate images of progressive rendering\n"
+                             "without stalling the renderer (0 disables capture)");
+
+      char aFileName[256] = "";
+
+      strncpy (aFileName, aCapture.FileName ().c_str (), 255);
+
+      if (ImGui::InputText ("File##Capture", aFileName, 256, ImGuiInputTextFlags_EnterReturnsTrue))
+      {
+        aCapture.SetFileName (aFileName);
+
+        myMainGui->GetSettings ().Set ("capture", "file", aFileName);
+      }
+      myMainGui->AddTooltip ("Number of samples is appended to the file name (press Enter to apply)");
+
+      ImGui::Spacing ();
+    }
+
+    if (ImGui::CollapsingHeader ("Denoising"))
+    {
+      ImGui::Spacing ();
+
+      ie::Denoiser* aDenoiser = ie::Denoiser::GetInstance ();
+
+      bool toDenoise = aDenoiser->IsEnabled ();
+
+      if (ImGui::Checkbox ("Denoise image", &toDenoise))
+      {
+        aDenoiser->SetEnabled (toDenoise);
+
+        myMainGui->GetSettings ().SetBoolean ("denoiser", "enabled", toDenoise);
+      }
+      myMainGui->AddTooltip ("Show denoised image in the viewport (updated each time\n"
+                             "the number of samples is doubled) and save it on export");
+
+      int aNbIterations = aDenoiser->NbIterations ();
+
+      if (ImGui::SliderInt ("Passes", &aNbIterations, 1, 8))
+      {
+        aDenoiser->SetNbIterations (aNbIterations);
+
+        myMainGui->GetSettings ().SetInteger ("denoiser", "iterations", aNbIterations);
+      }
+      myMainGui->AddTooltip ("Each pass doubles filter radius");
+
+      float aColorSigma = aDenoiser->ColorSigma ();
+
+      if (ImGui::SliderFloat ("Color", &aColorSigma, 0.05f, 2.f))
+      {
+        aDenoiser->SetColorSigma (aColorSigma);
+
+        myMainGui->GetSettings ().SetReal ("denoiser", "color", aColorSigma);
+      }
+      myMainGui->AddTooltip ("Larger values remove more noise, but blur shadows and reflections");
+
+      float aNormalSigma = aDenoiser->NormalSigma ();
+
+      if (ImGui::SliderFloat ("Normal", &aNormalSigma, 0.f, 128.f))
+      {
+        aDenoiser->SetNormalSigma (aNormalSigma);
+
+        myMainGui->GetSettings ().SetReal ("denoiser", "normal", aNormalSigma);
+      }
+      myMainGui->AddTooltip ("Larger values preserve more geometric edges");
+
+      float aDepthSigma = aDenoiser->DepthSigma ();
+
+      if (ImGui::SliderFloat ("Depth", &aDepthSigma, 0.001f, 0.1f))
+      {
+        aDenoiser->SetDepthSigma (aDepthSigma);
+
+        myMainGui->GetSettings ().SetReal ("denoiser", "depth", aDepthSigma);
+      }
+      myMainGui->AddTooltip ("Tolerance to depth difference (relative to depth per pixel)");
+
+      float anAlbedoSigma = aDenoiser->AlbedoSigma ();
+
+      if (ImGui::SliderFloat ("Albedo", &anAlbedoSigma, 0.01f, 1.f))
+      {
+        aDenoiser->SetAlbedoSigma (anAlbedoSigma);
+
+        myMainGui->GetSettings ().SetReal ("denoiser", "albedo", anAlbedoSigma);
+      }
+      myMainGui->AddTooltip ("Tolerance to material difference");
+
+      ImGui::Spacing ();
+    }
   }
   ImGui::EndDock ();
 }
@@ -0,0 +1,133 @@
+// Created: 2019-07-08
+//
+// Copyright (c) 2019 OPEN CASCADE SAS
+//
+// This file is a part of CADRays software.
+//
+// CADRays is free software; you can use it under the terms of the MIT license,
+// refer to file LICENSE.txt for complete text of the license and disclaimer of
+// any warranty.
+
+#include "TileWriter.hxx"
+
+#include <algorithm>
+#include <cctype>
+#include <sstream>
+
+//=======================================================================
+//function : FileName
+//purpose  :
+//=======================================================================
+std::string TileWriter::FileName (const std::string& theFileName)
+{
+  const size_t aDotPos = theFileName.find_last_of ('.');
+
+  if (aDotPos == std::string::npos || theFileName.find_first_of ("/\\", aDotPos) != std::string::npos)
+  {
+    return theFileName + ".ppm";
+  }
+
+  std::string anExtension = theFileName.substr (aDotPos + 1);
+
+  std::transform (anExtension.begin (), anExtension.end (), anExtension.begin (), ::tolower);
+
+  if (anExtension == "ppm" || anExtension == "pnm")
+  {
+    return theFileName;
+  }
+
+  return theFileName.substr (0, aDotPos) + ".ppm";
+}
+
+//=======================================================================
+//function : TileWriter
+//purpose  :
+//=======================================================================
+TileWriter::TileWriter ()
+  : myHeaderSize (0),
+    mySizeX (0),
+    mySizeY (0)
+{
+  //
+}
+
+//=======================================================================
+//function : Open
+//purpose  :
+//=======================================================================
+bool TileWriter::Open (const std::string& theFileName, const int theSizeX, const int theSizeY)
+{
+  if (theSizeX < 1 || theSizeY < 1)
+  {
+    return false;
+  }
+
+  myFile.open (theFileName.c_str (), std::ios::in | std::ios::out | std::ios::binary | std::ios::trunc);
+
+  if (!myFile.is_open ())
+  {
+    return false;
+  }
+
+  std::ostringstream aHeader;
+
+  aHeader << "P6\n" << theSizeX << " " << theSizeY << "\n255\n";
+
+  myFile << aHeader.str ();
+
+  myHeaderSize = static_cast<std::streamoff> (aHeader.str ().size ());
+
+  mySizeX = theSizeX;
+  mySizeY = theSizeY;
+
+  // Allocate the whole file, so that tiles can be written in any order
+  myFile.seekp (myHeaderSize + static_cast<std::streamoff> (theSizeX) * theSizeY * 3 - 1);
+  myFile.put (0);
+
+  return myFile.good ();
+}
+
+//=======================================================================
+//function : Write
+//purpose  :
+//=======================================================================
+bool TileWriter::Write (const Image_PixMap& theTile, const int theOffsetX, const int theOffsetY)
+{
+  if (!myFile.is_open () || theTile.Format () != Image_PixMap::ImgRGB
+   || theOffsetX < 0 || theOffsetX + static_cast<int> (theTile.SizeX ()) > mySizeX
+   || theOffsetY < 0 || theOffsetY + static_cast<int> (theTile.SizeY ()) > mySizeY)
+  {
+    return false;
+  }
+
+  for (Standard_Size aRow = 0; aRow < theTile.SizeY (); ++aRow)
+  {
+    const std::streamoff aPixel = static_cast<std::streamoff> (theOffsetY + aRow) * mySizeX + theOffsetX;
+
+    myFile.seekp (myHeaderSize + aPixel * 3);
+
+    myFile.write (reinterpret_cast<const char*> (theTile.Row (aRow)), theTile.SizeX () * 3);
+  }
+
+  return myFile.good ();
+}
+
+//=======================================================================
+//function : Close
+//purpose  :
+//=======================================================================
+bool TileWriter::Close ()
+{
+  if (!myFile.is_open ())
+  {
+    return false;
+  }
+
+  myFile.flush ();
+
+  const bool isDone = myFile.good ();
+
+  myFile.close ();
+
+  return isDone;
+}
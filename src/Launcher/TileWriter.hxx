@@ -0,0 +1,61 @@
+// Created: 2019-07-08
+//
+// Copyright (c) 2019 OPEN CASCADE SAS
+//
+// This file is a part of CADRays software.
+//
+// CADRays is free software; you can use it under the terms of the MIT license,
+// refer to file LICENSE.txt for complete text of the license and disclaimer of
+// any warranty.
+
+#ifndef _TileWriter_HeaderFile
+#define _TileWriter_HeaderFile
+
+#include <Image_PixMap.hxx>
+
+#include <fstream>
+#include <string>
+
+//! Writes image of arbitrary size tile by tile into binary PPM file.
+//! Only one tile is kept in memory, so the size of output image is
+//! limited by disk space only (PNG and other compressed formats need
+//! the whole image to be available at once).
+class TileWriter
+{
+public:
+
+  //! Returns the given file name with extension replaced by '.ppm'
+  //! (if it is not PPM or PNM file already).
+  static std::string FileName (const std::string& theFileName);
+
+public:
+
+  //! Creates new tile writer.
+  TileWriter ();
+
+  //! Creates file for image of the given size. Returns false on error.
+  bool Open (const std::string& theFileName, const int theSizeX, const int theSizeY);
+
+  //! Writes RGB tile (8-bit) at the given offset from the top left corner
+  //! of the image. Returns false on error.
+  bool Write (const Image_PixMap& theTile, const int theOffsetX, const int theOffsetY);
+
+  //! Closes the file. Returns false on error.
+  bool Close ();
+
+private:
+
+  //! Output file.
+  std::fstream myFile;
+
+  //! Size of file header.
+  std::streamoff myHeaderSize;
+
+  //! Width of output image.
+  int mySizeX;
+
+  //! Height of output image.
+  int mySizeY;
+};
+
+#endif // _TileWriter_HeaderFile
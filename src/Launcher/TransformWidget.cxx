@@ -9,6 +9,7 @@
 // any warranty.
 
 #include "TransformWidget.hxx"
+#include "AppViewer.hxx"
 #include "IconsFontAwesome.h"
 
 #include <ImGuizmo.h>
@@ -323,6 +324,8 @@ void TransformWidget::Draw (const char* theTitle)
       }
       aPrevIsoscale = aMatrixIsoscale[0];
     }
+
+    myMainGui->GetAppViewer()->RestartRendering();
   }
 
   ImGui::EndDock ();
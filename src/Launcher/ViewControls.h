@@ -65,6 +65,9 @@ public:
 
   Standard_EXPORT virtual bool IsWalkthough() const = 0;
 
+  //! Returns true if camera is being manipulated.
+  Standard_EXPORT virtual bool IsMoving() const = 0;
+
   Standard_EXPORT virtual void RegisterKey (ViewControls_Key theKey, int theExternalKey)
   {
     myMappedKeys[theKey] = theExternalKey;
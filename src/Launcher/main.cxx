@@ -14,6 +14,7 @@
 
 #include <tcl.h>
 #include <iostream>
+#include <sstream>
 
 #include <Draw_Interpretor.hxx>
 #include <Draw.hxx>
@@ -25,6 +26,10 @@
 
 #include <AppGui.hxx>
 #include <AppViewer.hxx>
+#include <JobRunner.hxx>
+#include <TileWriter.hxx>
+#include <ImageCapture.hxx>
+#include <Convergence.hxx>
 #include <OrbitControls.h>
 
 Standard_IMPORT Draw_Interpretor theCommands;
@@ -39,6 +44,245 @@ static void ReadInitFile (const TCollection_AsciiString& theFileName, Draw_Inter
   delete [] com;
 }
 
+static int RunHeadless (int argc, char const *argv[], Draw_Interpretor& theDI, const TCollection_AsciiString& theDataDir)
+{
+  TCollection_AsciiString aScriptPath;
+  TCollection_AsciiString anImagePath ("output.png");
+  TCollection_AsciiString anAovPath;
+  TCollection_AsciiString aReportPath;
+
+  bool toDenoise = false;
+
+  int aNbFrames = 0;
+  int aTileSize = 0;
+  int aCaptureInterval = 0;
+  int aSizeX = 1920;
+  int aSizeY = 1080;
+
+  for (int anArgIdx = 2; anArgIdx < argc; ++anArgIdx)
+  {
+    TCollection_AsciiString aFlag (argv[anArgIdx]);
+    aFlag.LowerCase();
+
+    if (aFlag == "--frames" && anArgIdx + 1 < argc && TCollection_AsciiString (argv[anArgIdx + 1]).IsIntegerValue())
+    {
+      aNbFrames = TCollection_AsciiString (argv[++anArgIdx]).IntegerValue();
+    }
+    else if (aFlag == "--size" && anArgIdx + 1 < argc)
+    {
+      if (sscanf (argv[++anArgIdx], "%dx%d", &aSizeX, &aSizeY) != 2)
+      {
+        aSizeX = aSizeY = 0;
+      }
+    }
+    else if (aFlag == "--tile" && anArgIdx + 1 < argc && TCollection_AsciiString (argv[anArgIdx + 1]).IsIntegerValue())
+    {
+      aTileSize = TCollection_AsciiString (argv[++anArgIdx]).IntegerValue();
+    }
+    else if (aFlag == "--capture" && anArgIdx + 1 < argc && TCollection_AsciiString (argv[anArgIdx + 1]).IsIntegerValue())
+    {
+      aCaptureInterval = TCollection_AsciiString (argv[++anArgIdx]).IntegerValue();
+    }
+    else if (aFlag == "--out" && anArgIdx + 1 < argc)
+    {
+      anImagePath = argv[++anArgIdx];
+    }
+    else if (aFlag == "--aov" && anArgIdx + 1 < argc)
+    {
+      anAovPath = argv[++anArgIdx];
+    }
+    else if (aFlag == "--denoise")
+    {
+      toDenoise = true;
+    }
+    else if (aFlag == "--denoise-benchmark" && anArgIdx + 1 < argc)
+    {
+      aReportPath = argv[++anArgIdx];
+    }
+    else if (aFlag == "--noise" && anArgIdx + 1 < argc && TCollection_AsciiString (argv[anArgIdx + 1]).IsRealValue())
+    {
+      ie::Convergence::GetInstance()->SetMaxNoise (TCollection_AsciiString (argv[++anArgIdx]).RealValue());
+    }
+    else if (aScriptPath.IsEmpty() && !aFlag.IsEmpty() && aFlag.Value (1) != '-')
+    {
+      aScriptPath = argv[anArgIdx];
+    }
+    else
+    {
+      aScriptPath.Clear();
+      break;
+    }
+  }
+
+  // Benchmark of the denoiser compares intermediate images with the final one
+  const bool isBadBenchmark = !aReportPath.IsEmpty() && (aNbFrames < 2 || aTileSize > 0);
+
+  if (aScriptPath.IsEmpty() || aNbFrames < 0 || aTileSize < 0 || aCaptureInterval < 0 || aSizeX < 1 || aSizeY < 1 || isBadBenchmark)
+  {
+    std::cout << "Usage: " << argv[0] << " --headless <scene.tcl> [--frames N] [--noise level] [--size WxH] [--tile size] [--capture N] [--aov buffers.exr]"
+                                         " [--denoise] [--denoise-benchmark report.csv (needs --frames)] [--out image.png]" << std::endl;
+    return 1;
+  }
+
+  // Tiles are streamed to disk, which is possible for uncompressed image only
+  if (aTileSize > 0 && TileWriter::FileName (anImagePath.ToCString()) != anImagePath.ToCString())
+  {
+    anImagePath = TileWriter::FileName (anImagePath.ToCString()).c_str();
+
+    std::cout << "Info: tiled image is written in PPM format to " << anImagePath << std::endl;
+  }
+
+  std::ifstream aScriptFile (aScriptPath.ToCString());
+
+  if (!aScriptFile.is_open())
+  {
+    std::cout << "Error: cannot open script " << aScriptPath << std::endl;
+    return 1;
+  }
+
+  std::string aContent ((std::istreambuf_iterator<char> (aScriptFile)),
+                        (std::istreambuf_iterator<char>()));
+  aScriptFile.close();
+
+#if !defined (_WIN32) && !defined (HAVE_EGL)
+  if (getenv ("DISPLAY") == NULL)
+  {
+    // OpenGl driver of OCCT built without EGL needs X server, virtual one is enough (e.g. with Mesa llvmpipe)
+    std::cout << "Error: no X display, build with USE_EGL option or run under virtual frame buffer (xvfb-run "
+              << argv[0] << " --headless ...)" << std::endl;
+    return 1;
+  }
+#endif
+
+  int aStatus = 0;
+
+  try
+  {
+    AppViewer aViewer ("CADRays", theDataDir.ToCString(), aSizeX, aSizeY, true);
+
+    aViewer.SetRTSize (ImVec2 (static_cast<float> (aSizeX), static_cast<float> (aSizeY)));
+    aViewer.SetScript (aContent, aNbFrames);
+    aViewer.SetTiledOutput (anImagePath.ToCString(), aTileSize);
+    aViewer.SetAovOutput (anAovPath.ToCString());
+    aViewer.SetDenoising (toDenoise, aReportPath.ToCString());
+
+    // Intermediate images of progressive rendering (e.g. image_00100.png)
+    if (aTileSize == 0)
+    {
+      aViewer.GetCapture().SetInterval (aCaptureInterval);
+      aViewer.GetCapture().SetFileName (anImagePath.ToCString());
+    }
+
+    if (!aViewer.RunHeadless (theDI))
+    {
+      aStatus = 1;
+    }
+    else if (aTileSize == 0 && !aViewer.GetTestingImage().Save (anImagePath))
+    {
+      std::cout << "Error: failed to save image " << anImagePath << std::endl;
+      aStatus = 1;
+    }
+
+    aViewer.ReleaseTestingData();
+  }
+  catch (const std::exception& theError)
+  {
+    std::cout << "Error: " << theError.what() << std::endl;
+    aStatus = 1;
+  }
+
+  ViewerTest::SetAISContext (Handle(AIS_InteractiveContext)());
+  ViewerTest::CurrentView (Handle(V3d_View)());
+
+  return aStatus;
+}
+
+static int RunJobs (int argc, char const *argv[], const TCollection_AsciiString& theDataDir)
+{
+  std::string aReportPath ("report.json");
+
+  int aNbWorkers = 1;
+
+  for (int anArgIdx = 3; anArgIdx < argc; ++anArgIdx)
+  {
+    TCollection_AsciiString aFlag (argv[anArgIdx]);
+    aFlag.LowerCase();
+
+    if (aFlag == "--workers" && anArgIdx + 1 < argc && TCollection_AsciiString (argv[anArgIdx + 1]).IsIntegerValue())
+    {
+      aNbWorkers = TCollection_AsciiString (argv[++anArgIdx]).IntegerValue();
+    }
+    else if (aFlag == "--report" && anArgIdx + 1 < argc)
+    {
+      aReportPath = argv[++anArgIdx];
+    }
+    else
+    {
+      aNbWorkers = 0;
+      break;
+    }
+  }
+
+  if (argc < 3 || aNbWorkers < 1)
+  {
+    std::cout << "Usage: " << argv[0] << " --jobs <manifest> [--workers N] [--report report.json]" << std::endl;
+    return 1;
+  }
+
+  JobRunner aRunner (argv[0], theDataDir.ToCString());
+
+  if (!aRunner.ReadManifest (argv[2]))
+  {
+    return 1;
+  }
+
+  return aRunner.Run (aNbWorkers, aReportPath) == 0 ? 0 : 1;
+}
+
+static int RunWorker (int argc, char const *argv[], Draw_Interpretor& theDI, const TCollection_AsciiString& theDataDir)
+{
+  JobRunner aRunner (argv[0], theDataDir.ToCString());
+
+  if (argc < 5 || !aRunner.ReadManifest (argv[2]))
+  {
+    return 1;
+  }
+
+  std::vector<int> aJobs;
+
+  std::stringstream aJobList (argv[4]);
+
+  for (std::string anIndex; std::getline (aJobList, anIndex, ',');)
+  {
+    const int aJobIdx = atoi (anIndex.c_str());
+
+    if (aJobIdx < 0 || aJobIdx >= static_cast<int> (aRunner.Jobs().size()))
+    {
+      std::cout << "Error: invalid job index " << anIndex << std::endl;
+      return 1;
+    }
+
+    aJobs.push_back (aJobIdx);
+  }
+
+  int aStatus = 0;
+
+  try
+  {
+    aStatus = aRunner.RunWorker (theDI, aJobs, argv[3]) == 0 ? 0 : 1;
+  }
+  catch (const std::exception& theError)
+  {
+    std::cout << "Error: " << theError.what() << std::endl;
+    aStatus = 1;
+  }
+
+  ViewerTest::SetAISContext (Handle(AIS_InteractiveContext)());
+  ViewerTest::CurrentView (Handle(V3d_View)());
+
+  return aStatus;
+}
+
 int main (int argc, char const *argv[])
 {
   Tcl_FindExecutable (argv[0]);
@@ -67,6 +311,11 @@ int main (int argc, char const *argv[])
     aCascadeDir = "occt-tcl/";
   }
 
+  if (argc > 1 && TCollection_AsciiString (argv[1]) == "--jobs")
+  {
+    return RunJobs (argc, argv, aDataDir);
+  }
+
 #ifdef _WIN32
   putenv (const_cast<char*> ((TCollection_AsciiString ("CASROOT=") + aCascadeDir).ToCString()));
 #else
@@ -99,6 +348,16 @@ int main (int argc, char const *argv[])
   //Draw::Load(aDI, "XDEDRAW", "DrawPlugin4", aDefDir, aUserDefDir);
   //Draw::Load(aDI, "AISV", "DrawPlugin5", aDefDir, aUserDefDir);
 
+  if (argc > 1 && TCollection_AsciiString (argv[1]) == "--headless")
+  {
+    return RunHeadless (argc, argv, aDI, aDataDir);
+  }
+
+  if (argc > 1 && TCollection_AsciiString (argv[1]) == "--worker")
+  {
+    return RunWorker (argc, argv, aDI, aDataDir);
+  }
+
   // Application init
   AppViewer aViewer ("CADRays", aDataDir.ToCString(), 1900, 1000);
 